@@ -0,0 +1,228 @@
+#include <glad/glad/glad.h>
+
+#include <GLFW/glfw3.h>
+
+#include <glm/gtx/transform.hpp>
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include <intern/Framebuffer/Framebuffer.h>
+#include <intern/Mesh/GeometryArena.h>
+#include <intern/Mesh/MeshImporter.h>
+#include <intern/Mesh/RenderQueue.h>
+#include <intern/Misc/GPUTimer.h>
+#include <intern/Misc/OpenGLErrorHandler.h>
+#include <intern/ShaderProgram/ShaderProgram.h>
+#include <intern/Window/Window.h>
+
+/*
+    Compares the CPU and GPU time of drawing many small objects:
+    one Mesh::draw per object (own buffers, uniform for the model matrix), one glDrawElementsBaseVertex per
+    object from a GeometryArena, and a RenderQueue submitting all objects with one
+    glMultiDrawElementsIndirect.
+
+    usage: DrawBenchmark [max objects]
+    Object counts go from 1000 up to max objects (default 100000), every object is one of 16 low poly
+    spheres. They are drawn into a small offscreen framebuffer, so the GPU time is not dominated by
+    rasterization. The CPU time covers recording and issuing the draws of a frame, the GPU is waited for
+    outside of it.
+*/
+
+constexpr int meshCount = 16;
+constexpr uint8_t timedFrames = 16;
+
+MeshData sphereMesh(int rings, int sectors)
+{
+    MeshData mesh;
+    for(int r = 0; r <= rings; r++)
+    {
+        const float theta = static_cast<float>(r) / rings * glm::pi<float>();
+        for(int s = 0; s <= sectors; s++)
+        {
+            const float phi = static_cast<float>(s) / sectors * glm::two_pi<float>();
+            const glm::vec3 normal{
+                std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi)};
+            mesh.vertices.push_back(
+                {.pos = normal * 0.5f,
+                 .nrm = normal,
+                 .uv = {static_cast<float>(s) / sectors, static_cast<float>(r) / rings},
+                 .tang = glm::vec4(-std::sin(phi), 0.0f, std::cos(phi), 1.0f)});
+        }
+    }
+    for(int r = 0; r < rings; r++)
+    {
+        for(int s = 0; s < sectors; s++)
+        {
+            const auto a = static_cast<GLuint>(r * (sectors + 1) + s);
+            const auto b = static_cast<GLuint>((r + 1) * (sectors + 1) + s);
+            mesh.indices.insert(mesh.indices.end(), {a, a + 1, b, a + 1, b + 1, b});
+        }
+    }
+    return mesh;
+}
+
+struct Timings
+{
+    double cpuMs = 0.0;
+    double gpuMs = 0.0;
+};
+
+/* Runs drawFrame for some frames, returns the average CPU time of drawFrame and GPU time of the frame */
+Timings timeFrames(Framebuffer& framebuffer, const std::function<void()>& drawFrame)
+{
+    using Clock = std::chrono::steady_clock;
+    GPUTimer<timedFrames> timer;
+    framebuffer.bind();
+    glEnable(GL_DEPTH_TEST);
+    std::chrono::duration<double> cpuTime{};
+    // the first frames only fill the rolling average with valid results
+    for(int frame = 0; frame < 2 * timedFrames; frame++)
+    {
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        timer.start();
+        const auto start = Clock::now();
+        drawFrame();
+        const auto end = Clock::now();
+        timer.end();
+        timer.evaluate();
+        glFinish();
+        if(frame >= timedFrames)
+        {
+            cpuTime += end - start;
+        }
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    return {.cpuMs = cpuTime.count() * 1000.0 / timedFrames, .gpuMs = timer.timeMilliseconds()};
+}
+
+int main(int argc, char** argv)
+{
+    GLFWwindow* window = initAndCreateGLFWWindow(64, 64, "Draw benchmark", {{GLFW_VISIBLE, GLFW_FALSE}});
+    if(gladLoadGL() == 0)
+    {
+        printf("Failed to initialize OpenGL context\n");
+        return 1;
+    }
+#ifndef NDEBUG
+    setupOpenGLMessageCallback();
+#endif
+    const size_t maxObjects = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 100000;
+
+    {
+        Framebuffer framebuffer{256, 256, {GL_RGBA8}, true};
+        ShaderProgram meshShader{
+            VERTEX_SHADER_BIT | FRAGMENT_SHADER_BIT,
+            {SHADERS_PATH "/Mesh/shaded.vert", SHADERS_PATH "/Mesh/shaded.frag"}};
+        ShaderProgram queueShader{
+            VERTEX_SHADER_BIT | FRAGMENT_SHADER_BIT,
+            {SHADERS_PATH "/Mesh/drawQueue.vert", SHADERS_PATH "/Mesh/shaded.frag"}};
+
+        GeometryArena arena{VertexLayoutOf<VertexStruct>::layout, 1 << 16, 1 << 18, "DrawBenchmark"};
+        std::vector<std::unique_ptr<ImportedMesh>> meshes;
+        std::vector<GeometryHandle> handles;
+        size_t triangles = 0;
+        for(int i = 0; i < meshCount; i++)
+        {
+            const MeshData sphere = sphereMesh(4 + i / 4, 6 + i);
+            meshes.push_back(std::make_unique<ImportedMesh>(sphere));
+            handles.push_back(arena.add<VertexStruct>(sphere.vertices, sphere.indices));
+            triangles += sphere.indices.size() / 3;
+        }
+        RenderQueue queue{arena, maxObjects, "DrawBenchmark queue"};
+
+        const glm::mat4 view =
+            glm::lookAt(glm::vec3(0.0f, 0.0f, 2.5f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+        const glm::mat4 projection = glm::perspective(glm::radians(60.0f), 1.0f, 0.1f, 10.0f);
+        for(ShaderProgram* shader : {&meshShader, &queueShader})
+        {
+            shader->useProgram();
+            glUniformMatrix4fv(1, 1, GL_FALSE, glm::value_ptr(view));
+            glUniformMatrix4fv(2, 1, GL_FALSE, glm::value_ptr(projection));
+            glUniform1i(3, 0);
+        }
+
+        printf(
+            "%d sphere meshes, %.0f triangles on average\n",
+            meshCount,
+            static_cast<double>(triangles) / meshCount);
+        printf("  objects  method            CPU(ms)  GPU(ms)  draws/ms(CPU)  CPU speedup\n");
+        for(size_t objects = 1000; objects <= maxObjects; objects *= 10)
+        {
+            // objects on a grid filling a cube in front of the camera
+            const auto side = static_cast<size_t>(std::ceil(std::cbrt(static_cast<double>(objects))));
+            const float spacing = 2.0f / static_cast<float>(side);
+            std::vector<glm::mat4> models(objects);
+            for(size_t i = 0; i < objects; i++)
+            {
+                const glm::vec3 cell{
+                    static_cast<float>(i % side),
+                    static_cast<float>(i / side % side),
+                    static_cast<float>(i / side / side)};
+                models[i] =
+                    glm::translate((cell + 0.5f) * spacing - 1.0f) * glm::scale(glm::vec3(spacing * 0.8f));
+            }
+
+            Timings meshTimings = timeFrames(
+                framebuffer,
+                [&]()
+                {
+                    meshShader.useProgram();
+                    for(size_t i = 0; i < objects; i++)
+                    {
+                        glUniformMatrix4fv(0, 1, GL_FALSE, glm::value_ptr(models[i]));
+                        meshes[i % meshCount]->draw();
+                    }
+                });
+            Timings arenaTimings = timeFrames(
+                framebuffer,
+                [&]()
+                {
+                    meshShader.useProgram();
+                    arena.bind();
+                    for(size_t i = 0; i < objects; i++)
+                    {
+                        glUniformMatrix4fv(0, 1, GL_FALSE, glm::value_ptr(models[i]));
+                        arena.draw(handles[i % meshCount]);
+                    }
+                    glBindVertexArray(0);
+                });
+            Timings queueTimings = timeFrames(
+                framebuffer,
+                [&]()
+                {
+                    queueShader.useProgram();
+                    queue.begin();
+                    for(size_t i = 0; i < objects; i++)
+                    {
+                        queue.add(handles[i % meshCount], {.model = models[i]});
+                    }
+                    queue.submit();
+                });
+
+            for(const auto& [name, timings] :
+                {std::pair{"Mesh::draw", meshTimings},
+                 std::pair{"arena base vertex", arenaTimings},
+                 std::pair{"MDI queue", queueTimings}})
+            {
+                printf(
+                    "  %7zu  %-17s  %7.3f  %7.3f  %13.0f  %10.2fx\n",
+                    objects,
+                    name,
+                    timings.cpuMs,
+                    timings.gpuMs,
+                    static_cast<double>(objects) / timings.cpuMs,
+                    meshTimings.cpuMs / timings.cpuMs);
+            }
+        }
+    }
+
+    glfwDestroyWindow(window);
+    glfwTerminate();
+    return 0;
+}
@@ -0,0 +1,284 @@
+#include <glad/glad/glad.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <span>
+#include <vector>
+
+#include <GLFW/glfw3.h>
+
+#include <glm/gtx/transform.hpp>
+
+#include <ImGui/imgui.h>
+#include <ImGui/imgui_impl_glfw.h>
+#include <ImGui/imgui_impl_opengl3.h>
+
+#include <intern/Camera/Camera.h>
+#include <intern/Context/Context.h>
+#include <intern/InputManager/InputManager.h>
+#include <intern/Mesh/Cube.h>
+#include <intern/Mesh/DynamicMesh.h>
+#include <intern/Mesh/InstanceBuffer.h>
+#include <intern/Misc/GPUTimer.h>
+#include <intern/Misc/ImGuiExtensions.h>
+#include <intern/Misc/OpenGLErrorHandler.h>
+#include <intern/Misc/ThreadPool.h>
+#include <intern/ShaderProgram/ShaderProgram.h>
+#include <intern/Window/Window.h>
+
+/*
+    Draws up to maxCubes animated cubes with a single instanced draw call.
+    The transforms and colors of all cubes are computed on the thread pool every frame and written straight
+    into the persistently mapped InstanceBuffer.
+    The waves below them are a DynamicMesh, its vertices are displaced on the CPU every frame.
+*/
+
+constexpr size_t maxCubes = 1 << 18;
+constexpr int waveResolution = 256;
+constexpr float waveSize = 44.0f;
+
+int main()
+{
+    Context ctx{};
+
+    //----------------------- INIT WINDOW
+
+    int WIDTH = 1200;
+    int HEIGHT = 800;
+
+    GLFWwindow* window =
+        initAndCreateGLFWWindow(WIDTH, HEIGHT, "Instanced cubes example", {{GLFW_MAXIMIZED, GLFW_TRUE}});
+
+    ctx.setWindow(window);
+    // disable VSYNC
+    glfwSwapInterval(0);
+
+    glfwGetWindowSize(window, &WIDTH, &HEIGHT);
+
+    //----------------------- INIT OpenGL
+    if(gladLoadGL() == 0)
+    {
+        std::cout << "Failed to initialize OpenGL context" << std::endl;
+        return -1;
+    }
+#ifndef NDEBUG
+    setupOpenGLMessageCallback();
+#endif
+    glClearColor(0.3f, 0.7f, 1.0f, 1.0f);
+    glEnable(GL_DEPTH_TEST);
+
+    //----------------------- INIT IMGUI & Input
+
+    InputManager input(ctx);
+    ctx.setInputManager(&input);
+    input.setupCallbacks();
+
+    IMGUI_CHECKVERSION();
+    ImGui::CreateContext();
+    ImGui::StyleColorsDark();
+    ImGui_ImplGlfw_InitForOpenGL(window, true);
+    ImGui_ImplOpenGL3_Init("#version 450");
+
+    //----------------------- INIT REST
+
+    Camera cam{ctx, static_cast<float>(WIDTH) / static_cast<float>(HEIGHT)};
+    ctx.setCamera(&cam);
+    cam.setPosition({0.0f, 0.0f, 70.0f});
+    cam.updateView();
+
+    Cube cube{1.0f};
+    ShaderProgram instancedShader{
+        VERTEX_SHADER_BIT | FRAGMENT_SHADER_BIT,
+        {SHADERS_PATH "/Mesh/instanced.vert", SHADERS_PATH "/Mesh/shaded.frag"}};
+
+    ThreadPool threadPool;
+    InstanceBuffer instances{maxCubes, "Cube instances"};
+    int cubeCount = 50000;
+    bool animate = true;
+    float animationTime = 0.0f;
+    GPUTimer<32> drawTimer;
+
+    ShaderProgram waveShader{
+        VERTEX_SHADER_BIT | FRAGMENT_SHADER_BIT,
+        {SHADERS_PATH "/Mesh/shaded.vert", SHADERS_PATH "/Mesh/shaded.frag"}};
+    constexpr auto waveVertices = static_cast<size_t>((waveResolution + 1) * (waveResolution + 1));
+    // the topology never changes, only the vertices are computed every frame
+    std::vector<GLuint> waveIndices;
+    waveIndices.reserve(static_cast<size_t>(waveResolution * waveResolution * 6));
+    for(int z = 0; z < waveResolution; z++)
+    {
+        for(int x = 0; x < waveResolution; x++)
+        {
+            const auto a = static_cast<GLuint>(z * (waveResolution + 1) + x);
+            const auto b = a + waveResolution + 1;
+            waveIndices.insert(waveIndices.end(), {a, b, a + 1, a + 1, b, b + 1});
+        }
+    }
+    DynamicMesh waves{
+        VertexLayoutOf<VertexStruct>::layout,
+        waveVertices,
+        waveIndices.size(),
+        DynamicMesh::defaultRegionCount,
+        "Waves"};
+    bool showWaves = true;
+
+    //----------------------- RENDERLOOP
+
+    glfwSetTime(0.0);
+    input.resetTime();
+    float lastTime = 0.0f;
+
+    while(glfwWindowShouldClose(window) == 0)
+    {
+        ImGui::Extensions::FrameStart();
+
+        input.update();
+        if(!ImGui::GetIO().WantCaptureMouse && !ImGui::GetIO().WantCaptureKeyboard)
+        {
+            cam.update();
+        }
+
+        const auto currentTime = static_cast<float>(input.getSimulationTime());
+        if(animate)
+        {
+            animationTime += currentTime - lastTime;
+        }
+        lastTime = currentTime;
+
+        int newWidth = WIDTH;
+        int newHeight = HEIGHT;
+        glfwGetFramebufferSize(window, &newWidth, &newHeight);
+        if((newWidth != WIDTH || newHeight != HEIGHT) && newWidth > 0 && newHeight > 0)
+        {
+            WIDTH = newWidth;
+            HEIGHT = newHeight;
+            glViewport(0, 0, WIDTH, HEIGHT);
+            cam.setAspect(static_cast<float>(WIDTH) / static_cast<float>(HEIGHT));
+        }
+
+        // cubes on a grid, every one bobbing and spinning around its own axis
+        const auto writeStart = std::chrono::steady_clock::now();
+        instances.begin();
+        const std::span<InstanceData> cubes = instances.allocate(static_cast<size_t>(cubeCount));
+        const auto side = static_cast<size_t>(std::ceil(std::cbrt(static_cast<double>(cubes.size()))));
+        // the grid always fills the same volume, more cubes are smaller
+        const float spacing = 40.0f / static_cast<float>(side);
+        parallelFor(
+            &threadPool,
+            cubes.size(),
+            4096,
+            [&, t = animationTime](size_t begin, size_t end)
+            {
+                for(size_t i = begin; i < end; i++)
+                {
+                    const glm::vec3 cell{
+                        static_cast<float>(i % side),
+                        static_cast<float>(i / side % side),
+                        static_cast<float>(i / side / side)};
+                    const glm::vec3 position = (cell + 0.5f) * spacing - 20.0f;
+                    const float phase = static_cast<float>(i) * 0.37f;
+                    const glm::vec3 offset{0.0f, std::sin(t * 2.0f + phase) * 0.25f * spacing, 0.0f};
+                    const glm::vec3 axis = glm::normalize(glm::vec3(std::sin(phase), 1.0f, std::cos(phase)));
+                    const glm::vec3 color = glm::vec3(0.5f) + 0.5f * glm::normalize(position + 0.001f);
+                    // assembled locally, the mapped memory is written once and never read
+                    const InstanceData instance{
+                        .model = glm::translate(position + offset) * glm::rotate(t + phase, axis) *
+                                 glm::scale(glm::vec3(spacing * 0.5f)),
+                        .color = glm::vec4(color, 1.0f),
+                        .materialID = static_cast<uint32_t>(i % 4)};
+                    cubes[i] = instance;
+                }
+            });
+        const std::chrono::duration<double, std::milli> writeTime =
+            std::chrono::steady_clock::now() - writeStart;
+
+        // waves written into the next region of the mesh, the GPU may still draw the previous ones
+        const auto waveStart = std::chrono::steady_clock::now();
+        if(showWaves)
+        {
+            waves.begin();
+            const std::span<VertexStruct> vertices = waves.writeVertices<VertexStruct>(waveVertices);
+            parallelFor(
+                &threadPool,
+                static_cast<size_t>(waveResolution + 1),
+                16,
+                [&, t = animationTime](size_t begin, size_t end)
+                {
+                    constexpr float step = waveSize / static_cast<float>(waveResolution);
+                    for(size_t z = begin; z < end; z++)
+                    {
+                        for(size_t x = 0; x <= static_cast<size_t>(waveResolution); x++)
+                        {
+                            const float px = static_cast<float>(x) * step - waveSize * 0.5f;
+                            const float pz = static_cast<float>(z) * step - waveSize * 0.5f;
+                            const float phaseX = px * 0.3f + t * 1.5f;
+                            const float phaseZ = pz * 0.2f + t;
+                            const float height = std::sin(phaseX) + 0.5f * std::cos(phaseZ);
+                            // derivatives of the height along x and z
+                            const float dx = 0.3f * std::cos(phaseX);
+                            const float dz = -0.1f * std::sin(phaseZ);
+                            vertices[z * (waveResolution + 1) + x] = {
+                                .pos = {px, height - 25.0f, pz},
+                                .nrm = glm::normalize(glm::vec3(-dx, 1.0f, -dz)),
+                                .uv = {static_cast<float>(x) / waveResolution,
+                                       static_cast<float>(z) / waveResolution},
+                                .tang = glm::vec4(glm::normalize(glm::vec3(1.0f, dx, 0.0f)), 1.0f)};
+                        }
+                    }
+                });
+            const std::span<GLuint> indices = waves.writeIndices(waveIndices.size());
+            std::copy(waveIndices.begin(), waveIndices.end(), indices.begin());
+            waves.end();
+        }
+        const std::chrono::duration<double, std::milli> waveTime =
+            std::chrono::steady_clock::now() - waveStart;
+
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        if(showWaves)
+        {
+            waveShader.useProgram();
+            glUniformMatrix4fv(0, 1, GL_FALSE, glm::value_ptr(glm::mat4{1.0f}));
+            glUniformMatrix4fv(1, 1, GL_FALSE, glm::value_ptr(*cam.getView()));
+            glUniformMatrix4fv(2, 1, GL_FALSE, glm::value_ptr(*cam.getProj()));
+            glUniform1i(3, 0);
+            waves.draw();
+        }
+        instancedShader.useProgram();
+        glUniformMatrix4fv(1, 1, GL_FALSE, glm::value_ptr(*cam.getView()));
+        glUniformMatrix4fv(2, 1, GL_FALSE, glm::value_ptr(*cam.getProj()));
+        glUniform1i(3, 0);
+        drawTimer.start();
+        instances.draw(cube);
+        drawTimer.end();
+        drawTimer.evaluate();
+        instances.end();
+
+        ImGui::Begin("Instancing");
+        ImGui::SliderInt("Cubes", &cubeCount, 1, static_cast<int>(maxCubes));
+        ImGui::Checkbox("Animate", &animate);
+        ImGui::Text("Instances: %zu in 1 draw call", instances.getInstanceCount());
+        ImGui::Text("Writing instances: %.2f ms", writeTime.count());
+        ImGui::Text("Drawing (GPU): %.2f ms", drawTimer.timeMilliseconds());
+        ImGui::Text("Stalls: %zu", instances.getStalls());
+        ImGui::Separator();
+        ImGui::Checkbox("Waves", &showWaves);
+        ImGui::Text("Writing waves: %.2f ms (%zu vertices)", waveTime.count(), waves.getVertexCount());
+        ImGui::Text("Stalls: %zu", waves.getStalls());
+        ImGui::End();
+
+        ImGui::Extensions::FrameEnd();
+
+        glfwSwapBuffers(window);
+        glfwPollEvents();
+    }
+
+    ImGui_ImplOpenGL3_Shutdown();
+    ImGui_ImplGlfw_Shutdown();
+    ImGui::DestroyContext();
+
+    glfwDestroyWindow(window);
+    glfwTerminate();
+    return 0;
+}
@@ -0,0 +1,118 @@
+#include <glad/glad/glad.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include <intern/Mesh/CookedMesh.h>
+#include <intern/Mesh/MeshOptimizer.h>
+#include <intern/Misc/ThreadPool.h>
+
+/*
+    Converts OBJ and glTF files into the cooked mesh format (see CookedMesh.h).
+    Does not need an OpenGL context.
+
+    usage: MeshCooker [--force] [-o <output folder>] [meshes...]
+    Without any meshes all objs, gltfs and glbs in MISC_PATH are cooked. Output files are written next to
+    the input unless an output folder is given. Up to date outputs are skipped unless --force is passed.
+    For every cooked mesh the post-transform cache efficiency before and after optimization is printed.
+*/
+
+namespace fs = std::filesystem;
+
+int main(int argc, char** argv)
+{
+    bool force = false;
+    fs::path outputFolder;
+    std::vector<fs::path> inputs;
+    for(int i = 1; i < argc; i++)
+    {
+        const std::string arg = argv[i];
+        if(arg == "--force")
+        {
+            force = true;
+        }
+        else if(arg == "-o" && i + 1 < argc)
+        {
+            outputFolder = argv[++i];
+        }
+        else
+        {
+            inputs.emplace_back(arg);
+        }
+    }
+    if(inputs.empty())
+    {
+        for(const auto& entry : fs::directory_iterator(MISC_PATH))
+        {
+            const fs::path extension = entry.path().extension();
+            if(entry.is_regular_file() &&
+               (extension == ".obj" || extension == ".gltf" || extension == ".glb"))
+            {
+                inputs.push_back(entry.path());
+            }
+        }
+    }
+    if(!outputFolder.empty())
+    {
+        fs::create_directories(outputFolder);
+    }
+
+    std::atomic<int> cooked = 0;
+    std::atomic<int> skipped = 0;
+    std::atomic<int> failed = 0;
+    const auto start = std::chrono::steady_clock::now();
+    {
+        ThreadPool pool;
+        pool.parallelFor(
+            inputs.size(),
+            1,
+            [&](size_t begin, size_t end)
+            {
+                for(size_t i = begin; i < end; i++)
+                {
+                    const fs::path& input = inputs[i];
+                    fs::path output = outputFolder.empty() ? input.parent_path() : outputFolder;
+                    output /= input.stem();
+                    output += CookedMesh::extension;
+
+                    // the importers split large files into chunks on the same pool
+                    bool wasCooked = false;
+                    MeshOptimizationStats stats;
+                    if(!cookMesh(input.string(), output.string(), &pool, force, &wasCooked, &stats))
+                    {
+                        failed++;
+                    }
+                    else if(wasCooked)
+                    {
+                        printf(
+                            "Cooked %s -> %s\n"
+                            "    ACMR %.3f -> %.3f, ATVR %.3f -> %.3f (optimized in %.1fms)\n",
+                            input.string().c_str(),
+                            output.string().c_str(),
+                            stats.before.acmr,
+                            stats.after.acmr,
+                            stats.before.atvr,
+                            stats.after.atvr,
+                            stats.seconds * 1000.0);
+                        cooked++;
+                    }
+                    else
+                    {
+                        skipped++;
+                    }
+                }
+            });
+    }
+    const std::chrono::duration<double> duration = std::chrono::steady_clock::now() - start;
+    printf(
+        "%d cooked, %d up to date, %d failed (%.2fs)\n",
+        cooked.load(),
+        skipped.load(),
+        failed.load(),
+        duration.count());
+    return failed > 0 ? 1 : 0;
+}
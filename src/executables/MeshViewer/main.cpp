@@ -0,0 +1,426 @@
+#include <glad/glad/glad.h>
+
+#include <GLFW/glfw3.h>
+
+#include <glm/gtx/transform.hpp>
+
+#include <ImGui/imgui.h>
+#include <ImGui/imgui_impl_glfw.h>
+#include <ImGui/imgui_impl_opengl3.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <string>
+
+#include <intern/Camera/Camera.h>
+#include <intern/Context/Context.h>
+#include <intern/Framebuffer/Framebuffer.h>
+#include <intern/InputManager/InputManager.h>
+#include <intern/Mesh/CookedMesh.h>
+#include <intern/Mesh/FullscreenTri.h>
+#include <intern/Mesh/MeshImporter.h>
+#include <intern/Mesh/MeshSimplifier.h>
+#include <intern/Mesh/Meshlets.h>
+#include <intern/Misc/ImGuiExtensions.h>
+#include <intern/Misc/OpenGLErrorHandler.h>
+#include <intern/Misc/ThreadPool.h>
+#include <intern/ShaderProgram/ShaderProgram.h>
+#include <intern/Window/Window.h>
+
+/*
+    Imports an OBJ or glTF file and reports the import throughput.
+    Pass the path of the file as the first argument, otherwise a procedural OBJ with about a million
+    triangles is written to the temp directory on the first run.
+    The mesh is cooked into the temp directory (see CookedMesh.h) if the cooked file is missing or
+    outdated and displayed from the cooked file, "Reimport" parses the source file again for comparison.
+    Cooked meshes can also be passed directly.
+    The meshlets of the mesh can be culled against the frustum and their normal cones on the CPU, the
+    window shows how many of them, and of the triangles, are submitted.
+    Cooked meshes have levels of detail, which are picked based on their error in pixels by default.
+*/
+
+namespace
+{
+    // torus knot, as a grid of quads with positions, normals and uvs
+    void writeProceduralMesh(const std::string& file)
+    {
+        constexpr int segments = 2048;
+        constexpr int sides = 256;
+        constexpr float tubeRadius = 0.12f;
+        std::cout << "Writing procedural mesh to " << file << std::endl;
+        FILE* out = fopen(file.c_str(), "w");
+        if(out == nullptr)
+        {
+            std::cerr << "ERROR: Unable to open file " << file << std::endl;
+            return;
+        }
+        const auto curve = [](float t)
+        {
+            const float r = 0.6f + 0.25f * std::cos(3.0f * t);
+            return glm::vec3(r * std::cos(2.0f * t), r * std::sin(2.0f * t), 0.25f * std::sin(3.0f * t));
+        };
+        for(int s = 0; s < segments; s++)
+        {
+            const float t = static_cast<float>(s) / segments * glm::two_pi<float>();
+            const glm::vec3 center = curve(t);
+            const glm::vec3 tangent = glm::normalize(curve(t + 0.001f) - center);
+            const glm::vec3 bitangent = glm::normalize(glm::cross(tangent, glm::normalize(center)));
+            const glm::vec3 normal = glm::cross(bitangent, tangent);
+            for(int i = 0; i < sides; i++)
+            {
+                const float a = static_cast<float>(i) / sides * glm::two_pi<float>();
+                const glm::vec3 direction = normal * std::cos(a) + bitangent * std::sin(a);
+                const glm::vec3 position = center + direction * tubeRadius;
+                fprintf(out, "v %.6f %.6f %.6f\n", position.x, position.y, position.z);
+                fprintf(out, "vn %.5f %.5f %.5f\n", direction.x, direction.y, direction.z);
+                const glm::vec2 uv{static_cast<float>(s) / segments * 16.0f, static_cast<float>(i) / sides};
+                fprintf(out, "vt %.5f %.5f\n", uv.x, uv.y);
+            }
+        }
+        for(int s = 0; s < segments; s++)
+        {
+            for(int i = 0; i < sides; i++)
+            {
+                // 1 based, wrapping around in both directions
+                const int a = s * sides + i + 1;
+                const int b = ((s + 1) % segments) * sides + i + 1;
+                const int c = ((s + 1) % segments) * sides + (i + 1) % sides + 1;
+                const int d = s * sides + (i + 1) % sides + 1;
+                fprintf(out, "f %d/%d/%d %d/%d/%d %d/%d/%d %d/%d/%d\n", a, a, a, b, b, b, c, c, c, d, d, d);
+            }
+        }
+        fclose(out);
+    }
+
+    // scales and moves the bounds into the unit cube around the origin
+    glm::mat4 fitToUnitCube(glm::vec3 minimum, glm::vec3 maximum)
+    {
+        const glm::vec3 extent = maximum - minimum;
+        const float scale = 1.0f / std::max({extent.x, extent.y, extent.z, 1e-6f});
+        return glm::scale(glm::vec3(scale)) * glm::translate(-(minimum + maximum) * 0.5f);
+    }
+
+    glm::mat4 fitToUnitCube(const MeshData& mesh)
+    {
+        if(mesh.vertices.empty())
+        {
+            return glm::mat4{1.0f};
+        }
+        glm::vec3 minimum = mesh.vertices[0].pos;
+        glm::vec3 maximum = mesh.vertices[0].pos;
+        for(const VertexStruct& vertex : mesh.vertices)
+        {
+            minimum = glm::min(minimum, vertex.pos);
+            maximum = glm::max(maximum, vertex.pos);
+        }
+        return fitToUnitCube(minimum, maximum);
+    }
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    Context ctx{};
+
+    //----------------------- INIT WINDOW
+
+    int WIDTH = 1200;
+    int HEIGHT = 800;
+
+    GLFWwindow* window =
+        initAndCreateGLFWWindow(WIDTH, HEIGHT, "Mesh Viewer example", {{GLFW_MAXIMIZED, GLFW_TRUE}});
+
+    ctx.setWindow(window);
+    // disable VSYNC
+    glfwSwapInterval(0);
+
+    // In case window was set to start maximized, retrieve size for framebuffer here
+    glfwGetWindowSize(window, &WIDTH, &HEIGHT);
+
+    //----------------------- INIT OpenGL
+    // init OpenGL context
+    if(gladLoadGL() == 0)
+    {
+        std::cout << "Failed to initialize OpenGL context" << std::endl;
+        return -1;
+    }
+#ifndef NDEBUG
+    setupOpenGLMessageCallback();
+#endif
+    glClearColor(0.05f, 0.05f, 0.1f, 1.0f);
+
+    //----------------------- INIT IMGUI & Input
+
+    InputManager input(ctx);
+    ctx.setInputManager(&input);
+    input.setupCallbacks();
+
+    IMGUI_CHECKVERSION();
+    ImGui::CreateContext();
+    ImGuiIO& io = ImGui::GetIO();
+    io.ConfigFlags |= ImGuiConfigFlags_DockingEnable;
+    io.ConfigDockingWithShift = false;
+    ImGui::StyleColorsDark();
+    // platform/renderer bindings
+    ImGui_ImplGlfw_InitForOpenGL(window, true);
+    ImGui_ImplOpenGL3_Init("#version 450");
+
+    //----------------------- INIT REST
+
+    FullscreenTri fullScreenTri;
+    ShaderProgram postProcessShader{
+        VERTEX_SHADER_BIT | FRAGMENT_SHADER_BIT,
+        {SHADERS_PATH "/General/screenQuad.vert", SHADERS_PATH "/General/hdrTonemapSimple.frag"}};
+
+    Framebuffer internalFBO{WIDTH, HEIGHT, {GL_RGBA16F}, true};
+
+    Camera cam{ctx, static_cast<float>(WIDTH) / static_cast<float>(HEIGHT)};
+    ctx.setCamera(&cam);
+
+    ShaderProgram meshShader{
+        VERTEX_SHADER_BIT | FRAGMENT_SHADER_BIT,
+        {SHADERS_PATH "/Mesh/shaded.vert", SHADERS_PATH "/Mesh/shaded.frag"}};
+
+    ThreadPool threadPool;
+    std::string meshPath;
+    if(argc > 1)
+    {
+        meshPath = argv[1];
+    }
+    else
+    {
+        meshPath = (std::filesystem::temp_directory_path() / "MeshViewer.obj").string();
+        if(!std::filesystem::exists(meshPath))
+        {
+            writeProceduralMesh(meshPath);
+        }
+    }
+
+    MeshData meshData;
+    MeshImportStats importStats;
+    std::unique_ptr<ImportedMesh> mesh;
+    std::unique_ptr<MeshletCuller> culler;
+    MeshletDrawList drawList;
+    glm::mat4 modelMatrix{1.0f};
+    const auto import = [&](ThreadPool* pool, bool generateTangents)
+    {
+        if(!importMesh(meshPath, meshData, pool, &importStats, {.generateTangents = generateTangents}))
+        {
+            return;
+        }
+        std::cout << meshPath << ": " << importStats.triangles << " triangles, " << importStats.vertices
+                  << " vertices (" << importStats.inputVertices << " before welding)\n"
+                  << "  parse " << importStats.parseSeconds * 1000.0 << " ms ("
+                  << importStats.megabytesPerSecond() << " MB/s), weld " << importStats.weldSeconds * 1000.0
+                  << " ms, tangents " << importStats.tangentSeconds * 1000.0 << " ms, total "
+                  << importStats.trianglesPerSecond() / 1.0e6 << " M triangles/s" << std::endl;
+        mesh = std::make_unique<ImportedMesh>(meshData);
+        culler = std::make_unique<MeshletCuller>(mesh->getMeshlets(), mesh->getIndexType());
+        modelMatrix = fitToUnitCube(meshData);
+    };
+    std::string cookedPath = meshPath;
+    if(!isCookedMeshPath(meshPath))
+    {
+        cookedPath = (std::filesystem::temp_directory_path() /
+                      (std::filesystem::path(meshPath).stem().string() + CookedMesh::extension))
+                         .string();
+        bool cooked = false;
+        if(cookMesh(meshPath, cookedPath, &threadPool, false, &cooked) && cooked)
+        {
+            std::cout << "Cooked " << meshPath << " -> " << cookedPath << std::endl;
+        }
+    }
+    // mapping + upload, the first run after cooking is usually served from the page cache
+    double cookedLoadSeconds = 0.0;
+    {
+        const auto start = std::chrono::steady_clock::now();
+        const CookedMesh cooked{cookedPath};
+        if(cooked.valid())
+        {
+            const CookedMeshHeader& header = cooked.getHeader();
+            mesh = std::make_unique<ImportedMesh>(cooked);
+            culler = std::make_unique<MeshletCuller>(mesh->getMeshlets(), mesh->getIndexType());
+            glFinish();
+            const std::chrono::duration<double> duration = std::chrono::steady_clock::now() - start;
+            cookedLoadSeconds = duration.count();
+            modelMatrix = fitToUnitCube(
+                {header.boundsMin[0], header.boundsMin[1], header.boundsMin[2]},
+                {header.boundsMax[0], header.boundsMax[1], header.boundsMax[2]});
+            std::cout << cookedPath << ": " << mesh->getTriangleCount() << " triangles, loaded in "
+                      << cookedLoadSeconds * 1000.0 << " ms" << std::endl;
+        }
+    }
+    if(!mesh)
+    {
+        import(&threadPool, true);
+    }
+    bool importedOnPool = true;
+    bool importTangents = true;
+    bool meshletCulling = true;
+    bool frustumCulling = true;
+    bool coneCulling = true;
+    bool automaticLod = true;
+    int forcedLod = 0;
+    float maxPixelError = 1.0f;
+    size_t currentLod = 0;
+
+    int shadingMode = 0;
+    const char* shadingModes[] = {"Shaded", "Normals", "UVs", "Tangents"}; // NOLINT
+
+    //----------------------- RENDERLOOP
+
+    // reset time to 0 before renderloop starts
+    glfwSetTime(0.0);
+    input.resetTime();
+
+    while(glfwWindowShouldClose(window) == 0)
+    {
+        ImGui::Extensions::FrameStart();
+
+        // input needs to be updated (checks for pressed buttons etc.)
+        input.update();
+        // dont update camera if UI is using user inputs
+        if(!ImGui::GetIO().WantCaptureMouse && !ImGui::GetIO().WantCaptureKeyboard)
+        {
+            cam.update();
+        }
+
+        internalFBO.bind();
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+        if(mesh)
+        {
+            meshShader.useProgram();
+            glUniformMatrix4fv(0, 1, GL_FALSE, glm::value_ptr(modelMatrix));
+            glUniformMatrix4fv(1, 1, GL_FALSE, glm::value_ptr(*cam.getView()));
+            glUniformMatrix4fv(2, 1, GL_FALSE, glm::value_ptr(*cam.getProj()));
+            glUniform1i(3, shadingMode);
+            const std::span<const MeshLod> lods = mesh->getLods();
+            currentLod = static_cast<size_t>(std::clamp(forcedLod, 0, static_cast<int>(lods.size()) - 1));
+            if(automaticLod)
+            {
+                // the mesh is scaled into the unit cube around the origin
+                const float distance = std::max(glm::length(cam.getPosition()) - 0.87f, cam.getNear());
+                const float pixelsPerUnit =
+                    projectedScale(*cam.getProj(), static_cast<float>(HEIGHT), distance) *
+                    glm::length(glm::vec3(modelMatrix[0]));
+                currentLod = selectLod(lods, pixelsPerUnit, maxPixelError);
+            }
+            // meshlets are only built for LOD 0
+            if(currentLod == 0 && meshletCulling && !mesh->getMeshlets().empty())
+            {
+                culler->cull(cam, modelMatrix, drawList, frustumCulling, coneCulling);
+                mesh->draw(drawList);
+            }
+            else
+            {
+                mesh->drawLod(currentLod);
+            }
+        }
+
+        // Post Processing (writes internal framebuffer to default framebuffer)
+        {
+            glBindFramebuffer(GL_FRAMEBUFFER, 0);
+            // overwriting full screen anyways, dont need to clear
+            glDisable(GL_DEPTH_TEST);
+            glBindTextureUnit(0, internalFBO.getColorTextures()[0].getTextureID());
+            postProcessShader.useProgram();
+            glUniform1f(0, 1.0f);
+            glUniform1i(1, 1);
+            fullScreenTri.draw();
+            glEnable(GL_DEPTH_TEST);
+        }
+
+        ImGui::Begin("Mesh Import");
+        ImGui::TextUnformatted(meshPath.c_str());
+        if(mesh)
+        {
+            ImGui::Text(
+                "Displaying %zu triangles, %zu vertices",
+                mesh->getTriangleCount(),
+                mesh->getVertexCount());
+        }
+        ImGui::Text("Cooked load + upload: %.1f ms", cookedLoadSeconds * 1000.0);
+        ImGui::Separator();
+        ImGui::Text(
+            "%zu triangles, %zu vertices (%zu before welding)",
+            importStats.triangles,
+            importStats.vertices,
+            importStats.inputVertices);
+        ImGui::Text(
+            "Parse: %.1f ms (%.1f MB/s)",
+            importStats.parseSeconds * 1000.0,
+            importStats.megabytesPerSecond());
+        ImGui::Text("Weld: %.1f ms", importStats.weldSeconds * 1000.0);
+        ImGui::Text("Tangents: %.1f ms", importStats.tangentSeconds * 1000.0);
+        ImGui::Text(
+            "Total: %.1f ms (%.2f M triangles/s)",
+            importStats.totalSeconds * 1000.0,
+            importStats.trianglesPerSecond() / 1.0e6);
+        ImGui::Checkbox("Use thread pool", &importedOnPool);
+        ImGui::Checkbox("Generate tangents", &importTangents);
+        if(ImGui::Button("Reimport"))
+        {
+            import(importedOnPool ? &threadPool : nullptr, importTangents);
+        }
+        ImGui::Combo("Display", &shadingMode, shadingModes, 4);
+        ImGui::Separator();
+        if(mesh)
+        {
+            const std::span<const MeshLod> lods = mesh->getLods();
+            ImGui::Checkbox("Automatic LOD", &automaticLod);
+            if(automaticLod)
+            {
+                ImGui::SliderFloat("Max pixel error", &maxPixelError, 0.25f, 16.0f);
+            }
+            else
+            {
+                ImGui::SliderInt("LOD", &forcedLod, 0, static_cast<int>(lods.size()) - 1);
+            }
+            ImGui::Text(
+                "LOD %zu of %zu: %u triangles, error %.5f",
+                currentLod,
+                lods.size(),
+                lods[currentLod].indexCount / 3,
+                lods[currentLod].error);
+        }
+        ImGui::Separator();
+        ImGui::Checkbox("Meshlet culling", &meshletCulling);
+        ImGui::Checkbox("Frustum", &frustumCulling);
+        ImGui::SameLine();
+        ImGui::Checkbox("Normal cones", &coneCulling);
+        if(culler && meshletCulling)
+        {
+            const MeshletCullingStats& cullingStats = culler->getStats();
+            ImGui::Text(
+                "%zu meshlets, %.1f%% culled (frustum %zu, cones %zu)",
+                cullingStats.meshlets,
+                cullingStats.cullingRate() * 100.0f,
+                cullingStats.frustumCulled,
+                cullingStats.coneCulled);
+            ImGui::Text(
+                "Submitted %.1f%% of the triangles in %zu draws",
+                cullingStats.submittedFraction() * 100.0f,
+                cullingStats.draws);
+            ImGui::Text("Culling: %.3f ms", cullingStats.seconds * 1000.0);
+        }
+        ImGui::End();
+
+        ImGui::Extensions::FrameEnd();
+
+        glfwSwapBuffers(window);
+        glfwPollEvents();
+    }
+
+    ImGui_ImplOpenGL3_Shutdown();
+    ImGui_ImplGlfw_Shutdown();
+    ImGui::DestroyContext();
+
+    glfwDestroyWindow(window);
+    glfwTerminate();
+    return 0;
+}
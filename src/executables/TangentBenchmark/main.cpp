@@ -0,0 +1,188 @@
+#include <glad/glad/glad.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <glm/gtc/constants.hpp>
+
+#include <intern/Mesh/MeshImporter.h>
+#include <intern/Mesh/TangentGeneration.h>
+#include <intern/Misc/ThreadPool.h>
+
+/*
+    Measures the throughput of generateTangents (see TangentGeneration.h) on one thread and on the
+    thread pool, and checks the generated tangents.
+    Does not need an OpenGL context.
+
+    usage: TangentBenchmark [meshes...]
+    Defaults to procedural torus knots with about 1 and 4 million triangles, whose tangents are also
+    compared to the analytic ones.
+*/
+
+// runs func until at least minSeconds passed, returns the average seconds per run
+double measure(const std::function<void()>& func, double minSeconds = 0.5)
+{
+    using Clock = std::chrono::steady_clock;
+    func(); // warmup
+    int runs = 0;
+    const auto start = Clock::now();
+    std::chrono::duration<double> elapsed{};
+    do
+    {
+        func();
+        runs++;
+        elapsed = Clock::now() - start;
+    }
+    while(elapsed.count() < minSeconds);
+    return elapsed.count() / runs;
+}
+
+// torus knot, as a grid of quads with positions, normals, uvs and the analytic tangents.
+// The vertices where the uvs wrap around are duplicated, like importers produce them for uv seams
+MeshData proceduralMesh(int segments, int sides)
+{
+    constexpr float tubeRadius = 0.12f;
+    const auto curve = [](float t)
+    {
+        const float r = 0.6f + 0.25f * std::cos(3.0f * t);
+        return glm::vec3(r * std::cos(2.0f * t), r * std::sin(2.0f * t), 0.25f * std::sin(3.0f * t));
+    };
+    // surface point at curve parameter t, angle a around the tube
+    const auto point = [&](float t, float a, glm::vec3* normalOut)
+    {
+        const glm::vec3 center = curve(t);
+        const glm::vec3 tangent = glm::normalize(curve(t + 0.001f) - center);
+        const glm::vec3 bitangent = glm::normalize(glm::cross(tangent, glm::normalize(center)));
+        const glm::vec3 normal = glm::cross(bitangent, tangent);
+        const glm::vec3 direction = normal * std::cos(a) + bitangent * std::sin(a);
+        if(normalOut != nullptr)
+        {
+            *normalOut = direction;
+        }
+        return center + direction * tubeRadius;
+    };
+    MeshData mesh;
+    mesh.vertices.reserve(static_cast<size_t>(segments + 1) * (sides + 1));
+    for(int s = 0; s <= segments; s++)
+    {
+        const float t = static_cast<float>(s) / segments * glm::two_pi<float>();
+        for(int i = 0; i <= sides; i++)
+        {
+            const float a = static_cast<float>(i) / sides * glm::two_pi<float>();
+            glm::vec3 normal;
+            const glm::vec3 position = point(t, a, &normal);
+            // direction of increasing u, which follows the curve
+            glm::vec3 tangent = point(t + 0.0001f, a, nullptr) - position;
+            tangent = glm::normalize(tangent - normal * glm::dot(normal, tangent));
+            mesh.vertices.push_back(
+                {.pos = position,
+                 .nrm = normal,
+                 .uv = {static_cast<float>(s) / segments * 16.0f, static_cast<float>(i) / sides},
+                 .tang = glm::vec4(tangent, 1.0f)});
+        }
+    }
+    mesh.indices.reserve(static_cast<size_t>(segments) * sides * 6);
+    for(int s = 0; s < segments; s++)
+    {
+        for(int i = 0; i < sides; i++)
+        {
+            const auto a = static_cast<GLuint>(s * (sides + 1) + i);
+            const auto b = static_cast<GLuint>((s + 1) * (sides + 1) + i);
+            mesh.indices.insert(mesh.indices.end(), {a, b, b + 1, a, b + 1, a + 1});
+        }
+    }
+    return mesh;
+}
+
+/* reference holds the expected tangents, or is empty if there are none */
+void benchmark(const char* name, MeshData& mesh, const std::vector<glm::vec4>& reference, ThreadPool& pool)
+{
+    const double megaTriangles = static_cast<double>(mesh.indices.size() / 3) / 1e6;
+    const double single = measure([&]() { generateTangents(mesh.vertices, mesh.indices); });
+    const double multi = measure([&]() { generateTangents(mesh.vertices, mesh.indices, &pool); });
+
+    // tangents have to be unit length and orthogonal to the normal, errors in degrees. Where the frame of
+    // the knot twists quickly the triangles are too coarse to follow it, so the average is compared
+    float orthogonalityError = 0.0f;
+    double referenceError = 0.0;
+    size_t mirrored = 0;
+    for(size_t i = 0; i < mesh.vertices.size(); i++)
+    {
+        const VertexStruct& vertex = mesh.vertices[i];
+        const glm::vec3 tangent = glm::vec3(vertex.tang);
+        const float cosine = std::abs(glm::dot(tangent, glm::normalize(vertex.nrm)));
+        orthogonalityError = std::max(orthogonalityError, glm::degrees(std::asin(std::min(cosine, 1.0f))));
+        orthogonalityError =
+            std::max(orthogonalityError, std::abs(glm::length(tangent) - 1.0f) * glm::degrees(1.0f));
+        if(!reference.empty())
+        {
+            const float angle = std::clamp(glm::dot(tangent, glm::vec3(reference[i])), -1.0f, 1.0f);
+            referenceError += glm::degrees(std::acos(angle)) / static_cast<double>(mesh.vertices.size());
+        }
+        mirrored += vertex.tang.w < 0.0f ? 1 : 0;
+    }
+
+    printf(
+        "  %-24s  %7.2f  %8.2f  %9.2f  %8.2f  %9.2f  %7.2fx  %10.3f  %12s  %8zu\n",
+        name,
+        megaTriangles,
+        single * 1000.0,
+        megaTriangles / single,
+        multi * 1000.0,
+        megaTriangles / multi,
+        single / multi,
+        orthogonalityError,
+        reference.empty() ? "-" : std::to_string(referenceError).c_str(),
+        mirrored);
+}
+
+int main(int argc, char** argv)
+{
+    ThreadPool pool;
+    printf("Tangent generation, 1 thread vs %u threads\n", pool.getThreadCount() + 1);
+    printf(
+        "  %-24s  %7s  %8s  %9s  %8s  %9s  %8s  %10s  %12s  %8s\n",
+        "mesh",
+        "MTris",
+        "1T(ms)",
+        "1T(MT/s)",
+        "MT(ms)",
+        "MT(MT/s)",
+        "speedup",
+        "ortho(deg)",
+        "avg analytic",
+        "mirrored");
+    if(argc > 1)
+    {
+        for(int i = 1; i < argc; i++)
+        {
+            MeshData mesh;
+            if(!importMesh(argv[i], mesh, &pool) || mesh.indices.empty())
+            {
+                printf("Could not load %s\n", argv[i]);
+                continue;
+            }
+            benchmark(argv[i], mesh, {}, pool);
+        }
+        return 0;
+    }
+    for(const auto& [segments, sides] : {std::pair{2048, 256}, std::pair{4096, 512}})
+    {
+        MeshData mesh = proceduralMesh(segments, sides);
+        std::vector<glm::vec4> reference(mesh.vertices.size());
+        std::transform(
+            mesh.vertices.begin(),
+            mesh.vertices.end(),
+            reference.begin(),
+            [](const VertexStruct& vertex) { return vertex.tang; });
+        const std::string name = "torus knot " + std::to_string(segments) + "x" + std::to_string(sides);
+        benchmark(name.c_str(), mesh, reference, pool);
+    }
+    return 0;
+}
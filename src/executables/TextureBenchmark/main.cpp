@@ -0,0 +1,460 @@
+#include <glad/glad/glad.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <intern/Misc/ThreadPool.h>
+#include <intern/Texture/BlockCompression.h>
+#include <intern/Texture/HDRPacking.h>
+#include <intern/Texture/Image.h>
+#include <intern/Texture/MipGenerator.h>
+#include <intern/Texture/TextureAtlas.h>
+
+/*
+    Throughput benchmarks for the CPU side texture processing. Does not need an OpenGL context.
+
+    usage: TextureBenchmark [image]
+    Defaults to the grid texture in MISC_PATH. HDR images only run the HDR packing benchmark,
+    for 8 bit images it runs on HDR texels synthesized from the image.
+*/
+
+// runs func until at least minSeconds passed, returns the average seconds per run
+double measure(const std::function<void()>& func, double minSeconds = 0.5)
+{
+    using Clock = std::chrono::steady_clock;
+    func(); // warmup
+    int runs = 0;
+    const auto start = Clock::now();
+    std::chrono::duration<double> elapsed{};
+    do
+    {
+        func();
+        runs++;
+        elapsed = Clock::now() - start;
+    }
+    while(elapsed.count() < minSeconds);
+    return elapsed.count() / runs;
+}
+
+// ------------------------------------------------------------ reference decoders, only used for the PSNR
+
+void decodeBC1(const uint8_t* block, uint8_t* rgba)
+{
+    const uint16_t c0 = block[0] | (block[1] << 8u);
+    const uint16_t c1 = block[2] | (block[3] << 8u);
+    int palette[4][3];
+    for(int i = 0; i < 2; i++)
+    {
+        const uint16_t c = i == 0 ? c0 : c1;
+        const uint32_t r = (c >> 11u) & 31u;
+        const uint32_t g = (c >> 5u) & 63u;
+        const uint32_t b = c & 31u;
+        palette[i][0] = static_cast<int>((r << 3u) | (r >> 2u));
+        palette[i][1] = static_cast<int>((g << 2u) | (g >> 4u));
+        palette[i][2] = static_cast<int>((b << 3u) | (b >> 2u));
+    }
+    for(int c = 0; c < 3; c++)
+    {
+        if(c0 > c1)
+        {
+            palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+            palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+        }
+        else
+        {
+            palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+            palette[3][c] = 0;
+        }
+    }
+    uint32_t indices = 0;
+    memcpy(&indices, block + 4, 4);
+    for(int i = 0; i < 16; i++)
+    {
+        const uint32_t index = (indices >> (2u * i)) & 3u;
+        for(int c = 0; c < 3; c++)
+        {
+            rgba[i * 4 + c] = static_cast<uint8_t>(palette[index][c]);
+        }
+    }
+}
+
+void decodeBC4(const uint8_t* block, uint8_t* rgba, int channel)
+{
+    int palette[8];
+    palette[0] = block[0];
+    palette[1] = block[1];
+    for(int i = 1; i < 7; i++)
+    {
+        palette[i + 1] = palette[0] > palette[1] ? ((7 - i) * palette[0] + i * palette[1]) / 7
+                                                 : (i < 5 ? ((5 - i) * palette[0] + i * palette[1]) / 5
+                                                          : (i == 5 ? 0 : 255));
+    }
+    uint64_t indices = 0;
+    for(int i = 0; i < 6; i++)
+    {
+        indices |= static_cast<uint64_t>(block[2 + i]) << (8u * i);
+    }
+    for(int i = 0; i < 16; i++)
+    {
+        rgba[i * 4 + channel] = static_cast<uint8_t>(palette[(indices >> (3u * i)) & 7u]);
+    }
+}
+
+void decodeBC7Mode6(const uint8_t* block, uint8_t* rgba)
+{
+    uint32_t position = 0;
+    auto read = [&](uint32_t count)
+    {
+        uint32_t value = 0;
+        for(uint32_t i = 0; i < count; i++, position++)
+        {
+            value |= ((block[position / 8] >> (position % 8)) & 1u) << i;
+        }
+        return value;
+    };
+    if(read(7) != (1u << 6u))
+    {
+        memset(rgba, 0, 64);
+        return;
+    }
+    uint32_t endpoints[2][4];
+    for(int c = 0; c < 4; c++)
+    {
+        endpoints[0][c] = read(7) << 1u;
+        endpoints[1][c] = read(7) << 1u;
+    }
+    const uint32_t p0 = read(1);
+    const uint32_t p1 = read(1);
+    constexpr uint32_t weights[16] = {0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+    for(int i = 0; i < 16; i++)
+    {
+        const uint32_t weight = weights[read(i == 0 ? 3 : 4)];
+        for(int c = 0; c < 4; c++)
+        {
+            const uint32_t a = endpoints[0][c] | p0;
+            const uint32_t b = endpoints[1][c] | p1;
+            rgba[i * 4 + c] = static_cast<uint8_t>(((64 - weight) * a + weight * b + 32) >> 6u);
+        }
+    }
+}
+
+double blockPSNR(BlockFormat format, const std::vector<uint8_t>& compressed, const Image& image)
+{
+    const int blocksX = (image.width + 3) / 4;
+    const int blocksY = (image.height + 3) / 4;
+    const int channelCount = format == BlockFormat::BC4 ? 1 : (format == BlockFormat::BC5 ? 2 : 3);
+    double squaredError = 0.0;
+    size_t samples = 0;
+    for(int by = 0; by < blocksY; by++)
+    {
+        for(int bx = 0; bx < blocksX; bx++)
+        {
+            const uint8_t* block = &compressed[(by * blocksX + bx) * blockSize(format)];
+            uint8_t decoded[64] = {};
+            switch(format)
+            {
+            case BlockFormat::BC1:
+                decodeBC1(block, decoded);
+                break;
+            case BlockFormat::BC3:
+                decodeBC1(block + 8, decoded);
+                break;
+            case BlockFormat::BC4:
+                decodeBC4(block, decoded, 0);
+                break;
+            case BlockFormat::BC5:
+                decodeBC4(block, decoded, 0);
+                decodeBC4(block + 8, decoded, 1);
+                break;
+            case BlockFormat::BC7:
+                decodeBC7Mode6(block, decoded);
+                break;
+            }
+            for(int i = 0; i < 16; i++)
+            {
+                const int x = bx * 4 + i % 4;
+                const int y = by * 4 + i / 4;
+                if(x >= image.width || y >= image.height)
+                {
+                    continue;
+                }
+                const uint8_t* source = image.pixels.get() + (y * image.width + x) * image.channels;
+                for(int c = 0; c < std::min(channelCount, image.channels); c++)
+                {
+                    const double diff = static_cast<double>(source[c]) - decoded[i * 4 + c];
+                    squaredError += diff * diff;
+                    samples++;
+                }
+            }
+        }
+    }
+    const double mse = squaredError / static_cast<double>(std::max<size_t>(samples, 1));
+    return mse == 0.0 ? INFINITY : 10.0 * std::log10(255.0 * 255.0 / mse);
+}
+
+void benchmarkBlockCompression(const Image& image, ThreadPool& pool)
+{
+    struct Entry
+    {
+        BlockFormat format;
+        const char* name;
+    };
+    constexpr Entry formats[] = {
+        {BlockFormat::BC1, "BC1"},
+        {BlockFormat::BC3, "BC3"},
+        {BlockFormat::BC4, "BC4"},
+        {BlockFormat::BC5, "BC5"},
+        {BlockFormat::BC7, "BC7"}};
+
+    printf("Block compression (%dx%d, %d channels)\n", image.width, image.height, image.channels);
+    printf("  format  ratio  PSNR(dB)  1 thread(MB/s)  %u threads(MB/s)\n", pool.getThreadCount() + 1);
+    // throughput is measured in uncompressed rgba8 bytes, the usual convention for texture encoders
+    const double megabytes = static_cast<double>(image.width) * image.height * 4 / (1024.0 * 1024.0);
+    for(const auto& entry : formats)
+    {
+        std::vector<uint8_t> compressed;
+        const auto encode = [&](ThreadPool* encodePool)
+        {
+            compressed = compressImage(
+                entry.format, image.pixels.get(), image.width, image.height, image.channels, encodePool);
+        };
+        const double single = measure([&]() { encode(nullptr); });
+        const double multi = measure([&]() { encode(&pool); });
+        printf(
+            "  %-6s  %4.1fx  %8.2f  %14.1f  %16.1f\n",
+            entry.name,
+            static_cast<double>(image.width) * image.height * 4 / static_cast<double>(compressed.size()),
+            blockPSNR(entry.format, compressed, image),
+            megabytes / single,
+            megabytes / multi);
+    }
+}
+
+void benchmarkMipGeneration(const Image& image, ThreadPool& pool)
+{
+    struct Entry
+    {
+        MipFilter filter;
+        const char* name;
+    };
+    constexpr Entry filters[] = {
+        {MipFilter::Box, "box"}, {MipFilter::Kaiser, "kaiser"}, {MipFilter::Lanczos, "lanczos"}};
+
+    printf("Mip chain generation (%dx%d, %d channels)\n", image.width, image.height, image.channels);
+    printf(
+        "  filter   space   1 thread(MTexels/s)  %u threads(MTexels/s)\n", pool.getThreadCount() + 1);
+    // throughput is measured in texels of level 0
+    const double megaTexels = static_cast<double>(image.width) * image.height / 1e6;
+    for(const auto& entry : filters)
+    {
+        for(const bool srgb : {false, true})
+        {
+            const auto generate = [&](ThreadPool* generatePool)
+            {
+                generateMipChain(
+                    image.pixels.get(),
+                    image.width,
+                    image.height,
+                    image.channels,
+                    {.filter = entry.filter, .srgb = srgb},
+                    generatePool);
+            };
+            const double single = measure([&]() { generate(nullptr); });
+            const double multi = measure([&]() { generate(&pool); });
+            printf(
+                "  %-7s  %-6s  %19.1f  %21.1f\n",
+                entry.name,
+                srgb ? "sRGB" : "linear",
+                megaTexels / single,
+                megaTexels / multi);
+        }
+    }
+}
+
+float decodeSmallFloat(uint32_t bits, int mantissaBits)
+{
+    const int exponent = static_cast<int>(bits >> mantissaBits);
+    const auto mantissa = static_cast<float>(bits & ((1u << mantissaBits) - 1u));
+    if(exponent == 0)
+    {
+        return std::ldexp(mantissa, -14 - mantissaBits);
+    }
+    return std::ldexp(1.0f + mantissa / static_cast<float>(1u << mantissaBits), exponent - 15);
+}
+
+void decodePacked(HDRStorage storage, uint32_t texel, float* rgb)
+{
+    if(storage == HDRStorage::RGB9E5)
+    {
+        const int exponent = static_cast<int>(texel >> 27u) - 15 - 9;
+        for(int c = 0; c < 3; c++)
+        {
+            rgb[c] = std::ldexp(static_cast<float>((texel >> (9u * c)) & 511u), exponent);
+        }
+        return;
+    }
+    rgb[0] = decodeSmallFloat(texel & 2047u, 6);
+    rgb[1] = decodeSmallFloat((texel >> 11u) & 2047u, 6);
+    rgb[2] = decodeSmallFloat(texel >> 22u, 5);
+}
+
+// texels is 3 channel rgb
+void benchmarkHDRPacking(const std::vector<float>& texels, ThreadPool& pool)
+{
+    struct Entry
+    {
+        HDRStorage storage;
+        const char* name;
+        decltype(&packRGB9E5) pack;
+    };
+    constexpr Entry storages[] = {
+        {HDRStorage::RGB9E5, "RGB9E5", packRGB9E5},
+        {HDRStorage::R11G11B10F, "R11G11B10F", packR11G11B10F}};
+
+    const size_t texelCount = texels.size() / 3;
+    printf("HDR packing (%zu texels, 12 -> 4 bytes per texel)\n", texelCount);
+    printf(
+        "  format      mean rel error  1 thread(MTexels/s)  %u threads(MTexels/s)\n",
+        pool.getThreadCount() + 1);
+    const double megaTexels = static_cast<double>(texelCount) / 1e6;
+    std::vector<uint32_t> packed(texelCount);
+    for(const auto& entry : storages)
+    {
+        const auto pack = [&](ThreadPool* packPool)
+        { entry.pack(texels.data(), texelCount, 3, packed.data(), packPool); };
+        const double single = measure([&]() { pack(nullptr); });
+        const double multi = measure([&]() { pack(&pool); });
+
+        // error relative to the brightest channel, the precision RGB9E5 is designed around
+        double errorSum = 0.0;
+        for(size_t i = 0; i < texelCount; i++)
+        {
+            const float* original = &texels[i * 3];
+            float decoded[3];
+            decodePacked(entry.storage, packed[i], decoded);
+            const float maxChannel = std::max({original[0], original[1], original[2], 1e-6f});
+            for(int c = 0; c < 3; c++)
+            {
+                errorSum += std::abs(decoded[c] - original[c]) / maxChannel / 3.0;
+            }
+        }
+        printf(
+            "  %-10s  %14.5f  %19.1f  %21.1f\n",
+            entry.name,
+            errorSum / static_cast<double>(texelCount),
+            megaTexels / single,
+            megaTexels / multi);
+    }
+}
+
+// count sprites of random sizes (16 to 256 texels per side) cut out of the image
+std::vector<Image> atlasSprites(const Image& image, int count)
+{
+    std::mt19937 random{1234};
+    std::uniform_int_distribution<int> sizeDistribution{16, 256};
+    std::vector<Image> sprites(count);
+    for(Image& sprite : sprites)
+    {
+        sprite.width = sizeDistribution(random);
+        sprite.height = sizeDistribution(random);
+        sprite.channels = image.channels;
+        // Image frees its pixels with stbi_image_free, which is free()
+        sprite.pixels.reset(static_cast<uint8_t*>(malloc(sprite.byteSize())));
+        const int startX = static_cast<int>(random() % image.width);
+        const int startY = static_cast<int>(random() % image.height);
+        for(int y = 0; y < sprite.height; y++)
+        {
+            for(int x = 0; x < sprite.width; x++)
+            {
+                const size_t source = static_cast<size_t>((startY + y) % image.height) * image.width +
+                                      (startX + x) % image.width;
+                memcpy(
+                    sprite.pixels.get() + (static_cast<size_t>(y) * sprite.width + x) * image.channels,
+                    image.pixels.get() + source * image.channels,
+                    image.channels);
+            }
+        }
+    }
+    return sprites;
+}
+
+void benchmarkAtlasPacking(const Image& image, ThreadPool& pool)
+{
+    printf("Atlas packing (sprites of 16 to 256 texels, 4 levels)\n");
+    printf(
+        "  sprites  mode    size            efficiency  pack(ms)  build 1 thread(ms)  %u threads(ms)\n",
+        pool.getThreadCount() + 1);
+    for(const int count : {64, 512, 2048})
+    {
+        const std::vector<Image> sprites = atlasSprites(image, count);
+        for(const bool array : {false, true})
+        {
+            const AtlasSettings settings{.array = array, .maxSize = array ? 2048 : 16384};
+            const PackedAtlas single = packAtlas(sprites, settings);
+            const PackedAtlas multi = packAtlas(sprites, settings, &pool);
+            if(!single.valid())
+            {
+                printf("  %7d  %-6s  does not fit\n", count, array ? "array" : "single");
+                continue;
+            }
+            char size[32];
+            snprintf(size, sizeof(size), "%dx%dx%d", single.width, single.height, single.layers);
+            printf(
+                "  %7d  %-6s  %-14s  %9.1f%%  %8.2f  %18.1f  %14.1f\n",
+                count,
+                array ? "array" : "single",
+                size,
+                single.stats.efficiency * 100.0f,
+                single.stats.packMs,
+                single.stats.buildMs,
+                multi.stats.buildMs);
+        }
+    }
+}
+
+// rgb float texels of an HDR image, or values spanning 2^-8 to 2^8 derived from an 8 bit one
+std::vector<float> hdrTexels(const Image& image)
+{
+    std::vector<float> texels(static_cast<size_t>(image.width) * image.height * 3, 0.0f);
+    for(size_t i = 0; i < texels.size() / 3; i++)
+    {
+        for(int c = 0; c < std::min(image.channels, 3); c++)
+        {
+            const size_t index = i * image.channels + c;
+            texels[i * 3 + c] =
+                image.isHdr
+                    ? reinterpret_cast<const float*>(image.pixels.get())[index]
+                    : std::exp2(16.0f * static_cast<float>(image.pixels.get()[index]) / 255.0f - 8.0f);
+        }
+    }
+    return texels;
+}
+
+int main(int argc, char** argv)
+{
+    const std::string file = argc > 1 ? argv[1] : MISC_PATH "/GridTexture.png";
+    const Image image = loadImage(file);
+    if(!image.valid())
+    {
+        printf("Could not load %s\n", file.c_str());
+        return 1;
+    }
+
+    ThreadPool pool;
+    if(!image.isHdr)
+    {
+        benchmarkBlockCompression(image, pool);
+        benchmarkMipGeneration(image, pool);
+        benchmarkAtlasPacking(image, pool);
+    }
+    benchmarkHDRPacking(hdrTexels(image), pool);
+    return 0;
+}
@@ -0,0 +1,308 @@
+#include <glad/glad/glad.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <intern/Misc/ThreadPool.h>
+#include <intern/Texture/BlockCompression.h>
+#include <intern/Texture/CookedTexture.h>
+#include <intern/Texture/HDRPacking.h>
+#include <intern/Texture/Image.h>
+#include <intern/Texture/MipGenerator.h>
+
+/*
+    Converts images into the cooked texture format (see CookedTexture.h), including the full mip chain.
+    Does not need an OpenGL context.
+
+    usage: TextureCooker [--no-mips] [--force] [--format bc1|bc3|bc4|bc5|bc7] [--srgb]
+                         [--hdr rgb9e5|r11g11b10f|float] [--filter box|kaiser|lanczos]
+                         [-o <output folder>] [images...]
+    Without any images all pngs and hdrs in MISC_PATH are cooked. Output files are written next to
+    the input unless an output folder is given. Up to date outputs are skipped unless --force is passed.
+    --format block compresses every level. --srgb marks the texture as sRGB: mips are filtered in linear
+    space and the sRGB variant of the (compressed) format is used. It is ignored (with a warning) for images
+    without such a format, ie. uncompressed 1 and 2 channel images and bc4/bc5.
+    --hdr picks the storage of HDR images (rgb9e5 by default), those are never block compressed.
+    --filter picks the mip filter (box by default), see MipGenerator.h
+*/
+
+namespace fs = std::filesystem;
+
+struct CookSettings
+{
+    bool mipMaps = true;
+    bool force = false;
+    std::optional<BlockFormat> blockFormat;
+    bool srgb = false;
+    HDRStorage hdrStorage = HDRStorage::RGB9E5;
+    MipFilter mipFilter = MipFilter::Box;
+    fs::path outputFolder;
+};
+
+std::optional<BlockFormat> parseBlockFormat(const std::string& name)
+{
+    constexpr std::pair<const char*, BlockFormat> formats[] = {
+        {"bc1", BlockFormat::BC1},
+        {"bc3", BlockFormat::BC3},
+        {"bc4", BlockFormat::BC4},
+        {"bc5", BlockFormat::BC5},
+        {"bc7", BlockFormat::BC7}};
+    for(const auto& [formatName, format] : formats)
+    {
+        if(name == formatName)
+        {
+            return format;
+        }
+    }
+    return std::nullopt;
+}
+
+std::optional<HDRStorage> parseHDRStorage(const std::string& name)
+{
+    constexpr std::pair<const char*, HDRStorage> storages[] = {
+        {"rgb9e5", HDRStorage::RGB9E5},
+        {"r11g11b10f", HDRStorage::R11G11B10F},
+        {"float", HDRStorage::Float32}};
+    for(const auto& [storageName, storage] : storages)
+    {
+        if(name == storageName)
+        {
+            return storage;
+        }
+    }
+    return std::nullopt;
+}
+
+std::optional<MipFilter> parseMipFilter(const std::string& name)
+{
+    constexpr std::pair<const char*, MipFilter> filters[] = {
+        {"box", MipFilter::Box}, {"kaiser", MipFilter::Kaiser}, {"lanczos", MipFilter::Lanczos}};
+    for(const auto& [filterName, filter] : filters)
+    {
+        if(name == filterName)
+        {
+            return filter;
+        }
+    }
+    return std::nullopt;
+}
+
+// uncompressed sRGB formats only exist for 3 and 4 channels
+GLenum ldrInternalFormat(const Image& image, bool srgb)
+{
+    if(srgb && image.channels >= 3)
+    {
+        return image.channels == 3 ? GL_SRGB8 : GL_SRGB8_ALPHA8;
+    }
+    return image.internalFormat();
+}
+
+// only BC4 and BC5 lack an sRGB variant, uncompressed see ldrInternalFormat
+bool hasSRGBFormat(const Image& image, const std::optional<BlockFormat>& blockFormat)
+{
+    if(blockFormat.has_value())
+    {
+        return *blockFormat != BlockFormat::BC4 && *blockFormat != BlockFormat::BC5;
+    }
+    return image.channels >= 3;
+}
+
+bool cookFile(const fs::path& input, const fs::path& output, const CookSettings& settings, ThreadPool& pool)
+{
+    // cooked textures are stored bottom row first, just like Texture(file) uploads them
+    const Image image = loadImage(input.string());
+    if(!image.valid())
+    {
+        return false;
+    }
+    if(image.isHdr)
+    {
+        const CookedTextureHeader header{
+            .internalFormat = hdrInternalFormat(settings.hdrStorage, image.channels),
+            .dataFormat = hdrDataFormat(settings.hdrStorage, image.channels),
+            .dataType = hdrDataType(settings.hdrStorage),
+            .width = static_cast<uint32_t>(image.width),
+            .height = static_cast<uint32_t>(image.height)};
+        return writeCookedTexture(
+            output.string(),
+            header,
+            buildHDRLevels(image, settings.hdrStorage, settings.mipMaps, &pool, settings.mipFilter));
+    }
+
+    // filtering in linear space is only correct if the texture is actually sampled as sRGB
+    const bool srgb = settings.srgb && hasSRGBFormat(image, settings.blockFormat);
+    if(settings.srgb && !srgb)
+    {
+        printf("%s has no sRGB format, ignoring --srgb\n", input.string().c_str());
+    }
+
+    std::vector<std::vector<uint8_t>> levels;
+    if(settings.mipMaps)
+    {
+        levels = generateMipChain(
+            image.pixels.get(),
+            image.width,
+            image.height,
+            image.channels,
+            {.filter = settings.mipFilter, .srgb = srgb},
+            &pool);
+    }
+    else
+    {
+        levels.emplace_back(image.pixels.get(), image.pixels.get() + image.byteSize());
+    }
+    const int levelCount = static_cast<int>(levels.size());
+
+    CookedTextureHeader header{
+        .internalFormat = ldrInternalFormat(image, srgb),
+        .dataFormat = image.dataFormat(),
+        .dataType = image.dataType(),
+        .width = static_cast<uint32_t>(image.width),
+        .height = static_cast<uint32_t>(image.height)};
+
+    if(settings.blockFormat.has_value())
+    {
+        for(int level = 0; level < levelCount; level++)
+        {
+            levels[level] = compressImage(
+                *settings.blockFormat,
+                levels[level].data(),
+                std::max(image.width >> level, 1),
+                std::max(image.height >> level, 1),
+                image.channels,
+                &pool);
+        }
+        // compressed levels are marked by a dataFormat and dataType of 0
+        header.internalFormat = blockFormatToGL(*settings.blockFormat, srgb);
+        header.dataFormat = 0;
+        header.dataType = 0;
+    }
+    return writeCookedTexture(output.string(), header, levels);
+}
+
+int main(int argc, char** argv)
+{
+    CookSettings settings;
+    std::vector<fs::path> inputs;
+    for(int i = 1; i < argc; i++)
+    {
+        const std::string arg = argv[i];
+        if(arg == "--no-mips")
+        {
+            settings.mipMaps = false;
+        }
+        else if(arg == "--force")
+        {
+            settings.force = true;
+        }
+        else if(arg == "--format" && i + 1 < argc)
+        {
+            settings.blockFormat = parseBlockFormat(argv[++i]);
+            if(!settings.blockFormat.has_value())
+            {
+                printf("Unknown block format %s\n", argv[i]);
+                return 1;
+            }
+        }
+        else if(arg == "--hdr" && i + 1 < argc)
+        {
+            const std::optional<HDRStorage> storage = parseHDRStorage(argv[++i]);
+            if(!storage.has_value())
+            {
+                printf("Unknown hdr storage %s\n", argv[i]);
+                return 1;
+            }
+            settings.hdrStorage = *storage;
+        }
+        else if(arg == "--filter" && i + 1 < argc)
+        {
+            const std::optional<MipFilter> filter = parseMipFilter(argv[++i]);
+            if(!filter.has_value())
+            {
+                printf("Unknown mip filter %s\n", argv[i]);
+                return 1;
+            }
+            settings.mipFilter = *filter;
+        }
+        else if(arg == "--srgb")
+        {
+            settings.srgb = true;
+        }
+        else if(arg == "-o" && i + 1 < argc)
+        {
+            settings.outputFolder = argv[++i];
+        }
+        else
+        {
+            inputs.emplace_back(arg);
+        }
+    }
+    if(inputs.empty())
+    {
+        for(const auto& entry : fs::directory_iterator(MISC_PATH))
+        {
+            if(entry.is_regular_file() &&
+               (entry.path().extension() == ".png" || entry.path().extension() == ".hdr"))
+            {
+                inputs.push_back(entry.path());
+            }
+        }
+    }
+    if(!settings.outputFolder.empty())
+    {
+        fs::create_directories(settings.outputFolder);
+    }
+
+    std::atomic<int> cooked = 0;
+    std::atomic<int> skipped = 0;
+    std::atomic<int> failed = 0;
+    const auto start = std::chrono::steady_clock::now();
+    {
+        ThreadPool pool;
+        pool.parallelFor(
+            inputs.size(),
+            1,
+            [&](size_t begin, size_t end)
+            {
+                for(size_t i = begin; i < end; i++)
+                {
+                    const fs::path& input = inputs[i];
+                    fs::path output = settings.outputFolder.empty() ? input.parent_path()
+                                                                    : settings.outputFolder;
+                    output /= input.stem();
+                    output += CookedTexture::extension;
+
+                    std::error_code ec;
+                    if(!settings.force && fs::exists(output, ec) &&
+                       fs::last_write_time(output, ec) >= fs::last_write_time(input, ec))
+                    {
+                        skipped++;
+                        continue;
+                    }
+                    if(cookFile(input, output, settings, pool))
+                    {
+                        printf("Cooked %s -> %s\n", input.string().c_str(), output.string().c_str());
+                        cooked++;
+                    }
+                    else
+                    {
+                        failed++;
+                    }
+                }
+            });
+    }
+    const std::chrono::duration<double> duration = std::chrono::steady_clock::now() - start;
+    printf(
+        "%d cooked, %d up to date, %d failed (%.2fs)\n",
+        cooked.load(),
+        skipped.load(),
+        failed.load(),
+        duration.count());
+    return failed > 0 ? 1 : 0;
+}
@@ -1,5 +1,12 @@
 #include <glad/glad/glad.h>
 
+#include <array>
+#include <cstring>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <vector>
+
 #include <GLFW/glfw3.h>
 
 #include <glm/gtx/transform.hpp>
@@ -8,15 +15,24 @@
 #include <ImGui/imgui_impl_glfw.h>
 #include <ImGui/imgui_impl_opengl3.h>
 
+#include <stb/stb_image_write.h>
+
+#include <intern/Buffer/ReadbackQueue.h>
 #include <intern/Camera/Camera.h>
 #include <intern/Context/Context.h>
 #include <intern/Framebuffer/Framebuffer.h>
+#include <intern/Framebuffer/RenderTargetPool.h>
 #include <intern/InputManager/InputManager.h>
 #include <intern/Mesh/Cube.h>
 #include <intern/Mesh/FullscreenTri.h>
+#include <intern/Misc/GPUMemoryTracker.h>
 #include <intern/Misc/ImGuiExtensions.h>
 #include <intern/Misc/OpenGLErrorHandler.h>
+#include <intern/Misc/ThreadPool.h>
 #include <intern/ShaderProgram/ShaderProgram.h>
+#include <intern/Texture/SamplerCache.h>
+#include <intern/Texture/TextureCache.h>
+#include <intern/Texture/TextureLoader.h>
 #include <intern/Window/Window.h>
 
 int main()
@@ -77,7 +93,10 @@ int main()
         VERTEX_SHADER_BIT | FRAGMENT_SHADER_BIT,
         {SHADERS_PATH "/General/screenQuad.vert", SHADERS_PATH "/General/hdrTonemapSimple.frag"}};
 
-    Framebuffer internalFBO{WIDTH, HEIGHT, {GL_RGBA16F}, true};
+    // the framebuffer is recreated on resize, the pool recycles the attachments when resizing back and forth
+    RenderTargetPool renderTargetPool;
+    std::optional<Framebuffer> internalFBO;
+    internalFBO.emplace(WIDTH, HEIGHT, std::initializer_list<GLenum>{GL_RGBA16F}, true, &renderTargetPool);
 
     // todo: not sure if I want the ctx.setXXX() functions to be part of the constructors
     //       any occasions where it would be undesirable?
@@ -89,7 +108,36 @@ int main()
         VERTEX_SHADER_BIT | FRAGMENT_SHADER_BIT,
         {SHADERS_PATH "/General/simpleTexture.vert", SHADERS_PATH "/General/simpleTexture.frag"}};
 
-    const Texture gridTexture{MISC_PATH "/GridTexture.png", true};
+    // decodes on the pool, placeholder is bound until the upload finished
+    ThreadPool threadPool;
+    TextureLoader textureLoader{threadPool};
+    // loading the same file again elsewhere returns the same texture
+    TextureCache textureCache{textureLoader};
+    const auto gridTexture = textureCache.load(MISC_PATH "/GridTexture.png", true);
+
+    // the same texture can be sampled in different ways without duplicating it
+    SamplerCache samplerCache;
+    const std::array<const char*, 3> samplingNames{"Nearest", "Trilinear", "Anisotropic"};
+    const std::array<SamplerDesc, 3> samplingModes{
+        SamplerDesc{.minFilter = GL_NEAREST_MIPMAP_NEAREST, .magFilter = GL_NEAREST},
+        SamplerDesc{},
+        SamplerDesc{.maxAnisotropy = 16.0f}};
+    int samplingMode = 2;
+
+    // screenshots and the depth under the cursor are read back without stalling the frame
+    ReadbackQueue readbackQueue{64 * 1024 * 1024, "Readback"};
+    bool takeScreenshot = false;
+    int screenshotCount = 0;
+    // OpenGL returns the bottom row first
+    stbi_flip_vertically_on_write(1);
+    float cursorDepth = 1.0f;
+    glm::vec3 cursorPosition{0.0f};
+
+    // the callback is called from within allocations, so only note it and free cached memory between frames
+    bool overBudget = false;
+    GPUMemoryTracker::get().setTotalBudget(
+        256 * 1024 * 1024, [&](GPUMemoryCategory /*category*/, size_t /*used*/, size_t /*budget*/)
+        { overBudget = true; });
 
     //----------------------- RENDERLOOP
 
@@ -101,6 +149,16 @@ int main()
     {
         ImGui::Extensions::FrameStart();
 
+        textureLoader.update();
+        textureCache.update();
+        readbackQueue.update();
+        if(overBudget)
+        {
+            textureCache.purge();
+            renderTargetPool.clear();
+            overBudget = false;
+        }
+
         // input needs to be updated (checks for pressed buttons etc.)
         input.update();
         // dont update camera if UI is using user inputs
@@ -111,23 +169,66 @@ int main()
 
         auto currentTime = static_cast<float>(input.getSimulationTime());
 
-        internalFBO.bind();
+        int newWidth = WIDTH;
+        int newHeight = HEIGHT;
+        glfwGetFramebufferSize(window, &newWidth, &newHeight);
+        // minimized windows report a size of 0
+        if((newWidth != WIDTH || newHeight != HEIGHT) && newWidth > 0 && newHeight > 0)
+        {
+            WIDTH = newWidth;
+            HEIGHT = newHeight;
+            internalFBO.reset();
+            internalFBO.emplace(
+                WIDTH, HEIGHT, std::initializer_list<GLenum>{GL_RGBA16F}, true, &renderTargetPool);
+            cam.setAspect(static_cast<float>(WIDTH) / static_cast<float>(HEIGHT));
+        }
+
+        internalFBO->bind();
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
         // Draw into internal framebuffer
         simpleShader.useProgram();
-        glBindTextureUnit(0, gridTexture.getTextureID());
+        glBindTextureUnit(0, gridTexture->getTextureID());
+        samplerCache.bind(0, samplingModes[samplingMode]);
         glUniformMatrix4fv(0, 1, GL_FALSE, glm::value_ptr(glm::mat4{1.0f}));
         glUniformMatrix4fv(1, 1, GL_FALSE, glm::value_ptr(*cam.getView()));
         glUniformMatrix4fv(2, 1, GL_FALSE, glm::value_ptr(*cam.getProj()));
         cube.draw();
+        // the post processing samples its input with the textures own parameters
+        SamplerCache::unbind(0);
+
+        // depth under the cursor arrives a few frames late, so it is unprojected with the matrices of the
+        // frame it was rendered in
+        const ImVec2 mouse{
+            ImGui::GetIO().MousePos.x * ImGui::GetIO().DisplayFramebufferScale.x,
+            ImGui::GetIO().MousePos.y * ImGui::GetIO().DisplayFramebufferScale.y};
+        const int cursorX = static_cast<int>(mouse.x);
+        const int cursorY = HEIGHT - 1 - static_cast<int>(mouse.y);
+        if(cursorX >= 0 && cursorX < WIDTH && cursorY >= 0 && cursorY < HEIGHT)
+        {
+            readbackQueue.readDepth(
+                *internalFBO,
+                [&, viewProjInverse = glm::inverse(*cam.getProj() * *cam.getView()), cursorX, cursorY,
+                 width = WIDTH, height = HEIGHT](const ReadbackResult& result)
+                {
+                    memcpy(&cursorDepth, result.data.data(), sizeof(float));
+                    const glm::vec4 ndc{
+                        (static_cast<float>(cursorX) + 0.5f) / static_cast<float>(width) * 2.0f - 1.0f,
+                        (static_cast<float>(cursorY) + 0.5f) / static_cast<float>(height) * 2.0f - 1.0f,
+                        cursorDepth * 2.0f - 1.0f,
+                        1.0f};
+                    const glm::vec4 world = viewProjInverse * ndc;
+                    cursorPosition = glm::vec3(world) / world.w;
+                },
+                {.x = cursorX, .y = cursorY, .width = 1, .height = 1});
+        }
 
         // Post Processing (writes internal framebuffer to default framebuffer)
         {
             glBindFramebuffer(GL_FRAMEBUFFER, 0);
             // overwriting full screen anyways, dont need to clear
             glDisable(GL_DEPTH_TEST);
-            glBindTextureUnit(0, internalFBO.getColorTextures()[0].getTextureID());
+            glBindTextureUnit(0, internalFBO->getColorTextures()[0].getTextureID());
             postProcessShader.useProgram();
             glUniform1f(0, 1.0f);
             glUniform1i(1, 1);
@@ -135,15 +236,85 @@ int main()
             glEnable(GL_DEPTH_TEST);
         }
 
+        const RenderTargetPool::Stats& poolStats = renderTargetPool.getStats();
+        ImGui::Begin("Render targets");
+        ImGui::Text("Hits: %zu Misses: %zu Freed: %zu", poolStats.hits, poolStats.misses, poolStats.freed);
+        ImGui::Text(
+            "In use: %zu Pooled: %zu (%.1f MB)",
+            poolStats.acquired,
+            poolStats.available,
+            static_cast<float>(poolStats.bytes) / (1024.0f * 1024.0f));
+        ImGui::End();
+        renderTargetPool.endFrame();
+
+        ImGui::Extensions::GPUMemoryWindow();
+
+        const ReadbackQueue::Stats& readbackStats = readbackQueue.getStats();
+        ImGui::Begin("Sampling");
+        ImGui::Combo(
+            "Grid texture", &samplingMode, samplingNames.data(), static_cast<int>(samplingNames.size()));
+        ImGui::Text("Max anisotropy: %.0f", samplerCache.getMaxSupportedAnisotropy());
+        ImGui::End();
+
+        ImGui::Begin("Readback");
+        if(cursorDepth < 1.0f)
+        {
+            ImGui::Text(
+                "Under cursor: %.2f %.2f %.2f", cursorPosition.x, cursorPosition.y, cursorPosition.z);
+        }
+        else
+        {
+            ImGui::Text("Under cursor: background");
+        }
+        takeScreenshot = ImGui::Button("Screenshot");
+        ImGui::Text(
+            "Pending: %zu (%.1f KB) Rejected: %zu",
+            readbackStats.pending,
+            static_cast<float>(readbackStats.pendingBytes) / 1024.0f,
+            readbackStats.rejected);
+        ImGui::End();
+
         // sRGB is broken in Dear ImGui
         //  glDisable(GL_FRAMEBUFFER_SRGB);
         ImGui::Extensions::FrameEnd();
         // glEnable(GL_FRAMEBUFFER_SRGB);
 
+        if(takeScreenshot)
+        {
+            // includes the UI, the png is written on the pool
+            const std::string name = "screenshot" + std::to_string(screenshotCount++) + ".png";
+            const std::string file = (std::filesystem::current_path() / name).string();
+            readbackQueue.readDefaultFramebuffer(
+                0,
+                0,
+                WIDTH,
+                HEIGHT,
+                GL_RGBA,
+                GL_UNSIGNED_BYTE,
+                [&threadPool, file](const ReadbackResult& result)
+                {
+                    threadPool.enqueue(
+                        [file,
+                         width = result.width,
+                         height = result.height,
+                         pixels = std::vector<uint8_t>(result.data.begin(), result.data.end())]()
+                        {
+                            stbi_write_png(file.c_str(), width, height, 4, pixels.data(), width * 4);
+                            std::cout << "Saved " << file << std::endl;
+                        });
+                });
+        }
+
         glfwSwapBuffers(window);
         glfwPollEvents();
     }
 
+    // screenshots that are still in flight are written before the pool shuts down
+    readbackQueue.flush();
+
+    // hand the attachments back before the pool is destroyed
+    internalFBO.reset();
+
     ImGui_ImplOpenGL3_Shutdown();
     ImGui_ImplGlfw_Shutdown();
     ImGui::DestroyContext();
@@ -0,0 +1,300 @@
+#include <glad/glad/glad.h>
+
+#include <GLFW/glfw3.h>
+
+#include <glm/gtx/transform.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include <intern/Framebuffer/Framebuffer.h>
+#include <intern/Mesh/MeshImporter.h>
+#include <intern/Mesh/VertexQuantization.h>
+#include <intern/Misc/GPUTimer.h>
+#include <intern/Misc/OpenGLErrorHandler.h>
+#include <intern/Misc/ThreadPool.h>
+#include <intern/ShaderProgram/ShaderProgram.h>
+#include <intern/Window/Window.h>
+
+/*
+    Compares the vertex formats of VertexQuantization.h: conversion throughput and precision on the CPU,
+    and draw throughput on the GPU.
+
+    usage: VertexFormatBenchmark [mesh]
+    Defaults to a procedural torus knot with about 2 million triangles. The mesh is drawn repeatedly into
+    a small offscreen framebuffer, all but the first draw fail the depth test, so the timings are
+    dominated by vertex fetch and shading.
+*/
+
+constexpr int drawsPerFrame = 16;
+constexpr uint8_t timedFrames = 64;
+
+// runs func until at least minSeconds passed, returns the average seconds per run
+double measure(const std::function<void()>& func, double minSeconds = 0.5)
+{
+    using Clock = std::chrono::steady_clock;
+    func(); // warmup
+    int runs = 0;
+    const auto start = Clock::now();
+    std::chrono::duration<double> elapsed{};
+    do
+    {
+        func();
+        runs++;
+        elapsed = Clock::now() - start;
+    }
+    while(elapsed.count() < minSeconds);
+    return elapsed.count() / runs;
+}
+
+// torus knot, as a grid of quads with positions, normals, uvs and tangents
+MeshData proceduralMesh(int segments, int sides)
+{
+    constexpr float tubeRadius = 0.12f;
+    const auto curve = [](float t)
+    {
+        const float r = 0.6f + 0.25f * std::cos(3.0f * t);
+        return glm::vec3(r * std::cos(2.0f * t), r * std::sin(2.0f * t), 0.25f * std::sin(3.0f * t));
+    };
+    MeshData mesh;
+    mesh.vertices.reserve(static_cast<size_t>(segments) * sides);
+    for(int s = 0; s < segments; s++)
+    {
+        const float t = static_cast<float>(s) / segments * glm::two_pi<float>();
+        const glm::vec3 center = curve(t);
+        const glm::vec3 tangent = glm::normalize(curve(t + 0.001f) - center);
+        const glm::vec3 bitangent = glm::normalize(glm::cross(tangent, glm::normalize(center)));
+        const glm::vec3 normal = glm::cross(bitangent, tangent);
+        for(int i = 0; i < sides; i++)
+        {
+            const float a = static_cast<float>(i) / sides * glm::two_pi<float>();
+            const glm::vec3 direction = normal * std::cos(a) + bitangent * std::sin(a);
+            mesh.vertices.push_back(
+                {.pos = center + direction * tubeRadius,
+                 .nrm = direction,
+                 .uv = {static_cast<float>(s) / segments * 16.0f, static_cast<float>(i) / sides},
+                 .tang = glm::vec4(tangent, 1.0f)});
+        }
+    }
+    mesh.indices.reserve(static_cast<size_t>(segments) * sides * 6);
+    for(int s = 0; s < segments; s++)
+    {
+        for(int i = 0; i < sides; i++)
+        {
+            // wrapping around in both directions
+            const auto a = static_cast<GLuint>(s * sides + i);
+            const auto b = static_cast<GLuint>(((s + 1) % segments) * sides + i);
+            const auto c = static_cast<GLuint>(((s + 1) % segments) * sides + (i + 1) % sides);
+            const auto d = static_cast<GLuint>(s * sides + (i + 1) % sides);
+            mesh.indices.insert(mesh.indices.end(), {a, b, c, a, c, d});
+        }
+    }
+    return mesh;
+}
+
+// ------------------------------------------------------------ reference decoders, only used for the errors
+
+float halfToFloat(uint16_t half)
+{
+    const int exponent = (half >> 10u) & 31u;
+    const auto mantissa = static_cast<float>(half & 1023u);
+    const float magnitude =
+        exponent == 0 ? std::ldexp(mantissa, -24) : std::ldexp(1.0f + mantissa / 1024.0f, exponent - 15);
+    return (half & 0x8000u) != 0 ? -magnitude : magnitude;
+}
+
+glm::vec3 octDecode(float u, float v)
+{
+    glm::vec3 n{u, v, 1.0f - std::abs(u) - std::abs(v)};
+    if(n.z < 0.0f)
+    {
+        n.x = (1.0f - std::abs(v)) * (u >= 0.0f ? 1.0f : -1.0f);
+        n.y = (1.0f - std::abs(u)) * (v >= 0.0f ? 1.0f : -1.0f);
+    }
+    return glm::normalize(n);
+}
+
+// position in [0, 1] and normal of vertex i, as the vertex shader would see them
+void decodeVertex(
+    VertexFormat format, const std::vector<uint8_t>& data, size_t i, glm::vec3& position, glm::vec3& normal)
+{
+    if(format == VertexFormat::Half)
+    {
+        HalfVertex vertex;
+        memcpy(&vertex, &data[i * sizeof(HalfVertex)], sizeof(HalfVertex));
+        position = {halfToFloat(vertex.pos[0]), halfToFloat(vertex.pos[1]), halfToFloat(vertex.pos[2])};
+        normal = octDecode(
+            std::max(vertex.nrm[0] / 32767.0f, -1.0f), std::max(vertex.nrm[1] / 32767.0f, -1.0f));
+        return;
+    }
+    QuantizedVertex vertex;
+    memcpy(&vertex, &data[i * sizeof(QuantizedVertex)], sizeof(QuantizedVertex));
+    position = glm::vec3(vertex.pos[0], vertex.pos[1], vertex.pos[2]) / 65535.0f;
+    normal = octDecode(std::max(vertex.nrm[0] / 127.0f, -1.0f), std::max(vertex.nrm[1] / 127.0f, -1.0f));
+}
+
+void benchmarkConversion(const MeshData& mesh, ThreadPool& pool)
+{
+    printf("Conversion (%zu vertices)\n", mesh.vertices.size());
+    printf(
+        "  format     bytes  max pos error  max normal error(deg)  "
+        "1 thread(MVerts/s)  %u threads(MVerts/s)\n",
+        pool.getThreadCount() + 1);
+    const double megaVertices = static_cast<double>(mesh.vertices.size()) / 1e6;
+    for(const auto& [format, name] :
+        {std::pair{VertexFormat::Half, "Half"}, std::pair{VertexFormat::Quantized, "Quantized"}})
+    {
+        glm::mat4 decode;
+        std::vector<uint8_t> data;
+        const auto convert = [&](ThreadPool* convertPool)
+        { data = quantizeVertices(mesh.vertices, format, &decode, convertPool); };
+        const double single = measure([&]() { convert(nullptr); });
+        const double multi = measure([&]() { convert(&pool); });
+
+        // position error relative to the largest extent of the bounds, normal error in degrees
+        const float extent = std::max({decode[0][0], decode[1][1], decode[2][2], 1e-6f});
+        float positionError = 0.0f;
+        float normalError = 0.0f;
+        for(size_t i = 0; i < mesh.vertices.size(); i++)
+        {
+            glm::vec3 position;
+            glm::vec3 normal;
+            decodeVertex(format, data, i, position, normal);
+            const glm::vec3 decoded = glm::vec3(decode * glm::vec4(position, 1.0f));
+            positionError = std::max(positionError, glm::length(decoded - mesh.vertices[i].pos) / extent);
+            const float cosine = std::clamp(glm::dot(normal, mesh.vertices[i].nrm), -1.0f, 1.0f);
+            normalError = std::max(normalError, glm::degrees(std::acos(cosine)));
+        }
+        printf(
+            "  %-9s  %5zu  %13.2e  %21.3f  %18.1f  %20.1f\n",
+            name,
+            vertexFormatSize(format),
+            positionError,
+            normalError,
+            megaVertices / single,
+            megaVertices / multi);
+    }
+}
+
+void benchmarkDraw(const MeshData& mesh)
+{
+    constexpr int width = 256;
+    constexpr int height = 256;
+    Framebuffer framebuffer{width, height, {GL_RGBA8}, true};
+    ShaderProgram fullShader{
+        VERTEX_SHADER_BIT | FRAGMENT_SHADER_BIT,
+        {SHADERS_PATH "/Mesh/shaded.vert", SHADERS_PATH "/Mesh/shaded.frag"}};
+    ShaderProgram quantizedShader{
+        VERTEX_SHADER_BIT | FRAGMENT_SHADER_BIT,
+        {SHADERS_PATH "/Mesh/shadedQuantized.vert", SHADERS_PATH "/Mesh/shaded.frag"}};
+
+    // fit the mesh into the view
+    glm::vec3 minimum = mesh.vertices[0].pos;
+    glm::vec3 maximum = mesh.vertices[0].pos;
+    for(const VertexStruct& vertex : mesh.vertices)
+    {
+        minimum = glm::min(minimum, vertex.pos);
+        maximum = glm::max(maximum, vertex.pos);
+    }
+    const glm::vec3 extent = maximum - minimum;
+    const float scale = 1.0f / std::max({extent.x, extent.y, extent.z, 1e-6f});
+    const glm::mat4 model = glm::scale(glm::vec3(scale)) * glm::translate(-(minimum + maximum) * 0.5f);
+    const glm::mat4 view =
+        glm::lookAt(glm::vec3(0.0f, 0.6f, 1.4f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    const glm::mat4 projection = glm::perspective(glm::radians(60.0f), 1.0f, 0.1f, 10.0f);
+
+    const double megaTriangles = static_cast<double>(mesh.indices.size() / 3 * drawsPerFrame) / 1e6;
+    printf(
+        "Drawing (%zu triangles, %d draws per frame, %dx%d)\n",
+        mesh.indices.size() / 3,
+        drawsPerFrame,
+        width,
+        height);
+    printf("  format     bytes  vertex buffer(MB)  frame(ms)  MTris/s  relative\n");
+    double fullMs = 0.0;
+    for(const auto& [format, name] :
+        {std::pair{VertexFormat::Full, "Full"},
+         std::pair{VertexFormat::Half, "Half"},
+         std::pair{VertexFormat::Quantized, "Quantized"}})
+    {
+        const ImportedMesh gpuMesh{mesh, format};
+        ShaderProgram& shader = format == VertexFormat::Full ? fullShader : quantizedShader;
+        GPUTimer<timedFrames> timer;
+        framebuffer.bind();
+        glEnable(GL_DEPTH_TEST);
+        shader.useProgram();
+        glUniformMatrix4fv(0, 1, GL_FALSE, glm::value_ptr(model));
+        glUniformMatrix4fv(1, 1, GL_FALSE, glm::value_ptr(view));
+        glUniformMatrix4fv(2, 1, GL_FALSE, glm::value_ptr(projection));
+        glUniform1i(3, 0);
+        if(format != VertexFormat::Full)
+        {
+            glUniformMatrix4fv(4, 1, GL_FALSE, glm::value_ptr(gpuMesh.getPositionDecode()));
+        }
+        // the first frames only fill the rolling average with valid results
+        for(int frame = 0; frame < 2 * timedFrames; frame++)
+        {
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            timer.start();
+            for(int draw = 0; draw < drawsPerFrame; draw++)
+            {
+                gpuMesh.draw();
+            }
+            timer.end();
+            timer.evaluate();
+        }
+        const double ms = timer.timeMilliseconds();
+        fullMs = format == VertexFormat::Full ? ms : fullMs;
+        printf(
+            "  %-9s  %5zu  %17.1f  %9.3f  %7.0f  %7.2fx\n",
+            name,
+            vertexFormatSize(format),
+            static_cast<double>(mesh.vertices.size() * vertexFormatSize(format)) / (1024.0 * 1024.0),
+            ms,
+            megaTriangles / (ms / 1000.0),
+            fullMs / ms);
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+int main(int argc, char** argv)
+{
+    GLFWwindow* window =
+        initAndCreateGLFWWindow(64, 64, "Vertex format benchmark", {{GLFW_VISIBLE, GLFW_FALSE}});
+    if(gladLoadGL() == 0)
+    {
+        printf("Failed to initialize OpenGL context\n");
+        return 1;
+    }
+#ifndef NDEBUG
+    setupOpenGLMessageCallback();
+#endif
+
+    ThreadPool pool;
+    MeshData mesh;
+    if(argc > 1)
+    {
+        if(!importMesh(argv[1], mesh, &pool) || mesh.vertices.empty())
+        {
+            printf("Could not load %s\n", argv[1]);
+            return 1;
+        }
+    }
+    else
+    {
+        mesh = proceduralMesh(4096, 256);
+    }
+
+    benchmarkConversion(mesh, pool);
+    benchmarkDraw(mesh);
+
+    glfwDestroyWindow(window);
+    glfwTerminate();
+    return 0;
+}
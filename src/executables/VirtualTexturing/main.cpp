@@ -0,0 +1,202 @@
+#include <glad/glad/glad.h>
+
+#include <GLFW/glfw3.h>
+
+#include <glm/gtx/transform.hpp>
+
+#include <ImGui/imgui.h>
+#include <ImGui/imgui_impl_glfw.h>
+#include <ImGui/imgui_impl_opengl3.h>
+
+#include <intern/Camera/Camera.h>
+#include <intern/Context/Context.h>
+#include <intern/Framebuffer/Framebuffer.h>
+#include <intern/InputManager/InputManager.h>
+#include <intern/Mesh/Cube.h>
+#include <intern/Mesh/FullscreenTri.h>
+#include <intern/Misc/ImGuiExtensions.h>
+#include <intern/Misc/OpenGLErrorHandler.h>
+#include <intern/Misc/ThreadPool.h>
+#include <intern/ShaderProgram/ShaderProgram.h>
+#include <intern/Texture/Image.h>
+#include <intern/VirtualTexture/VirtualTexture.h>
+#include <intern/Window/Window.h>
+
+/*
+    Renders a cube with a virtual texture (see VirtualTexture.h).
+    The tile cache is kept deliberately small, so that moving the camera causes pages to be evicted.
+*/
+
+int main()
+{
+    Context ctx{};
+
+    //----------------------- INIT WINDOW
+
+    int WIDTH = 1200;
+    int HEIGHT = 800;
+
+    GLFWwindow* window = initAndCreateGLFWWindow(
+        WIDTH, HEIGHT, "Virtual Texturing example", {{GLFW_MAXIMIZED, GLFW_TRUE}});
+
+    ctx.setWindow(window);
+    // disable VSYNC
+    glfwSwapInterval(0);
+
+    // In case window was set to start maximized, retrieve size for framebuffer here
+    glfwGetWindowSize(window, &WIDTH, &HEIGHT);
+
+    //----------------------- INIT OpenGL
+    // init OpenGL context
+    if(gladLoadGL() == 0)
+    {
+        std::cout << "Failed to initialize OpenGL context" << std::endl;
+        return -1;
+    }
+#ifndef NDEBUG
+    setupOpenGLMessageCallback();
+#endif
+    glClearColor(0.3f, 0.7f, 1.0f, 1.0f);
+    glDisable(GL_BLEND);
+
+    //----------------------- INIT IMGUI & Input
+
+    InputManager input(ctx);
+    ctx.setInputManager(&input);
+    input.setupCallbacks();
+
+    IMGUI_CHECKVERSION();
+    ImGui::CreateContext();
+    ImGuiIO& io = ImGui::GetIO();
+    io.ConfigFlags |= ImGuiConfigFlags_DockingEnable;
+    io.ConfigDockingWithShift = false;
+    ImGui::StyleColorsDark();
+    // platform/renderer bindings
+    ImGui_ImplGlfw_InitForOpenGL(window, true);
+    ImGui_ImplOpenGL3_Init("#version 450");
+
+    //----------------------- INIT REST
+
+    FullscreenTri fullScreenTri;
+    ShaderProgram postProcessShader{
+        VERTEX_SHADER_BIT | FRAGMENT_SHADER_BIT,
+        {SHADERS_PATH "/General/screenQuad.vert", SHADERS_PATH "/General/hdrTonemapSimple.frag"}};
+
+    Framebuffer internalFBO{WIDTH, HEIGHT, {GL_RGBA16F}, true};
+
+    Camera cam{ctx, static_cast<float>(WIDTH) / static_cast<float>(HEIGHT)};
+    ctx.setCamera(&cam);
+
+    Cube cube{1.0f};
+    ShaderProgram feedbackShader{
+        VERTEX_SHADER_BIT | FRAGMENT_SHADER_BIT,
+        {SHADERS_PATH "/General/simpleTexture.vert", SHADERS_PATH "/VirtualTexture/feedback.frag"}};
+    ShaderProgram virtualTextureShader{
+        VERTEX_SHADER_BIT | FRAGMENT_SHADER_BIT,
+        {SHADERS_PATH "/General/simpleTexture.vert", SHADERS_PATH "/VirtualTexture/virtualTexture.frag"}};
+
+    ThreadPool threadPool;
+    const Image gridImage = loadImage(MISC_PATH "/GridTexture.png");
+    const VirtualTextureDesc vtDesc{
+        .name = "Grid VT",
+        .width = gridImage.width,
+        .height = gridImage.height,
+        .pageSize = 128,
+        .border = 4,
+        .cacheTilesX = 6,
+        .cacheTilesY = 6,
+        .viewportWidth = WIDTH,
+        .viewportHeight = HEIGHT};
+    VirtualTexture virtualTexture{
+        vtDesc, imagePageProvider(gridImage, vtDesc.pageSize, vtDesc.border, &threadPool), threadPool};
+
+    //----------------------- RENDERLOOP
+
+    // reset time to 0 before renderloop starts
+    glfwSetTime(0.0);
+    input.resetTime();
+
+    while(glfwWindowShouldClose(window) == 0)
+    {
+        ImGui::Extensions::FrameStart();
+
+        // input needs to be updated (checks for pressed buttons etc.)
+        input.update();
+        // dont update camera if UI is using user inputs
+        if(!ImGui::GetIO().WantCaptureMouse && !ImGui::GetIO().WantCaptureKeyboard)
+        {
+            cam.update();
+        }
+
+        // feedback of earlier frames decides what gets streamed in
+        virtualTexture.update();
+
+        // Feedback pass (low resolution, read back asynchronously)
+        virtualTexture.beginFeedback();
+        feedbackShader.useProgram();
+        glUniformMatrix4fv(0, 1, GL_FALSE, glm::value_ptr(glm::mat4{1.0f}));
+        glUniformMatrix4fv(1, 1, GL_FALSE, glm::value_ptr(*cam.getView()));
+        glUniformMatrix4fv(2, 1, GL_FALSE, glm::value_ptr(*cam.getProj()));
+        virtualTexture.setFeedbackUniforms(3);
+        cube.draw();
+        virtualTexture.endFeedback();
+
+        internalFBO.bind();
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+        // Draw into internal framebuffer
+        virtualTextureShader.useProgram();
+        virtualTexture.bind(0, 1);
+        glUniformMatrix4fv(0, 1, GL_FALSE, glm::value_ptr(glm::mat4{1.0f}));
+        glUniformMatrix4fv(1, 1, GL_FALSE, glm::value_ptr(*cam.getView()));
+        glUniformMatrix4fv(2, 1, GL_FALSE, glm::value_ptr(*cam.getProj()));
+        virtualTexture.setUniforms(3);
+        cube.draw();
+
+        // Post Processing (writes internal framebuffer to default framebuffer)
+        {
+            glBindFramebuffer(GL_FRAMEBUFFER, 0);
+            // overwriting full screen anyways, dont need to clear
+            glDisable(GL_DEPTH_TEST);
+            glBindTextureUnit(0, internalFBO.getColorTextures()[0].getTextureID());
+            postProcessShader.useProgram();
+            glUniform1f(0, 1.0f);
+            glUniform1i(1, 1);
+            fullScreenTri.draw();
+            glEnable(GL_DEPTH_TEST);
+        }
+
+        const VirtualTexture::Stats& stats = virtualTexture.getStats();
+        ImGui::Begin("Virtual Texture");
+        ImGui::Text("Requested pages: %zu", stats.requestedPages);
+        ImGui::Text("Hit rate: %.1f%%", stats.hitRate * 100.0f);
+        ImGui::Text(
+            "Resident pages: %zu / %d", stats.residentPages, vtDesc.cacheTilesX * vtDesc.cacheTilesY);
+        ImGui::Text("Pending loads: %zu", stats.pendingLoads);
+        ImGui::Text("Evictions: %zu", stats.evictions);
+        ImGui::Text(
+            "Uploaded this frame: %zu pages, %.1f KB",
+            stats.uploadedPages,
+            static_cast<float>(stats.uploadedBytes) / 1024.0f);
+        ImGui::Image(
+            reinterpret_cast<ImTextureID>(static_cast<uintptr_t>(
+                virtualTexture.getPhysicalTexture().getTextureID())),
+            ImVec2(256, 256),
+            ImVec2(0, 1),
+            ImVec2(1, 0));
+        ImGui::End();
+
+        ImGui::Extensions::FrameEnd();
+
+        glfwSwapBuffers(window);
+        glfwPollEvents();
+    }
+
+    ImGui_ImplOpenGL3_Shutdown();
+    ImGui_ImplGlfw_Shutdown();
+    ImGui::DestroyContext();
+
+    glfwDestroyWindow(window);
+    glfwTerminate();
+    return 0;
+}
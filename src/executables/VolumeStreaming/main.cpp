@@ -0,0 +1,272 @@
+#include <glad/glad/glad.h>
+
+#include <GLFW/glfw3.h>
+
+#include <glm/gtx/transform.hpp>
+
+#include <ImGui/imgui.h>
+#include <ImGui/imgui_impl_glfw.h>
+#include <ImGui/imgui_impl_opengl3.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <filesystem>
+#include <string>
+
+#include <intern/Camera/Camera.h>
+#include <intern/Context/Context.h>
+#include <intern/Framebuffer/Framebuffer.h>
+#include <intern/InputManager/InputManager.h>
+#include <intern/Mesh/Cube.h>
+#include <intern/Mesh/FullscreenTri.h>
+#include <intern/Misc/ImGuiExtensions.h>
+#include <intern/Misc/OpenGLErrorHandler.h>
+#include <intern/Misc/ThreadPool.h>
+#include <intern/ShaderProgram/ShaderProgram.h>
+#include <intern/Volume/BrickedVolume.h>
+#include <intern/Volume/VolumeBrickCache.h>
+#include <intern/Window/Window.h>
+
+/*
+    Raymarches a bricked volume that is streamed in brick by brick (see VolumeBrickCache.h).
+    Pass the path of a .bvol file as the first argument, otherwise a procedural volume is written to the
+    temp directory on the first run.
+    The brick cache is kept deliberately small, so that moving the camera causes bricks to be evicted.
+*/
+
+namespace
+{
+    // a few soft blobs in an otherwise empty volume, so that empty bricks can be skipped
+    void writeProceduralVolume(const std::string& file, ThreadPool& pool)
+    {
+        constexpr int size = 512;
+        constexpr std::array<glm::vec4, 5> blobs{
+            glm::vec4{0.3f, 0.3f, 0.3f, 0.2f},
+            glm::vec4{0.7f, 0.35f, 0.6f, 0.25f},
+            glm::vec4{0.5f, 0.7f, 0.4f, 0.18f},
+            glm::vec4{0.25f, 0.75f, 0.75f, 0.15f},
+            glm::vec4{0.75f, 0.8f, 0.2f, 0.12f}};
+        std::cout << "Writing procedural volume to " << file << std::endl;
+        writeBrickedVolume(
+            file,
+            {.width = size, .height = size, .depth = size},
+            [&](int z, uint8_t* voxels)
+            {
+                for(int y = 0; y < size; y++)
+                {
+                    for(int x = 0; x < size; x++)
+                    {
+                        const glm::vec3 position = (glm::vec3(x, y, z) + 0.5f) / static_cast<float>(size);
+                        float value = 0.0f;
+                        for(const glm::vec4& blob : blobs)
+                        {
+                            const float distance = glm::length(position - glm::vec3(blob)) / blob.w;
+                            // shell with some ripples, so that there is detail to look at
+                            const float ripple = 0.75f + 0.25f * std::sin(distance * 40.0f);
+                            value += std::max(1.0f - distance, 0.0f) * ripple;
+                        }
+                        voxels[static_cast<size_t>(y) * size + x] =
+                            static_cast<uint8_t>(std::min(value, 1.0f) * 255.0f);
+                    }
+                }
+            },
+            &pool);
+    }
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    Context ctx{};
+
+    //----------------------- INIT WINDOW
+
+    int WIDTH = 1200;
+    int HEIGHT = 800;
+
+    GLFWwindow* window = initAndCreateGLFWWindow(
+        WIDTH, HEIGHT, "Volume Streaming example", {{GLFW_MAXIMIZED, GLFW_TRUE}});
+
+    ctx.setWindow(window);
+    // disable VSYNC
+    glfwSwapInterval(0);
+
+    // In case window was set to start maximized, retrieve size for framebuffer here
+    glfwGetWindowSize(window, &WIDTH, &HEIGHT);
+
+    //----------------------- INIT OpenGL
+    // init OpenGL context
+    if(gladLoadGL() == 0)
+    {
+        std::cout << "Failed to initialize OpenGL context" << std::endl;
+        return -1;
+    }
+#ifndef NDEBUG
+    setupOpenGLMessageCallback();
+#endif
+    glClearColor(0.05f, 0.05f, 0.1f, 1.0f);
+
+    //----------------------- INIT IMGUI & Input
+
+    InputManager input(ctx);
+    ctx.setInputManager(&input);
+    input.setupCallbacks();
+
+    IMGUI_CHECKVERSION();
+    ImGui::CreateContext();
+    ImGuiIO& io = ImGui::GetIO();
+    io.ConfigFlags |= ImGuiConfigFlags_DockingEnable;
+    io.ConfigDockingWithShift = false;
+    ImGui::StyleColorsDark();
+    // platform/renderer bindings
+    ImGui_ImplGlfw_InitForOpenGL(window, true);
+    ImGui_ImplOpenGL3_Init("#version 450");
+
+    //----------------------- INIT REST
+
+    FullscreenTri fullScreenTri;
+    ShaderProgram postProcessShader{
+        VERTEX_SHADER_BIT | FRAGMENT_SHADER_BIT,
+        {SHADERS_PATH "/General/screenQuad.vert", SHADERS_PATH "/General/hdrTonemapSimple.frag"}};
+
+    Framebuffer internalFBO{WIDTH, HEIGHT, {GL_RGBA16F}, true};
+
+    Camera cam{ctx, static_cast<float>(WIDTH) / static_cast<float>(HEIGHT)};
+    ctx.setCamera(&cam);
+
+    Cube cube{1.0f};
+    ShaderProgram volumeShader{
+        VERTEX_SHADER_BIT | FRAGMENT_SHADER_BIT,
+        {SHADERS_PATH "/Volume/brickedVolume.vert", SHADERS_PATH "/Volume/brickedVolume.frag"}};
+
+    ThreadPool threadPool;
+    std::string volumePath;
+    if(argc > 1)
+    {
+        volumePath = argv[1];
+    }
+    else
+    {
+        volumePath = (std::filesystem::temp_directory_path() / "VolumeStreaming").string() +
+                     BrickedVolume::extension;
+        if(!std::filesystem::exists(volumePath))
+        {
+            writeProceduralVolume(volumePath, threadPool);
+        }
+    }
+    const BrickedVolume volume{volumePath};
+    if(!volume.valid())
+    {
+        return -1;
+    }
+    const VolumeBrickCacheDesc cacheDesc{
+        .name = "Brick atlas", .cacheBricksX = 6, .cacheBricksY = 6, .cacheBricksZ = 6};
+    VolumeBrickCache brickCache{volume, threadPool, cacheDesc};
+
+    float minValue = 0.1f;
+    float maxValue = 1.0f;
+    float density = 200.0f;
+
+    //----------------------- RENDERLOOP
+
+    // reset time to 0 before renderloop starts
+    glfwSetTime(0.0);
+    input.resetTime();
+
+    while(glfwWindowShouldClose(window) == 0)
+    {
+        ImGui::Extensions::FrameStart();
+
+        // input needs to be updated (checks for pressed buttons etc.)
+        input.update();
+        // dont update camera if UI is using user inputs
+        if(!ImGui::GetIO().WantCaptureMouse && !ImGui::GetIO().WantCaptureKeyboard)
+        {
+            cam.update();
+        }
+
+        // volume coordinates are the positions of the cube shifted by 0.5
+        const glm::mat4 volumeToWorld = glm::translate(glm::vec3(-0.5f));
+        const glm::vec3 cameraInVolume = cam.getPosition() + glm::vec3(0.5f);
+        const glm::mat4 volumeToClip = *cam.getProj() * *cam.getView() * volumeToWorld;
+        brickCache.update(volumeToClip, cameraInVolume, minValue, maxValue);
+
+        internalFBO.bind();
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+        // Draw the back faces of the volume into internal framebuffer, the shader marches from the camera
+        glEnable(GL_CULL_FACE);
+        glCullFace(GL_FRONT);
+        glEnable(GL_BLEND);
+        // shader outputs premultiplied color
+        glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+        volumeShader.useProgram();
+        brickCache.bind(0, 1);
+        glUniformMatrix4fv(0, 1, GL_FALSE, glm::value_ptr(glm::mat4{1.0f}));
+        glUniformMatrix4fv(1, 1, GL_FALSE, glm::value_ptr(*cam.getView()));
+        glUniformMatrix4fv(2, 1, GL_FALSE, glm::value_ptr(*cam.getProj()));
+        glUniform3fv(3, 1, glm::value_ptr(cameraInVolume));
+        brickCache.setUniforms(4);
+        glUniform2f(7, minValue, maxValue);
+        glUniform1f(8, density);
+        cube.draw();
+        glDisable(GL_BLEND);
+        glCullFace(GL_BACK);
+        glDisable(GL_CULL_FACE);
+
+        // Post Processing (writes internal framebuffer to default framebuffer)
+        {
+            glBindFramebuffer(GL_FRAMEBUFFER, 0);
+            // overwriting full screen anyways, dont need to clear
+            glDisable(GL_DEPTH_TEST);
+            glBindTextureUnit(0, internalFBO.getColorTextures()[0].getTextureID());
+            postProcessShader.useProgram();
+            glUniform1f(0, 1.0f);
+            glUniform1i(1, 1);
+            fullScreenTri.draw();
+            glEnable(GL_DEPTH_TEST);
+        }
+
+        const BrickedVolumeHeader& header = volume.getHeader();
+        const VolumeBrickCache::Stats& stats = brickCache.getStats();
+        ImGui::Begin("Volume Streaming");
+        ImGui::Text(
+            "Volume: %ux%ux%u, %u bricks of %u^3",
+            header.width,
+            header.height,
+            header.depth,
+            volume.getBrickCount(),
+            header.brickSize);
+        ImGui::DragFloatRange2("Value range", &minValue, &maxValue, 0.005f, 0.0f, 1.0f);
+        ImGui::SliderFloat("Density", &density, 1.0f, 1000.0f, "%.0f", ImGuiSliderFlags_Logarithmic);
+        ImGui::Separator();
+        ImGui::Text(
+            "Visible bricks: %zu (%zu skipped by value range)", stats.visibleBricks, stats.culledBricks);
+        ImGui::Text("Hit rate: %.1f%%", stats.hitRate * 100.0f);
+        ImGui::Text(
+            "Resident bricks: %zu / %d",
+            stats.residentBricks,
+            cacheDesc.cacheBricksX * cacheDesc.cacheBricksY * cacheDesc.cacheBricksZ);
+        ImGui::Text("Pending loads: %zu", stats.pendingLoads);
+        ImGui::Text("Evictions: %zu", stats.evictions);
+        ImGui::Text(
+            "Uploaded this frame: %zu bricks, %.1f KB (%.1f MB/s)",
+            stats.uploadedBricks,
+            static_cast<float>(stats.uploadedBytes) / 1024.0f,
+            static_cast<float>(stats.uploadedBytes) / (1024.0f * 1024.0f) * io.Framerate);
+        ImGui::End();
+
+        ImGui::Extensions::FrameEnd();
+
+        glfwSwapBuffers(window);
+        glfwPollEvents();
+    }
+
+    ImGui_ImplOpenGL3_Shutdown();
+    ImGui_ImplGlfw_Shutdown();
+    ImGui::DestroyContext();
+
+    glfwDestroyWindow(window);
+    glfwTerminate();
+    return 0;
+}
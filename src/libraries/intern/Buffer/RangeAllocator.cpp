@@ -0,0 +1,140 @@
+#include "RangeAllocator.h"
+
+#include <cassert>
+#include <iterator>
+
+namespace
+{
+    size_t alignUp(size_t value, size_t alignment)
+    {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+} // namespace
+
+RangeAllocator::RangeAllocator(size_t capacity)
+{
+    grow(capacity);
+}
+
+std::optional<size_t> RangeAllocator::allocate(size_t size, size_t alignment)
+{
+    assert(alignment > 0);
+    if(size == 0)
+    {
+        return std::nullopt;
+    }
+    for(auto it = freeBySize.lower_bound({size, 0}); it != freeBySize.end(); it++)
+    {
+        const auto [rangeSize, rangeOffset] = *it;
+        const size_t start = alignUp(rangeOffset, alignment);
+        if(start + size > rangeOffset + rangeSize)
+        {
+            continue;
+        }
+        removeFreeRange(freeByOffset.find(rangeOffset));
+        if(start > rangeOffset)
+        {
+            addFreeRange(rangeOffset, start - rangeOffset);
+        }
+        if(start + size < rangeOffset + rangeSize)
+        {
+            addFreeRange(start + size, rangeOffset + rangeSize - start - size);
+        }
+        allocations.emplace(start, size);
+        usedSize += size;
+        return start;
+    }
+    return std::nullopt;
+}
+
+void RangeAllocator::free(size_t offset)
+{
+    const auto allocation = allocations.find(offset);
+    assert(allocation != allocations.end() && "Freed a range that was not allocated");
+    size_t size = allocation->second;
+    usedSize -= size;
+    allocations.erase(allocation);
+
+    // merge with the free neighbours
+    auto next = freeByOffset.lower_bound(offset);
+    if(next != freeByOffset.end() && next->first == offset + size)
+    {
+        size += next->second;
+        removeFreeRange(next);
+    }
+    auto previous = freeByOffset.lower_bound(offset);
+    if(previous != freeByOffset.begin())
+    {
+        previous--;
+        if(previous->first + previous->second == offset)
+        {
+            offset = previous->first;
+            size += previous->second;
+            removeFreeRange(previous);
+        }
+    }
+    addFreeRange(offset, size);
+}
+
+void RangeAllocator::grow(size_t newCapacity)
+{
+    assert(newCapacity >= capacity);
+    if(newCapacity == capacity)
+    {
+        return;
+    }
+    size_t offset = capacity;
+    // extend the free range at the end, if there is one
+    if(!freeByOffset.empty())
+    {
+        const auto last = std::prev(freeByOffset.end());
+        if(last->first + last->second == capacity)
+        {
+            offset = last->first;
+            removeFreeRange(last);
+        }
+    }
+    addFreeRange(offset, newCapacity - offset);
+    capacity = newCapacity;
+}
+
+void RangeAllocator::reset()
+{
+    freeByOffset.clear();
+    freeBySize.clear();
+    allocations.clear();
+    usedSize = 0;
+    if(capacity > 0)
+    {
+        addFreeRange(0, capacity);
+    }
+}
+
+size_t RangeAllocator::allocationSize(size_t offset) const
+{
+    const auto allocation = allocations.find(offset);
+    assert(allocation != allocations.end());
+    return allocation->second;
+}
+
+RangeAllocatorStats RangeAllocator::getStats() const
+{
+    return {
+        .capacity = capacity,
+        .usedSize = usedSize,
+        .allocations = allocations.size(),
+        .freeBlocks = freeByOffset.size(),
+        .largestFreeBlock = freeBySize.empty() ? 0 : freeBySize.rbegin()->first};
+}
+
+void RangeAllocator::addFreeRange(size_t offset, size_t size)
+{
+    freeByOffset.emplace(offset, size);
+    freeBySize.emplace(size, offset);
+}
+
+void RangeAllocator::removeFreeRange(std::map<size_t, size_t>::iterator range)
+{
+    freeBySize.erase({range->second, range->first});
+    freeByOffset.erase(range);
+}
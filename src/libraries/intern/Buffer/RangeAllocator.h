@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <set>
+#include <utility>
+
+struct RangeAllocatorStats
+{
+    size_t capacity = 0;
+    size_t usedSize = 0;
+    size_t allocations = 0;
+    size_t freeBlocks = 0;
+    size_t largestFreeBlock = 0;
+
+    [[nodiscard]] inline size_t freeSize() const
+    {
+        return capacity - usedSize;
+    }
+
+    /* 0 if all free space is one block, approaching 1 the more it is split into small blocks */
+    [[nodiscard]] inline float fragmentation() const
+    {
+        return freeSize() > 0 ? 1.0f - static_cast<float>(largestFreeBlock) / static_cast<float>(freeSize())
+                              : 0.0f;
+    }
+};
+
+/** Hands out ranges of [0, capacity), eg. of a buffer, without touching the memory itself.
+ * The free ranges are kept in a list sorted by offset (to merge neighbours when freeing) and by size,
+ * allocations take the smallest free range that fits (best fit), which keeps the large ones intact.
+ * Units are up to the user (bytes, vertices, indices, ...).
+ */
+class RangeAllocator
+{
+  public:
+    explicit RangeAllocator(size_t capacity = 0);
+
+    /** @return Offset of the range, nullopt if no free range is large enough
+     * @param alignment Of the offset, the space skipped in front of it stays free
+     */
+    std::optional<size_t> allocate(size_t size, size_t alignment = 1);
+    /* offset has to be returned by allocate() */
+    void free(size_t offset);
+    /* Appends free space at the end */
+    void grow(size_t newCapacity);
+    /* Frees everything */
+    void reset();
+
+    /* Size of the allocation at offset */
+    [[nodiscard]] size_t allocationSize(size_t offset) const;
+
+    [[nodiscard]] inline size_t getCapacity() const
+    {
+        return capacity;
+    }
+
+    [[nodiscard]] inline size_t getUsedSize() const
+    {
+        return usedSize;
+    }
+
+    /* Offset -> size of the allocations, sorted by offset */
+    [[nodiscard]] inline const std::map<size_t, size_t>& getAllocations() const
+    {
+        return allocations;
+    }
+
+    [[nodiscard]] RangeAllocatorStats getStats() const;
+
+  private:
+    void addFreeRange(size_t offset, size_t size);
+    void removeFreeRange(std::map<size_t, size_t>::iterator range);
+
+    size_t capacity = 0;
+    size_t usedSize = 0;
+    // offset -> size
+    std::map<size_t, size_t> freeByOffset;
+    // (size, offset)
+    std::set<std::pair<size_t, size_t>> freeBySize;
+    std::map<size_t, size_t> allocations;
+};
@@ -0,0 +1,297 @@
+#include "ReadbackQueue.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+#include <intern/Framebuffer/Framebuffer.h>
+#include <intern/Misc/GPUMemoryTracker.h>
+#include <intern/Texture/Texture.h>
+
+namespace
+{
+    constexpr size_t requestAlignment = 16;
+
+    size_t alignUp(size_t value, size_t alignment)
+    {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+
+    // size of a pixel in client memory, 0 for unsupported combinations
+    size_t bytesPerPixel(GLenum format, GLenum type)
+    {
+        switch(type)
+        {
+        // packed types, one value per pixel
+        case GL_UNSIGNED_INT_24_8:
+        case GL_UNSIGNED_INT_10F_11F_11F_REV:
+        case GL_UNSIGNED_INT_5_9_9_9_REV:
+        case GL_UNSIGNED_INT_2_10_10_10_REV:
+            return 4;
+        case GL_FLOAT_32_UNSIGNED_INT_24_8_REV:
+            return 8;
+        default:
+            break;
+        }
+
+        size_t channels = 0;
+        switch(format)
+        {
+        case GL_RED:
+        case GL_RED_INTEGER:
+        case GL_DEPTH_COMPONENT:
+        case GL_STENCIL_INDEX:
+            channels = 1;
+            break;
+        case GL_RG:
+        case GL_RG_INTEGER:
+            channels = 2;
+            break;
+        case GL_RGB:
+        case GL_BGR:
+        case GL_RGB_INTEGER:
+            channels = 3;
+            break;
+        case GL_RGBA:
+        case GL_BGRA:
+        case GL_RGBA_INTEGER:
+            channels = 4;
+            break;
+        default:
+            return 0;
+        }
+
+        switch(type)
+        {
+        case GL_UNSIGNED_BYTE:
+        case GL_BYTE:
+            return channels;
+        case GL_UNSIGNED_SHORT:
+        case GL_SHORT:
+        case GL_HALF_FLOAT:
+            return channels * 2;
+        case GL_UNSIGNED_INT:
+        case GL_INT:
+        case GL_FLOAT:
+            return channels * 4;
+        default:
+            return 0;
+        }
+    }
+} // namespace
+
+ReadbackQueue::ReadbackQueue(size_t size, const char* name) : capacity(size)
+{
+    constexpr GLbitfield flags = GL_MAP_READ_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    glCreateBuffers(1, &bufferID);
+    // the driver should keep this in memory the cpu can read from quickly
+    glNamedBufferStorage(bufferID, static_cast<GLsizeiptr>(capacity), nullptr, flags | GL_CLIENT_STORAGE_BIT);
+    GPUMemoryTracker::get().trackBuffer(bufferID, GPUMemoryCategory::Staging, capacity);
+    mapped = static_cast<const uint8_t*>(
+        glMapNamedBufferRange(bufferID, 0, static_cast<GLsizeiptr>(capacity), flags));
+    assert(mapped != nullptr && "Could not map readback buffer");
+    if(strlen(name) > 0)
+    {
+        glObjectLabel(GL_BUFFER, bufferID, -1, name);
+    }
+}
+
+ReadbackQueue::~ReadbackQueue()
+{
+    // callbacks of pending readbacks are not called anymore
+    for(const Request& request : requests)
+    {
+        glDeleteSync(request.fence);
+    }
+    glUnmapNamedBuffer(bufferID);
+    GPUMemoryTracker::get().untrackBuffer(bufferID);
+    glDeleteBuffers(1, &bufferID);
+}
+
+bool ReadbackQueue::read(
+    const Texture& texture, GLenum format, GLenum type, Callback callback, const ReadbackRegion& region)
+{
+    const GLsizei levelWidth = std::max(texture.getWidth() >> region.level, 1);
+    const GLsizei levelHeight = std::max(texture.getHeight() >> region.level, 1);
+    const GLsizei width = region.width < 0 ? levelWidth - region.x : region.width;
+    const GLsizei height = region.height < 0 ? levelHeight - region.y : region.height;
+    assert(region.x >= 0 && region.y >= 0);
+    assert(region.x + width <= levelWidth && region.y + height <= levelHeight);
+
+    return enqueue(
+        width,
+        height,
+        format,
+        type,
+        std::move(callback),
+        [&](GLintptr offset, GLsizei size)
+        {
+            glGetTextureSubImage(
+                texture.getTextureID(),
+                region.level,
+                region.x,
+                region.y,
+                0,
+                width,
+                height,
+                1,
+                format,
+                type,
+                size,
+                reinterpret_cast<void*>(offset)); // NOLINT(performance-no-int-to-ptr)
+        });
+}
+
+bool ReadbackQueue::readColor(
+    const Framebuffer& framebuffer, int attachment, GLenum format, GLenum type, Callback callback,
+    const ReadbackRegion& region)
+{
+    // depth is stored behind the color attachments
+    const int colorAttachments = static_cast<int>(framebuffer.getColorTextures().size()) -
+                                 (framebuffer.getDepthTexture() != nullptr ? 1 : 0);
+    assert(attachment >= 0 && attachment < colorAttachments);
+    return read(framebuffer.getColorTextures()[attachment], format, type, std::move(callback), region);
+}
+
+bool ReadbackQueue::readDepth(const Framebuffer& framebuffer, Callback callback, const ReadbackRegion& region)
+{
+    const Texture* depth = framebuffer.getDepthTexture();
+    assert(depth != nullptr && "Framebuffer has no depth attachment");
+    return read(*depth, GL_DEPTH_COMPONENT, GL_FLOAT, std::move(callback), region);
+}
+
+bool ReadbackQueue::readDefaultFramebuffer(
+    GLint x, GLint y, GLsizei width, GLsizei height, GLenum format, GLenum type, Callback callback)
+{
+    return enqueue(
+        width,
+        height,
+        format,
+        type,
+        std::move(callback),
+        [&](GLintptr offset, GLsizei size)
+        {
+            GLint previousFramebuffer = 0;
+            glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &previousFramebuffer);
+            glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+            glReadBuffer(GL_BACK);
+            glReadnPixels(
+                x,
+                y,
+                width,
+                height,
+                format,
+                type,
+                size,
+                reinterpret_cast<void*>(offset)); // NOLINT(performance-no-int-to-ptr)
+            glBindFramebuffer(GL_READ_FRAMEBUFFER, previousFramebuffer);
+        });
+}
+
+void ReadbackQueue::update()
+{
+    frame++;
+    while(!requests.empty() && deliver(false))
+    {
+    }
+}
+
+void ReadbackQueue::flush()
+{
+    while(!requests.empty())
+    {
+        deliver(true);
+    }
+}
+
+bool ReadbackQueue::enqueue(
+    GLsizei width, GLsizei height, GLenum format, GLenum type, Callback&& callback,
+    const std::function<void(GLintptr offset, GLsizei size)>& copy)
+{
+    const size_t pixelBytes = bytesPerPixel(format, type);
+    assert(pixelBytes > 0 && "Unsupported readback format or type");
+    assert(width > 0 && height > 0);
+    const size_t size = static_cast<size_t>(width) * height * pixelBytes;
+
+    // same allocation scheme as StagingRing, except that memory is released by delivering requests
+    if(used == 0)
+    {
+        head = tail = 0;
+    }
+    size_t start = alignUp(head, requestAlignment);
+    if(used == 0 || head > tail)
+    {
+        // free space is [head, capacity) and [0, tail)
+        if(start + size > capacity)
+        {
+            start = 0;
+            if(size > tail && used != 0)
+            {
+                stats.rejected++;
+                return false;
+            }
+        }
+    }
+    else if(head == tail || start + size > tail)
+    {
+        stats.rejected++;
+        return false;
+    }
+    if(start + size > capacity)
+    {
+        stats.rejected++;
+        return false;
+    }
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, bufferID);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    copy(static_cast<GLintptr>(start), static_cast<GLsizei>(size));
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    const size_t consumed = (start >= head ? start - head : capacity - head + start) + size;
+    head = start + size;
+    used += consumed;
+    requests.push_back(
+        {.offset = start,
+         .size = size,
+         .end = head,
+         .consumed = consumed,
+         .fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0),
+         .callback = std::move(callback),
+         .result = {.width = width, .height = height, .format = format, .type = type, .frame = frame}});
+
+    stats.queued++;
+    stats.pending = requests.size();
+    stats.pendingBytes = used;
+    return true;
+}
+
+bool ReadbackQueue::deliver(bool wait)
+{
+    Request& request = requests.front();
+    const GLuint64 timeout = wait ? GL_TIMEOUT_IGNORED : 0;
+    // flushing makes sure the fence reaches the GPU, otherwise it might never be signaled
+    const GLenum status = glClientWaitSync(request.fence, GL_SYNC_FLUSH_COMMANDS_BIT, timeout);
+    if(status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+    {
+        return false;
+    }
+    glDeleteSync(request.fence);
+
+    // the memory is released only afterwards, so callbacks can queue new readbacks without overwriting it
+    // (references into a deque stay valid when pushing to its back)
+    request.result.data = {mapped + request.offset, request.size};
+    if(request.callback)
+    {
+        request.callback(request.result);
+    }
+    tail = request.end;
+    used -= request.consumed;
+    requests.pop_front();
+
+    stats.delivered++;
+    stats.pending = requests.size();
+    stats.pendingBytes = used;
+    return true;
+}
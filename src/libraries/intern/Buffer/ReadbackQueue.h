@@ -0,0 +1,141 @@
+#pragma once
+
+#include <glad/glad/glad.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <span>
+
+class Texture;
+class Framebuffer;
+
+/* Part of a texture level to read back, width/height of -1 mean "up to the edge of the level" */
+struct ReadbackRegion
+{
+    GLint level = 0;
+    GLint x = 0;
+    GLint y = 0;
+    GLsizei width = -1;
+    GLsizei height = -1;
+};
+
+/* Pixels of a finished readback, rows are tightly packed, bottom row first (as OpenGL returns them) */
+struct ReadbackResult
+{
+    GLsizei width = 0;
+    GLsizei height = 0;
+    GLenum format = 0;
+    GLenum type = 0;
+    // only valid during the callback, copy what needs to be kept
+    std::span<const uint8_t> data;
+    // number of update() calls before the readback was queued
+    uint64_t frame = 0;
+};
+
+/** Asynchronous readback of textures and framebuffers (screenshots, picking, captures of automated runs).
+ * Requests copy into a persistently mapped pixel pack buffer that is used as a ring, each request is
+ * guarded by a fence and handed to its callback from update() once that fence was signaled, usually
+ * one to three frames later. Nothing ever waits on the GPU (except flush()), when the ring is full new
+ * requests are rejected instead.
+ */
+class ReadbackQueue
+{
+  public:
+    using Callback = std::function<void(const ReadbackResult&)>;
+
+    struct Stats
+    {
+        // requests queued / delivered / rejected because the ring was full, since construction
+        size_t queued = 0;
+        size_t delivered = 0;
+        size_t rejected = 0;
+        // requests waiting for the GPU and the ring memory they occupy
+        size_t pending = 0;
+        size_t pendingBytes = 0;
+    };
+
+    /** @param size Capacity of the ring in bytes, needs to hold all readbacks of a few frames
+     */
+    explicit ReadbackQueue(size_t size, const char* name = "");
+    ~ReadbackQueue();
+
+    ReadbackQueue(ReadbackQueue&&) = delete;
+    ReadbackQueue(const ReadbackQueue&) = delete;
+    ReadbackQueue& operator=(ReadbackQueue&&) = delete;
+    ReadbackQueue& operator=(const ReadbackQueue&) = delete;
+
+    /** Queues a copy of a region of the texture
+     * @param format, type Client side format of the result, eg. GL_RGBA / GL_UNSIGNED_BYTE
+     *                     or GL_DEPTH_COMPONENT / GL_FLOAT
+     * @return false if the ring has no space left for the copy (the callback is never called then)
+     */
+    bool read(
+        const Texture& texture, GLenum format, GLenum type, Callback callback,
+        const ReadbackRegion& region = {});
+
+    /* Queues a copy of a color attachment of the framebuffer, see read() */
+    bool readColor(
+        const Framebuffer& framebuffer, int attachment, GLenum format, GLenum type, Callback callback,
+        const ReadbackRegion& region = {});
+
+    /* Queues a copy of the depth of the framebuffer as GL_FLOAT, see read() */
+    bool readDepth(const Framebuffer& framebuffer, Callback callback, const ReadbackRegion& region = {});
+
+    /* Queues a copy of the back buffer of the default framebuffer (eg. for screenshots including the UI) */
+    bool readDefaultFramebuffer(
+        GLint x, GLint y, GLsizei width, GLsizei height, GLenum format, GLenum type, Callback callback);
+
+    /** Calls the callbacks of all finished readbacks, in the order they were queued. Never blocks.
+     * Call once per frame, on the GL thread.
+     */
+    void update();
+
+    /** Waits for all pending readbacks and calls their callbacks, eg. before shutting down
+     */
+    void flush();
+
+    [[nodiscard]] inline const Stats& getStats() const
+    {
+        return stats;
+    }
+
+    [[nodiscard]] inline GLuint getBufferID() const
+    {
+        return bufferID;
+    }
+
+  private:
+    struct Request
+    {
+        size_t offset;
+        size_t size;
+        // end of the request in the ring, and the bytes it occupies there (including the part at the end
+        // of the buffer that was skipped for it)
+        size_t end;
+        size_t consumed;
+        GLsync fence;
+        Callback callback;
+        ReadbackResult result;
+    };
+
+    // reserves space in the ring, issues the copy into it (with the pack buffer bound) and fences it
+    bool enqueue(
+        GLsizei width, GLsizei height, GLenum format, GLenum type, Callback&& callback,
+        const std::function<void(GLintptr offset, GLsizei size)>& copy);
+    // deliver the front request once its fence was signaled, returns false if it is still in flight
+    bool deliver(bool wait);
+
+    GLuint bufferID = 0xFFFFFFFF;
+    const uint8_t* mapped = nullptr;
+    size_t capacity = 0;
+
+    // bytes [tail, head) (wrapping) are in use
+    size_t head = 0;
+    size_t tail = 0;
+    size_t used = 0;
+    std::deque<Request> requests;
+    uint64_t frame = 0;
+    Stats stats;
+};
@@ -0,0 +1,44 @@
+#include "RegionFences.h"
+
+#include <cassert>
+
+RegionFences::RegionFences(size_t regionCount) : fences(regionCount, nullptr)
+{
+    assert(regionCount > 0);
+}
+
+RegionFences::~RegionFences()
+{
+    for(const GLsync fence : fences)
+    {
+        if(fence != nullptr)
+        {
+            glDeleteSync(fence);
+        }
+    }
+}
+
+bool RegionFences::wait(size_t region)
+{
+    GLsync& fence = fences[region];
+    if(fence == nullptr)
+    {
+        return false;
+    }
+    GLenum result = glClientWaitSync(fence, 0, 0);
+    const bool stalled = result == GL_TIMEOUT_EXPIRED;
+    while(result == GL_TIMEOUT_EXPIRED)
+    {
+        // flush, otherwise the fence might never be submitted
+        result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+    }
+    glDeleteSync(fence);
+    fence = nullptr;
+    return stalled;
+}
+
+void RegionFences::fence(size_t region)
+{
+    assert(fences[region] == nullptr && "Region fenced twice without waiting for it");
+    fences[region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <glad/glad/glad.h>
+
+#include <cstddef>
+#include <vector>
+
+/** Fences for buffers that are split into regions written by the CPU in turn, usually one region per
+ * frame in flight of a persistently mapped buffer. Before a region is written again wait() makes sure
+ * the GPU finished the commands reading it, which were guarded with fence().
+ * Only use from the GL thread.
+ */
+class RegionFences
+{
+  public:
+    explicit RegionFences(size_t regionCount);
+    ~RegionFences();
+
+    RegionFences(RegionFences&&) = delete;
+    RegionFences(const RegionFences&) = delete;
+    RegionFences& operator=(RegionFences&&) = delete;
+    RegionFences& operator=(const RegionFences&) = delete;
+
+    /* Blocks until the commands fenced for the region are done. Returns true if that had to wait */
+    bool wait(size_t region);
+    /* Guards all commands issued so far, call after the last command reading the region */
+    void fence(size_t region);
+
+    [[nodiscard]] inline size_t getRegionCount() const
+    {
+        return fences.size();
+    }
+
+  private:
+    std::vector<GLsync> fences;
+};
@@ -0,0 +1,109 @@
+#include "StagingRing.h"
+
+#include <cassert>
+#include <cstring>
+
+#include <intern/Misc/GPUMemoryTracker.h>
+
+namespace
+{
+    size_t alignUp(size_t value, size_t alignment)
+    {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+} // namespace
+
+StagingRing::StagingRing(size_t size, const char* name) : capacity(size)
+{
+    constexpr GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    glCreateBuffers(1, &bufferID);
+    glNamedBufferStorage(bufferID, static_cast<GLsizeiptr>(capacity), nullptr, flags);
+    GPUMemoryTracker::get().trackBuffer(bufferID, GPUMemoryCategory::Staging, capacity);
+    mapped = static_cast<uint8_t*>(
+        glMapNamedBufferRange(bufferID, 0, static_cast<GLsizeiptr>(capacity), flags));
+    assert(mapped != nullptr && "Could not map staging buffer");
+    if(strlen(name) > 0)
+    {
+        glObjectLabel(GL_BUFFER, bufferID, -1, name);
+    }
+}
+
+StagingRing::~StagingRing()
+{
+    for(const auto& region : regions)
+    {
+        glDeleteSync(region.fence);
+    }
+    glUnmapNamedBuffer(bufferID);
+    GPUMemoryTracker::get().untrackBuffer(bufferID);
+    glDeleteBuffers(1, &bufferID);
+}
+
+StagingRing::Allocation StagingRing::allocate(size_t size, size_t alignment)
+{
+    if(used == 0)
+    {
+        // ring is idle, restart at the front to get the largest contiguous block
+        head = tail = 0;
+    }
+
+    size_t start = alignUp(head, alignment);
+    if(used == 0 || head > tail)
+    {
+        // free space is [head, capacity) and [0, tail)
+        if(start + size > capacity)
+        {
+            if(size > tail && used != 0)
+            {
+                return {};
+            }
+            // skip the remainder at the end of the buffer, it is released together with this block
+            start = 0;
+        }
+    }
+    else if(head == tail || start + size > tail)
+    {
+        // full, or not enough space in [head, tail)
+        return {};
+    }
+    if(start + size > capacity)
+    {
+        return {};
+    }
+
+    const size_t consumed = (start >= head ? start - head : capacity - head + start) + size;
+    head = start + size;
+    used += consumed;
+    unfencedBytes += consumed;
+    return {.offset = static_cast<GLintptr>(start), .ptr = mapped + start, .size = size};
+}
+
+void StagingRing::fence()
+{
+    if(unfencedBytes == 0)
+    {
+        return;
+    }
+    regions.push_back(
+        {.end = head, .bytes = unfencedBytes, .fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0)});
+    unfencedBytes = 0;
+}
+
+void StagingRing::retire(bool waitForOldest)
+{
+    while(!regions.empty())
+    {
+        Region& region = regions.front();
+        const GLuint64 timeout = waitForOldest ? GL_TIMEOUT_IGNORED : 0;
+        const GLenum status = glClientWaitSync(region.fence, GL_SYNC_FLUSH_COMMANDS_BIT, timeout);
+        if(status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+        {
+            return;
+        }
+        waitForOldest = false;
+        glDeleteSync(region.fence);
+        tail = region.end;
+        used -= region.bytes;
+        regions.pop_front();
+    }
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <glad/glad/glad.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+
+/** Persistently and coherently mapped buffer used as a ring of staging memory for uploads
+ * (bind as GL_PIXEL_UNPACK_BUFFER or use as copy source).
+ * Memory handed out by allocate() is reused only once the fence inserted after it was signaled,
+ * so writing into it never stalls and never overwrites data the GPU is still reading.
+ */
+class StagingRing
+{
+  public:
+    struct Allocation
+    {
+        // offset into the buffer, to be passed as the "pointer" argument of GL calls
+        GLintptr offset = 0;
+        // mapped pointer to write to, nullptr if the allocation failed
+        uint8_t* ptr = nullptr;
+        size_t size = 0;
+    };
+
+    explicit StagingRing(size_t size, const char* name = "");
+    ~StagingRing();
+
+    StagingRing(StagingRing&&) = delete;
+    StagingRing(const StagingRing&) = delete;
+    StagingRing& operator=(StagingRing&&) = delete;
+    StagingRing& operator=(const StagingRing&) = delete;
+
+    /** Reserves a contiguous block. Fails (returns an allocation with ptr == nullptr) if the ring
+     * does not have enough space that is not in use by the GPU. Never blocks.
+     */
+    Allocation allocate(size_t size, size_t alignment = 16);
+
+    /** Guards all allocations made since the last call with a fence.
+     * Call once the GL commands reading from them have been issued.
+     */
+    void fence();
+
+    /** Releases all blocks whose fence has been signaled.
+     * @param waitForOldest Block until at least the oldest fence has been signaled
+     */
+    void retire(bool waitForOldest = false);
+
+    [[nodiscard]] inline GLuint getBufferID() const
+    {
+        return bufferID;
+    }
+
+    [[nodiscard]] inline size_t getSize() const
+    {
+        return capacity;
+    }
+
+    [[nodiscard]] inline size_t getUsedSize() const
+    {
+        return used;
+    }
+
+    [[nodiscard]] inline bool hasPendingFences() const
+    {
+        return !regions.empty();
+    }
+
+  private:
+    struct Region
+    {
+        size_t end;
+        size_t bytes;
+        GLsync fence;
+    };
+
+    GLuint bufferID = 0xFFFFFFFF;
+    uint8_t* mapped = nullptr;
+    size_t capacity = 0;
+
+    // bytes [tail, head) (wrapping) are in use, either by the GPU or not yet fenced
+    size_t head = 0;
+    size_t tail = 0;
+    size_t used = 0;
+    size_t unfencedBytes = 0;
+    std::deque<Region> regions;
+};
@@ -2,10 +2,18 @@
 
 #include <cassert>
 
+#include <intern/Misc/GPUMemoryTracker.h>
+
+#include "RenderTargetPool.h"
+
 Framebuffer::Framebuffer(
-    GLsizei width, GLsizei height, std::initializer_list<GLenum> colorTextureFormats, bool useDepthStencil)
-    : width(width), height(height), hasDepthStencilAttachment(useDepthStencil)
+    GLsizei width, GLsizei height, std::initializer_list<GLenum> colorTextureFormats, bool useDepthStencil,
+    RenderTargetPool* pool)
+    : width(width), height(height), hasDepthStencilAttachment(useDepthStencil), pool(pool)
 {
+    const auto createTexture = [&](const TextureDesc& desc)
+    { return pool != nullptr ? pool->acquire(desc) : Texture{desc}; };
+
     textures.reserve(colorTextureFormats.size() + (int)useDepthStencil);
 
     glCreateFramebuffers(1, &handle);
@@ -13,16 +21,18 @@ Framebuffer::Framebuffer(
     int index = 0;
     for(const auto& format : colorTextureFormats)
     {
-        Texture& newTex =
-            textures.emplace_back(TextureDesc{.width = width, .height = height, .internalFormat = format});
+        Texture& newTex = textures.emplace_back(
+            createTexture(TextureDesc{.width = width, .height = height, .internalFormat = format}));
         glNamedFramebufferTexture(handle, GL_COLOR_ATTACHMENT0 + index, newTex.getTextureID(), 0);
+        GPUMemoryTracker::get().setTextureCategory(newTex.getTextureID(), GPUMemoryCategory::RenderTarget);
         index++;
     }
     if(useDepthStencil)
     {
-        Texture& newTex = textures.emplace_back(
-            TextureDesc{.width = width, .height = height, .internalFormat = GL_DEPTH24_STENCIL8});
+        Texture& newTex = textures.emplace_back(createTexture(
+            TextureDesc{.width = width, .height = height, .internalFormat = GL_DEPTH24_STENCIL8}));
         glNamedFramebufferTexture(handle, GL_DEPTH_STENCIL_ATTACHMENT, newTex.getTextureID(), 0);
+        GPUMemoryTracker::get().setTextureCategory(newTex.getTextureID(), GPUMemoryCategory::RenderTarget);
     }
 
     std::vector<GLenum> attachments(colorTextureFormats.size());
@@ -43,6 +53,13 @@ Framebuffer::Framebuffer(
 Framebuffer::~Framebuffer()
 {
     glDeleteFramebuffers(1, &handle);
+    if(pool != nullptr)
+    {
+        for(Texture& texture : textures)
+        {
+            pool->release(std::move(texture));
+        }
+    }
 }
 
 void Framebuffer::bind() const
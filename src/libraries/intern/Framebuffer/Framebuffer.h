@@ -7,14 +7,23 @@
 
 #include <intern/Texture/Texture.h>
 
+class RenderTargetPool;
+
 class Framebuffer
 {
   public:
+    /** @param pool If given, the attachments are taken from the pool and handed back on destruction,
+     *             so recreating framebuffers (eg. on resize) recycles textures.
+     *             Has to outlive the framebuffer
+     */
     Framebuffer(
         GLsizei width, GLsizei height, std::initializer_list<GLenum> colorTextureFormats,
-        bool useDepthStencil);
+        bool useDepthStencil, RenderTargetPool* pool = nullptr);
     ~Framebuffer();
 
+    Framebuffer(const Framebuffer&) = delete;
+    Framebuffer& operator=(const Framebuffer&) = delete;
+
     void bind() const;
 
     [[nodiscard]] const std::vector<Texture>& getColorTextures() const;
@@ -26,5 +35,6 @@ class Framebuffer
     GLsizei height = -1;
     bool hasDepthStencilAttachment = false;
     GLuint handle = 0xFFFFFFFF;
+    RenderTargetPool* pool = nullptr;
     std::vector<Texture> textures;
 };
\ No newline at end of file
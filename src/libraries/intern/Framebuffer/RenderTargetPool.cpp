@@ -0,0 +1,124 @@
+#include "RenderTargetPool.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+#include <intern/Misc/Hash.h>
+
+size_t RenderTargetPool::KeyHash::operator()(const Key& key) const
+{
+    size_t hash = 0;
+    for(const uint32_t value :
+        {static_cast<uint32_t>(key.width),
+         static_cast<uint32_t>(key.height),
+         static_cast<uint32_t>(key.levels),
+         static_cast<uint32_t>(key.internalFormat),
+         static_cast<uint32_t>(key.minFilter),
+         static_cast<uint32_t>(key.magFilter),
+         static_cast<uint32_t>(key.wrapS),
+         static_cast<uint32_t>(key.wrapT)})
+    {
+        hashCombine(hash, value);
+    }
+    return hash;
+}
+
+size_t RenderTargetPool::estimateBytes(const Key& key)
+{
+    size_t bytes = 0;
+    for(int level = 0; level < key.levels; level++)
+    {
+        bytes += textureLevelSize(
+            key.internalFormat, std::max(key.width >> level, 1), std::max(key.height >> level, 1));
+    }
+    return bytes;
+}
+
+RenderTargetPool::RenderTargetPool(uint32_t framesUntilFree) : framesUntilFree(framesUntilFree)
+{
+}
+
+Texture RenderTargetPool::acquire(const TextureDesc& desc)
+{
+    assert(desc.data == nullptr && desc.levelData.empty() && "Render targets can not have initial data");
+    const Key key{
+        .width = desc.width,
+        .height = desc.height,
+        .levels = desc.levels,
+        .internalFormat = desc.internalFormat,
+        .minFilter = desc.minFilter,
+        .magFilter = desc.magFilter,
+        .wrapS = desc.wrapS,
+        .wrapT = desc.wrapT};
+
+    auto iter = available.find(key);
+    if(iter != available.end() && !iter->second.empty())
+    {
+        // most recently released first, its memory is the most likely to still be hot
+        Texture texture = std::move(iter->second.back().texture);
+        iter->second.pop_back();
+        stats.hits++;
+        stats.available--;
+        stats.acquired++;
+        if(strlen(desc.name) > 0)
+        {
+            glObjectLabel(GL_TEXTURE, texture.getTextureID(), -1, desc.name);
+        }
+        acquired.emplace(texture.getTextureID(), key);
+        return texture;
+    }
+
+    Texture texture{desc};
+    stats.misses++;
+    stats.acquired++;
+    stats.bytes += estimateBytes(key);
+    acquired.emplace(texture.getTextureID(), key);
+    return texture;
+}
+
+void RenderTargetPool::release(Texture&& texture)
+{
+    auto iter = acquired.find(texture.getTextureID());
+    assert(iter != acquired.end() && "Texture was not acquired from this pool");
+    if(iter == acquired.end())
+    {
+        return;
+    }
+    available[iter->second].push_back(Entry{.texture = std::move(texture), .lastUsed = frame});
+    acquired.erase(iter);
+    stats.acquired--;
+    stats.available++;
+}
+
+void RenderTargetPool::endFrame()
+{
+    frame++;
+    for(auto iter = available.begin(); iter != available.end();)
+    {
+        std::vector<Entry>& entries = iter->second;
+        const size_t bytes = estimateBytes(iter->first);
+        const auto expired = std::remove_if(
+            entries.begin(),
+            entries.end(),
+            [&](const Entry& entry) { return entry.lastUsed + framesUntilFree < frame; });
+        const size_t freed = std::distance(expired, entries.end());
+        // erasing destroys the textures
+        entries.erase(expired, entries.end());
+        stats.freed += freed;
+        stats.available -= freed;
+        stats.bytes -= freed * bytes;
+        iter = entries.empty() ? available.erase(iter) : std::next(iter);
+    }
+}
+
+void RenderTargetPool::clear()
+{
+    for(const auto& [key, entries] : available)
+    {
+        stats.freed += entries.size();
+        stats.bytes -= entries.size() * estimateBytes(key);
+    }
+    stats.available = 0;
+    available.clear();
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <glad/glad/glad.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include <intern/Texture/Texture.h>
+
+/** Recycles render target textures instead of creating and deleting them every time a Framebuffer is
+ * (re)created, eg. on window resize or for the intermediate targets of multi pass effects.
+ * Textures are matched by the fields of their TextureDesc that define the allocation
+ * (size, format, levels, filters and wrapping), initial data is not supported.
+ *
+ * Usage: acquire() hands out a texture, release() takes it back (Framebuffer does both when constructed
+ * with a pool). Call endFrame() once per frame: textures that were not handed out for framesUntilFree
+ * frames are deleted.
+ */
+class RenderTargetPool
+{
+  public:
+    struct Stats
+    {
+        // acquires served by a recycled texture / by creating a new one, since construction
+        size_t hits = 0;
+        size_t misses = 0;
+        // textures deleted after being unused for too long
+        size_t freed = 0;
+        // textures currently handed out / waiting in the pool
+        size_t acquired = 0;
+        size_t available = 0;
+        // bytes of all textures owned by the pool or handed out (all mip levels, estimated from the format)
+        size_t bytes = 0;
+    };
+
+    explicit RenderTargetPool(uint32_t framesUntilFree = 3);
+
+    RenderTargetPool(const RenderTargetPool&) = delete;
+    RenderTargetPool& operator=(const RenderTargetPool&) = delete;
+
+    /** Returns a texture matching the descriptor, recycled if possible.
+     * Hand it back with release() before destroying the pool.
+     */
+    Texture acquire(const TextureDesc& desc);
+
+    /** Takes back a texture that was returned from acquire(), its content is undefined from now on
+     */
+    void release(Texture&& texture);
+
+    /** Advances the frame counter and deletes textures that were unused for framesUntilFree frames
+     */
+    void endFrame();
+
+    /** Deletes all textures that are not handed out
+     */
+    void clear();
+
+    [[nodiscard]] inline const Stats& getStats() const
+    {
+        return stats;
+    }
+
+  private:
+    struct Key
+    {
+        GLsizei width;
+        GLsizei height;
+        GLsizei levels;
+        GLenum internalFormat;
+        GLint minFilter;
+        GLint magFilter;
+        GLint wrapS;
+        GLint wrapT;
+
+        bool operator==(const Key& other) const = default;
+    };
+
+    struct KeyHash
+    {
+        size_t operator()(const Key& key) const;
+    };
+
+    struct Entry
+    {
+        Texture texture;
+        uint64_t lastUsed;
+    };
+
+    static size_t estimateBytes(const Key& key);
+
+    uint32_t framesUntilFree;
+    uint64_t frame = 0;
+    std::unordered_map<Key, std::vector<Entry>, KeyHash> available;
+    // key of every texture that is currently handed out, by texture ID
+    std::unordered_map<GLuint, Key> acquired;
+    Stats stats;
+};
@@ -0,0 +1,293 @@
+#include "CookedMesh.h"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+#include "MeshImporter.h"
+#include "MeshOptimizer.h"
+
+namespace
+{
+    constexpr uint64_t streamAlignment = 16;
+    constexpr size_t streamCount = static_cast<size_t>(CookedMeshStreamType::Count);
+
+    uint64_t alignUp(uint64_t value)
+    {
+        return (value + streamAlignment - 1) / streamAlignment * streamAlignment;
+    }
+
+    template <typename T>
+    std::span<const T> streamAs(std::span<const uint8_t> bytes)
+    {
+        return {reinterpret_cast<const T*>(bytes.data()), bytes.size() / sizeof(T)};
+    }
+
+    // true if the header of the file can be read and has all of the required flags set
+    bool hasCurrentHeader(const std::string& file, uint32_t requiredFlags)
+    {
+        std::ifstream in(file, std::ios::binary);
+        CookedMeshHeader header;
+        in.read(reinterpret_cast<char*>(&header), sizeof(header));
+        return in.good() && memcmp(header.magic, CookedMeshHeader::magicValue, sizeof(header.magic)) == 0 &&
+               header.version == CookedMeshHeader::currentVersion &&
+               header.vertexStride == sizeof(VertexStruct) && (header.flags & requiredFlags) == requiredFlags;
+    }
+} // namespace
+
+CookedMesh::CookedMesh(const std::string& path) : file(path)
+{
+    const size_t indexEnd = sizeof(CookedMeshHeader) + streamCount * sizeof(CookedMeshStream);
+    if(!file.isOpen() || file.size() < indexEnd)
+    {
+        std::cout << "Could not load cooked mesh " << path << std::endl;
+        return;
+    }
+    header = reinterpret_cast<const CookedMeshHeader*>(file.data());
+    if(memcmp(header->magic, CookedMeshHeader::magicValue, sizeof(header->magic)) != 0 ||
+       header->version != CookedMeshHeader::currentVersion || header->vertexStride != sizeof(VertexStruct) ||
+       (header->indexType != GL_UNSIGNED_SHORT && header->indexType != GL_UNSIGNED_INT))
+    {
+        std::cout << "Invalid cooked mesh header in " << path << std::endl;
+        return;
+    }
+    streams = reinterpret_cast<const CookedMeshStream*>(file.data() + sizeof(CookedMeshHeader));
+    for(size_t i = 0; i < streamCount; i++)
+    {
+        if(streams[i].offset > file.size() || streams[i].size > file.size() - streams[i].offset ||
+           streams[i].offset % streamAlignment != 0)
+        {
+            std::cout << "Truncated cooked mesh " << path << std::endl;
+            return;
+        }
+    }
+    const size_t indexSize = header->indexType == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(uint32_t);
+    const size_t vertexSize = sizeof(VertexStruct);
+    if(getStream(CookedMeshStreamType::Vertices).size() != size_t{header->vertexCount} * vertexSize ||
+       getStream(CookedMeshStreamType::Indices).size() != size_t{header->indexCount} * indexSize ||
+       getMeshlets().size() != header->meshletCount || getLods().size() != header->lodCount)
+    {
+        std::cout << "Invalid stream sizes in cooked mesh " << path << std::endl;
+        return;
+    }
+    // everything below is drawn or culled as it is, so out of range values would make the GPU read past
+    // the buffers
+    if(!indicesInRange() || !meshletsInRange() || !lodsInRange())
+    {
+        std::cout << "Out of range indices in cooked mesh " << path << std::endl;
+        return;
+    }
+    isValid = true;
+}
+
+bool CookedMesh::indicesInRange() const
+{
+    const std::span<const uint8_t> indices = getStream(CookedMeshStreamType::Indices);
+    if(header->indexType == GL_UNSIGNED_SHORT)
+    {
+        return std::ranges::all_of(
+            streamAs<uint16_t>(indices), [&](uint16_t index) { return index < header->vertexCount; });
+    }
+    return std::ranges::all_of(
+        streamAs<uint32_t>(indices), [&](uint32_t index) { return index < header->vertexCount; });
+}
+
+bool CookedMesh::meshletsInRange() const
+{
+    const std::span<const uint32_t> meshletVertices = getMeshletVertices();
+    const std::span<const uint8_t> meshletTriangles = getMeshletTriangles();
+    if(getStream(CookedMeshStreamType::MeshletVertices).size() % sizeof(uint32_t) != 0 ||
+       !std::ranges::all_of(meshletVertices, [&](uint32_t vertex) { return vertex < header->vertexCount; }))
+    {
+        return false;
+    }
+    for(const Meshlet& meshlet : getMeshlets())
+    {
+        // triangleOffset is also the first index of the meshlet in the index buffer
+        const uint64_t triangleEnd = uint64_t{meshlet.triangleOffset} + uint64_t{meshlet.triangleCount} * 3;
+        if(uint64_t{meshlet.vertexOffset} + meshlet.vertexCount > meshletVertices.size() ||
+           triangleEnd > meshletTriangles.size() || triangleEnd > header->indexCount)
+        {
+            return false;
+        }
+        const std::span<const uint8_t> triangles =
+            meshletTriangles.subspan(meshlet.triangleOffset, size_t{meshlet.triangleCount} * 3);
+        if(!std::ranges::all_of(triangles, [&](uint8_t vertex) { return vertex < meshlet.vertexCount; }))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool CookedMesh::lodsInRange() const
+{
+    return std::ranges::all_of(
+        getLods(),
+        [&](const MeshLod& lod)
+        {
+            return lod.indexCount % 3 == 0 &&
+                   uint64_t{lod.firstIndex} + uint64_t{lod.indexCount} <= uint64_t{header->indexCount};
+        });
+}
+
+std::span<const uint8_t> CookedMesh::getStream(CookedMeshStreamType type) const
+{
+    const CookedMeshStream& stream = streams[static_cast<size_t>(type)];
+    return file.bytes().subspan(stream.offset, stream.size);
+}
+
+std::span<const VertexStruct> CookedMesh::getVertices() const
+{
+    return streamAs<VertexStruct>(getStream(CookedMeshStreamType::Vertices));
+}
+
+std::span<const Meshlet> CookedMesh::getMeshlets() const
+{
+    return streamAs<Meshlet>(getStream(CookedMeshStreamType::Meshlets));
+}
+
+std::span<const uint32_t> CookedMesh::getMeshletVertices() const
+{
+    return streamAs<uint32_t>(getStream(CookedMeshStreamType::MeshletVertices));
+}
+
+std::span<const uint8_t> CookedMesh::getMeshletTriangles() const
+{
+    return getStream(CookedMeshStreamType::MeshletTriangles);
+}
+
+std::span<const MeshLod> CookedMesh::getLods() const
+{
+    return streamAs<MeshLod>(getStream(CookedMeshStreamType::Lods));
+}
+
+bool writeCookedMesh(
+    const std::string& file, const MeshData& mesh, const MeshletData* meshlets, std::span<const MeshLod> lods,
+    uint32_t flags)
+{
+    const GLenum indexType = mesh.vertices.size() <= 65536 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+    CookedMeshHeader header{
+        .vertexStride = sizeof(VertexStruct),
+        .vertexCount = static_cast<uint32_t>(mesh.vertices.size()),
+        .indexCount = static_cast<uint32_t>(mesh.indices.size()),
+        .indexType = indexType,
+        .meshletCount = meshlets != nullptr ? static_cast<uint32_t>(meshlets->meshlets.size()) : 0,
+        .flags = flags,
+        .lodCount = static_cast<uint32_t>(lods.size())};
+    memcpy(header.magic, CookedMeshHeader::magicValue, sizeof(header.magic));
+    if(!mesh.vertices.empty())
+    {
+        glm::vec3 minimum = mesh.vertices[0].pos;
+        glm::vec3 maximum = mesh.vertices[0].pos;
+        for(const VertexStruct& vertex : mesh.vertices)
+        {
+            minimum = glm::min(minimum, vertex.pos);
+            maximum = glm::max(maximum, vertex.pos);
+        }
+        memcpy(header.boundsMin, &minimum, sizeof(header.boundsMin));
+        memcpy(header.boundsMax, &maximum, sizeof(header.boundsMax));
+    }
+
+    std::vector<uint16_t> shortIndices;
+    std::span<const uint8_t> indexBytes{
+        reinterpret_cast<const uint8_t*>(mesh.indices.data()), mesh.indices.size() * sizeof(GLuint)};
+    if(header.indexType == GL_UNSIGNED_SHORT)
+    {
+        shortIndices.assign(mesh.indices.begin(), mesh.indices.end());
+        indexBytes = {reinterpret_cast<const uint8_t*>(shortIndices.data()), shortIndices.size() * 2};
+    }
+
+    std::span<const uint8_t> data[streamCount]; // NOLINT
+    data[static_cast<size_t>(CookedMeshStreamType::Vertices)] = {
+        reinterpret_cast<const uint8_t*>(mesh.vertices.data()), mesh.vertices.size() * sizeof(VertexStruct)};
+    data[static_cast<size_t>(CookedMeshStreamType::Indices)] = indexBytes;
+    if(meshlets != nullptr)
+    {
+        data[static_cast<size_t>(CookedMeshStreamType::Meshlets)] = {
+            reinterpret_cast<const uint8_t*>(meshlets->meshlets.data()),
+            meshlets->meshlets.size() * sizeof(Meshlet)};
+        data[static_cast<size_t>(CookedMeshStreamType::MeshletVertices)] = {
+            reinterpret_cast<const uint8_t*>(meshlets->vertices.data()),
+            meshlets->vertices.size() * sizeof(uint32_t)};
+        data[static_cast<size_t>(CookedMeshStreamType::MeshletTriangles)] = meshlets->triangles;
+    }
+    data[static_cast<size_t>(CookedMeshStreamType::Lods)] = {
+        reinterpret_cast<const uint8_t*>(lods.data()), lods.size_bytes()};
+
+    CookedMeshStream index[streamCount]; // NOLINT
+    uint64_t offset = alignUp(sizeof(CookedMeshHeader) + sizeof(index));
+    for(size_t i = 0; i < streamCount; i++)
+    {
+        index[i] = {.offset = data[i].empty() ? 0 : offset, .size = data[i].size()};
+        offset = alignUp(offset + data[i].size());
+    }
+
+    std::ofstream out(file, std::ios::binary | std::ios::trunc);
+    if(!out.is_open())
+    {
+        std::cerr << "ERROR: Unable to open file " << file << std::endl;
+        return false;
+    }
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(index), sizeof(index));
+    constexpr static char padding[streamAlignment] = {}; // NOLINT
+    for(size_t i = 0; i < streamCount; i++)
+    {
+        if(data[i].empty())
+        {
+            continue;
+        }
+        out.write(
+            padding,
+            static_cast<std::streamsize>(index[i].offset) - static_cast<std::streamsize>(out.tellp()));
+        out.write(
+            reinterpret_cast<const char*>(data[i].data()), static_cast<std::streamsize>(data[i].size()));
+    }
+    return out.good();
+}
+
+bool cookMesh(
+    const std::string& input, const std::string& output, ThreadPool* pool, bool force, bool* cooked,
+    MeshOptimizationStats* stats)
+{
+    constexpr uint32_t allFlags = CookedMeshHeader::optimizedFlag | CookedMeshHeader::meshletsFlag |
+                                  CookedMeshHeader::lodsFlag | CookedMeshHeader::tangentsFlag;
+    if(cooked != nullptr)
+    {
+        *cooked = false;
+    }
+    std::error_code ec;
+    if(!force && std::filesystem::exists(output, ec) &&
+       std::filesystem::last_write_time(output, ec) >= std::filesystem::last_write_time(input, ec) &&
+       hasCurrentHeader(output, allFlags))
+    {
+        return true;
+    }
+    MeshData mesh;
+    if(!importMesh(input, mesh, pool, nullptr, {.generateTangents = true}))
+    {
+        return false;
+    }
+    optimizeMesh(mesh, {}, stats);
+    const std::vector<MeshLod> lods = buildLods(mesh, {}, pool);
+    const MeshletData meshlets =
+        buildMeshlets(mesh.vertices, std::span<const GLuint>{mesh.indices}.first(lods[0].indexCount));
+    if(!writeCookedMesh(output, mesh, &meshlets, lods, allFlags))
+    {
+        return false;
+    }
+    if(cooked != nullptr)
+    {
+        *cooked = true;
+    }
+    return true;
+}
+
+bool isCookedMeshPath(const std::string& file)
+{
+    const std::string_view extension = CookedMesh::extension;
+    return file.size() >= extension.size() && file.ends_with(extension);
+}
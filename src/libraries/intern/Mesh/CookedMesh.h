@@ -0,0 +1,150 @@
+#pragma once
+
+#include <glad/glad/glad.h>
+
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+
+#include <intern/Misc/MappedFile.h>
+
+#include "Mesh.h"
+#include "MeshSimplifier.h"
+#include "Meshlets.h"
+
+class ThreadPool;
+struct MeshData;
+struct MeshOptimizationStats;
+
+/*
+    Binary runtime mesh format:
+
+    CookedMeshHeader
+    CookedMeshStream[CookedMeshStreamType::Count]     offset and size of every stream, empty ones are 0
+    stream data                                       each stream starts on a 16 byte boundary
+
+    Streams are stored exactly as OpenGL expects them (VertexStructs, 16 or 32 bit indices), so
+    Mesh buffers can be created straight from the mapping.
+*/
+
+enum struct CookedMeshStreamType
+{
+    Vertices,         // VertexStruct
+    Indices,          // uint16_t or uint32_t, see CookedMeshHeader::indexType
+    Meshlets,         // Meshlet, optional
+    MeshletVertices,  // uint32_t indices into the vertices, optional
+    MeshletTriangles, // 3 uint8_t indices into the vertices of the meshlet per triangle, optional
+    Lods,             // MeshLod, ranges of the index buffer, optional
+    Count
+};
+
+struct CookedMeshHeader
+{
+    constexpr static char magicValue[8] = {'O', 'G', 'L', 'F', 'M', 'S', 'H', '\0'}; // NOLINT
+    constexpr static uint32_t currentVersion = 2;
+    // indices and vertices were reordered by optimizeMesh
+    constexpr static uint32_t optimizedFlag = 1u << 0u;
+    // meshlets were built, for meshes with indices
+    constexpr static uint32_t meshletsFlag = 1u << 1u;
+    // levels of detail were built
+    constexpr static uint32_t lodsFlag = 1u << 2u;
+    // tangents were computed by generateTangents
+    constexpr static uint32_t tangentsFlag = 1u << 3u;
+
+    char magic[8] = {}; // NOLINT
+    uint32_t version = currentVersion;
+    // sizeof(VertexStruct) when the file was written, files with a different layout are rejected
+    uint32_t vertexStride = 0;
+    uint32_t vertexCount = 0;
+    // of all LODs
+    uint32_t indexCount = 0;
+    // GL_UNSIGNED_SHORT or GL_UNSIGNED_INT
+    uint32_t indexType = 0;
+    uint32_t meshletCount = 0;
+    // axis aligned bounds of the positions
+    float boundsMin[3] = {}; // NOLINT
+    float boundsMax[3] = {}; // NOLINT
+    uint32_t flags = 0;
+    uint32_t lodCount = 0;
+};
+static_assert(sizeof(CookedMeshHeader) == 64);
+
+struct CookedMeshStream
+{
+    uint64_t offset = 0;
+    uint64_t size = 0;
+};
+
+/** Memory mapped view of a cooked mesh file
+ */
+class CookedMesh
+{
+  public:
+    constexpr static const char* extension = ".cmesh";
+
+    explicit CookedMesh(const std::string& file);
+
+    CookedMesh(const CookedMesh&) = delete;
+    CookedMesh& operator=(const CookedMesh&) = delete;
+
+    /* true if the file could be mapped and passed validation */
+    [[nodiscard]] inline bool valid() const
+    {
+        return isValid;
+    }
+
+    [[nodiscard]] inline const CookedMeshHeader& getHeader() const
+    {
+        return *header;
+    }
+
+    /* Raw bytes of a stream, straight from the mapping (first access reads them from disk) */
+    [[nodiscard]] std::span<const uint8_t> getStream(CookedMeshStreamType type) const;
+
+    [[nodiscard]] std::span<const VertexStruct> getVertices() const;
+    [[nodiscard]] std::span<const Meshlet> getMeshlets() const;
+    [[nodiscard]] std::span<const uint32_t> getMeshletVertices() const;
+    [[nodiscard]] std::span<const uint8_t> getMeshletTriangles() const;
+    [[nodiscard]] std::span<const MeshLod> getLods() const;
+
+  private:
+    /* true if all indices address a vertex of the mesh */
+    [[nodiscard]] bool indicesInRange() const;
+    /* true if all meshlets lie inside the meshlet streams and the index buffer, and address valid vertices */
+    [[nodiscard]] bool meshletsInRange() const;
+    /* true if all LODs are whole triangles inside the index buffer */
+    [[nodiscard]] bool lodsInRange() const;
+
+    MappedFile file;
+    const CookedMeshHeader* header = nullptr;
+    const CookedMeshStream* streams = nullptr;
+    bool isValid = false;
+};
+
+/** Writes a cooked mesh file. Indices are stored as 16 bit if all vertices can be addressed with them.
+ * @param file Path of the file to write
+ * @param mesh Vertices and indices of the mesh
+ * @param meshlets Optional meshlet table, referencing the vertices of mesh
+ * @param lods Optional levels of detail, referencing the indices of mesh
+ * @param flags Stored in CookedMeshHeader::flags
+ * @return false if the file could not be written
+ */
+bool writeCookedMesh(
+    const std::string& file, const MeshData& mesh, const MeshletData* meshlets = nullptr,
+    std::span<const MeshLod> lods = {}, uint32_t flags = 0);
+
+/** Imports the mesh with generated tangents (see importMesh), optimizes it (see optimizeMesh), builds its
+ * LODs (see buildLods) and the meshlets of LOD 0 and writes it as a cooked mesh, unless the output is up
+ * to date (newer than the input, with all of these steps done) already.
+ * Does not need an OpenGL context.
+ * @param cooked Set to true if the output was written, false if it was up to date
+ * @param stats Filled with the vertex cache statistics if the output was written
+ * @return false if the input could not be imported or the output could not be written
+ */
+bool cookMesh(
+    const std::string& input, const std::string& output, ThreadPool* pool = nullptr, bool force = false,
+    bool* cooked = nullptr, MeshOptimizationStats* stats = nullptr);
+
+/* true if the path ends in CookedMesh::extension */
+bool isCookedMeshPath(const std::string& file);
@@ -0,0 +1,132 @@
+#include "DynamicMesh.h"
+
+#include <cstring>
+
+#include <intern/Misc/GPUMemoryTracker.h>
+
+#include "VertexArrayCache.h"
+
+DynamicMesh::DynamicMesh(
+    const VertexLayout& layout, size_t maxVertices, size_t maxIndices, size_t regionCount, const char* name)
+    : layout(layout), maxVertices(maxVertices), maxIndices(maxIndices), fences(regionCount)
+{
+    // with a single region the update would overwrite the geometry that is still drawn
+    assert(regionCount >= 2);
+    assert(maxVertices > 0);
+
+    constexpr GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    const size_t vertexBytes = regionCount * maxVertices * static_cast<size_t>(layout.stride);
+    glCreateBuffers(1, &vboHandles[0]);
+    glNamedBufferStorage(vboHandles[0], static_cast<GLsizeiptr>(vertexBytes), nullptr, flags);
+    GPUMemoryTracker::get().trackBuffer(vboHandles[0], GPUMemoryCategory::Mesh, vertexBytes);
+    mappedVertices = static_cast<uint8_t*>(
+        glMapNamedBufferRange(vboHandles[0], 0, static_cast<GLsizeiptr>(vertexBytes), flags));
+    assert(mappedVertices != nullptr && "Could not map dynamic vertex buffer");
+
+    vboHandles[1] = 0;
+    if(maxIndices > 0)
+    {
+        const size_t indexBytes = regionCount * maxIndices * sizeof(GLuint);
+        glCreateBuffers(1, &vboHandles[1]);
+        glNamedBufferStorage(vboHandles[1], static_cast<GLsizeiptr>(indexBytes), nullptr, flags);
+        GPUMemoryTracker::get().trackBuffer(vboHandles[1], GPUMemoryCategory::Mesh, indexBytes);
+        mappedIndices = static_cast<GLuint*>(
+            glMapNamedBufferRange(vboHandles[1], 0, static_cast<GLsizeiptr>(indexBytes), flags));
+        assert(mappedIndices != nullptr && "Could not map dynamic index buffer");
+    }
+    if(strlen(name) > 0)
+    {
+        glObjectLabel(GL_BUFFER, vboHandles[0], -1, name);
+    }
+
+    vaoHandle = VertexArrayCache::get().acquire(layout);
+}
+
+DynamicMesh::~DynamicMesh()
+{
+    VertexArrayCache::get().release(vaoHandle);
+    glUnmapNamedBuffer(vboHandles[0]);
+    GPUMemoryTracker::get().untrackBuffer(vboHandles[0]);
+    if(vboHandles[1] != 0)
+    {
+        glUnmapNamedBuffer(vboHandles[1]);
+        GPUMemoryTracker::get().untrackBuffer(vboHandles[1]);
+    }
+    glDeleteBuffers(2, &vboHandles[0]);
+}
+
+void DynamicMesh::begin()
+{
+    assert(!writing && "begin() called twice without end()");
+    writtenRegion = drawable ? (drawnRegion + 1) % fences.getRegionCount() : 0;
+    if(fences.wait(writtenRegion))
+    {
+        stalls++;
+    }
+    writtenVertexCount = 0;
+    writtenIndexCount = 0;
+    writing = true;
+}
+
+uint8_t* DynamicMesh::writeVertexData(size_t count)
+{
+    assert(writing && "Geometry can only be written between begin() and end()");
+    assert(count <= maxVertices);
+    writtenVertexCount = count;
+    return mappedVertices + writtenRegion * maxVertices * static_cast<size_t>(layout.stride);
+}
+
+std::span<GLuint> DynamicMesh::writeIndices(size_t count)
+{
+    assert(writing && "Geometry can only be written between begin() and end()");
+    assert(count <= maxIndices);
+    writtenIndexCount = count;
+    return {mappedIndices + writtenRegion * maxIndices, count};
+}
+
+void DynamicMesh::end()
+{
+    assert(writing && "end() called without begin()");
+    assert((maxIndices == 0 || writtenIndexCount > 0 || writtenVertexCount == 0) && "Indices missing");
+    writing = false;
+    // all draws of the previous region have been issued by now
+    if(drawable)
+    {
+        fences.fence(drawnRegion);
+    }
+    drawnRegion = writtenRegion;
+    drawnVertexCount = writtenVertexCount;
+    drawnIndexCount = writtenIndexCount;
+    drawable = true;
+}
+
+void DynamicMesh::draw() const
+{
+    if(!drawable || drawnVertexCount == 0)
+    {
+        return;
+    }
+    const auto stride = static_cast<size_t>(layout.stride);
+    // the VAO only holds the layout, the region of the buffers is attached here
+    glBindVertexArray(vaoHandle);
+    glVertexArrayVertexBuffer(
+        vaoHandle,
+        0,
+        vboHandles[0],
+        static_cast<GLintptr>(drawnRegion * maxVertices * stride),
+        layout.stride);
+    glVertexArrayElementBuffer(vaoHandle, vboHandles[1]);
+    if(vboHandles[1] != 0)
+    {
+        glDrawElements(
+            GL_TRIANGLES,
+            static_cast<GLsizei>(drawnIndexCount),
+            GL_UNSIGNED_INT,
+            reinterpret_cast<const void*>(drawnRegion * maxIndices * sizeof(GLuint)));
+    }
+    else
+    {
+        glDrawArrays(GL_TRIANGLES, 0, static_cast<GLsizei>(drawnVertexCount));
+    }
+    glBindVertexArray(0);
+}
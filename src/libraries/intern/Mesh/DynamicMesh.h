@@ -0,0 +1,122 @@
+#pragma once
+
+#include <glad/glad/glad.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+#include <intern/Buffer/RegionFences.h>
+
+#include "VertexLayout.h"
+
+/** Mesh whose geometry is written anew by the CPU, eg. every frame for procedural or CPU deformed
+ * geometry. Unlike Mesh the vertex and index buffers are persistently and coherently mapped and split into
+ * regionCount regions, each large enough for maxVertices and maxIndices. Every update is written into the
+ * next region while draw() keeps reading the previous one, and a region is only written again once the
+ * fence placed after its last draw has passed, so updates neither copy in the driver nor stall unless
+ * the GPU is regionCount - 1 updates behind.
+ * Every update: begin(), writeVertices() and writeIndices(), end(). draw() draws the geometry of the last
+ * end(), also while the next update is being written.
+ * Only use from the GL thread.
+ */
+class DynamicMesh
+{
+  public:
+    constexpr static size_t defaultRegionCount = 3;
+
+    /* Without indices (maxIndices = 0) the vertices are drawn in order */
+    DynamicMesh(
+        const VertexLayout& layout, size_t maxVertices, size_t maxIndices,
+        size_t regionCount = defaultRegionCount, const char* name = "");
+    ~DynamicMesh();
+
+    DynamicMesh(DynamicMesh&&) = delete;
+    DynamicMesh(const DynamicMesh&) = delete;
+    DynamicMesh& operator=(DynamicMesh&&) = delete;
+    DynamicMesh& operator=(const DynamicMesh&) = delete;
+
+    /* Starts an update in the next region, waits if the GPU still reads it */
+    void begin();
+    /** Mapped memory for the count vertices of this update, count has to be at most maxVertices.
+     * The memory is write combined: write it sequentially and never read from it.
+     */
+    template <typename Vertex>
+    std::span<Vertex> writeVertices(size_t count)
+    {
+        assert(sizeof(Vertex) == static_cast<size_t>(layout.stride) && "Vertex does not match the layout");
+        return {reinterpret_cast<Vertex*>(writeVertexData(count)), count};
+    }
+    /* Mapped memory for the count indices of this update, see writeVertices() */
+    std::span<GLuint> writeIndices(size_t count);
+    /* Makes the update visible to draw() */
+    void end();
+
+    /* Copies the geometry into the mesh, in a begin()/end() of its own */
+    template <typename Vertex>
+    void update(std::span<const Vertex> vertices, std::span<const GLuint> indices = {})
+    {
+        begin();
+        std::span<Vertex> mappedVertices = writeVertices<Vertex>(vertices.size());
+        std::copy(vertices.begin(), vertices.end(), mappedVertices.begin());
+        std::span<GLuint> mappedIndices = writeIndices(indices.size());
+        std::copy(indices.begin(), indices.end(), mappedIndices.begin());
+        end();
+    }
+
+    /* Draws the geometry of the last end(), nothing before the first one */
+    void draw() const;
+
+    [[nodiscard]] inline size_t getVertexCount() const
+    {
+        return drawnVertexCount;
+    }
+
+    [[nodiscard]] inline size_t getIndexCount() const
+    {
+        return drawnIndexCount;
+    }
+
+    [[nodiscard]] inline size_t getMaxVertices() const
+    {
+        return maxVertices;
+    }
+
+    [[nodiscard]] inline size_t getMaxIndices() const
+    {
+        return maxIndices;
+    }
+
+    /* begin() calls that had to wait for the GPU */
+    [[nodiscard]] inline size_t getStalls() const
+    {
+        return stalls;
+    }
+
+  private:
+    uint8_t* writeVertexData(size_t count);
+
+    VertexLayout layout;
+    size_t maxVertices = 0;
+    size_t maxIndices = 0;
+    // shared with all meshes of the same layout, see VertexArrayCache
+    GLuint vaoHandle = 0xffffffff;
+    // the index buffer is 0 for meshes without indices
+    GLuint vboHandles[2] = {0xffffffff, 0xffffffff}; // NOLINT
+    uint8_t* mappedVertices = nullptr;
+    GLuint* mappedIndices = nullptr;
+
+    RegionFences fences;
+    // region read by draw() and region of the update in progress
+    size_t drawnRegion = 0;
+    size_t writtenRegion = 0;
+    size_t drawnVertexCount = 0;
+    size_t drawnIndexCount = 0;
+    size_t writtenVertexCount = 0;
+    size_t writtenIndexCount = 0;
+    size_t stalls = 0;
+    bool drawable = false;
+    bool writing = false;
+};
@@ -2,5 +2,6 @@
 
 FullscreenTri::FullscreenTri()
 {
-    init(vertices, indices);
+    // drawn without indices
+    init<PositionVertex>(vertices);
 }
\ No newline at end of file
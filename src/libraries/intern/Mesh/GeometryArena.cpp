@@ -0,0 +1,345 @@
+#include "GeometryArena.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <optional>
+
+#include <intern/Misc/GPUMemoryTracker.h>
+
+#include "VertexArrayCache.h"
+
+namespace
+{
+    /* Collects copies between two buffers and merges the ones that continue the previous one */
+    class BufferCopier
+    {
+      public:
+        BufferCopier(GLuint source, GLuint destination) : source(source), destination(destination)
+        {
+        }
+
+        ~BufferCopier()
+        {
+            flush();
+        }
+
+        BufferCopier(const BufferCopier&) = delete;
+        BufferCopier& operator=(const BufferCopier&) = delete;
+
+        void copy(size_t sourceOffset, size_t destinationOffset, size_t size)
+        {
+            if(pendingSize > 0 && sourceOffset == pendingSource + pendingSize &&
+               destinationOffset == pendingDestination + pendingSize)
+            {
+                pendingSize += size;
+                return;
+            }
+            flush();
+            pendingSource = sourceOffset;
+            pendingDestination = destinationOffset;
+            pendingSize = size;
+        }
+
+        [[nodiscard]] inline size_t getCopiedBytes() const
+        {
+            return copiedBytes + pendingSize;
+        }
+
+      private:
+        void flush()
+        {
+            if(pendingSize == 0)
+            {
+                return;
+            }
+            glCopyNamedBufferSubData(
+                source,
+                destination,
+                static_cast<GLintptr>(pendingSource),
+                static_cast<GLintptr>(pendingDestination),
+                static_cast<GLsizeiptr>(pendingSize));
+            copiedBytes += pendingSize;
+            pendingSize = 0;
+        }
+
+        GLuint source;
+        GLuint destination;
+        size_t pendingSource = 0;
+        size_t pendingDestination = 0;
+        size_t pendingSize = 0;
+        size_t copiedBytes = 0;
+    };
+} // namespace
+
+GeometryArena::GeometryArena(
+    const VertexLayout& layout, size_t vertexCapacity, size_t indexCapacity, const char* name)
+    : layout(layout), name(name), vertexAllocator(vertexCapacity), indexAllocator(indexCapacity)
+{
+    assert(vertexCapacity > 0 && indexCapacity > 0);
+    vaoHandle = VertexArrayCache::get().acquire(layout);
+    createBuffers(vertexCapacity, indexCapacity, &buffers[0], &buffers[1]);
+}
+
+GeometryArena::~GeometryArena()
+{
+    VertexArrayCache::get().release(vaoHandle);
+    deleteBuffers();
+}
+
+GeometryHandle
+GeometryArena::add(std::span<const uint8_t> vertexData, std::span<const uint8_t> indexData, GLenum indexType)
+{
+    const auto stride = static_cast<size_t>(layout.stride);
+    assert(vertexData.size() % stride == 0);
+    assert(indexType == GL_UNSIGNED_SHORT || indexType == GL_UNSIGNED_INT);
+    const size_t vertexCount = vertexData.size() / stride;
+    const size_t indexSize = indexType == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(uint32_t);
+    const size_t indexCount = indexData.size() / indexSize;
+    if(vertexCount == 0 || indexCount == 0)
+    {
+        return invalidHandle;
+    }
+
+    std::optional<size_t> firstVertex = vertexAllocator.allocate(vertexCount);
+    std::optional<size_t> firstIndex = indexAllocator.allocate(indexCount);
+    if(!firstVertex || !firstIndex)
+    {
+        if(firstVertex)
+        {
+            vertexAllocator.free(*firstVertex);
+        }
+        if(firstIndex)
+        {
+            indexAllocator.free(*firstIndex);
+        }
+        // compacting is enough if the free space is only fragmented, otherwise grow as well
+        const auto newCapacity = [](const RangeAllocator& allocator, size_t count)
+        {
+            const size_t capacity = allocator.getCapacity();
+            return capacity - allocator.getUsedSize() >= count
+                       ? capacity
+                       : std::max(capacity * 2, allocator.getUsedSize() + count);
+        };
+        relocate(newCapacity(vertexAllocator, vertexCount), newCapacity(indexAllocator, indexCount));
+        firstVertex = vertexAllocator.allocate(vertexCount);
+        firstIndex = indexAllocator.allocate(indexCount);
+        assert(firstVertex && firstIndex);
+    }
+
+    glNamedBufferSubData(
+        buffers[0],
+        static_cast<GLintptr>(*firstVertex * stride),
+        static_cast<GLsizeiptr>(vertexData.size()),
+        vertexData.data());
+    if(indexType == GL_UNSIGNED_INT)
+    {
+        glNamedBufferSubData(
+            buffers[1],
+            static_cast<GLintptr>(*firstIndex * sizeof(GLuint)),
+            static_cast<GLsizeiptr>(indexData.size()),
+            indexData.data());
+    }
+    else
+    {
+        std::vector<uint16_t> shortIndices(indexCount);
+        memcpy(shortIndices.data(), indexData.data(), indexData.size());
+        const std::vector<GLuint> widened(shortIndices.begin(), shortIndices.end());
+        glNamedBufferSubData(
+            buffers[1],
+            static_cast<GLintptr>(*firstIndex * sizeof(GLuint)),
+            static_cast<GLsizeiptr>(widened.size() * sizeof(GLuint)),
+            widened.data());
+    }
+
+    GeometryHandle handle = invalidHandle;
+    if(freeHandles.empty())
+    {
+        handle = static_cast<GeometryHandle>(geometries.size());
+        geometries.emplace_back();
+    }
+    else
+    {
+        handle = freeHandles.back();
+        freeHandles.pop_back();
+    }
+    geometries[handle] = {
+        .range =
+            {.baseVertex = static_cast<GLint>(*firstVertex),
+             .vertexCount = static_cast<GLuint>(vertexCount),
+             .firstIndex = static_cast<GLuint>(*firstIndex),
+             .indexCount = static_cast<GLuint>(indexCount)},
+        .live = true};
+    return handle;
+}
+
+void GeometryArena::remove(GeometryHandle handle)
+{
+    assert(
+        handle < geometries.size() && geometries[handle].live && "Removed geometry that is not in the arena");
+    Geometry& geometry = geometries[handle];
+    vertexAllocator.free(static_cast<size_t>(geometry.range.baseVertex));
+    indexAllocator.free(geometry.range.firstIndex);
+    geometry = {};
+    freeHandles.push_back(handle);
+}
+
+void GeometryArena::compact()
+{
+    relocate(vertexAllocator.getCapacity(), indexAllocator.getCapacity());
+}
+
+bool GeometryArena::compactIfFragmented(float maxFragmentation)
+{
+    if(vertexAllocator.getStats().fragmentation() <= maxFragmentation &&
+       indexAllocator.getStats().fragmentation() <= maxFragmentation)
+    {
+        return false;
+    }
+    compact();
+    return true;
+}
+
+void GeometryArena::bind() const
+{
+    glBindVertexArray(vaoHandle);
+    glVertexArrayVertexBuffer(vaoHandle, 0, buffers[0], 0, layout.stride);
+    glVertexArrayElementBuffer(vaoHandle, buffers[1]);
+}
+
+void GeometryArena::draw(GeometryHandle handle) const
+{
+    const GeometryRange& range = getRange(handle);
+    draw(handle, 0, static_cast<GLsizei>(range.indexCount));
+}
+
+void GeometryArena::draw(GeometryHandle handle, GLuint firstIndex, GLsizei count) const
+{
+    assert(handle < geometries.size() && geometries[handle].live);
+    const GeometryRange& range = getRange(handle);
+    assert(firstIndex + static_cast<GLuint>(count) <= range.indexCount);
+    glDrawElementsBaseVertex(
+        GL_TRIANGLES,
+        count,
+        GL_UNSIGNED_INT,
+        reinterpret_cast<const void*>(static_cast<uintptr_t>(range.firstIndex + firstIndex) * sizeof(GLuint)),
+        range.baseVertex);
+}
+
+void GeometryArena::draw(std::span<const GeometryHandle> handles) const
+{
+    bind();
+    for(const GeometryHandle handle : handles)
+    {
+        draw(handle);
+    }
+    glBindVertexArray(0);
+}
+
+GeometryArenaStats GeometryArena::getStats() const
+{
+    return {
+        .vertices = vertexAllocator.getStats(),
+        .indices = indexAllocator.getStats(),
+        .geometries = geometries.size() - freeHandles.size(),
+        .compactions = compactions,
+        .grows = grows,
+        .movedBytes = movedBytes};
+}
+
+void GeometryArena::relocate(size_t newVertexCapacity, size_t newIndexCapacity)
+{
+    GLuint newBuffers[2]; // NOLINT
+    createBuffers(newVertexCapacity, newIndexCapacity, &newBuffers[0], &newBuffers[1]);
+    grows += newVertexCapacity != vertexAllocator.getCapacity() ||
+                     newIndexCapacity != indexAllocator.getCapacity()
+                 ? 1
+                 : 0;
+    compactions++;
+
+    std::vector<GeometryHandle> live;
+    live.reserve(geometries.size());
+    for(GeometryHandle handle = 0; handle < geometries.size(); handle++)
+    {
+        if(geometries[handle].live)
+        {
+            live.push_back(handle);
+        }
+    }
+
+    // keep the order of the geometries, so ranges that are already packed are copied in one go
+    const auto stride = static_cast<size_t>(layout.stride);
+    vertexAllocator = RangeAllocator{newVertexCapacity};
+    std::sort(
+        live.begin(),
+        live.end(),
+        [&](GeometryHandle a, GeometryHandle b)
+        { return geometries[a].range.baseVertex < geometries[b].range.baseVertex; });
+    {
+        BufferCopier copier{buffers[0], newBuffers[0]};
+        for(const GeometryHandle handle : live)
+        {
+            GeometryRange& range = geometries[handle].range;
+            const size_t firstVertex = *vertexAllocator.allocate(range.vertexCount);
+            copier.copy(
+                static_cast<size_t>(range.baseVertex) * stride,
+                firstVertex * stride,
+                range.vertexCount * stride);
+            range.baseVertex = static_cast<GLint>(firstVertex);
+        }
+        movedBytes += copier.getCopiedBytes();
+    }
+
+    indexAllocator = RangeAllocator{newIndexCapacity};
+    std::sort(
+        live.begin(),
+        live.end(),
+        [&](GeometryHandle a, GeometryHandle b)
+        { return geometries[a].range.firstIndex < geometries[b].range.firstIndex; });
+    {
+        BufferCopier copier{buffers[1], newBuffers[1]};
+        for(const GeometryHandle handle : live)
+        {
+            GeometryRange& range = geometries[handle].range;
+            const size_t firstIndex = *indexAllocator.allocate(range.indexCount);
+            copier.copy(
+                range.firstIndex * sizeof(GLuint),
+                firstIndex * sizeof(GLuint),
+                range.indexCount * sizeof(GLuint));
+            range.firstIndex = static_cast<GLuint>(firstIndex);
+        }
+        movedBytes += copier.getCopiedBytes();
+    }
+
+    deleteBuffers();
+    buffers[0] = newBuffers[0];
+    buffers[1] = newBuffers[1];
+}
+
+void GeometryArena::createBuffers(
+    size_t vertexCapacity, size_t indexCapacity, GLuint* vertexBuffer, GLuint* indexBuffer)
+{
+    const size_t vertexBytes = vertexCapacity * static_cast<size_t>(layout.stride);
+    const size_t indexBytes = indexCapacity * sizeof(GLuint);
+    glCreateBuffers(1, vertexBuffer);
+    glNamedBufferStorage(
+        *vertexBuffer, static_cast<GLsizeiptr>(vertexBytes), nullptr, GL_DYNAMIC_STORAGE_BIT);
+    GPUMemoryTracker::get().trackBuffer(*vertexBuffer, GPUMemoryCategory::Mesh, vertexBytes);
+    glCreateBuffers(1, indexBuffer);
+    glNamedBufferStorage(*indexBuffer, static_cast<GLsizeiptr>(indexBytes), nullptr, GL_DYNAMIC_STORAGE_BIT);
+    GPUMemoryTracker::get().trackBuffer(*indexBuffer, GPUMemoryCategory::Mesh, indexBytes);
+    if(!name.empty())
+    {
+        const std::string vertexName = name + " vertices";
+        const std::string indexName = name + " indices";
+        glObjectLabel(GL_BUFFER, *vertexBuffer, -1, vertexName.c_str());
+        glObjectLabel(GL_BUFFER, *indexBuffer, -1, indexName.c_str());
+    }
+}
+
+void GeometryArena::deleteBuffers()
+{
+    GPUMemoryTracker::get().untrackBuffer(buffers[0]);
+    GPUMemoryTracker::get().untrackBuffer(buffers[1]);
+    glDeleteBuffers(2, &buffers[0]);
+}
@@ -0,0 +1,150 @@
+#pragma once
+
+#include <glad/glad/glad.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+
+#include <intern/Buffer/RangeAllocator.h>
+
+#include "VertexLayout.h"
+
+/* Identifies geometry in a GeometryArena, stays valid when the arena is compacted or grows */
+using GeometryHandle = uint32_t;
+
+/* Where geometry currently is in the buffers of its arena */
+struct GeometryRange
+{
+    // index of the first vertex, added to every index (glDrawElementsBaseVertex)
+    GLint baseVertex = 0;
+    GLuint vertexCount = 0;
+    GLuint firstIndex = 0;
+    GLuint indexCount = 0;
+};
+
+struct GeometryArenaStats
+{
+    // in vertices and indices
+    RangeAllocatorStats vertices;
+    RangeAllocatorStats indices;
+    size_t geometries = 0;
+    size_t compactions = 0;
+    // compactions that also enlarged the buffers
+    size_t grows = 0;
+    // bytes copied on the GPU by all compactions
+    size_t movedBytes = 0;
+};
+
+/** One vertex buffer and one index buffer shared by many meshes of the same VertexLayout, so they can be
+ * drawn one after another (or with a single multi draw) without switching VAOs or buffers.
+ * Ranges of both buffers are handed out by a RangeAllocator, indices stay relative to the first vertex
+ * of their geometry and are drawn with glDrawElementsBaseVertex. Indices are always GL_UNSIGNED_INT.
+ * The buffers have immutable storage. When they are too fragmented for a new geometry the live ranges are
+ * copied to the front of new buffers on the GPU (compact()), and when they are too small the new buffers
+ * are larger. Handles are not affected by this, ranges have to be queried again with getRange().
+ * Only use from the GL thread.
+ */
+class GeometryArena
+{
+  public:
+    constexpr static GeometryHandle invalidHandle = 0xffffffff;
+
+    /* Capacities in vertices and indices */
+    GeometryArena(
+        const VertexLayout& layout, size_t vertexCapacity, size_t indexCapacity, const char* name = "");
+    ~GeometryArena();
+
+    GeometryArena(GeometryArena&&) = delete;
+    GeometryArena(const GeometryArena&) = delete;
+    GeometryArena& operator=(GeometryArena&&) = delete;
+    GeometryArena& operator=(const GeometryArena&) = delete;
+
+    /** Uploads indexed triangles
+     * @param vertexData Tightly packed vertices of the layout of the arena
+     * @param indexData Indices of type indexType (GL_UNSIGNED_SHORT or GL_UNSIGNED_INT), 16 bit indices are
+     *                  widened
+     */
+    GeometryHandle
+    add(std::span<const uint8_t> vertexData, std::span<const uint8_t> indexData, GLenum indexType);
+
+    template <typename Vertex>
+    GeometryHandle add(std::span<const Vertex> vertices, std::span<const GLuint> indices)
+    {
+        return add(
+            {reinterpret_cast<const uint8_t*>(vertices.data()), vertices.size_bytes()},
+            {reinterpret_cast<const uint8_t*>(indices.data()), indices.size_bytes()},
+            GL_UNSIGNED_INT);
+    }
+
+    /* Frees the ranges of the geometry, the handle can be reused by later add()s */
+    void remove(GeometryHandle handle);
+
+    /* Moves all geometry to the front of the buffers, so all free space is a single range at the end */
+    void compact();
+    /** Compacts if the free vertices or indices are fragmented more than maxFragmentation
+     * (see RangeAllocatorStats::fragmentation), eg. once per frame after meshes were removed
+     * @return true if the arena was compacted
+     */
+    bool compactIfFragmented(float maxFragmentation = 0.5f);
+
+    /* Binds the shared VAO of the layout with the buffers of the arena attached */
+    void bind() const;
+    /* Draws all triangles of the geometry, the arena has to be bound */
+    void draw(GeometryHandle handle) const;
+    /* Draws count indices starting at firstIndex (relative to the geometry, eg. one LOD), has to be bound */
+    void draw(GeometryHandle handle, GLuint firstIndex, GLsizei count) const;
+    /* Binds the arena, draws all the geometries and unbinds it again */
+    void draw(std::span<const GeometryHandle> handles) const;
+
+    [[nodiscard]] inline const GeometryRange& getRange(GeometryHandle handle) const
+    {
+        return geometries[handle].range;
+    }
+
+    [[nodiscard]] inline const VertexLayout& getLayout() const
+    {
+        return layout;
+    }
+
+    [[nodiscard]] inline GLuint getVertexBuffer() const
+    {
+        return buffers[0];
+    }
+
+    [[nodiscard]] inline GLuint getIndexBuffer() const
+    {
+        return buffers[1];
+    }
+
+    [[nodiscard]] GeometryArenaStats getStats() const;
+
+  private:
+    struct Geometry
+    {
+        GeometryRange range;
+        bool live = false;
+    };
+
+    /* Allocates new buffers, copies all live geometry to their front and replaces the old buffers */
+    void relocate(size_t newVertexCapacity, size_t newIndexCapacity);
+    void
+    createBuffers(size_t vertexCapacity, size_t indexCapacity, GLuint* vertexBuffer, GLuint* indexBuffer);
+    void deleteBuffers();
+
+    VertexLayout layout;
+    std::string name;
+    // shared with all meshes of the same layout, see VertexArrayCache
+    GLuint vaoHandle = 0xffffffff;
+    // vertex and index buffer
+    GLuint buffers[2] = {0xffffffff, 0xffffffff}; // NOLINT
+    RangeAllocator vertexAllocator;
+    RangeAllocator indexAllocator;
+    std::vector<Geometry> geometries;
+    std::vector<GeometryHandle> freeHandles;
+    size_t compactions = 0;
+    size_t grows = 0;
+    size_t movedBytes = 0;
+};
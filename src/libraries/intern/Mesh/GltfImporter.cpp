@@ -0,0 +1,679 @@
+#include "MeshImporter.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <limits>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <vector>
+
+#include <intern/Misc/Json.h>
+#include <intern/Misc/MappedFile.h>
+
+#include "MeshImporterShared.h"
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    constexpr uint32_t glbMagic = 0x46546C67;      // "glTF"
+    constexpr uint32_t glbChunkJson = 0x4E4F534A;  // "JSON"
+    constexpr uint32_t glbChunkBinary = 0x004E4942; // "BIN\0"
+
+    // glTF enums
+    constexpr int componentByte = 5120;
+    constexpr int componentUnsignedByte = 5121;
+    constexpr int componentShort = 5122;
+    constexpr int componentUnsignedShort = 5123;
+    constexpr int componentUnsignedInt = 5125;
+    constexpr int componentFloat = 5126;
+    constexpr int modeTriangles = 4;
+
+    // resolved accessor, element i starts at data + i * stride
+    struct Accessor
+    {
+        const uint8_t* data = nullptr;
+        size_t count = 0;
+        size_t stride = 0;
+        int componentType = 0;
+        int components = 0;
+        bool normalized = false;
+    };
+
+    int componentSize(int componentType)
+    {
+        switch(componentType)
+        {
+        case componentByte:
+        case componentUnsignedByte:
+            return 1;
+        case componentShort:
+        case componentUnsignedShort:
+            return 2;
+        case componentUnsignedInt:
+        case componentFloat:
+            return 4;
+        default:
+            return 0;
+        }
+    }
+
+    int componentCount(std::string_view type)
+    {
+        if(type == "SCALAR")
+            return 1;
+        if(type == "VEC2")
+            return 2;
+        if(type == "VEC3")
+            return 3;
+        if(type == "VEC4")
+            return 4;
+        return 0;
+    }
+
+    // reads component c of element i as float, normalizing integers if the accessor says so
+    float readFloat(const Accessor& accessor, size_t i, int c)
+    {
+        const uint8_t* element = accessor.data + i * accessor.stride;
+        switch(accessor.componentType)
+        {
+        case componentFloat:
+        {
+            float value = 0.0f;
+            memcpy(&value, element + c * 4, 4);
+            return value;
+        }
+        case componentUnsignedByte:
+        {
+            const float value = element[c];
+            return accessor.normalized ? value / 255.0f : value;
+        }
+        case componentByte:
+        {
+            const float value = static_cast<int8_t>(element[c]);
+            return accessor.normalized ? std::max(value / 127.0f, -1.0f) : value;
+        }
+        case componentUnsignedShort:
+        {
+            uint16_t value = 0;
+            memcpy(&value, element + c * 2, 2);
+            return accessor.normalized ? static_cast<float>(value) / 65535.0f : static_cast<float>(value);
+        }
+        case componentShort:
+        {
+            int16_t value = 0;
+            memcpy(&value, element + c * 2, 2);
+            return accessor.normalized ? std::max(static_cast<float>(value) / 32767.0f, -1.0f)
+                                       : static_cast<float>(value);
+        }
+        default:
+            return 0.0f;
+        }
+    }
+
+    uint32_t readIndex(const Accessor& accessor, size_t i)
+    {
+        const uint8_t* element = accessor.data + i * accessor.stride;
+        switch(accessor.componentType)
+        {
+        case componentUnsignedByte:
+            return element[0];
+        case componentUnsignedShort:
+        {
+            uint16_t value = 0;
+            memcpy(&value, element, 2);
+            return value;
+        }
+        default:
+        {
+            uint32_t value = 0;
+            memcpy(&value, element, 4);
+            return value;
+        }
+        }
+    }
+
+    bool decodeBase64(std::string_view text, std::vector<uint8_t>& bytes)
+    {
+        uint32_t bits = 0;
+        int bitCount = 0;
+        bytes.reserve(text.size() / 4 * 3);
+        for(const char c : text)
+        {
+            uint32_t value = 0;
+            if(c >= 'A' && c <= 'Z')
+                value = c - 'A';
+            else if(c >= 'a' && c <= 'z')
+                value = c - 'a' + 26;
+            else if(c >= '0' && c <= '9')
+                value = c - '0' + 52;
+            else if(c == '+')
+                value = 62;
+            else if(c == '/')
+                value = 63;
+            else if(c == '=')
+                break;
+            else
+                return false;
+            bits = (bits << 6u) | value;
+            bitCount += 6;
+            if(bitCount >= 8)
+            {
+                bitCount -= 8;
+                bytes.push_back(static_cast<uint8_t>(bits >> static_cast<uint32_t>(bitCount)));
+            }
+        }
+        return true;
+    }
+
+    std::string decodeURI(std::string_view uri)
+    {
+        std::string decoded;
+        for(size_t i = 0; i < uri.size(); i++)
+        {
+            int value = 0;
+            if(uri[i] == '%' && i + 2 < uri.size() &&
+               std::from_chars(uri.data() + i + 1, uri.data() + i + 3, value, 16).ptr == uri.data() + i + 3)
+            {
+                decoded += static_cast<char>(value);
+                i += 2;
+            }
+            else
+            {
+                decoded += uri[i];
+            }
+        }
+        return decoded;
+    }
+
+    glm::mat4 nodeTransform(const JsonValue& node)
+    {
+        glm::mat4 matrix{1.0f};
+        const JsonValue& values = node["matrix"];
+        if(values.size() == 16)
+        {
+            for(int i = 0; i < 16; i++)
+            {
+                matrix[i / 4][i % 4] = static_cast<float>(values[i].getNumber());
+            }
+            return matrix;
+        }
+
+        const JsonValue& t = node["translation"];
+        const JsonValue& r = node["rotation"];
+        const JsonValue& s = node["scale"];
+        const float x = static_cast<float>(r[0].getNumber(0.0));
+        const float y = static_cast<float>(r[1].getNumber(0.0));
+        const float z = static_cast<float>(r[2].getNumber(0.0));
+        const float w = static_cast<float>(r[3].getNumber(1.0));
+        // rotation matrix of the unit quaternion, columns scaled
+        const float rotation[3][3] = {
+            {1 - 2 * (y * y + z * z), 2 * (x * y + z * w), 2 * (x * z - y * w)},
+            {2 * (x * y - z * w), 1 - 2 * (x * x + z * z), 2 * (y * z + x * w)},
+            {2 * (x * z + y * w), 2 * (y * z - x * w), 1 - 2 * (x * x + y * y)}};
+        for(int column = 0; column < 3; column++)
+        {
+            const float scale = static_cast<float>(s[column].getNumber(1.0));
+            for(int row = 0; row < 3; row++)
+            {
+                matrix[column][row] = rotation[column][row] * scale;
+            }
+            matrix[3][column] = static_cast<float>(t[column].getNumber(0.0));
+        }
+        return matrix;
+    }
+
+    class GltfImporter
+    {
+      public:
+        GltfImporter(const std::string& file, ThreadPool* pool) : file(file), pool(pool)
+        {
+        }
+
+        bool load(MeshData& mesh, size_t& bytes)
+        {
+            const MappedFile mapping{file};
+            if(!mapping.isOpen())
+            {
+                std::cout << "Could not load mesh " << file << std::endl;
+                return false;
+            }
+            bytes = mapping.size();
+
+            std::string_view json{reinterpret_cast<const char*>(mapping.data()), mapping.size()};
+            std::span<const uint8_t> binaryChunk;
+            uint32_t magic = 0;
+            if(mapping.size() >= 12)
+            {
+                memcpy(&magic, mapping.data(), 4);
+            }
+            if(magic == glbMagic && !parseGlb(mapping.bytes(), json, binaryChunk))
+            {
+                std::cout << "Invalid glb container in " << file << std::endl;
+                return false;
+            }
+            if(!parseJson(json, document))
+            {
+                std::cout << "Invalid JSON in " << file << std::endl;
+                return false;
+            }
+            if(!loadBuffers(binaryChunk, bytes))
+            {
+                return false;
+            }
+
+            const JsonValue& scenes = document["scenes"];
+            if(scenes.size() > 0)
+            {
+                const JsonValue& scene = scenes[static_cast<size_t>(document["scene"].getInt(0))];
+                for(const JsonValue& root : scene["nodes"].getArray())
+                {
+                    if(!addNode(root.getInt(-1), glm::mat4{1.0f}, 0, mesh))
+                    {
+                        return false;
+                    }
+                }
+            }
+            else
+            {
+                // no scene, nodes would not be displayed. Take the meshes as they are instead
+                for(size_t i = 0; i < document["meshes"].size(); i++)
+                {
+                    if(!addMesh(document["meshes"][i], glm::mat4{1.0f}, mesh))
+                    {
+                        return false;
+                    }
+                }
+            }
+            return true;
+        }
+
+      private:
+        static bool
+        parseGlb(std::span<const uint8_t> bytes, std::string_view& json, std::span<const uint8_t>& binary)
+        {
+            uint32_t header[3];
+            memcpy(header, bytes.data(), sizeof(header));
+            if(header[1] != 2 || header[2] > bytes.size())
+            {
+                return false;
+            }
+            size_t offset = 12;
+            json = {};
+            while(offset + 8 <= header[2])
+            {
+                uint32_t chunk[2];
+                memcpy(chunk, bytes.data() + offset, sizeof(chunk));
+                offset += 8;
+                if(chunk[0] > header[2] - offset)
+                {
+                    return false;
+                }
+                if(chunk[1] == glbChunkJson && json.empty())
+                {
+                    json = {reinterpret_cast<const char*>(bytes.data() + offset), chunk[0]};
+                }
+                else if(chunk[1] == glbChunkBinary && binary.empty())
+                {
+                    binary = bytes.subspan(offset, chunk[0]);
+                }
+                // chunks are 4 byte aligned
+                offset += (chunk[0] + 3u) & ~3u;
+            }
+            return !json.empty();
+        }
+
+        bool loadBuffers(std::span<const uint8_t> binaryChunk, size_t& bytes)
+        {
+            const std::filesystem::path directory = std::filesystem::path(file).parent_path();
+            for(const JsonValue& buffer : document["buffers"].getArray())
+            {
+                const std::string_view uri = buffer["uri"].getString();
+                const std::optional<size_t> byteLength = buffer["byteLength"].getSize();
+                if(!byteLength.has_value())
+                {
+                    std::cout << "Invalid buffer length in " << file << std::endl;
+                    return false;
+                }
+                std::span<const uint8_t> data;
+                if(uri.empty())
+                {
+                    // only the first buffer of a glb may refer to the binary chunk
+                    data = buffers.empty() ? binaryChunk : std::span<const uint8_t>{};
+                }
+                else if(uri.starts_with("data:"))
+                {
+                    const size_t comma = uri.find(',');
+                    std::vector<uint8_t>& decoded = embeddedBuffers.emplace_back();
+                    if(comma == std::string_view::npos || uri.substr(0, comma).find(";base64") == uri.npos ||
+                       !decodeBase64(uri.substr(comma + 1), decoded))
+                    {
+                        std::cout << "Unsupported data URI in " << file << std::endl;
+                        return false;
+                    }
+                    data = decoded;
+                }
+                else
+                {
+                    const std::string path = (directory / decodeURI(uri)).string();
+                    const MappedFile& mapping = externalBuffers.emplace_back(path);
+                    if(!mapping.isOpen())
+                    {
+                        std::cout << "Could not load buffer " << path << std::endl;
+                        return false;
+                    }
+                    bytes += mapping.size();
+                    data = mapping.bytes();
+                }
+                if(data.size() < *byteLength)
+                {
+                    std::cout << "Truncated buffer in " << file << std::endl;
+                    return false;
+                }
+                buffers.push_back(data.first(*byteLength));
+            }
+            return true;
+        }
+
+        // validates that the accessor lies within its buffer
+        bool getAccessor(int index, Accessor& accessor)
+        {
+            const JsonValue& json = document["accessors"][static_cast<size_t>(index)];
+            accessor.componentType = json["componentType"].getInt();
+            accessor.components = componentCount(json["type"].getString());
+            accessor.normalized = json["normalized"].getBool();
+            const std::optional<size_t> count = json["count"].getSize();
+            const size_t elementSize = static_cast<size_t>(componentSize(accessor.componentType)) *
+                                       static_cast<size_t>(accessor.components);
+            // vertices and indices are addressed with 32 bit indices
+            if(!json.isObject() || elementSize == 0 || !count.has_value() ||
+               *count > std::numeric_limits<uint32_t>::max())
+            {
+                std::cout << "Invalid accessor " << index << " in " << file << std::endl;
+                return false;
+            }
+            accessor.count = *count;
+            if(json.find("sparse") != nullptr)
+            {
+                std::cout << "Sparse accessors are not supported, ignoring in " << file << std::endl;
+            }
+
+            const JsonValue* viewIndex = json.find("bufferView");
+            if(viewIndex == nullptr)
+            {
+                // all zeros, as required by the spec
+                zeros.emplace_back(elementSize, 0);
+                accessor.data = zeros.back().data();
+                accessor.stride = 0;
+                return true;
+            }
+            const JsonValue& view = document["bufferViews"][static_cast<size_t>(viewIndex->getInt(-1))];
+            const auto bufferIndex = static_cast<size_t>(view["buffer"].getInt(-1));
+            const std::optional<size_t> viewOffset = view["byteOffset"].getSize(0);
+            const std::optional<size_t> viewLength = view["byteLength"].getSize();
+            const std::optional<size_t> offset = json["byteOffset"].getSize(0);
+            const std::optional<size_t> stride = view["byteStride"].getSize(0);
+            if(!view.isObject() || bufferIndex >= buffers.size() || !viewOffset.has_value() ||
+               !viewLength.has_value() || !offset.has_value() || !stride.has_value())
+            {
+                std::cout << "Invalid buffer view of accessor " << index << " in " << file << std::endl;
+                return false;
+            }
+            accessor.stride = *stride == 0 ? elementSize : *stride;
+            // compared without sums or products, which could wrap around for hostile values
+            const size_t bufferSize = buffers[bufferIndex].size();
+            if(*viewOffset > bufferSize || *viewLength > bufferSize - *viewOffset ||
+               (accessor.count > 0 &&
+                (*offset > *viewLength || elementSize > *viewLength - *offset ||
+                 accessor.count - 1 > (*viewLength - *offset - elementSize) / accessor.stride)))
+            {
+                std::cout << "Accessor " << index << " out of bounds in " << file << std::endl;
+                return false;
+            }
+            accessor.data = buffers[bufferIndex].data() + *viewOffset + *offset;
+            return true;
+        }
+
+        bool addNode(int index, const glm::mat4& parent, int depth, MeshData& mesh)
+        {
+            const JsonValue& node = document["nodes"][static_cast<size_t>(index)];
+            // the node graph has to be a forest, cycles are invalid files
+            if(!node.isObject() || depth > static_cast<int>(document["nodes"].size()))
+            {
+                std::cout << "Invalid node hierarchy in " << file << std::endl;
+                return false;
+            }
+            const glm::mat4 transform = parent * nodeTransform(node);
+            const JsonValue* meshIndex = node.find("mesh");
+            if(meshIndex != nullptr &&
+               !addMesh(document["meshes"][static_cast<size_t>(meshIndex->getInt(-1))], transform, mesh))
+            {
+                return false;
+            }
+            for(const JsonValue& child : node["children"].getArray())
+            {
+                if(!addNode(child.getInt(-1), transform, depth + 1, mesh))
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        bool addMesh(const JsonValue& json, const glm::mat4& transform, MeshData& mesh)
+        {
+            // normals are transformed with the cofactor matrix (the inverse transpose, up to scale),
+            // mirroring transforms also flip the winding order
+            glm::vec3 cofactor[3];
+            for(int i = 0; i < 3; i++)
+            {
+                const glm::vec3 a{transform[(i + 1) % 3]};
+                const glm::vec3 b{transform[(i + 2) % 3]};
+                cofactor[i] = glm::cross(a, b);
+            }
+            const float determinant = glm::dot(glm::vec3{transform[0]}, cofactor[0]);
+            const bool mirrored = determinant < 0.0f;
+
+            for(const JsonValue& primitive : json["primitives"].getArray())
+            {
+                if(primitive["mode"].getInt(modeTriangles) != modeTriangles)
+                {
+                    std::cout << "Skipping non triangle primitive in " << file << std::endl;
+                    continue;
+                }
+                const JsonValue& attributes = primitive["attributes"];
+                Accessor positions;
+                Accessor normals;
+                Accessor uvs;
+                const JsonValue* normalIndex = attributes.find("NORMAL");
+                const JsonValue* uvIndex = attributes.find("TEXCOORD_0");
+                if(!getAccessor(attributes["POSITION"].getInt(-1), positions) || positions.components != 3 ||
+                   (normalIndex != nullptr && !getAccessor(normalIndex->getInt(-1), normals)) ||
+                   (uvIndex != nullptr && !getAccessor(uvIndex->getInt(-1), uvs)))
+                {
+                    return false;
+                }
+                const bool validNormals =
+                    normalIndex == nullptr || (normals.components == 3 && normals.count == positions.count);
+                const bool validUVs =
+                    uvIndex == nullptr || (uvs.components == 2 && uvs.count == positions.count);
+                if(!validNormals || !validUVs)
+                {
+                    std::cout << "Mismatching vertex attributes in " << file << std::endl;
+                    return false;
+                }
+
+                const size_t base = mesh.vertices.size();
+                mesh.vertices.resize(base + positions.count);
+                parallelFor(
+                    pool,
+                    positions.count,
+                    64 * 1024,
+                    [&](size_t begin, size_t end)
+                    {
+                        for(size_t i = begin; i < end; i++)
+                        {
+                            VertexStruct& vertex = mesh.vertices[base + i];
+                            vertex = VertexStruct{};
+                            const glm::vec4 position{
+                                readFloat(positions, i, 0),
+                                readFloat(positions, i, 1),
+                                readFloat(positions, i, 2),
+                                1.0f};
+                            vertex.pos = glm::vec3{transform * position};
+                            if(normalIndex != nullptr)
+                            {
+                                const float x = readFloat(normals, i, 0);
+                                const float y = readFloat(normals, i, 1);
+                                const float z = readFloat(normals, i, 2);
+                                const glm::vec3 normal =
+                                    cofactor[0] * x + cofactor[1] * y + cofactor[2] * z;
+                                const float length = glm::length(normal);
+                                vertex.nrm = length > 0.0f ? normal / (mirrored ? -length : length) : normal;
+                            }
+                            if(uvIndex != nullptr)
+                            {
+                                // glTF has the origin of the uvs in the top left corner
+                                vertex.uv = glm::vec2{readFloat(uvs, i, 0), 1.0f - readFloat(uvs, i, 1)};
+                            }
+                        }
+                    });
+
+                const size_t firstIndex = mesh.indices.size();
+                const JsonValue* indexAccessor = primitive.find("indices");
+                if(indexAccessor != nullptr)
+                {
+                    Accessor indices;
+                    if(!getAccessor(indexAccessor->getInt(-1), indices) || indices.components != 1 ||
+                       (indices.componentType != componentUnsignedByte &&
+                        indices.componentType != componentUnsignedShort &&
+                        indices.componentType != componentUnsignedInt))
+                    {
+                        std::cout << "Invalid index accessor in " << file << std::endl;
+                        return false;
+                    }
+                    mesh.indices.resize(firstIndex + indices.count / 3 * 3);
+                    for(size_t i = 0; i < indices.count / 3 * 3; i++)
+                    {
+                        const uint32_t index = readIndex(indices, i);
+                        if(index >= positions.count)
+                        {
+                            std::cout << "Index out of range in " << file << std::endl;
+                            return false;
+                        }
+                        mesh.indices[firstIndex + i] = static_cast<GLuint>(base + index);
+                    }
+                }
+                else
+                {
+                    mesh.indices.resize(firstIndex + positions.count / 3 * 3);
+                    for(size_t i = 0; i < positions.count / 3 * 3; i++)
+                    {
+                        mesh.indices[firstIndex + i] = static_cast<GLuint>(base + i);
+                    }
+                }
+                if(mirrored)
+                {
+                    for(size_t i = firstIndex; i < mesh.indices.size(); i += 3)
+                    {
+                        std::swap(mesh.indices[i + 1], mesh.indices[i + 2]);
+                    }
+                }
+                if(normalIndex == nullptr)
+                {
+                    // indices are relative to the primitive here
+                    std::vector<GLuint> local(mesh.indices.begin() + firstIndex, mesh.indices.end());
+                    for(GLuint& index : local)
+                    {
+                        index -= static_cast<GLuint>(base);
+                    }
+                    computeMissingNormals(std::span{mesh.vertices}.subspan(base), local);
+                }
+            }
+            return true;
+        }
+
+        const std::string& file;
+        ThreadPool* pool;
+        JsonValue document;
+        std::vector<std::span<const uint8_t>> buffers;
+        std::vector<MappedFile> externalBuffers;
+        std::vector<std::vector<uint8_t>> embeddedBuffers;
+        // storage of accessors without a buffer view
+        std::vector<std::vector<uint8_t>> zeros;
+    };
+} // namespace
+
+bool importGltf(const std::string& file, MeshData& mesh, ThreadPool* pool, MeshImportStats* stats)
+{
+    const auto start = Clock::now();
+    MeshData scene;
+    size_t bytes = 0;
+    GltfImporter importer{file, pool};
+    if(!importer.load(scene, bytes))
+    {
+        return false;
+    }
+    const auto parsed = Clock::now();
+
+    // primitives often share vertices (eg. split by material), weld identical ones
+    const auto components = [&](size_t i)
+    {
+        const VertexStruct& vertex = scene.vertices[i];
+        return std::array<float, 8>{
+            vertex.pos.x, vertex.pos.y, vertex.pos.z, vertex.nrm.x, vertex.nrm.y, vertex.nrm.z, vertex.uv.x,
+            vertex.uv.y};
+    };
+    std::vector<uint32_t> remap;
+    std::vector<uint32_t> unique;
+    weldVertices(
+        scene.vertices.size(),
+        pool,
+        [&](size_t i)
+        {
+            size_t hash = 0;
+            for(const float value : components(i))
+            {
+                // + 0.0f turns -0 into 0, so both hash the same
+                hashCombine(hash, std::bit_cast<uint32_t>(value + 0.0f));
+            }
+            return hash;
+        },
+        [&](size_t i, size_t j) { return components(i) == components(j); },
+        remap,
+        unique);
+
+    mesh.vertices.resize(unique.size());
+    for(size_t i = 0; i < unique.size(); i++)
+    {
+        mesh.vertices[i] = scene.vertices[unique[i]];
+    }
+    mesh.indices.resize(scene.indices.size());
+    for(size_t i = 0; i < scene.indices.size(); i++)
+    {
+        mesh.indices[i] = remap[scene.indices[i]];
+    }
+    const auto welded = Clock::now();
+
+    if(stats != nullptr)
+    {
+        *stats = MeshImportStats{
+            .bytes = bytes,
+            .triangles = mesh.indices.size() / 3,
+            .inputVertices = scene.vertices.size(),
+            .vertices = mesh.vertices.size(),
+            .parseSeconds = std::chrono::duration<double>(parsed - start).count(),
+            .weldSeconds = std::chrono::duration<double>(welded - parsed).count(),
+            .totalSeconds = std::chrono::duration<double>(welded - start).count()};
+    }
+    return true;
+}
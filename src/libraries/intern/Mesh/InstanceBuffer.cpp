@@ -0,0 +1,100 @@
+#include "InstanceBuffer.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+#include <intern/Misc/GPUMemoryTracker.h>
+
+#include "Mesh.h"
+
+namespace
+{
+    size_t alignUp(size_t value, size_t alignment)
+    {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+} // namespace
+
+InstanceBuffer::InstanceBuffer(size_t maxInstances, const char* name) : maxInstances(maxInstances)
+{
+    assert(maxInstances > 0);
+    GLint storageAlignment = 0;
+    glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &storageAlignment);
+    regionStride =
+        alignUp(maxInstances * sizeof(InstanceData), static_cast<size_t>(std::max(storageAlignment, 1)));
+
+    constexpr GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    const size_t bytes = framesInFlight * regionStride;
+    glCreateBuffers(1, &bufferID);
+    glNamedBufferStorage(bufferID, static_cast<GLsizeiptr>(bytes), nullptr, flags);
+    GPUMemoryTracker::get().trackBuffer(bufferID, GPUMemoryCategory::Mesh, bytes);
+    mapped = static_cast<uint8_t*>(glMapNamedBufferRange(bufferID, 0, static_cast<GLsizeiptr>(bytes), flags));
+    assert(mapped != nullptr && "Could not map instance buffer");
+    if(strlen(name) > 0)
+    {
+        glObjectLabel(GL_BUFFER, bufferID, -1, name);
+    }
+}
+
+InstanceBuffer::~InstanceBuffer()
+{
+    glUnmapNamedBuffer(bufferID);
+    GPUMemoryTracker::get().untrackBuffer(bufferID);
+    glDeleteBuffers(1, &bufferID);
+}
+
+void InstanceBuffer::begin()
+{
+    assert(!writing && "begin() called twice without end()");
+    if(fences.wait(region))
+    {
+        stalls++;
+    }
+    instanceCount = 0;
+    writing = true;
+}
+
+bool InstanceBuffer::add(const InstanceData& instance)
+{
+    const std::span<InstanceData> allocated = allocate(1);
+    if(allocated.empty())
+    {
+        return false;
+    }
+    memcpy(allocated.data(), &instance, sizeof(InstanceData));
+    return true;
+}
+
+std::span<InstanceData> InstanceBuffer::allocate(size_t count)
+{
+    assert(writing && "Instances can only be added between begin() and end()");
+    count = std::min(count, maxInstances - instanceCount);
+    auto* first = reinterpret_cast<InstanceData*>(mapped + region * regionStride) + instanceCount;
+    instanceCount += count;
+    return {first, count};
+}
+
+void InstanceBuffer::draw(const Mesh& mesh) const
+{
+    assert(writing && "draw() has to be called between begin() and end()");
+    if(instanceCount == 0)
+    {
+        return;
+    }
+    glBindBufferRange(
+        GL_SHADER_STORAGE_BUFFER,
+        binding,
+        bufferID,
+        static_cast<GLintptr>(region * regionStride),
+        static_cast<GLsizeiptr>(instanceCount * sizeof(InstanceData)));
+    mesh.drawInstanced(static_cast<GLsizei>(instanceCount));
+}
+
+void InstanceBuffer::end()
+{
+    assert(writing && "end() called without begin()");
+    writing = false;
+    fences.fence(region);
+    region = (region + 1) % framesInFlight;
+}
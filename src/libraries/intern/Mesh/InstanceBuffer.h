@@ -0,0 +1,90 @@
+#pragma once
+
+#include <glad/glad/glad.h>
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+#include <intern/Buffer/RegionFences.h>
+
+class Mesh;
+
+/* Data of every instance, as read by src/shaders/Mesh/instanced.vert (std430) */
+struct InstanceData
+{
+    glm::mat4 model{1.0f};
+    glm::vec4 color{1.0f};
+    // not used by instanced.vert, free for other shaders, eg. to index a material table
+    uint32_t materialID = 0;
+    uint32_t padding[3] = {}; // NOLINT
+};
+static_assert(sizeof(InstanceData) == 96);
+
+/** Per instance data that is written anew every frame, for drawing many copies of a Mesh with one
+ * Mesh::drawInstanced call. The shader storage buffer is persistently mapped and split into
+ * framesInFlight regions, one per frame, each guarded by a fence, so writing the instances of the next
+ * frame does not wait for the GPU to finish the previous ones.
+ * Shaders read the instance at index gl_InstanceID of the buffer bound at binding.
+ * Every frame: begin(), add() or allocate() the instances, draw() any number of times, end().
+ * Only use from the GL thread.
+ */
+class InstanceBuffer
+{
+  public:
+    constexpr static size_t framesInFlight = 3;
+    constexpr static GLuint binding = 1;
+
+    explicit InstanceBuffer(size_t maxInstances, const char* name = "");
+    ~InstanceBuffer();
+
+    InstanceBuffer(InstanceBuffer&&) = delete;
+    InstanceBuffer(const InstanceBuffer&) = delete;
+    InstanceBuffer& operator=(InstanceBuffer&&) = delete;
+    InstanceBuffer& operator=(const InstanceBuffer&) = delete;
+
+    /* Starts a frame without instances, waits if the GPU still reads the region of this frame */
+    void begin();
+    /* Returns false if the buffer is full, the instance is dropped then */
+    bool add(const InstanceData& instance);
+    /** Appends count instances that are written by the caller, eg. in parallel.
+     * The memory is write combined: write it sequentially and never read from it.
+     * @return Mapped memory of the instances, shorter than count if the buffer is full
+     */
+    std::span<InstanceData> allocate(size_t count);
+    /* Draws the mesh once for every instance added since begin() */
+    void draw(const Mesh& mesh) const;
+    /* Guards the instances of this frame, call after their last draw */
+    void end();
+
+    [[nodiscard]] inline size_t getInstanceCount() const
+    {
+        return instanceCount;
+    }
+
+    [[nodiscard]] inline size_t getMaxInstances() const
+    {
+        return maxInstances;
+    }
+
+    /* begin() calls that had to wait for the GPU */
+    [[nodiscard]] inline size_t getStalls() const
+    {
+        return stalls;
+    }
+
+  private:
+    size_t maxInstances = 0;
+    // bytes between the regions, aligned for glBindBufferRange
+    size_t regionStride = 0;
+    GLuint bufferID = 0xffffffff;
+    uint8_t* mapped = nullptr;
+
+    RegionFences fences{framesInFlight};
+    size_t region = 0;
+    size_t instanceCount = 0;
+    size_t stalls = 0;
+    bool writing = false;
+};
@@ -1,66 +1,170 @@
 #include "Mesh.h"
 
-#include <numeric>
+#include <cassert>
+
+#include <intern/Misc/GPUMemoryTracker.h>
+
+#include "Meshlets.h"
+#include "VertexArrayCache.h"
+#include "VertexQuantization.h"
+
+namespace
+{
+    // the compact formats are read as vec4 position, vec2 octahedral normal, vec2 uv, vec2 octahedral tangent
+    const VertexLayout& vertexLayout(VertexFormat format)
+    {
+        switch(format)
+        {
+        case VertexFormat::Half:
+            return VertexLayoutOf<HalfVertex>::layout;
+        case VertexFormat::Quantized:
+            return VertexLayoutOf<QuantizedVertex>::layout;
+        case VertexFormat::Full:
+            break;
+        }
+        return VertexLayoutOf<VertexStruct>::layout;
+    }
+} // namespace
 
 Mesh::~Mesh()
 {
     if(initialized)
     {
-        glDeleteVertexArrays(1, &vaoHandle);
+        VertexArrayCache::get().release(vaoHandle);
+        GPUMemoryTracker::get().untrackBuffer(vboHandles[0]);
+        GPUMemoryTracker::get().untrackBuffer(vboHandles[1]);
         glDeleteBuffers(2, &vboHandles[0]);
     }
 }
 
-void Mesh::init(std::span<const VertexStruct> vertices, std::span<const GLuint> indices)
+void Mesh::init(std::span<const VertexStruct> vertices, std::span<const GLuint> indices, VertexFormat format)
+{
+    const std::span<const uint8_t> indexData{
+        reinterpret_cast<const uint8_t*>(indices.data()), indices.size_bytes()};
+    if(format == VertexFormat::Full)
+    {
+        init(
+            {reinterpret_cast<const uint8_t*>(vertices.data()), vertices.size_bytes()},
+            indexData,
+            GL_UNSIGNED_INT);
+        return;
+    }
+    glm::mat4 decode{1.0f};
+    const std::vector<uint8_t> converted = quantizeVertices(vertices, format, &decode);
+    init(converted, indexData, GL_UNSIGNED_INT, format, decode);
+}
+
+void Mesh::init(
+    std::span<const uint8_t> vertexData, std::span<const uint8_t> indexData, GLenum indexType,
+    VertexFormat format, const glm::mat4& positionDecode)
+{
+    this->format = format;
+    this->positionDecode = positionDecode;
+    initBuffers(vertexData, indexData, indexType, vertexLayout(format));
+}
+
+void Mesh::initBuffers(
+    std::span<const uint8_t> vertexData, std::span<const uint8_t> indexData, GLenum indexType,
+    const VertexLayout& layout)
 {
     // todo: warning if already initialized
-    // todo: bool: recalcTangent using mikktspace
+    const auto stride = static_cast<size_t>(layout.stride);
+    assert(vertexData.size() % stride == 0);
+    assert(indexType == GL_UNSIGNED_SHORT || indexType == GL_UNSIGNED_INT);
 
-    indexCount = indices.empty() ? vertices.size() : indices.size();
+    this->indexType = indexType;
+    vertexStride = layout.stride;
+    const size_t indexSize = indexType == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(uint32_t);
+    indexCount = static_cast<unsigned int>(
+        indexData.empty() ? vertexData.size() / stride : indexData.size() / indexSize);
 
-    glCreateVertexArrays(1, &vaoHandle);
-    glBindVertexArray(vaoHandle);
+    vaoHandle = VertexArrayCache::get().acquire(layout);
+
+    glCreateBuffers(1, &vboHandles[0]);
+    glNamedBufferStorage(vboHandles[0], static_cast<GLsizeiptr>(vertexData.size()), vertexData.data(), 0);
+    GPUMemoryTracker::get().trackBuffer(vboHandles[0], GPUMemoryCategory::Mesh, vertexData.size());
+
+    // without indices draw() uses glDrawArrays, so no trivial index buffer is needed
+    vboHandles[1] = 0;
+    if(!indexData.empty())
+    {
+        glCreateBuffers(1, &vboHandles[1]);
+        glNamedBufferStorage(vboHandles[1], static_cast<GLsizeiptr>(indexData.size()), indexData.data(), 0);
+        GPUMemoryTracker::get().trackBuffer(vboHandles[1], GPUMemoryCategory::Mesh, indexData.size());
+    }
+
+    initialized = true;
+}
+
+void Mesh::setDrawnIndexCount(unsigned int count)
+{
+    assert(count <= indexCount);
+    indexCount = count;
+}
 
-    glGenBuffers(2, &vboHandles[0]);
-
-    glBindBuffer(GL_ARRAY_BUFFER, vboHandles[0]);
-    glBufferStorage(GL_ARRAY_BUFFER, sizeof(VertexStruct) * vertices.size(), vertices.data(), 0);
-
-    // position
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(VertexStruct), (void*)0);
-    // normal
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(VertexStruct), (void*)(3 * sizeof(float)));
-    // uvs
-    glEnableVertexAttribArray(2);
-    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(VertexStruct), (void*)(6 * sizeof(float)));
-    // tangents
-    glEnableVertexAttribArray(3);
-    glVertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE, sizeof(VertexStruct), (void*)(8 * sizeof(float)));
-
-    // uses the second buffer as the source for indices
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, vboHandles[1]);
-    if(!indices.empty())
+void Mesh::draw() const
+{
+    // the VAO only holds the layout, the buffers of this mesh are attached here
+    glBindVertexArray(vaoHandle);
+    glVertexArrayVertexBuffer(vaoHandle, 0, vboHandles[0], 0, vertexStride);
+    glVertexArrayElementBuffer(vaoHandle, vboHandles[1]);
+    if(vboHandles[1] != 0)
     {
-        glBufferStorage(GL_ELEMENT_ARRAY_BUFFER, sizeof(GLuint) * indexCount, indices.data(), 0);
+        glDrawElements(GL_TRIANGLES, indexCount, indexType, nullptr);
     }
-    else // if no index buffer was given, construct a trivial one to not break drawing api
+    else
     {
-        std::vector<GLuint> tempIndices(vertices.size());
-        std::iota(tempIndices.begin(), tempIndices.end(), 0);
-        glBufferStorage(GL_ELEMENT_ARRAY_BUFFER, sizeof(GLuint) * tempIndices.size(), tempIndices.data(), 0);
+        glDrawArrays(GL_TRIANGLES, 0, indexCount);
     }
+    glBindVertexArray(0);
+}
 
-    // unbind the VBO, we don't need it anymore
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
+void Mesh::drawInstanced(GLsizei instanceCount) const
+{
+    glBindVertexArray(vaoHandle);
+    glVertexArrayVertexBuffer(vaoHandle, 0, vboHandles[0], 0, vertexStride);
+    glVertexArrayElementBuffer(vaoHandle, vboHandles[1]);
+    if(vboHandles[1] != 0)
+    {
+        glDrawElementsInstanced(GL_TRIANGLES, indexCount, indexType, nullptr, instanceCount);
+    }
+    else
+    {
+        glDrawArraysInstanced(GL_TRIANGLES, 0, indexCount, instanceCount);
+    }
+    glBindVertexArray(0);
+}
 
-    initialized = true;
+void Mesh::draw(GLuint firstIndex, GLsizei count) const
+{
+    assert(vboHandles[1] != 0 && "Ranges can only be drawn from meshes with indices");
+    const size_t indexSize = indexType == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(uint32_t);
+    glBindVertexArray(vaoHandle);
+    glVertexArrayVertexBuffer(vaoHandle, 0, vboHandles[0], 0, vertexStride);
+    glVertexArrayElementBuffer(vaoHandle, vboHandles[1]);
+    glDrawElements(
+        GL_TRIANGLES,
+        count,
+        indexType,
+        reinterpret_cast<const void*>(static_cast<uintptr_t>(firstIndex) * indexSize));
+    glBindVertexArray(0);
 }
 
-void Mesh::draw() const
+void Mesh::draw(const MeshletDrawList& drawList) const
 {
+    assert(vboHandles[1] != 0 && "Ranges can only be drawn from meshes with indices");
+    if(drawList.counts.empty())
+    {
+        return;
+    }
     glBindVertexArray(vaoHandle);
-    glDrawElements(GL_TRIANGLES, indexCount, indexType, nullptr);
+    glVertexArrayVertexBuffer(vaoHandle, 0, vboHandles[0], 0, vertexStride);
+    glVertexArrayElementBuffer(vaoHandle, vboHandles[1]);
+    glMultiDrawElements(
+        GL_TRIANGLES,
+        drawList.counts.data(),
+        indexType,
+        drawList.offsets.data(),
+        static_cast<GLsizei>(drawList.counts.size()));
     glBindVertexArray(0);
-}
\ No newline at end of file
+}
@@ -5,9 +5,15 @@
 #include <glm/ext.hpp>
 #include <glm/glm.hpp>
 
+#include <cstddef>
+#include <cstdint>
 #include <span>
 #include <vector>
 
+#include "VertexLayout.h"
+
+struct MeshletDrawList;
+
 struct VertexStruct
 {
     glm::vec3 pos = glm::vec3(0.0f);
@@ -16,6 +22,37 @@ struct VertexStruct
     glm::vec4 tang = glm::vec4(0.0f);
 };
 
+template <>
+struct VertexLayoutOf<VertexStruct>
+{
+    constexpr static VertexLayout layout = makeVertexLayout<VertexStruct>(
+        {vertexAttribute<glm::vec3>(0, offsetof(VertexStruct, pos)),
+         vertexAttribute<glm::vec3>(1, offsetof(VertexStruct, nrm)),
+         vertexAttribute<glm::vec2>(2, offsetof(VertexStruct, uv)),
+         vertexAttribute<glm::vec4>(3, offsetof(VertexStruct, tang))});
+};
+
+/* For passes that only need positions, eg. depth only or fullscreen passes */
+struct PositionVertex
+{
+    glm::vec3 pos = glm::vec3(0.0f);
+};
+
+template <>
+struct VertexLayoutOf<PositionVertex>
+{
+    constexpr static VertexLayout layout =
+        makeVertexLayout<PositionVertex>({vertexAttribute<glm::vec3>(0, offsetof(PositionVertex, pos))});
+};
+
+/* Layouts the vertices of a Mesh can be stored in on the GPU, see VertexQuantization.h */
+enum struct VertexFormat
+{
+    Full,     // VertexStruct, 48 bytes
+    Half,     // HalfVertex, 20 bytes
+    Quantized // QuantizedVertex, 16 bytes
+};
+
 class Mesh
 {
   public:
@@ -29,14 +66,75 @@ class Mesh
     Mesh& operator=(const Mesh&) = delete;
 
     void draw() const;
+    /* Draws instanceCount copies, the shader tells them apart by gl_InstanceID (see InstanceBuffer) */
+    void drawInstanced(GLsizei instanceCount) const;
+    /* Draws ranges of the index buffer only, eg. the visible meshlets (see MeshletCuller) */
+    void draw(const MeshletDrawList& drawList) const;
+    /* Draws count indices starting at firstIndex, eg. one level of detail */
+    void draw(GLuint firstIndex, GLsizei count) const;
+
+    /* Full for meshes created from custom vertex types */
+    [[nodiscard]] inline VertexFormat getVertexFormat() const
+    {
+        return format;
+    }
+
+    /* GL_UNSIGNED_SHORT or GL_UNSIGNED_INT */
+    [[nodiscard]] inline GLenum getIndexType() const
+    {
+        return indexType;
+    }
+
+    /* Maps the stored positions into object space, has to be applied before the model matrix.
+     * Identity for VertexFormat::Full, compact formats need src/shaders/Mesh/shadedQuantized.vert */
+    [[nodiscard]] inline const glm::mat4& getPositionDecode() const
+    {
+        return positionDecode;
+    }
 
   protected:
-    void init(std::span<const VertexStruct> vertices, std::span<const GLuint> indices = {});
+    /* Without indices the vertices are drawn in order. Vertices are converted if format is not Full */
+    void init(
+        std::span<const VertexStruct> vertices, std::span<const GLuint> indices = {},
+        VertexFormat format = VertexFormat::Full);
+
+    /** Creates the buffers straight from the given memory (eg. a mapped file), nothing is copied on the CPU
+     * @param vertexData Tightly packed vertices of the given format
+     * @param indexData Indices of type indexType (GL_UNSIGNED_SHORT or GL_UNSIGNED_INT), may be empty
+     * @param positionDecode See getPositionDecode, returned by quantizeVertices for compact formats
+     */
+    void init(
+        std::span<const uint8_t> vertexData, std::span<const uint8_t> indexData, GLenum indexType,
+        VertexFormat format = VertexFormat::Full, const glm::mat4& positionDecode = glm::mat4{1.0f});
+
+    /* Vertices of any type with a VertexLayoutOf specialization, uploaded as they are */
+    template <typename Vertex>
+    void init(std::span<const Vertex> vertices, std::span<const GLuint> indices = {})
+    {
+        initBuffers(
+            {reinterpret_cast<const uint8_t*>(vertices.data()), vertices.size_bytes()},
+            {reinterpret_cast<const uint8_t*>(indices.data()), indices.size_bytes()},
+            GL_UNSIGNED_INT,
+            VertexLayoutOf<Vertex>::layout);
+    }
+
+    /* Limits draw() to the first count indices, eg. to LOD 0 if the index buffer holds all LODs */
+    void setDrawnIndexCount(unsigned int count);
 
   private:
+    void initBuffers(
+        std::span<const uint8_t> vertexData, std::span<const uint8_t> indexData, GLenum indexType,
+        const VertexLayout& layout);
+
     bool initialized = false;
+    // shared with all meshes of the same layout, see VertexArrayCache
     GLuint vaoHandle = 0xffffffff;
+    GLsizei vertexStride = 0;
+    // the index buffer is 0 for meshes without indices
     GLuint vboHandles[2] = {0xffffffff, 0xffffffff}; // NOLINT
     GLenum indexType = GL_UNSIGNED_INT;
+    VertexFormat format = VertexFormat::Full;
+    glm::mat4 positionDecode{1.0f};
+    // indices, or vertices if there are none
     unsigned int indexCount = 0;
 };
\ No newline at end of file
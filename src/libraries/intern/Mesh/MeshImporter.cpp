@@ -0,0 +1,114 @@
+#include "MeshImporter.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cctype>
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+
+#include "CookedMesh.h"
+#include "MeshImporterShared.h"
+#include "TangentGeneration.h"
+
+void computeMissingNormals(std::span<VertexStruct> vertices, std::span<const GLuint> indices)
+{
+    std::vector<glm::vec3> normals(vertices.size(), glm::vec3(0.0f));
+    bool missing = false;
+    for(const VertexStruct& vertex : vertices)
+    {
+        missing = missing || (vertex.nrm.x == 0.0f && vertex.nrm.y == 0.0f && vertex.nrm.z == 0.0f);
+    }
+    if(!missing)
+    {
+        return;
+    }
+
+    for(size_t i = 0; i + 2 < indices.size(); i += 3)
+    {
+        const glm::vec3& p0 = vertices[indices[i + 0]].pos;
+        const glm::vec3& p1 = vertices[indices[i + 1]].pos;
+        const glm::vec3& p2 = vertices[indices[i + 2]].pos;
+        // length is twice the area of the triangle
+        const glm::vec3 faceNormal = glm::cross(p1 - p0, p2 - p0);
+        normals[indices[i + 0]] += faceNormal;
+        normals[indices[i + 1]] += faceNormal;
+        normals[indices[i + 2]] += faceNormal;
+    }
+    for(size_t i = 0; i < vertices.size(); i++)
+    {
+        VertexStruct& vertex = vertices[i];
+        const float length = glm::length(normals[i]);
+        if(vertex.nrm.x == 0.0f && vertex.nrm.y == 0.0f && vertex.nrm.z == 0.0f && length > 0.0f)
+        {
+            vertex.nrm = normals[i] / length;
+        }
+    }
+}
+
+bool importMesh(
+    const std::string& file, MeshData& mesh, ThreadPool* pool, MeshImportStats* stats,
+    const MeshImportOptions& options)
+{
+    std::string extension = std::filesystem::path(file).extension().string();
+    std::transform(
+        extension.begin(),
+        extension.end(),
+        extension.begin(),
+        [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    bool imported = false;
+    if(extension == ".obj")
+    {
+        imported = importObj(file, mesh, pool, stats);
+    }
+    else if(extension == ".gltf" || extension == ".glb")
+    {
+        imported = importGltf(file, mesh, pool, stats);
+    }
+    else
+    {
+        std::cout << "Unsupported mesh format " << file << std::endl;
+    }
+    if(!imported || !options.generateTangents)
+    {
+        return imported;
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    generateTangents(mesh.vertices, mesh.indices, pool);
+    if(stats != nullptr)
+    {
+        stats->tangentSeconds =
+            std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        stats->totalSeconds += stats->tangentSeconds;
+    }
+    return true;
+}
+
+ImportedMesh::ImportedMesh(const MeshData& data, VertexFormat format)
+    : vertexCount(data.vertices.size()), triangleCount(data.indices.size() / 3)
+{
+    init(data.vertices, data.indices, format);
+    meshlets = buildMeshlets(data.vertices, data.indices).meshlets;
+    lods = {{.firstIndex = 0, .indexCount = static_cast<uint32_t>(data.indices.size())}};
+}
+
+ImportedMesh::ImportedMesh(const CookedMesh& cooked) : vertexCount(cooked.getHeader().vertexCount)
+{
+    // the LOD ranges are only checked by the CookedMesh constructor
+    assert(cooked.valid() && "Cooked mesh did not pass validation");
+    init(
+        cooked.getStream(CookedMeshStreamType::Vertices),
+        cooked.getStream(CookedMeshStreamType::Indices),
+        cooked.getHeader().indexType);
+    const std::span<const Meshlet> cookedMeshlets = cooked.getMeshlets();
+    meshlets.assign(cookedMeshlets.begin(), cookedMeshlets.end());
+    const std::span<const MeshLod> cookedLods = cooked.getLods();
+    lods.assign(cookedLods.begin(), cookedLods.end());
+    if(lods.empty())
+    {
+        lods = {{.firstIndex = 0, .indexCount = cooked.getHeader().indexCount}};
+    }
+    setDrawnIndexCount(lods[0].indexCount);
+    triangleCount = lods[0].indexCount / 3;
+}
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <glad/glad/glad.h>
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "Mesh.h"
+#include "MeshSimplifier.h"
+#include "Meshlets.h"
+
+class CookedMesh;
+class ThreadPool;
+
+/* Indexed triangle list, in the layout Mesh::init expects */
+struct MeshData
+{
+    std::vector<VertexStruct> vertices;
+    std::vector<GLuint> indices;
+};
+
+struct MeshImportStats
+{
+    // bytes read from disk, including external glTF buffers
+    size_t bytes = 0;
+    size_t triangles = 0;
+    // vertices referenced by the triangles before / after welding
+    size_t inputVertices = 0;
+    size_t vertices = 0;
+    double parseSeconds = 0.0;
+    double weldSeconds = 0.0;
+    // only set if MeshImportOptions::generateTangents was used
+    double tangentSeconds = 0.0;
+    double totalSeconds = 0.0;
+
+    [[nodiscard]] inline double megabytesPerSecond() const
+    {
+        return parseSeconds > 0.0 ? static_cast<double>(bytes) / (1024.0 * 1024.0) / parseSeconds : 0.0;
+    }
+
+    [[nodiscard]] inline double trianglesPerSecond() const
+    {
+        return totalSeconds > 0.0 ? static_cast<double>(triangles) / totalSeconds : 0.0;
+    }
+};
+
+struct MeshImportOptions
+{
+    // computes VertexStruct::tang after importing, see TangentGeneration.h
+    bool generateTangents = false;
+};
+
+/** Loads a Wavefront OBJ file into a single mesh.
+ * The file is split into chunks at line boundaries which are parsed on the pool, if one is given.
+ * Polygons are triangulated as fans, negative (relative) indices are supported, groups and materials
+ * are ignored. Vertices with the same position/uv/normal indices are welded, normals are computed
+ * (area weighted) if the file has none. Tangents are left at 0.
+ * @return false if the file could not be read or contains invalid data
+ */
+bool importObj(
+    const std::string& file, MeshData& mesh, ThreadPool* pool = nullptr, MeshImportStats* stats = nullptr);
+
+/** Loads the triangles of the default scene of a glTF 2.0 file (.gltf with external or embedded
+ * buffers, or .glb) into a single mesh, with the node transforms applied.
+ * Vertices with identical attributes are welded across primitives. Normals are computed if a primitive
+ * has none. Tangents are left at 0.
+ * @return false if the file could not be read or contains invalid data
+ */
+bool importGltf(
+    const std::string& file, MeshData& mesh, ThreadPool* pool = nullptr, MeshImportStats* stats = nullptr);
+
+/* Picks importObj or importGltf based on the file extension */
+bool importMesh(
+    const std::string& file, MeshData& mesh, ThreadPool* pool = nullptr, MeshImportStats* stats = nullptr,
+    const MeshImportOptions& options = {});
+
+/** Mesh created from imported data, with the meshlets of its triangles for culling (see Meshlets.h)
+ * and its levels of detail (see MeshSimplifier.h)
+ */
+class ImportedMesh : public Mesh
+{
+  public:
+    /* Vertices are converted if format is not VertexFormat::Full, see VertexQuantization.h */
+    explicit ImportedMesh(const MeshData& data, VertexFormat format = VertexFormat::Full);
+    /* Buffers are created straight from the mapping of the file, the CookedMesh can be closed afterwards.
+     * Meshlets and LODs are only available if they were cooked, draw() draws LOD 0 */
+    explicit ImportedMesh(const CookedMesh& cooked);
+
+    [[nodiscard]] inline size_t getVertexCount() const
+    {
+        return vertexCount;
+    }
+
+    [[nodiscard]] inline size_t getTriangleCount() const
+    {
+        return triangleCount;
+    }
+
+    [[nodiscard]] inline std::span<const Meshlet> getMeshlets() const
+    {
+        return meshlets;
+    }
+
+    /* At least LOD 0, the full mesh */
+    [[nodiscard]] inline std::span<const MeshLod> getLods() const
+    {
+        return lods;
+    }
+
+    inline void drawLod(size_t lod) const
+    {
+        draw(lods[lod].firstIndex, static_cast<GLsizei>(lods[lod].indexCount));
+    }
+
+  private:
+    size_t vertexCount = 0;
+    size_t triangleCount = 0;
+    std::vector<Meshlet> meshlets;
+    std::vector<MeshLod> lods;
+};
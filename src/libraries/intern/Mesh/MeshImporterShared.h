@@ -0,0 +1,126 @@
+#pragma once
+
+#include <glad/glad/glad.h>
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include <intern/Misc/Hash.h>
+#include <intern/Misc/ThreadPool.h>
+
+#include "Mesh.h"
+
+/*
+    Helpers shared by the OBJ and glTF importers, not part of the public interface.
+*/
+
+// spreads the bits of a combined hash over all 64 bits (murmur3 finalizer)
+inline uint64_t finalizeHash(uint64_t hash)
+{
+    hash ^= hash >> 33u;
+    hash *= 0xFF51AFD7ED558CCDull;
+    hash ^= hash >> 33u;
+    hash *= 0xC4CEB9FE1A85EC53ull;
+    hash ^= hash >> 33u;
+    return hash;
+}
+
+/** Welds duplicates among count input vertices.
+ * The inputs are split into shards by their hash, each shard is deduplicated with its own open
+ * addressing table on the pool. Welded vertices are numbered in the order of their first use, so the
+ * locality of the input is kept.
+ * @param hash Returns the 64 bit hash of input vertex i
+ * @param equal Returns true if input vertices i and j are the same
+ * @param remap Is set to the welded vertex of every input vertex
+ * @param unique Is set to the first input vertex of every welded vertex
+ */
+template <typename Hash, typename Equal>
+void weldVertices(
+    size_t count, ThreadPool* pool, const Hash& hash, const Equal& equal, std::vector<uint32_t>& remap,
+    std::vector<uint32_t>& unique)
+{
+    std::vector<uint64_t> hashes(count);
+    parallelFor(
+        pool,
+        count,
+        64 * 1024,
+        [&](size_t begin, size_t end)
+        {
+            for(size_t i = begin; i < end; i++)
+            {
+                hashes[i] = finalizeHash(hash(i));
+            }
+        });
+
+    // high bits select the shard, low bits the slot within its table
+    const size_t shardCount = pool != nullptr && count > 64 * 1024 ? pool->getThreadCount() + 1 : 1;
+    remap.resize(count);
+    parallelFor(
+        pool,
+        shardCount,
+        1,
+        [&](size_t shardBegin, size_t shardEnd)
+        {
+            std::vector<uint32_t> table;
+            for(size_t shard = shardBegin; shard < shardEnd; shard++)
+            {
+                size_t shardSize = 0;
+                for(size_t i = 0; i < count; i++)
+                {
+                    shardSize += (hashes[i] >> 32u) % shardCount == shard;
+                }
+                // at most half full
+                const size_t tableSize = std::bit_ceil(std::max<size_t>(shardSize * 2, 16));
+                const size_t mask = tableSize - 1;
+                table.assign(tableSize, UINT32_MAX);
+                for(size_t i = 0; i < count; i++)
+                {
+                    if((hashes[i] >> 32u) % shardCount != shard)
+                    {
+                        continue;
+                    }
+                    size_t slot = hashes[i] & mask;
+                    while(true)
+                    {
+                        const uint32_t other = table[slot];
+                        if(other == UINT32_MAX)
+                        {
+                            table[slot] = static_cast<uint32_t>(i);
+                            remap[i] = static_cast<uint32_t>(i);
+                            break;
+                        }
+                        if(hashes[other] == hashes[i] && equal(other, i))
+                        {
+                            remap[i] = other;
+                            break;
+                        }
+                        slot = (slot + 1) & mask;
+                    }
+                }
+            }
+        });
+
+    // inputs point to the first input with the same value, number those in order of appearance
+    unique.clear();
+    for(size_t i = 0; i < count; i++)
+    {
+        if(remap[i] == i)
+        {
+            remap[i] = static_cast<uint32_t>(unique.size());
+            unique.push_back(static_cast<uint32_t>(i));
+        }
+        else
+        {
+            remap[i] = remap[remap[i]];
+        }
+    }
+}
+
+/** Sets the normals of vertices that have none (all components 0) to the area weighted average
+ * of the normals of the triangles using them
+ */
+void computeMissingNormals(std::span<VertexStruct> vertices, std::span<const GLuint> indices);
@@ -0,0 +1,373 @@
+#include "MeshOptimizer.h"
+#include "MeshImporter.h"
+
+#include <intern/Misc/ThreadPool.h>
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <numeric>
+#include <vector>
+
+namespace
+{
+    constexpr uint32_t invalidVertex = ~0u;
+
+    /* FIFO cache simulated with timestamps: a vertex is still in the cache if fewer than cacheSize
+     * vertices were added since it was */
+    struct CacheSimulation
+    {
+        std::vector<uint32_t> timestamps;
+        uint32_t time = 0;
+        uint32_t cacheSize = 0;
+
+        CacheSimulation(size_t vertexCount, uint32_t cacheSize)
+            : timestamps(vertexCount, 0), time(cacheSize + 1), cacheSize(cacheSize)
+        {
+        }
+
+        void flush()
+        {
+            time += cacheSize + 1;
+        }
+
+        // returns the number of misses
+        uint32_t add(const GLuint* indices, size_t count)
+        {
+            uint32_t misses = 0;
+            for(size_t i = 0; i < count; i++)
+            {
+                if(time - timestamps[indices[i]] > cacheSize)
+                {
+                    timestamps[indices[i]] = time++;
+                    misses++;
+                }
+            }
+            return misses;
+        }
+    };
+
+    /* First triangle of every cluster, clusters start wherever all vertices of a triangle miss the cache.
+     * Triangle 0 always starts one, even if it is degenerate and misses fewer than 3 times */
+    std::vector<uint32_t>
+    hardBoundaries(std::span<const GLuint> indices, size_t vertexCount, uint32_t cacheSize)
+    {
+        std::vector<uint32_t> boundaries;
+        CacheSimulation cache{vertexCount, cacheSize};
+        for(size_t triangle = 0; triangle < indices.size() / 3; triangle++)
+        {
+            if(cache.add(&indices[triangle * 3], 3) == 3 || triangle == 0)
+            {
+                boundaries.push_back(static_cast<uint32_t>(triangle));
+            }
+        }
+        return boundaries;
+    }
+
+    /* Splits the hard clusters further, starting a new cluster as soon as the running ACMR of the current
+     * one drops below threshold * the ACMR of the whole hard cluster (Sander et al. 2007) */
+    std::vector<uint32_t> softBoundaries(
+        std::span<const GLuint> indices, size_t vertexCount, std::span<const uint32_t> hard,
+        uint32_t cacheSize, float threshold)
+    {
+        const size_t triangleCount = indices.size() / 3;
+        std::vector<uint32_t> boundaries;
+        CacheSimulation cache{vertexCount, cacheSize};
+        for(size_t cluster = 0; cluster < hard.size(); cluster++)
+        {
+            const size_t start = hard[cluster];
+            const size_t end = cluster + 1 < hard.size() ? hard[cluster + 1] : triangleCount;
+
+            cache.flush();
+            const uint32_t clusterMisses = cache.add(&indices[start * 3], (end - start) * 3);
+            const float clusterThreshold =
+                threshold * static_cast<float>(clusterMisses) / static_cast<float>(end - start);
+
+            boundaries.push_back(static_cast<uint32_t>(start));
+            cache.flush();
+            uint32_t runningMisses = 0;
+            uint32_t runningTriangles = 0;
+            for(size_t triangle = start; triangle < end; triangle++)
+            {
+                runningMisses += cache.add(&indices[triangle * 3], 3);
+                runningTriangles++;
+                const float runningACMR =
+                    static_cast<float>(runningMisses) / static_cast<float>(runningTriangles);
+                if(runningACMR <= clusterThreshold)
+                {
+                    boundaries.push_back(static_cast<uint32_t>(triangle + 1));
+                    cache.flush();
+                    runningMisses = 0;
+                    runningTriangles = 0;
+                }
+            }
+            // the last cluster is what is left over and usually has a bad ACMR, merge it with the one before
+            // (this also removes the boundary at end if the last triangle reached the threshold)
+            if(boundaries.back() != start)
+            {
+                boundaries.pop_back();
+            }
+        }
+        return boundaries;
+    }
+} // namespace
+
+VertexCacheStats analyzeVertexCache(std::span<const GLuint> indices, size_t vertexCount, uint32_t cacheSize)
+{
+    VertexCacheStats stats;
+    if(indices.empty())
+    {
+        return stats;
+    }
+    CacheSimulation cache{vertexCount, cacheSize};
+    stats.misses = cache.add(indices.data(), indices.size());
+
+    std::vector<bool> referenced(vertexCount, false);
+    size_t referencedCount = 0;
+    for(const GLuint index : indices)
+    {
+        referencedCount += referenced[index] ? 0 : 1;
+        referenced[index] = true;
+    }
+    stats.acmr = static_cast<float>(stats.misses) / static_cast<float>(indices.size() / 3);
+    stats.atvr = static_cast<float>(stats.misses) / static_cast<float>(referencedCount);
+    return stats;
+}
+
+void optimizeVertexCache(std::span<GLuint> indices, size_t vertexCount, uint32_t cacheSize)
+{
+    const size_t triangleCount = indices.size() / 3;
+    assert(std::all_of(indices.begin(), indices.end(), [&](GLuint index) { return index < vertexCount; }));
+
+    // triangles using each vertex
+    std::vector<uint32_t> adjacencyOffsets(vertexCount + 1, 0);
+    for(const GLuint index : indices)
+    {
+        adjacencyOffsets[index + 1]++;
+    }
+    std::partial_sum(adjacencyOffsets.begin(), adjacencyOffsets.end(), adjacencyOffsets.begin());
+    std::vector<uint32_t> adjacency(indices.size());
+    {
+        std::vector<uint32_t> cursors(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+        for(size_t i = 0; i < indices.size(); i++)
+        {
+            adjacency[cursors[indices[i]]++] = static_cast<uint32_t>(i / 3);
+        }
+    }
+    // triangles that still have to be emitted
+    std::vector<uint32_t> liveTriangles(vertexCount);
+    for(size_t v = 0; v < vertexCount; v++)
+    {
+        liveTriangles[v] = adjacencyOffsets[v + 1] - adjacencyOffsets[v];
+    }
+
+    std::vector<uint32_t> timestamps(vertexCount, 0);
+    uint32_t time = cacheSize + 1;
+    std::vector<bool> emitted(triangleCount, false);
+    std::vector<uint32_t> deadEnds;
+    deadEnds.reserve(indices.size());
+    std::vector<uint32_t> candidates;
+    std::vector<GLuint> result;
+    result.reserve(indices.size());
+    size_t cursor = 0;
+
+    const auto nextUnfinished = [&]()
+    {
+        // most recently referenced vertex that still has triangles, otherwise the next one in input order
+        while(!deadEnds.empty())
+        {
+            const uint32_t vertex = deadEnds.back();
+            deadEnds.pop_back();
+            if(liveTriangles[vertex] > 0)
+            {
+                return vertex;
+            }
+        }
+        for(; cursor < vertexCount; cursor++)
+        {
+            if(liveTriangles[cursor] > 0)
+            {
+                return static_cast<uint32_t>(cursor);
+            }
+        }
+        return invalidVertex;
+    };
+
+    uint32_t fanning = nextUnfinished();
+    while(fanning != invalidVertex)
+    {
+        // emit all remaining triangles around the fanning vertex
+        candidates.clear();
+        for(uint32_t i = adjacencyOffsets[fanning]; i < adjacencyOffsets[fanning + 1]; i++)
+        {
+            const uint32_t triangle = adjacency[i];
+            if(emitted[triangle])
+            {
+                continue;
+            }
+            emitted[triangle] = true;
+            for(uint32_t c = 0; c < 3; c++)
+            {
+                const GLuint vertex = indices[triangle * 3 + c];
+                result.push_back(vertex);
+                deadEnds.push_back(vertex);
+                candidates.push_back(vertex);
+                liveTriangles[vertex]--;
+                if(time - timestamps[vertex] > cacheSize)
+                {
+                    timestamps[vertex] = time++;
+                }
+            }
+        }
+
+        // continue with the candidate that will still be in the cache after its remaining triangles are
+        // emitted and was added the longest time ago
+        uint32_t best = invalidVertex;
+        int64_t bestPriority = -1;
+        for(const uint32_t vertex : candidates)
+        {
+            if(liveTriangles[vertex] == 0)
+            {
+                continue;
+            }
+            int64_t priority = 0;
+            if(time - timestamps[vertex] + 2 * liveTriangles[vertex] <= cacheSize)
+            {
+                priority = time - timestamps[vertex];
+            }
+            if(priority > bestPriority)
+            {
+                best = vertex;
+                bestPriority = priority;
+            }
+        }
+        fanning = best != invalidVertex ? best : nextUnfinished();
+    }
+    assert(result.size() == triangleCount * 3);
+    std::copy(result.begin(), result.end(), indices.begin());
+}
+
+void optimizeOverdraw(
+    std::span<GLuint> indices, std::span<const VertexStruct> vertices, uint32_t cacheSize, float threshold)
+{
+    const size_t triangleCount = indices.size() / 3;
+    if(triangleCount == 0)
+    {
+        return;
+    }
+    const std::vector<uint32_t> hard = hardBoundaries(indices, vertices.size(), cacheSize);
+    const std::vector<uint32_t> clusters =
+        softBoundaries(indices, vertices.size(), hard, cacheSize, threshold);
+
+    // area weighted centroids and normals
+    struct Cluster
+    {
+        glm::vec3 centroid{0.0f};
+        glm::vec3 normal{0.0f};
+        float area = 0.0f;
+    };
+    std::vector<Cluster> data(clusters.size());
+    glm::vec3 meshCentroid{0.0f};
+    float meshArea = 0.0f;
+    for(size_t cluster = 0; cluster < clusters.size(); cluster++)
+    {
+        const size_t end = cluster + 1 < clusters.size() ? clusters[cluster + 1] : triangleCount;
+        Cluster& c = data[cluster];
+        for(size_t triangle = clusters[cluster]; triangle < end; triangle++)
+        {
+            const glm::vec3& p0 = vertices[indices[triangle * 3 + 0]].pos;
+            const glm::vec3& p1 = vertices[indices[triangle * 3 + 1]].pos;
+            const glm::vec3& p2 = vertices[indices[triangle * 3 + 2]].pos;
+            const glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+            const float area = glm::length(normal);
+            c.centroid += (p0 + p1 + p2) * (area / 3.0f);
+            c.normal += normal;
+            c.area += area;
+        }
+        meshCentroid += c.centroid;
+        meshArea += c.area;
+        c.centroid = c.area > 0.0f ? c.centroid / c.area : c.centroid;
+    }
+    meshCentroid = meshArea > 0.0f ? meshCentroid / meshArea : meshCentroid;
+
+    std::vector<float> keys(clusters.size());
+    for(size_t cluster = 0; cluster < clusters.size(); cluster++)
+    {
+        const Cluster& c = data[cluster];
+        const float length = glm::length(c.normal);
+        keys[cluster] = length > 0.0f ? glm::dot(c.centroid - meshCentroid, c.normal / length) : 0.0f;
+    }
+    std::vector<uint32_t> order(clusters.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return keys[a] > keys[b]; });
+
+    std::vector<GLuint> result;
+    result.reserve(indices.size());
+    for(const uint32_t cluster : order)
+    {
+        const size_t end = cluster + 1 < clusters.size() ? clusters[cluster + 1] : triangleCount;
+        result.insert(result.end(), indices.begin() + clusters[cluster] * 3, indices.begin() + end * 3);
+    }
+    assert(result.size() == triangleCount * 3);
+    std::copy(result.begin(), result.end(), indices.begin());
+}
+
+void optimizeVertexFetch(MeshData& mesh)
+{
+    if(mesh.indices.empty())
+    {
+        return;
+    }
+    std::vector<GLuint> remap(mesh.vertices.size(), invalidVertex);
+    std::vector<VertexStruct> vertices;
+    vertices.reserve(mesh.vertices.size());
+    for(GLuint& index : mesh.indices)
+    {
+        if(remap[index] == invalidVertex)
+        {
+            remap[index] = static_cast<GLuint>(vertices.size());
+            vertices.push_back(mesh.vertices[index]);
+        }
+        index = remap[index];
+    }
+    mesh.vertices = std::move(vertices);
+}
+
+void optimizeMesh(MeshData& mesh, const MeshOptimizationSettings& settings, MeshOptimizationStats* stats)
+{
+    const auto start = std::chrono::steady_clock::now();
+    if(stats != nullptr)
+    {
+        stats->before = analyzeVertexCache(mesh.indices, mesh.vertices.size(), settings.cacheSize);
+    }
+    optimizeVertexCache(mesh.indices, mesh.vertices.size(), settings.cacheSize);
+    if(settings.reduceOverdraw)
+    {
+        optimizeOverdraw(mesh.indices, mesh.vertices, settings.cacheSize, settings.overdrawThreshold);
+    }
+    optimizeVertexFetch(mesh);
+    if(stats != nullptr)
+    {
+        stats->after = analyzeVertexCache(mesh.indices, mesh.vertices.size(), settings.cacheSize);
+        const std::chrono::duration<double> duration = std::chrono::steady_clock::now() - start;
+        stats->seconds = duration.count();
+    }
+}
+
+void optimizeMeshes(
+    std::span<MeshData> meshes, ThreadPool* pool, const MeshOptimizationSettings& settings,
+    std::span<MeshOptimizationStats> stats)
+{
+    assert(stats.empty() || stats.size() == meshes.size());
+    parallelFor(
+        pool,
+        meshes.size(),
+        1,
+        [&](size_t begin, size_t end)
+        {
+            for(size_t i = begin; i < end; i++)
+            {
+                optimizeMesh(meshes[i], settings, stats.empty() ? nullptr : &stats[i]);
+            }
+        });
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <glad/glad/glad.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+#include "Mesh.h"
+
+class ThreadPool;
+struct MeshData;
+
+struct MeshOptimizationSettings
+{
+    // size of the FIFO cache the order is optimized for, and the statistics are measured with
+    uint32_t cacheSize = 16;
+    bool reduceOverdraw = true;
+    // clusters for the overdraw ordering are split once their ACMR gets this close to the ACMR of the
+    // whole cluster, higher values make more (smaller) clusters at the cost of cache efficiency
+    float overdrawThreshold = 1.05f;
+};
+
+/* Post-transform cache efficiency of an index buffer, simulated with a FIFO cache */
+struct VertexCacheStats
+{
+    size_t misses = 0;
+    // average cache misses per triangle, between 0.5 (ideal for large regular meshes) and 3
+    float acmr = 0.0f;
+    // average transformations per referenced vertex, 1 is ideal
+    float atvr = 0.0f;
+};
+
+struct MeshOptimizationStats
+{
+    VertexCacheStats before;
+    VertexCacheStats after;
+    double seconds = 0.0;
+};
+
+VertexCacheStats
+analyzeVertexCache(std::span<const GLuint> indices, size_t vertexCount, uint32_t cacheSize = 16);
+
+/** Reorders the triangles for post-transform cache locality (Tipsify, Sander et al. 2007).
+ * Runs in linear time, the relative order of vertices is not changed.
+ */
+void optimizeVertexCache(std::span<GLuint> indices, size_t vertexCount, uint32_t cacheSize = 16);
+
+/** Reorders clusters of triangles so the ones facing away from the center of the mesh come first, which
+ * reduces overdraw from most directions. Expects cache optimized indices, which are split into clusters
+ * where the cache is flushed and wherever the threshold is reached (see MeshOptimizationSettings).
+ */
+void optimizeOverdraw(
+    std::span<GLuint> indices, std::span<const VertexStruct> vertices, uint32_t cacheSize = 16,
+    float threshold = 1.05f);
+
+/** Reorders the vertices in the order they are first referenced by the indices, so vertex fetch reads
+ * memory sequentially. Unreferenced vertices are removed.
+ */
+void optimizeVertexFetch(MeshData& mesh);
+
+/* Runs all of the above in order */
+void optimizeMesh(
+    MeshData& mesh, const MeshOptimizationSettings& settings = {}, MeshOptimizationStats* stats = nullptr);
+
+/** Optimizes every mesh, distributed across the pool if one is given
+ * @param stats Empty, or one entry per mesh
+ */
+void optimizeMeshes(
+    std::span<MeshData> meshes, ThreadPool* pool = nullptr, const MeshOptimizationSettings& settings = {},
+    std::span<MeshOptimizationStats> stats = {});
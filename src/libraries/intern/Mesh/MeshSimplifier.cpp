@@ -0,0 +1,415 @@
+#include "MeshSimplifier.h"
+#include "MeshImporter.h"
+#include "MeshOptimizer.h"
+
+#include <intern/Misc/ThreadPool.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+#include <numeric>
+
+namespace
+{
+    /* error(p) = p^T A p + 2 b^T p + c, summed over planes weighted by their area */
+    struct Quadric
+    {
+        double a00 = 0.0, a01 = 0.0, a02 = 0.0, a11 = 0.0, a12 = 0.0, a22 = 0.0;
+        double b0 = 0.0, b1 = 0.0, b2 = 0.0;
+        double c = 0.0;
+        double weight = 0.0;
+
+        void addPlane(const glm::vec3& normal, float distance, float area)
+        {
+            const double x = normal.x;
+            const double y = normal.y;
+            const double z = normal.z;
+            const double d = distance;
+            a00 += area * x * x;
+            a01 += area * x * y;
+            a02 += area * x * z;
+            a11 += area * y * y;
+            a12 += area * y * z;
+            a22 += area * z * z;
+            b0 += area * x * d;
+            b1 += area * y * d;
+            b2 += area * z * d;
+            c += area * d * d;
+            weight += area;
+        }
+
+        void add(const Quadric& other)
+        {
+            a00 += other.a00;
+            a01 += other.a01;
+            a02 += other.a02;
+            a11 += other.a11;
+            a12 += other.a12;
+            a22 += other.a22;
+            b0 += other.b0;
+            b1 += other.b1;
+            b2 += other.b2;
+            c += other.c;
+            weight += other.weight;
+        }
+
+        // sum of the weighted squared distances, not normalized
+        [[nodiscard]] double evaluate(const glm::vec3& p) const
+        {
+            const double x = p.x;
+            const double y = p.y;
+            const double z = p.z;
+            return a00 * x * x + a11 * y * y + a22 * z * z + 2.0 * (a01 * x * y + a02 * x * z + a12 * y * z) +
+                   2.0 * (b0 * x + b1 * y + b2 * z) + c;
+        }
+    };
+
+    struct Collapse
+    {
+        GLuint from = 0;
+        GLuint to = 0;
+        float cost = 0.0f;
+    };
+
+    uint64_t edgeKey(GLuint a, GLuint b)
+    {
+        return (static_cast<uint64_t>(a) << 32u) | b;
+    }
+
+    // vertices on open borders (if requested) and on seams, where other vertices share the position
+    std::vector<bool> lockedVertices(
+        std::span<const VertexStruct> vertices, std::span<const GLuint> indices, bool lockBorders)
+    {
+        std::vector<bool> locked(vertices.size(), false);
+
+        std::vector<GLuint> order(vertices.size());
+        std::iota(order.begin(), order.end(), 0);
+        const auto positionLess = [&](GLuint a, GLuint b)
+        {
+            const glm::vec3& p = vertices[a].pos;
+            const glm::vec3& q = vertices[b].pos;
+            return p.x != q.x ? p.x < q.x : (p.y != q.y ? p.y < q.y : p.z < q.z);
+        };
+        std::sort(order.begin(), order.end(), positionLess);
+        for(size_t i = 1; i < order.size(); i++)
+        {
+            if(!positionLess(order[i - 1], order[i]))
+            {
+                locked[order[i - 1]] = true;
+                locked[order[i]] = true;
+            }
+        }
+
+        if(lockBorders)
+        {
+            std::vector<uint64_t> edges;
+            edges.reserve(indices.size());
+            for(size_t i = 0; i < indices.size(); i += 3)
+            {
+                for(size_t e = 0; e < 3; e++)
+                {
+                    edges.push_back(edgeKey(indices[i + e], indices[i + (e + 1) % 3]));
+                }
+            }
+            std::sort(edges.begin(), edges.end());
+            for(const uint64_t edge : edges)
+            {
+                const auto a = static_cast<GLuint>(edge >> 32u);
+                const auto b = static_cast<GLuint>(edge);
+                // an edge without its opposite belongs to a single triangle
+                if(!std::binary_search(edges.begin(), edges.end(), edgeKey(b, a)))
+                {
+                    locked[a] = true;
+                    locked[b] = true;
+                }
+            }
+        }
+        return locked;
+    }
+} // namespace
+
+std::vector<GLuint> simplifyMesh(
+    std::span<const VertexStruct> vertices, std::span<const GLuint> indices, size_t targetIndexCount,
+    const SimplifySettings& settings, float* error)
+{
+    assert(indices.size() % 3 == 0);
+    std::vector<GLuint> result(indices.begin(), indices.end());
+    if(error != nullptr)
+    {
+        *error = 0.0f;
+    }
+    if(vertices.empty() || result.size() <= targetIndexCount)
+    {
+        return result;
+    }
+
+    // errors are measured in the bounds of the mesh, scaled so the largest extent is 1
+    glm::vec3 minimum = vertices[0].pos;
+    glm::vec3 maximum = vertices[0].pos;
+    for(const VertexStruct& vertex : vertices)
+    {
+        minimum = glm::min(minimum, vertex.pos);
+        maximum = glm::max(maximum, vertex.pos);
+    }
+    const glm::vec3 extent = maximum - minimum;
+    const float scale = 1.0f / std::max({extent.x, extent.y, extent.z, 1e-20f});
+    std::vector<glm::vec3> positions(vertices.size());
+    for(size_t v = 0; v < vertices.size(); v++)
+    {
+        positions[v] = (vertices[v].pos - minimum) * scale;
+    }
+
+    const std::vector<bool> locked = lockedVertices(vertices, indices, settings.lockBorders);
+    std::vector<Quadric> quadrics(vertices.size());
+    for(size_t i = 0; i < result.size(); i += 3)
+    {
+        const glm::vec3& p0 = positions[result[i + 0]];
+        const glm::vec3 normal = glm::cross(positions[result[i + 1]] - p0, positions[result[i + 2]] - p0);
+        const float area = glm::length(normal);
+        if(area == 0.0f)
+        {
+            continue;
+        }
+        const glm::vec3 unitNormal = normal / area;
+        for(size_t c = 0; c < 3; c++)
+        {
+            quadrics[result[i + c]].addPlane(unitNormal, -glm::dot(unitNormal, p0), area * 0.5f);
+        }
+    }
+
+    const float attributeWeight = settings.attributeWeight * settings.attributeWeight;
+    const auto collapseCost = [&](GLuint from, GLuint to)
+    {
+        const Quadric& a = quadrics[from];
+        const Quadric& b = quadrics[to];
+        const double weight = a.weight + b.weight;
+        const double distance =
+            weight > 0.0 ? (a.evaluate(positions[to]) + b.evaluate(positions[to])) / weight : 0.0;
+        const glm::vec3 normal = vertices[from].nrm - vertices[to].nrm;
+        const glm::vec2 uv = vertices[from].uv - vertices[to].uv;
+        const float attributes = glm::dot(normal, normal) + uv.x * uv.x + uv.y * uv.y;
+        return static_cast<float>(std::max(distance, 0.0)) + attributeWeight * attributes;
+    };
+
+    const auto triangleNormal = [&](const GLuint* corners)
+    {
+        const glm::vec3& p0 = positions[corners[0]];
+        return glm::cross(positions[corners[1]] - p0, positions[corners[2]] - p0);
+    };
+
+    std::vector<GLuint> remap(vertices.size());
+    std::iota(remap.begin(), remap.end(), 0);
+    std::vector<bool> touched(vertices.size());
+    std::vector<uint64_t> edges;
+    std::vector<Collapse> collapses;
+    std::vector<uint32_t> adjacencyOffsets(vertices.size() + 1);
+    std::vector<uint32_t> adjacency;
+    const float maxCost = settings.maxError * settings.maxError;
+    float worstCost = 0.0f;
+
+    // every pass collapses the cheapest edges that do not share vertices, then rebuilds the triangles
+    while(result.size() > targetIndexCount)
+    {
+        edges.clear();
+        for(size_t i = 0; i < result.size(); i += 3)
+        {
+            for(size_t e = 0; e < 3; e++)
+            {
+                const GLuint a = result[i + e];
+                const GLuint b = result[i + (e + 1) % 3];
+                edges.push_back(edgeKey(std::min(a, b), std::max(a, b)));
+            }
+        }
+        std::sort(edges.begin(), edges.end());
+        edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+
+        collapses.clear();
+        for(const uint64_t edge : edges)
+        {
+            const auto a = static_cast<GLuint>(edge >> 32u);
+            const auto b = static_cast<GLuint>(edge);
+            constexpr float infinite = std::numeric_limits<float>::infinity();
+            const float ab = locked[a] ? infinite : collapseCost(a, b);
+            const float ba = locked[b] ? infinite : collapseCost(b, a);
+            const Collapse collapse = ab <= ba ? Collapse{a, b, ab} : Collapse{b, a, ba};
+            if(collapse.cost <= maxCost)
+            {
+                collapses.push_back(collapse);
+            }
+        }
+        if(collapses.empty())
+        {
+            break;
+        }
+        std::sort(
+            collapses.begin(),
+            collapses.end(),
+            [](const Collapse& a, const Collapse& b) { return a.cost < b.cost; });
+
+        // triangles around every vertex
+        std::fill(adjacencyOffsets.begin(), adjacencyOffsets.end(), 0);
+        for(const GLuint index : result)
+        {
+            adjacencyOffsets[index + 1]++;
+        }
+        std::partial_sum(adjacencyOffsets.begin(), adjacencyOffsets.end(), adjacencyOffsets.begin());
+        adjacency.resize(result.size());
+        {
+            std::vector<uint32_t> cursors(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+            for(size_t i = 0; i < result.size(); i++)
+            {
+                adjacency[cursors[result[i]]++] = static_cast<uint32_t>(i / 3);
+            }
+        }
+
+        std::fill(touched.begin(), touched.end(), false);
+        const size_t removable = (result.size() - targetIndexCount) / 3;
+        size_t removed = 0;
+        for(const Collapse& collapse : collapses)
+        {
+            if(removed >= removable)
+            {
+                break;
+            }
+            if(touched[collapse.from] || touched[collapse.to])
+            {
+                continue;
+            }
+            // triangles around from must not flip, the ones also using to disappear
+            bool flips = false;
+            size_t degenerate = 0;
+            for(uint32_t i = adjacencyOffsets[collapse.from]; i < adjacencyOffsets[collapse.from + 1]; i++)
+            {
+                const GLuint* triangle = &result[size_t{adjacency[i]} * 3];
+                GLuint corners[3] = {remap[triangle[0]], remap[triangle[1]], remap[triangle[2]]}; // NOLINT
+                if(corners[0] == corners[1] || corners[1] == corners[2] || corners[2] == corners[0])
+                {
+                    // already removed by another collapse of this pass
+                    continue;
+                }
+                if(std::find(corners, corners + 3, collapse.to) != corners + 3)
+                {
+                    degenerate++;
+                    continue;
+                }
+                const glm::vec3 before = triangleNormal(corners);
+                std::replace(corners, corners + 3, collapse.from, collapse.to);
+                const glm::vec3 after = triangleNormal(corners);
+                // rejecting large rotations too keeps triangles from flipping over several passes
+                if(glm::dot(before, after) <= 0.25f * glm::length(before) * glm::length(after))
+                {
+                    flips = true;
+                    break;
+                }
+            }
+            if(flips)
+            {
+                continue;
+            }
+            remap[collapse.from] = collapse.to;
+            quadrics[collapse.to].add(quadrics[collapse.from]);
+            touched[collapse.from] = true;
+            touched[collapse.to] = true;
+            removed += degenerate;
+            worstCost = std::max(worstCost, collapse.cost);
+        }
+        if(removed == 0)
+        {
+            break;
+        }
+
+        size_t written = 0;
+        for(size_t i = 0; i < result.size(); i += 3)
+        {
+            const GLuint a = remap[result[i + 0]];
+            const GLuint b = remap[result[i + 1]];
+            const GLuint c = remap[result[i + 2]];
+            if(a != b && b != c && c != a)
+            {
+                result[written++] = a;
+                result[written++] = b;
+                result[written++] = c;
+            }
+        }
+        result.resize(written);
+    }
+
+    if(error != nullptr)
+    {
+        *error = std::sqrt(worstCost);
+    }
+    return result;
+}
+
+std::vector<MeshLod> buildLods(MeshData& mesh, const LodSettings& settings, ThreadPool* pool)
+{
+    std::vector<MeshLod> lods{{.firstIndex = 0, .indexCount = static_cast<uint32_t>(mesh.indices.size())}};
+    if(mesh.indices.empty() || settings.maxLods <= 1)
+    {
+        return lods;
+    }
+
+    // simplifyMesh measures errors relative to the largest extent
+    glm::vec3 minimum = mesh.vertices[0].pos;
+    glm::vec3 maximum = mesh.vertices[0].pos;
+    for(const VertexStruct& vertex : mesh.vertices)
+    {
+        minimum = glm::min(minimum, vertex.pos);
+        maximum = glm::max(maximum, vertex.pos);
+    }
+    const glm::vec3 extent = maximum - minimum;
+    const float scale = std::max({extent.x, extent.y, extent.z});
+
+    std::vector<std::vector<GLuint>> levels(settings.maxLods - 1);
+    std::vector<float> errors(levels.size());
+    parallelFor(
+        pool,
+        levels.size(),
+        1,
+        [&](size_t begin, size_t end)
+        {
+            for(size_t i = begin; i < end; i++)
+            {
+                const double ratio = std::pow(settings.reduction, static_cast<double>(i + 1));
+                const auto triangles = static_cast<double>(mesh.indices.size() / 3);
+                const size_t target = static_cast<size_t>(triangles * ratio) * 3;
+                levels[i] = simplifyMesh(mesh.vertices, mesh.indices, target, settings.simplify, &errors[i]);
+                optimizeVertexCache(levels[i], mesh.vertices.size());
+            }
+        });
+
+    for(size_t i = 0; i < levels.size(); i++)
+    {
+        const MeshLod& previous = lods.back();
+        if(previous.indexCount / 3 < settings.minTriangles || levels[i].size() * 4 > previous.indexCount * 3)
+        {
+            break;
+        }
+        lods.push_back(
+            {.firstIndex = static_cast<uint32_t>(mesh.indices.size()),
+             .indexCount = static_cast<uint32_t>(levels[i].size()),
+             // selectLod relies on errors that only grow
+             .error = std::max(errors[i] * scale, previous.error)});
+        mesh.indices.insert(mesh.indices.end(), levels[i].begin(), levels[i].end());
+    }
+    return lods;
+}
+
+float projectedScale(const glm::mat4& projection, float viewportHeight, float distance)
+{
+    // projection[1][1] is 1 / tan(fovy / 2)
+    return projection[1][1] * 0.5f * viewportHeight / std::max(distance, 1e-6f);
+}
+
+size_t selectLod(std::span<const MeshLod> lods, float pixelsPerUnit, float maxPixelError)
+{
+    for(size_t i = lods.size(); i-- > 1;)
+    {
+        if(lods[i].error * pixelsPerUnit <= maxPixelError)
+        {
+            return i;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <glad/glad/glad.h>
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "Mesh.h"
+
+class ThreadPool;
+struct MeshData;
+
+struct SimplifySettings
+{
+    // collapses with a larger error are not done, relative to the largest extent of the mesh
+    float maxError = 0.01f;
+    // how much differences in normals and uvs count compared to (relative) distances
+    float attributeWeight = 0.05f;
+    // vertices on open borders are kept in place, so meshes that are split into parts stay watertight.
+    // Vertices on uv/normal seams (different vertices at the same position) are always kept
+    bool lockBorders = true;
+};
+
+/** Simplifies the triangles with quadric error metrics (Garland & Heckbert 1997) by collapsing edges
+ * into one of their vertices, so the vertices are not modified.
+ * @param targetIndexCount Stops once the result has at most this many indices, or no collapse is below
+ *                         settings.maxError anymore
+ * @param error Set to the largest error of all collapses, relative to the largest extent of the mesh
+ * @return Indices of the simplified triangles
+ */
+std::vector<GLuint> simplifyMesh(
+    std::span<const VertexStruct> vertices, std::span<const GLuint> indices, size_t targetIndexCount,
+    const SimplifySettings& settings = {}, float* error = nullptr);
+
+/* Range of the index buffer holding one level of detail, also stored in cooked meshes */
+struct MeshLod
+{
+    uint32_t firstIndex = 0;
+    uint32_t indexCount = 0;
+    // largest distance (in object space) between the surface of this LOD and the full mesh, approximately
+    float error = 0.0f;
+    uint32_t reserved = 0;
+};
+static_assert(sizeof(MeshLod) == 16);
+
+struct LodSettings
+{
+    // including LOD 0, the full mesh
+    size_t maxLods = 6;
+    // triangles of every LOD relative to the previous one
+    float reduction = 0.5f;
+    // no more LODs are added once a LOD has fewer triangles, or can not be reduced by at least a quarter
+    size_t minTriangles = 64;
+    SimplifySettings simplify = {.maxError = 0.05f};
+};
+
+/** Appends the simplified levels of detail to the indices of the mesh. LOD 0 keeps the original indices.
+ * Every LOD is simplified from the full mesh, all of them in parallel if a pool is given, and is optimized
+ * for the vertex cache afterwards.
+ * @return The LODs, from the most to the least detailed
+ */
+std::vector<MeshLod> buildLods(MeshData& mesh, const LodSettings& settings = {}, ThreadPool* pool = nullptr);
+
+/* Size in pixels of one unit at the given distance from the camera, for perspective projections */
+float projectedScale(const glm::mat4& projection, float viewportHeight, float distance);
+
+/** Picks the least detailed LOD whose error stays below maxPixelError
+ * @param pixelsPerUnit Size of one object space unit on the screen, see projectedScale
+ */
+size_t selectLod(std::span<const MeshLod> lods, float pixelsPerUnit, float maxPixelError = 1.0f);
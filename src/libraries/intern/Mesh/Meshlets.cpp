@@ -0,0 +1,288 @@
+#include "Meshlets.h"
+
+#include <intern/Camera/Camera.h>
+#include <intern/Misc/CPUFeatures.h>
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+#if INTERN_HAS_SSE2
+    #include <emmintrin.h>
+#endif
+
+namespace
+{
+    constexpr uint8_t unassigned = 0xff;
+
+    glm::vec3 meshletPosition(
+        std::span<const VertexStruct> vertices, const MeshletData& data, const Meshlet& meshlet, size_t i)
+    {
+        return vertices[data.vertices[meshlet.vertexOffset + i]].pos;
+    }
+
+    // Ritter's bounding sphere and the cone around the normals of all triangles
+    void computeBounds(std::span<const VertexStruct> vertices, const MeshletData& data, Meshlet& meshlet)
+    {
+        const glm::vec3 first = meshletPosition(vertices, data, meshlet, 0);
+        glm::vec3 a = first;
+        glm::vec3 b = first;
+        for(size_t i = 1; i < meshlet.vertexCount; i++)
+        {
+            const glm::vec3 p = meshletPosition(vertices, data, meshlet, i);
+            a = glm::dot(p - first, p - first) > glm::dot(a - first, a - first) ? p : a;
+        }
+        for(size_t i = 0; i < meshlet.vertexCount; i++)
+        {
+            const glm::vec3 p = meshletPosition(vertices, data, meshlet, i);
+            b = glm::dot(p - a, p - a) > glm::dot(b - a, b - a) ? p : b;
+        }
+        glm::vec3 center = (a + b) * 0.5f;
+        float radius = glm::length(b - a) * 0.5f;
+        for(size_t i = 0; i < meshlet.vertexCount; i++)
+        {
+            const glm::vec3 p = meshletPosition(vertices, data, meshlet, i);
+            const float distance = glm::length(p - center);
+            if(distance > radius)
+            {
+                const float grown = (radius + distance) * 0.5f;
+                center += (p - center) * ((grown - radius) / distance);
+                radius = grown;
+            }
+        }
+
+        glm::vec3 normals[maxMeshletTriangles]; // NOLINT
+        size_t normalCount = 0;
+        glm::vec3 axis{0.0f};
+        for(size_t t = 0; t < meshlet.triangleCount; t++)
+        {
+            const uint8_t* triangle = &data.triangles[meshlet.triangleOffset + t * 3];
+            const glm::vec3 p0 = meshletPosition(vertices, data, meshlet, triangle[0]);
+            const glm::vec3 p1 = meshletPosition(vertices, data, meshlet, triangle[1]);
+            const glm::vec3 p2 = meshletPosition(vertices, data, meshlet, triangle[2]);
+            const glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+            const float area = glm::length(normal);
+            // degenerate triangles can not be seen from any direction
+            if(area > 0.0f)
+            {
+                normals[normalCount++] = normal / area;
+                axis += normal / area;
+            }
+        }
+        const float axisLength = glm::length(axis);
+        float minimumDot = 1.0f;
+        if(axisLength > 0.0f)
+        {
+            axis /= axisLength;
+            for(size_t i = 0; i < normalCount; i++)
+            {
+                minimumDot = std::min(minimumDot, glm::dot(normals[i], axis));
+            }
+        }
+
+        memcpy(meshlet.center, &center, sizeof(meshlet.center));
+        meshlet.radius = radius;
+        memcpy(meshlet.coneAxis, &axis, sizeof(meshlet.coneAxis));
+        // cones wider than ~85 degrees are visible from nearly everywhere, a cutoff of 1 disables the test
+        meshlet.coneCutoff =
+            axisLength > 0.0f && minimumDot > 0.1f ? std::sqrt(1.0f - minimumDot * minimumDot) : 1.0f;
+    }
+} // namespace
+
+MeshletData buildMeshlets(
+    std::span<const VertexStruct> vertices, std::span<const GLuint> indices, size_t maxVertices,
+    size_t maxTriangles)
+{
+    assert(maxVertices >= 3 && maxVertices < unassigned && maxTriangles > 0);
+    assert(maxTriangles <= maxMeshletTriangles);
+    MeshletData data;
+    data.meshlets.reserve(indices.size() / 3 / maxTriangles + 1);
+    data.triangles.reserve(indices.size());
+    std::vector<uint8_t> localIndices(vertices.size(), unassigned);
+
+    Meshlet meshlet;
+    const auto finish = [&]()
+    {
+        if(meshlet.triangleCount == 0)
+        {
+            return;
+        }
+        computeBounds(vertices, data, meshlet);
+        for(size_t i = 0; i < meshlet.vertexCount; i++)
+        {
+            localIndices[data.vertices[meshlet.vertexOffset + i]] = unassigned;
+        }
+        data.meshlets.push_back(meshlet);
+        meshlet = Meshlet{
+            .vertexOffset = static_cast<uint32_t>(data.vertices.size()),
+            .triangleOffset = static_cast<uint32_t>(data.triangles.size())};
+    };
+
+    for(size_t t = 0; t < indices.size() / 3; t++)
+    {
+        const GLuint a = indices[t * 3 + 0];
+        const GLuint b = indices[t * 3 + 1];
+        const GLuint c = indices[t * 3 + 2];
+        const size_t added = (localIndices[a] == unassigned ? 1 : 0) +
+                             (localIndices[b] == unassigned && b != a ? 1 : 0) +
+                             (localIndices[c] == unassigned && c != a && c != b ? 1 : 0);
+        if(meshlet.vertexCount + added > maxVertices || meshlet.triangleCount == maxTriangles)
+        {
+            finish();
+        }
+        for(const GLuint vertex : {a, b, c})
+        {
+            if(localIndices[vertex] == unassigned)
+            {
+                localIndices[vertex] = static_cast<uint8_t>(meshlet.vertexCount++);
+                data.vertices.push_back(vertex);
+            }
+            data.triangles.push_back(localIndices[vertex]);
+        }
+        meshlet.triangleCount++;
+    }
+    finish();
+    return data;
+}
+
+MeshletCuller::MeshletCuller(std::span<const Meshlet> meshlets, GLenum indexType)
+    : meshletCount(meshlets.size()),
+      indexSize(indexType == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(GLuint))
+{
+    const size_t padded = (meshlets.size() + 3) / 4 * 4;
+    for(auto* array : {&centerX, &centerY, &centerZ, &radius, &axisX, &axisY, &axisZ, &cutoff})
+    {
+        array->resize(padded, 0.0f);
+    }
+    firstIndices.resize(padded, 0);
+    indexCounts.resize(padded, 0);
+    for(size_t i = 0; i < meshlets.size(); i++)
+    {
+        const Meshlet& meshlet = meshlets[i];
+        centerX[i] = meshlet.center[0];
+        centerY[i] = meshlet.center[1];
+        centerZ[i] = meshlet.center[2];
+        radius[i] = meshlet.radius;
+        axisX[i] = meshlet.coneAxis[0];
+        axisY[i] = meshlet.coneAxis[1];
+        axisZ[i] = meshlet.coneAxis[2];
+        cutoff[i] = meshlet.coneCutoff;
+        firstIndices[i] = meshlet.triangleOffset;
+        indexCounts[i] = meshlet.triangleCount * 3;
+        triangleCount += meshlet.triangleCount;
+    }
+}
+
+void MeshletCuller::cull(
+    Camera& camera, const glm::mat4& model, MeshletDrawList& drawList, bool frustum, bool cones)
+{
+    const auto start = std::chrono::steady_clock::now();
+    stats = {.meshlets = meshletCount, .triangles = triangleCount};
+    drawList.counts.clear();
+    drawList.offsets.clear();
+
+    // planes of the frustum in object space (Gribb/Hartmann), normalized so spheres can be tested
+    const glm::mat4 clip = *camera.getProj() * *camera.getView() * model;
+    const auto row = [&](int r) { return glm::vec4(clip[0][r], clip[1][r], clip[2][r], clip[3][r]); };
+    glm::vec4 planes[6] = { // NOLINT
+        row(3) + row(0), row(3) - row(0), row(3) + row(1), row(3) - row(1), row(3) + row(2), row(3) - row(2)};
+    for(glm::vec4& plane : planes)
+    {
+        plane /= glm::length(glm::vec3(plane));
+    }
+    // backfacing is preserved by the (invertible) model matrix, so the cones can be tested in object space
+    const glm::vec3 eye = glm::vec3(glm::inverse(model) * glm::vec4(camera.getPosition(), 1.0f));
+
+    GLuint rangeEnd = 0;
+    for(size_t base = 0; base < meshletCount; base += 4)
+    {
+        // bit per meshlet
+        int inside = 0xf;
+        int backfacing = 0;
+#if INTERN_HAS_SSE2
+        const __m128 cx = _mm_loadu_ps(&centerX[base]);
+        const __m128 cy = _mm_loadu_ps(&centerY[base]);
+        const __m128 cz = _mm_loadu_ps(&centerZ[base]);
+        const __m128 r = _mm_loadu_ps(&radius[base]);
+        if(frustum)
+        {
+            const __m128 negativeRadius = _mm_sub_ps(_mm_setzero_ps(), r);
+            __m128 visible = _mm_castsi128_ps(_mm_set1_epi32(-1));
+            for(const glm::vec4& plane : planes)
+            {
+                const __m128 distance = _mm_add_ps(
+                    _mm_add_ps(_mm_mul_ps(cx, _mm_set1_ps(plane.x)), _mm_mul_ps(cy, _mm_set1_ps(plane.y))),
+                    _mm_add_ps(_mm_mul_ps(cz, _mm_set1_ps(plane.z)), _mm_set1_ps(plane.w)));
+                visible = _mm_and_ps(visible, _mm_cmpge_ps(distance, negativeRadius));
+            }
+            inside = _mm_movemask_ps(visible);
+        }
+        if(cones)
+        {
+            const __m128 dx = _mm_sub_ps(cx, _mm_set1_ps(eye.x));
+            const __m128 dy = _mm_sub_ps(cy, _mm_set1_ps(eye.y));
+            const __m128 dz = _mm_sub_ps(cz, _mm_set1_ps(eye.z));
+            const __m128 length = _mm_sqrt_ps(
+                _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz)));
+            const __m128 dot = _mm_add_ps(
+                _mm_add_ps(
+                    _mm_mul_ps(dx, _mm_loadu_ps(&axisX[base])), _mm_mul_ps(dy, _mm_loadu_ps(&axisY[base]))),
+                _mm_mul_ps(dz, _mm_loadu_ps(&axisZ[base])));
+            const __m128 limit = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&cutoff[base]), length), r);
+            backfacing = _mm_movemask_ps(_mm_cmpge_ps(dot, limit));
+        }
+#else
+        for(size_t lane = 0; lane < 4; lane++)
+        {
+            const size_t i = base + lane;
+            const glm::vec3 center{centerX[i], centerY[i], centerZ[i]};
+            for(const glm::vec4& plane : planes)
+            {
+                if(frustum && glm::dot(glm::vec3(plane), center) + plane.w < -radius[i])
+                {
+                    inside &= ~(1 << lane);
+                }
+            }
+            const glm::vec3 direction = center - eye;
+            if(cones && glm::dot(direction, glm::vec3(axisX[i], axisY[i], axisZ[i])) >=
+                            cutoff[i] * glm::length(direction) + radius[i])
+            {
+                backfacing |= 1 << lane;
+            }
+        }
+#endif
+
+        for(size_t lane = 0; lane < std::min<size_t>(4, meshletCount - base); lane++)
+        {
+            const size_t i = base + lane;
+            if((inside & (1 << lane)) == 0)
+            {
+                stats.frustumCulled++;
+                continue;
+            }
+            if((backfacing & (1 << lane)) != 0)
+            {
+                stats.coneCulled++;
+                continue;
+            }
+            stats.submittedTriangles += indexCounts[i] / 3;
+            if(!drawList.counts.empty() && firstIndices[i] == rangeEnd)
+            {
+                drawList.counts.back() += static_cast<GLsizei>(indexCounts[i]);
+            }
+            else
+            {
+                drawList.counts.push_back(static_cast<GLsizei>(indexCounts[i]));
+                drawList.offsets.push_back(
+                    reinterpret_cast<const void*>(static_cast<uintptr_t>(firstIndices[i]) * indexSize));
+            }
+            rangeEnd = firstIndices[i] + indexCounts[i];
+        }
+    }
+
+    stats.draws = drawList.counts.size();
+    const std::chrono::duration<double> duration = std::chrono::steady_clock::now() - start;
+    stats.seconds = duration.count();
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <glad/glad/glad.h>
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "Mesh.h"
+
+class Camera;
+
+constexpr size_t maxMeshletVertices = 64;
+constexpr size_t maxMeshletTriangles = 124;
+
+/* Cluster of at most maxMeshletVertices vertices and maxMeshletTriangles triangles */
+struct Meshlet
+{
+    // first entry in MeshletData::vertices / MeshletData::triangles. Meshlets keep the order of the
+    // triangles, so triangleOffset is also the first index of the meshlet in the index buffer of the mesh
+    uint32_t vertexOffset = 0;
+    uint32_t triangleOffset = 0;
+    uint32_t vertexCount = 0;
+    uint32_t triangleCount = 0;
+    // bounding sphere
+    float center[3] = {}; // NOLINT
+    float radius = 0.0f;
+    // normal cone, every triangle faces away from a camera at p if
+    // dot(center - p, coneAxis) >= coneCutoff * length(center - p) + radius
+    float coneAxis[3] = {}; // NOLINT
+    float coneCutoff = 1.0f;
+};
+static_assert(sizeof(Meshlet) == 48);
+
+struct MeshletData
+{
+    std::vector<Meshlet> meshlets;
+    // indices into the vertices of the mesh
+    std::vector<uint32_t> vertices;
+    // 3 indices into the vertices of the meshlet per triangle
+    std::vector<uint8_t> triangles;
+};
+
+/** Splits the triangles into meshlets, in order. Works best on indices optimized for the vertex cache
+ * (see optimizeVertexCache), where consecutive triangles share most of their vertices.
+ */
+MeshletData buildMeshlets(
+    std::span<const VertexStruct> vertices, std::span<const GLuint> indices,
+    size_t maxVertices = maxMeshletVertices, size_t maxTriangles = maxMeshletTriangles);
+
+struct MeshletCullingStats
+{
+    size_t meshlets = 0;
+    size_t frustumCulled = 0;
+    // only counts meshlets that passed the frustum test
+    size_t coneCulled = 0;
+    size_t triangles = 0;
+    size_t submittedTriangles = 0;
+    // ranges in the draw list, after merging adjacent meshlets
+    size_t draws = 0;
+    double seconds = 0.0;
+
+    [[nodiscard]] inline float cullingRate() const
+    {
+        return meshlets > 0 ? static_cast<float>(frustumCulled + coneCulled) / static_cast<float>(meshlets)
+                            : 0.0f;
+    }
+
+    [[nodiscard]] inline float submittedFraction() const
+    {
+        return triangles > 0 ? static_cast<float>(submittedTriangles) / static_cast<float>(triangles) : 0.0f;
+    }
+};
+
+/* Ranges of the index buffer of a mesh in the form glMultiDrawElements expects, see Mesh::draw */
+struct MeshletDrawList
+{
+    std::vector<GLsizei> counts;
+    // byte offsets into the index buffer
+    std::vector<const void*> offsets;
+};
+
+/** Culls the meshlets of a mesh against the view frustum and their normal cones, 4 at a time with SSE2.
+ * Visible meshlets are written as ranges of the index buffer, adjacent ones are merged into one range.
+ */
+class MeshletCuller
+{
+  public:
+    /* indexType of the mesh the meshlets belong to, see Mesh::getIndexType */
+    MeshletCuller(std::span<const Meshlet> meshlets, GLenum indexType);
+
+    void cull(
+        Camera& camera, const glm::mat4& model, MeshletDrawList& drawList, bool frustum = true,
+        bool cones = true);
+
+    [[nodiscard]] inline const MeshletCullingStats& getStats() const
+    {
+        return stats;
+    }
+
+  private:
+    // bounds in structure of arrays layout, padded to a multiple of 4
+    std::vector<float> centerX, centerY, centerZ, radius; // NOLINT
+    std::vector<float> axisX, axisY, axisZ, cutoff;       // NOLINT
+    std::vector<uint32_t> firstIndices, indexCounts;      // NOLINT
+    size_t meshletCount = 0;
+    size_t triangleCount = 0;
+    size_t indexSize = sizeof(GLuint);
+    MeshletCullingStats stats;
+};
@@ -0,0 +1,360 @@
+#include "MeshImporter.h"
+
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+
+#include <intern/Misc/MappedFile.h>
+
+#include "MeshImporterShared.h"
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    // chunks are parsed independently, smaller ones balance better across the pool
+    constexpr size_t chunkBytes = 1024 * 1024;
+
+    // one corner of a triangle, indices are 0 based
+    struct ObjCorner
+    {
+        int32_t index[3]; // NOLINT position, uv, normal
+        // bit n: index[n] is given, bit n + 3: index[n] is relative to the start of the chunk
+        uint8_t flags;
+    };
+
+    struct ObjChunk
+    {
+        std::vector<glm::vec3> positions;
+        std::vector<glm::vec2> uvs;
+        std::vector<glm::vec3> normals;
+        std::vector<ObjCorner> corners;
+        // first line that could not be parsed, 0 if there was none. Counted from the start of the chunk
+        size_t errorLine = 0;
+    };
+
+    inline bool isBlank(char c)
+    {
+        return c == ' ' || c == '\t';
+    }
+
+    const char* skipSpaces(const char* current, const char* end)
+    {
+        while(current != end && isBlank(*current))
+        {
+            current++;
+        }
+        return current;
+    }
+
+    const char* parseFloats(const char* current, const char* end, float* values, int count, int required)
+    {
+        for(int i = 0; i < count; i++)
+        {
+            current = skipSpaces(current, end);
+            if(current != end && *current == '+')
+            {
+                current++;
+            }
+            const auto result = std::from_chars(current, end, values[i]);
+            if(result.ec != std::errc{})
+            {
+                return i < required ? nullptr : current;
+            }
+            current = result.ptr;
+        }
+        return current;
+    }
+
+    // parses "v", "v/vt", "v//vn" or "v/vt/vn"
+    const char*
+    parseCorner(const char* current, const char* end, const size_t (&counts)[3], ObjCorner& corner)
+    {
+        corner.flags = 0;
+        for(int i = 0; i < 3; i++)
+        {
+            if(i > 0)
+            {
+                if(current == end || *current != '/')
+                {
+                    break;
+                }
+                current++;
+                // empty uv index in "v//vn"
+                if(current != end && *current == '/')
+                {
+                    continue;
+                }
+            }
+            int32_t value = 0;
+            const auto result = std::from_chars(current, end, value);
+            if(result.ec != std::errc{} || value == 0)
+            {
+                return nullptr;
+            }
+            current = result.ptr;
+            if(value > 0)
+            {
+                corner.index[i] = value - 1;
+                corner.flags |= 1u << i;
+            }
+            else
+            {
+                // may point into an earlier chunk, in which case it becomes negative here
+                corner.index[i] = static_cast<int32_t>(counts[i]) + value;
+                corner.flags |= (1u << i) | (1u << (i + 3));
+            }
+        }
+        return current;
+    }
+
+    void parseChunk(const char* current, const char* end, ObjChunk& chunk)
+    {
+        std::vector<ObjCorner> polygon;
+        size_t line = 0;
+        while(current != end)
+        {
+            line++;
+            const char* lineEnd = current;
+            while(lineEnd != end && *lineEnd != '\n')
+            {
+                lineEnd++;
+            }
+            const char* next = lineEnd != end ? lineEnd + 1 : end;
+            if(lineEnd != current && lineEnd[-1] == '\r')
+            {
+                lineEnd--;
+            }
+
+            current = skipSpaces(current, lineEnd);
+            bool valid = true;
+            if(lineEnd - current >= 2 && current[0] == 'v' && isBlank(current[1]))
+            {
+                glm::vec3& position = chunk.positions.emplace_back();
+                valid = parseFloats(current + 2, lineEnd, &position.x, 3, 3) != nullptr;
+            }
+            else if(lineEnd - current >= 3 && current[0] == 'v' && current[1] == 't' && isBlank(current[2]))
+            {
+                // the optional w is skipped
+                glm::vec2& uv = chunk.uvs.emplace_back();
+                valid = parseFloats(current + 3, lineEnd, &uv.x, 2, 1) != nullptr;
+            }
+            else if(lineEnd - current >= 3 && current[0] == 'v' && current[1] == 'n' && isBlank(current[2]))
+            {
+                glm::vec3& normal = chunk.normals.emplace_back();
+                valid = parseFloats(current + 3, lineEnd, &normal.x, 3, 3) != nullptr;
+            }
+            else if(lineEnd - current >= 2 && current[0] == 'f' && isBlank(current[1]))
+            {
+                const size_t counts[3] = {chunk.positions.size(), chunk.uvs.size(), chunk.normals.size()};
+                polygon.clear();
+                current = skipSpaces(current + 2, lineEnd);
+                while(valid && current != lineEnd)
+                {
+                    current = parseCorner(current, lineEnd, counts, polygon.emplace_back());
+                    valid = current != nullptr;
+                    current = valid ? skipSpaces(current, lineEnd) : lineEnd;
+                }
+                valid = valid && polygon.size() >= 3;
+                // fan triangulation
+                for(size_t i = 2; valid && i < polygon.size(); i++)
+                {
+                    chunk.corners.push_back(polygon[0]);
+                    chunk.corners.push_back(polygon[i - 1]);
+                    chunk.corners.push_back(polygon[i]);
+                }
+            }
+            if(!valid && chunk.errorLine == 0)
+            {
+                chunk.errorLine = line;
+            }
+            current = next;
+        }
+    }
+} // namespace
+
+bool importObj(const std::string& file, MeshData& mesh, ThreadPool* pool, MeshImportStats* stats)
+{
+    const auto start = Clock::now();
+    const MappedFile mapping{file};
+    if(!mapping.isOpen())
+    {
+        std::cout << "Could not load mesh " << file << std::endl;
+        return false;
+    }
+    const char* data = reinterpret_cast<const char*>(mapping.data());
+    const size_t size = mapping.size();
+
+    // chunks start at the beginning of a line
+    std::vector<size_t> chunkStarts{0};
+    while(chunkStarts.back() + chunkBytes < size)
+    {
+        size_t boundary = chunkStarts.back() + chunkBytes;
+        while(boundary < size && data[boundary - 1] != '\n')
+        {
+            boundary++;
+        }
+        if(boundary >= size)
+        {
+            break;
+        }
+        chunkStarts.push_back(boundary);
+    }
+    chunkStarts.push_back(size);
+
+    std::vector<ObjChunk> chunks(chunkStarts.size() - 1);
+    parallelFor(
+        pool,
+        chunks.size(),
+        1,
+        [&](size_t begin, size_t end)
+        {
+            for(size_t i = begin; i < end; i++)
+            {
+                parseChunk(data + chunkStarts[i], data + chunkStarts[i + 1], chunks[i]);
+            }
+        });
+
+    // offsets of the attributes and triangle corners of every chunk in the whole file
+    std::vector<size_t> offsets[4]; // NOLINT position, uv, normal, corner
+    for(auto& offset : offsets)
+    {
+        offset.resize(chunks.size() + 1, 0);
+    }
+    for(size_t i = 0; i < chunks.size(); i++)
+    {
+        if(chunks[i].errorLine != 0)
+        {
+            size_t line = chunks[i].errorLine;
+            for(size_t j = 0; j < i; j++)
+            {
+                line += static_cast<size_t>(
+                    std::count(data + chunkStarts[j], data + chunkStarts[j + 1], '\n'));
+            }
+            std::cout << "Invalid data in line " << line << " of mesh " << file << std::endl;
+            return false;
+        }
+        offsets[0][i + 1] = offsets[0][i] + chunks[i].positions.size();
+        offsets[1][i + 1] = offsets[1][i] + chunks[i].uvs.size();
+        offsets[2][i + 1] = offsets[2][i] + chunks[i].normals.size();
+        offsets[3][i + 1] = offsets[3][i] + chunks[i].corners.size();
+    }
+    const size_t attributeCounts[3] = {offsets[0].back(), offsets[1].back(), offsets[2].back()};
+    const size_t cornerCount = offsets[3].back();
+
+    // resolve relative indices and gather everything into arrays for the whole file
+    std::vector<glm::vec3> positions(attributeCounts[0]);
+    std::vector<glm::vec2> uvs(attributeCounts[1]);
+    std::vector<glm::vec3> normals(attributeCounts[2]);
+    std::vector<uint32_t> corners(cornerCount * 3);
+    std::atomic<bool> outOfRange = false;
+    parallelFor(
+        pool,
+        chunks.size(),
+        1,
+        [&](size_t begin, size_t end)
+        {
+            for(size_t i = begin; i < end; i++)
+            {
+                ObjChunk& chunk = chunks[i];
+                std::copy(chunk.positions.begin(), chunk.positions.end(), positions.begin() + offsets[0][i]);
+                std::copy(chunk.uvs.begin(), chunk.uvs.end(), uvs.begin() + offsets[1][i]);
+                std::copy(chunk.normals.begin(), chunk.normals.end(), normals.begin() + offsets[2][i]);
+                uint32_t* out = &corners[offsets[3][i] * 3];
+                for(const ObjCorner& corner : chunk.corners)
+                {
+                    for(uint32_t a = 0; a < 3; a++)
+                    {
+                        int64_t index = corner.index[a];
+                        if((corner.flags & (1u << (a + 3))) != 0)
+                        {
+                            index += static_cast<int64_t>(offsets[a][i]);
+                        }
+                        if((corner.flags & (1u << a)) == 0)
+                        {
+                            // uv and normal are optional, the position is not
+                            index = UINT32_MAX;
+                            outOfRange = outOfRange || a == 0;
+                        }
+                        else if(index < 0 || index >= static_cast<int64_t>(attributeCounts[a]))
+                        {
+                            outOfRange = true;
+                        }
+                        *out++ = static_cast<uint32_t>(index);
+                    }
+                }
+                chunk = ObjChunk{};
+            }
+        });
+    if(outOfRange)
+    {
+        std::cout << "Index out of range in mesh " << file << std::endl;
+        return false;
+    }
+    const auto parsed = Clock::now();
+
+    // corners with the same position/uv/normal indices become the same vertex
+    std::vector<uint32_t> remap;
+    std::vector<uint32_t> unique;
+    weldVertices(
+        cornerCount,
+        pool,
+        [&](size_t i)
+        {
+            size_t hash = 0;
+            hashCombine(hash, corners[i * 3 + 0]);
+            hashCombine(hash, corners[i * 3 + 1]);
+            hashCombine(hash, corners[i * 3 + 2]);
+            return hash;
+        },
+        [&](size_t i, size_t j)
+        {
+            return corners[i * 3 + 0] == corners[j * 3 + 0] && corners[i * 3 + 1] == corners[j * 3 + 1] &&
+                   corners[i * 3 + 2] == corners[j * 3 + 2];
+        },
+        remap,
+        unique);
+
+    mesh.vertices.resize(unique.size());
+    parallelFor(
+        pool,
+        unique.size(),
+        64 * 1024,
+        [&](size_t begin, size_t end)
+        {
+            for(size_t i = begin; i < end; i++)
+            {
+                const uint32_t* corner = &corners[static_cast<size_t>(unique[i]) * 3];
+                VertexStruct& vertex = mesh.vertices[i];
+                vertex = VertexStruct{};
+                vertex.pos = positions[corner[0]];
+                if(corner[1] != UINT32_MAX)
+                {
+                    vertex.uv = uvs[corner[1]];
+                }
+                if(corner[2] != UINT32_MAX)
+                {
+                    vertex.nrm = normals[corner[2]];
+                }
+            }
+        });
+    mesh.indices.assign(remap.begin(), remap.end());
+    computeMissingNormals(mesh.vertices, mesh.indices);
+    const auto welded = Clock::now();
+
+    if(stats != nullptr)
+    {
+        *stats = MeshImportStats{
+            .bytes = size,
+            .triangles = cornerCount / 3,
+            .inputVertices = cornerCount,
+            .vertices = mesh.vertices.size(),
+            .parseSeconds = std::chrono::duration<double>(parsed - start).count(),
+            .weldSeconds = std::chrono::duration<double>(welded - parsed).count(),
+            .totalSeconds = std::chrono::duration<double>(welded - start).count()};
+    }
+    return true;
+}
@@ -0,0 +1,139 @@
+#include "RenderQueue.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <numeric>
+#include <vector>
+
+#include <intern/Misc/GPUMemoryTracker.h>
+
+#include "VertexArrayCache.h"
+
+namespace
+{
+    size_t alignUp(size_t value, size_t alignment)
+    {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+} // namespace
+
+RenderQueue::RenderQueue(const GeometryArena& arena, size_t maxDraws, const char* name)
+    : arena(arena), maxDraws(maxDraws)
+{
+    assert(maxDraws > 0);
+    GLint storageAlignment = 0;
+    glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &storageAlignment);
+    drawDataStride = alignUp(maxDraws * sizeof(DrawData), static_cast<size_t>(std::max(storageAlignment, 1)));
+
+    constexpr GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    const size_t commandBytes = framesInFlight * maxDraws * sizeof(DrawElementsIndirectCommand);
+    const size_t drawDataBytes = framesInFlight * drawDataStride;
+    std::vector<GLuint> drawIndices(maxDraws);
+    std::iota(drawIndices.begin(), drawIndices.end(), 0);
+    glCreateBuffers(3, &buffers[0]);
+    glNamedBufferStorage(buffers[0], static_cast<GLsizeiptr>(commandBytes), nullptr, flags);
+    glNamedBufferStorage(buffers[1], static_cast<GLsizeiptr>(drawDataBytes), nullptr, flags);
+    glNamedBufferStorage(
+        buffers[2], static_cast<GLsizeiptr>(maxDraws * sizeof(GLuint)), drawIndices.data(), 0);
+    GPUMemoryTracker::get().trackBuffer(buffers[0], GPUMemoryCategory::Mesh, commandBytes);
+    GPUMemoryTracker::get().trackBuffer(buffers[1], GPUMemoryCategory::Mesh, drawDataBytes);
+    GPUMemoryTracker::get().trackBuffer(buffers[2], GPUMemoryCategory::Mesh, maxDraws * sizeof(GLuint));
+    mappedCommands = static_cast<DrawElementsIndirectCommand*>(
+        glMapNamedBufferRange(buffers[0], 0, static_cast<GLsizeiptr>(commandBytes), flags));
+    mappedDrawData = static_cast<uint8_t*>(
+        glMapNamedBufferRange(buffers[1], 0, static_cast<GLsizeiptr>(drawDataBytes), flags));
+    assert(mappedCommands != nullptr && mappedDrawData != nullptr && "Could not map render queue buffers");
+    if(strlen(name) > 0)
+    {
+        glObjectLabel(GL_BUFFER, buffers[0], -1, name);
+    }
+
+    // own VAO instead of the shared one of the layout, it has the draw index as an extra attribute
+    glCreateVertexArrays(1, &vaoHandle);
+    setVertexArrayLayout(vaoHandle, arena.getLayout());
+    glEnableVertexArrayAttrib(vaoHandle, drawIndexLocation);
+    glVertexArrayAttribIFormat(vaoHandle, drawIndexLocation, 1, GL_UNSIGNED_INT, 0);
+    glVertexArrayAttribBinding(vaoHandle, drawIndexLocation, 1);
+    glVertexArrayBindingDivisor(vaoHandle, 1, 1);
+    glVertexArrayVertexBuffer(vaoHandle, 1, buffers[2], 0, sizeof(GLuint));
+}
+
+RenderQueue::~RenderQueue()
+{
+    glUnmapNamedBuffer(buffers[0]);
+    glUnmapNamedBuffer(buffers[1]);
+    for(const GLuint buffer : buffers)
+    {
+        GPUMemoryTracker::get().untrackBuffer(buffer);
+    }
+    glDeleteBuffers(3, &buffers[0]);
+    glDeleteVertexArrays(1, &vaoHandle);
+}
+
+void RenderQueue::begin()
+{
+    assert(!recording && "begin() called twice without submit()");
+    if(fences.wait(region))
+    {
+        stats.stalls++;
+    }
+    drawCount = 0;
+    triangleCount = 0;
+    recording = true;
+}
+
+bool RenderQueue::add(GeometryHandle handle, GLuint firstIndex, GLsizei count, const DrawData& data)
+{
+    assert(recording && "add() called outside of begin() / submit()");
+    if(drawCount == maxDraws)
+    {
+        stats.rejected++;
+        return false;
+    }
+    const GeometryRange& range = arena.getRange(handle);
+    assert(firstIndex + static_cast<GLuint>(count) <= range.indexCount);
+    // the mapped memory is write combined, write every command in one go and never read it back
+    mappedCommands[region * maxDraws + drawCount] = {
+        .count = static_cast<GLuint>(count),
+        .instanceCount = 1,
+        .firstIndex = range.firstIndex + firstIndex,
+        .baseVertex = range.baseVertex,
+        .baseInstance = static_cast<GLuint>(drawCount)};
+    memcpy(mappedDrawData + region * drawDataStride + drawCount * sizeof(DrawData), &data, sizeof(DrawData));
+    drawCount++;
+    triangleCount += static_cast<size_t>(count) / 3;
+    return true;
+}
+
+void RenderQueue::submit()
+{
+    assert(recording && "submit() called without begin()");
+    recording = false;
+    stats.draws = drawCount;
+    stats.triangles = triangleCount;
+    stats.frames++;
+    if(drawCount > 0)
+    {
+        glBindVertexArray(vaoHandle);
+        glVertexArrayVertexBuffer(vaoHandle, 0, arena.getVertexBuffer(), 0, arena.getLayout().stride);
+        glVertexArrayElementBuffer(vaoHandle, arena.getIndexBuffer());
+        glBindBufferRange(
+            GL_SHADER_STORAGE_BUFFER,
+            drawDataBinding,
+            buffers[1],
+            static_cast<GLintptr>(region * drawDataStride),
+            static_cast<GLsizeiptr>(drawCount * sizeof(DrawData)));
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, buffers[0]);
+        glMultiDrawElementsIndirect(
+            GL_TRIANGLES,
+            GL_UNSIGNED_INT,
+            reinterpret_cast<const void*>(region * maxDraws * sizeof(DrawElementsIndirectCommand)),
+            static_cast<GLsizei>(drawCount),
+            0);
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+        glBindVertexArray(0);
+    }
+    fences.fence(region);
+    region = (region + 1) % framesInFlight;
+}
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <glad/glad/glad.h>
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+
+#include <intern/Buffer/RegionFences.h>
+
+#include "GeometryArena.h"
+
+/* Layout of the commands read by glMultiDrawElementsIndirect */
+struct DrawElementsIndirectCommand
+{
+    GLuint count = 0;
+    GLuint instanceCount = 0;
+    GLuint firstIndex = 0;
+    GLint baseVertex = 0;
+    GLuint baseInstance = 0;
+};
+static_assert(sizeof(DrawElementsIndirectCommand) == 20);
+
+/* Data of every draw, as read by src/shaders/Mesh/drawQueue.vert (std430) */
+struct DrawData
+{
+    glm::mat4 model{1.0f};
+};
+static_assert(sizeof(DrawData) % 16 == 0);
+
+struct RenderQueueStats
+{
+    // of the last submit()
+    size_t draws = 0;
+    size_t triangles = 0;
+    // since construction
+    size_t frames = 0;
+    // begin() calls that had to wait for the GPU to finish with the buffers
+    size_t stalls = 0;
+    // draws that were dropped because the queue was full
+    size_t rejected = 0;
+};
+
+/** Collects the draws of a frame from a GeometryArena and submits them with a single
+ * glMultiDrawElementsIndirect call.
+ * add() writes the indirect command and the DrawData of the draw straight into persistently mapped
+ * buffers. They are split into framesInFlight regions, one per frame, and every region is guarded by a
+ * fence, so recording the next frames never waits unless the GPU is more than framesInFlight - 1 frames
+ * behind.
+ * The shaders find the DrawData of their draw in the shader storage buffer at drawDataBinding, indexed by
+ * the drawIndex attribute (location drawIndexLocation). That attribute is sourced from a buffer holding
+ * 0, 1, 2, ... with a divisor of 1, so every draw reads its baseInstance (gl_DrawID and gl_BaseInstance
+ * need GL 4.6 or ARB_shader_draw_parameters).
+ * Geometry must not be added to or removed from the arena between begin() and submit(), the recorded
+ * commands point to the ranges it had when add() was called.
+ * Only use from the GL thread.
+ */
+class RenderQueue
+{
+  public:
+    constexpr static size_t framesInFlight = 3;
+    constexpr static GLuint drawDataBinding = 0;
+    constexpr static GLuint drawIndexLocation = 8;
+
+    RenderQueue(const GeometryArena& arena, size_t maxDraws, const char* name = "");
+    ~RenderQueue();
+
+    RenderQueue(RenderQueue&&) = delete;
+    RenderQueue(const RenderQueue&) = delete;
+    RenderQueue& operator=(RenderQueue&&) = delete;
+    RenderQueue& operator=(const RenderQueue&) = delete;
+
+    /* Starts recording a frame. Waits if the GPU still reads the region of framesInFlight frames ago */
+    void begin();
+
+    /* Draws all triangles of the geometry. Returns false if the queue is full, the draw is dropped then */
+    inline bool add(GeometryHandle handle, const DrawData& data)
+    {
+        return add(handle, 0, static_cast<GLsizei>(arena.getRange(handle).indexCount), data);
+    }
+    /* Draws count indices starting at firstIndex, relative to the geometry (eg. one LOD) */
+    bool add(GeometryHandle handle, GLuint firstIndex, GLsizei count, const DrawData& data);
+
+    /** Issues all draws recorded since begin(). The shader has to be bound already, the arena and the
+     * draw data are bound here.
+     */
+    void submit();
+
+    [[nodiscard]] inline size_t getDrawCount() const
+    {
+        return drawCount;
+    }
+
+    [[nodiscard]] inline size_t getMaxDraws() const
+    {
+        return maxDraws;
+    }
+
+    [[nodiscard]] inline const RenderQueueStats& getStats() const
+    {
+        return stats;
+    }
+
+  private:
+    const GeometryArena& arena;
+    size_t maxDraws = 0;
+    // bytes between the regions of the draw data buffer, aligned for glBindBufferRange
+    size_t drawDataStride = 0;
+
+    GLuint vaoHandle = 0xffffffff;
+    // indirect commands, draw data, draw indices
+    GLuint buffers[3] = {0xffffffff, 0xffffffff, 0xffffffff}; // NOLINT
+    DrawElementsIndirectCommand* mappedCommands = nullptr;
+    uint8_t* mappedDrawData = nullptr;
+
+    RegionFences fences{framesInFlight};
+    size_t region = 0;
+    size_t drawCount = 0;
+    size_t triangleCount = 0;
+    bool recording = false;
+    RenderQueueStats stats;
+};
@@ -0,0 +1,170 @@
+#include "TangentGeneration.h"
+
+#include <intern/Misc/ThreadPool.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <memory>
+#include <vector>
+
+namespace
+{
+    constexpr size_t grainSize = 16384;
+
+    glm::vec3 projectOnPlane(const glm::vec3& normal, const glm::vec3& v)
+    {
+        return v - normal * glm::dot(normal, v);
+    }
+
+    // returns false (and leaves v untouched) for zero length vectors
+    bool normalizeSafe(glm::vec3& v)
+    {
+        const float length = glm::length(v);
+        if(length <= 1e-20f)
+        {
+            return false;
+        }
+        v = v / length;
+        return true;
+    }
+
+    /* Direction of increasing u on the triangle, w is 1 if the uv mapping preserves the orientation of the
+     * triangle, -1 if it is mirrored and 0 if the uvs are degenerate */
+    glm::vec4 faceTangent(std::span<const VertexStruct> vertices, const GLuint* triangle)
+    {
+        const VertexStruct& v0 = vertices[triangle[0]];
+        const VertexStruct& v1 = vertices[triangle[1]];
+        const VertexStruct& v2 = vertices[triangle[2]];
+        const glm::vec3 d1 = v1.pos - v0.pos;
+        const glm::vec3 d2 = v2.pos - v0.pos;
+        const float s1 = v1.uv.x - v0.uv.x;
+        const float t1 = v1.uv.y - v0.uv.y;
+        const float s2 = v2.uv.x - v0.uv.x;
+        const float t2 = v2.uv.y - v0.uv.y;
+        const float signedArea = s1 * t2 - t1 * s2;
+        // dP/du scaled by the signed uv area
+        glm::vec3 tangent = d1 * t2 - d2 * t1;
+        if(signedArea == 0.0f || !normalizeSafe(tangent))
+        {
+            return glm::vec4(0.0f);
+        }
+        const float orientation = signedArea > 0.0f ? 1.0f : -1.0f;
+        return glm::vec4(tangent * orientation, orientation);
+    }
+
+    glm::vec3 anyPerpendicular(const glm::vec3& normal)
+    {
+        const glm::vec3 axis =
+            std::abs(normal.x) < 0.9f ? glm::vec3(1.0f, 0.0f, 0.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+        glm::vec3 perpendicular = glm::cross(normal, axis);
+        normalizeSafe(perpendicular);
+        return perpendicular;
+    }
+} // namespace
+
+void generateTangents(std::span<VertexStruct> vertices, std::span<const GLuint> indices, ThreadPool* pool)
+{
+    const size_t triangleCount = indices.size() / 3;
+    std::vector<glm::vec4> faceTangents(triangleCount);
+    // corners of the triangles using every vertex, filled in parallel
+    const std::unique_ptr<std::atomic<uint32_t>[]> cornerCounts{
+        new std::atomic<uint32_t>[vertices.size() + 1]};
+    for(size_t v = 0; v <= vertices.size(); v++)
+    {
+        cornerCounts[v].store(0, std::memory_order_relaxed);
+    }
+    parallelFor(
+        pool,
+        triangleCount,
+        grainSize,
+        [&](size_t begin, size_t end)
+        {
+            for(size_t t = begin; t < end; t++)
+            {
+                faceTangents[t] = faceTangent(vertices, &indices[t * 3]);
+                for(size_t c = 0; c < 3; c++)
+                {
+                    cornerCounts[indices[t * 3 + c] + 1].fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+        });
+
+    std::vector<uint32_t> cornerOffsets(vertices.size() + 1, 0);
+    for(size_t v = 0; v < vertices.size(); v++)
+    {
+        cornerOffsets[v + 1] = cornerOffsets[v] + cornerCounts[v + 1].load(std::memory_order_relaxed);
+        // reused as the insertion cursor
+        cornerCounts[v].store(cornerOffsets[v], std::memory_order_relaxed);
+    }
+    std::vector<uint32_t> corners(triangleCount * 3);
+    parallelFor(
+        pool,
+        triangleCount,
+        grainSize,
+        [&](size_t begin, size_t end)
+        {
+            for(size_t corner = begin * 3; corner < end * 3; corner++)
+            {
+                corners[cornerCounts[indices[corner]].fetch_add(1, std::memory_order_relaxed)] =
+                    static_cast<uint32_t>(corner);
+            }
+        });
+
+    parallelFor(
+        pool,
+        vertices.size(),
+        grainSize,
+        [&](size_t begin, size_t end)
+        {
+            for(size_t v = begin; v < end; v++)
+            {
+                VertexStruct& vertex = vertices[v];
+                // the insertion order depends on the threads, sorting keeps the sums deterministic
+                const auto first = corners.begin() + cornerOffsets[v];
+                const auto last = corners.begin() + cornerOffsets[v + 1];
+                std::sort(first, last);
+
+                glm::vec3 normal = vertex.nrm;
+                if(!normalizeSafe(normal))
+                {
+                    vertex.tang = glm::vec4(0.0f);
+                    continue;
+                }
+                // angle weighted sums of the projected face tangents, for both orientations
+                glm::vec3 sums[2] = {glm::vec3(0.0f), glm::vec3(0.0f)}; // NOLINT
+                float weights[2] = {0.0f, 0.0f};                          // NOLINT
+                for(auto it = first; it != last; it++)
+                {
+                    const uint32_t triangle = *it / 3;
+                    const uint32_t corner = *it % 3;
+                    const glm::vec4& face = faceTangents[triangle];
+                    glm::vec3 tangent = projectOnPlane(normal, glm::vec3(face));
+                    if(face.w == 0.0f || !normalizeSafe(tangent))
+                    {
+                        continue;
+                    }
+                    glm::vec3 next = projectOnPlane(
+                        normal, vertices[indices[triangle * 3 + (corner + 1) % 3]].pos - vertex.pos);
+                    glm::vec3 previous = projectOnPlane(
+                        normal, vertices[indices[triangle * 3 + (corner + 2) % 3]].pos - vertex.pos);
+                    if(!normalizeSafe(next) || !normalizeSafe(previous))
+                    {
+                        continue;
+                    }
+                    const float angle = std::acos(std::clamp(glm::dot(next, previous), -1.0f, 1.0f));
+                    const int side = face.w > 0.0f ? 0 : 1;
+                    sums[side] += tangent * angle;
+                    weights[side] += angle;
+                }
+                const int side = weights[0] >= weights[1] ? 0 : 1;
+                glm::vec3 tangent = sums[side];
+                if(!normalizeSafe(tangent))
+                {
+                    vertex.tang = glm::vec4(anyPerpendicular(normal), 1.0f);
+                    continue;
+                }
+                vertex.tang = glm::vec4(tangent, side == 0 ? 1.0f : -1.0f);
+            }
+        });
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <glad/glad/glad.h>
+
+#include <span>
+
+#include "Mesh.h"
+
+class ThreadPool;
+
+/** Computes the tangent frames for normal mapping like MikkTSpace (Mikkelsen 2008) does, so normal maps
+ * baked against it are reproduced. Writes VertexStruct::tang in place, w is the handedness:
+ * bitangent = tang.w * cross(nrm, tang.xyz).
+ * Expects welded vertices (as the importers produce) with normals and uvs. Unlike MikkTSpace, vertices
+ * are never split: where triangles with mirrored uvs share a vertex, the side with the larger angle wins.
+ * Triangles and then vertices are processed in ranges on the pool, if one is given.
+ */
+void generateTangents(
+    std::span<VertexStruct> vertices, std::span<const GLuint> indices, ThreadPool* pool = nullptr);
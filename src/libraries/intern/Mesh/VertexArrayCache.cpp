@@ -0,0 +1,90 @@
+#include "VertexArrayCache.h"
+
+#include <cassert>
+#include <functional>
+
+#include <intern/Misc/Hash.h>
+
+void setVertexArrayLayout(GLuint vertexArray, const VertexLayout& layout, GLuint binding)
+{
+    for(uint32_t i = 0; i < layout.attributeCount; i++)
+    {
+        const VertexAttribute& attribute = layout.attributes[i];
+        glEnableVertexArrayAttrib(vertexArray, attribute.location);
+        if(attribute.integer)
+        {
+            glVertexArrayAttribIFormat(
+                vertexArray, attribute.location, attribute.size, attribute.type, attribute.offset);
+        }
+        else
+        {
+            glVertexArrayAttribFormat(
+                vertexArray,
+                attribute.location,
+                attribute.size,
+                attribute.type,
+                attribute.normalized,
+                attribute.offset);
+        }
+        glVertexArrayAttribBinding(vertexArray, attribute.location, binding);
+    }
+}
+
+VertexArrayCache& VertexArrayCache::get()
+{
+    static VertexArrayCache cache;
+    return cache;
+}
+
+size_t VertexArrayCache::LayoutHash::operator()(const VertexLayout& layout) const
+{
+    size_t hash = std::hash<uint32_t>{}(static_cast<uint32_t>(layout.stride));
+    for(uint32_t i = 0; i < layout.attributeCount; i++)
+    {
+        const VertexAttribute& attribute = layout.attributes[i];
+        for(const uint32_t value :
+            {attribute.location,
+             static_cast<uint32_t>(attribute.size),
+             attribute.type,
+             static_cast<uint32_t>(attribute.normalized),
+             attribute.offset,
+             static_cast<uint32_t>(attribute.integer)})
+        {
+            hashCombine(hash, value);
+        }
+    }
+    return hash;
+}
+
+GLuint VertexArrayCache::acquire(const VertexLayout& layout)
+{
+    Entry& entry = vertexArrays[layout];
+    entry.references++;
+    if(entry.handle != 0)
+    {
+        return entry.handle;
+    }
+
+    glCreateVertexArrays(1, &entry.handle);
+    setVertexArrayLayout(entry.handle, layout);
+    return entry.handle;
+}
+
+void VertexArrayCache::release(GLuint vertexArray)
+{
+    for(auto it = vertexArrays.begin(); it != vertexArrays.end(); it++)
+    {
+        if(it->second.handle != vertexArray)
+        {
+            continue;
+        }
+        assert(it->second.references > 0);
+        if(--it->second.references == 0)
+        {
+            glDeleteVertexArrays(1, &it->second.handle);
+            vertexArrays.erase(it);
+        }
+        return;
+    }
+    assert(false && "Released a vertex array that is not part of the cache");
+}
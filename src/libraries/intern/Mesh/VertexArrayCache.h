@@ -0,0 +1,51 @@
+#pragma once
+
+#include <glad/glad/glad.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+
+#include "VertexLayout.h"
+
+/* Enables and sets up the attributes of the layout on the vertex array, all sourced from the given binding */
+void setVertexArrayLayout(GLuint vertexArray, const VertexLayout& layout, GLuint binding = 0);
+
+/** Vertex array objects shared by all meshes with the same VertexLayout. The attribute formats live in
+ * the VAO and are set up once with DSA, meshes only attach their buffers to binding 0 before drawing.
+ * VAOs are reference counted and deleted together with the last mesh using them.
+ * Only use from the GL thread.
+ */
+class VertexArrayCache
+{
+  public:
+    static VertexArrayCache& get();
+
+    VertexArrayCache(const VertexArrayCache&) = delete;
+    VertexArrayCache& operator=(const VertexArrayCache&) = delete;
+
+    /* VAO with the given layout, created on first use. Has to be released again */
+    GLuint acquire(const VertexLayout& layout);
+    void release(GLuint vertexArray);
+
+    [[nodiscard]] inline size_t getVertexArrayCount() const
+    {
+        return vertexArrays.size();
+    }
+
+  private:
+    VertexArrayCache() = default;
+
+    struct LayoutHash
+    {
+        size_t operator()(const VertexLayout& layout) const;
+    };
+
+    struct Entry
+    {
+        GLuint handle = 0;
+        uint32_t references = 0;
+    };
+
+    std::unordered_map<VertexLayout, Entry, LayoutHash> vertexArrays;
+};
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <glad/glad/glad.h>
+
+#include <glm/glm.hpp>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+
+/*
+    Compile time description of vertex types, used by Mesh to set up its vertex array.
+    A vertex type is made usable with Mesh by specializing VertexLayoutOf:
+
+    template <>
+    struct VertexLayoutOf<MyVertex>
+    {
+        constexpr static VertexLayout layout = makeVertexLayout<MyVertex>(
+            {vertexAttribute<glm::vec3>(0, offsetof(MyVertex, pos)),
+             normalizedAttribute(1, 4, GL_UNSIGNED_BYTE, offsetof(MyVertex, color))});
+    };
+*/
+
+constexpr size_t maxVertexAttributes = 8;
+
+/* Arguments of glVertexArrayAttribFormat (or glVertexArrayAttribIFormat for integer attributes) */
+struct VertexAttribute
+{
+    GLuint location = 0;
+    GLint size = 0;
+    GLenum type = GL_FLOAT;
+    GLboolean normalized = GL_FALSE;
+    GLuint offset = 0;
+    // read as int/uint in the shader instead of being converted to float
+    bool integer = false;
+
+    constexpr bool operator==(const VertexAttribute& other) const = default;
+};
+
+/* All attributes are sourced from a single interleaved buffer (binding 0) */
+struct VertexLayout
+{
+    std::array<VertexAttribute, maxVertexAttributes> attributes{};
+    uint32_t attributeCount = 0;
+    GLsizei stride = 0;
+
+    constexpr bool operator==(const VertexLayout& other) const = default;
+};
+
+/* Component count and type of float attributes, deduced from their C++ type */
+template <typename T>
+struct VertexAttributeComponents;
+
+template <>
+struct VertexAttributeComponents<float>
+{
+    constexpr static GLint size = 1;
+};
+
+template <>
+struct VertexAttributeComponents<glm::vec2>
+{
+    constexpr static GLint size = 2;
+};
+
+template <>
+struct VertexAttributeComponents<glm::vec3>
+{
+    constexpr static GLint size = 3;
+};
+
+template <>
+struct VertexAttributeComponents<glm::vec4>
+{
+    constexpr static GLint size = 4;
+};
+
+template <typename T>
+constexpr VertexAttribute vertexAttribute(GLuint location, size_t offset)
+{
+    return {
+        .location = location,
+        .size = VertexAttributeComponents<T>::size,
+        .type = GL_FLOAT,
+        .offset = static_cast<GLuint>(offset)};
+}
+
+/* Integer components, converted to floats in [0, 1] (unsigned) or [-1, 1] (signed) */
+constexpr VertexAttribute normalizedAttribute(GLuint location, GLint size, GLenum type, size_t offset)
+{
+    return {
+        .location = location,
+        .size = size,
+        .type = type,
+        .normalized = GL_TRUE,
+        .offset = static_cast<GLuint>(offset)};
+}
+
+/* More than maxVertexAttributes attributes fail to compile */
+template <typename Vertex>
+constexpr VertexLayout makeVertexLayout(std::initializer_list<VertexAttribute> attributes)
+{
+    VertexLayout layout{.stride = sizeof(Vertex)};
+    for(const VertexAttribute& attribute : attributes)
+    {
+        layout.attributes[layout.attributeCount++] = attribute;
+    }
+    return layout;
+}
+
+/* Specialize with a constexpr static VertexLayout layout member, see above */
+template <typename Vertex>
+struct VertexLayoutOf;
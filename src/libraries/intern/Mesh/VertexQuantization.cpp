@@ -0,0 +1,338 @@
+#include "VertexQuantization.h"
+#include "VertexQuantizationKernels.h"
+
+#include <intern/Misc/CPUFeatures.h>
+#include <intern/Misc/ThreadPool.h>
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstring>
+#include <type_traits>
+
+#if INTERN_HAS_SSE2
+    #include <emmintrin.h>
+#endif
+
+namespace
+{
+    constexpr float maxHalf = 65504.0f;
+    // smallest normal half float (2^-14)
+    constexpr float minNormalHalf = 6.103515625e-05f;
+    constexpr float maxSnorm16 = 32767.0f;
+    constexpr float maxSnorm8 = 127.0f;
+    constexpr float maxUnorm16 = 65535.0f;
+
+    uint16_t floatToHalf(float value)
+    {
+        const uint32_t sign = (std::bit_cast<uint32_t>(value) >> 16u) & 0x8000u;
+        float magnitude = std::abs(value);
+        // written this way round so NaN ends up as 0
+        magnitude = magnitude > 0.0f ? std::min(magnitude, maxHalf) : 0.0f;
+        if(magnitude < minNormalHalf)
+        {
+            // denormal, rounding up to 1 << 10 correctly produces the smallest normal
+            return static_cast<uint16_t>(sign | static_cast<uint32_t>(std::lrint(std::ldexp(magnitude, 24))));
+        }
+        // rebias the exponent from 127 to 15 and round the mantissa, carries propagate into the exponent
+        const uint32_t bits = std::bit_cast<uint32_t>(magnitude) - ((127u - 15u) << 23u);
+        return static_cast<uint16_t>(sign | ((bits + (1u << 12u)) >> 13u));
+    }
+
+    int32_t toSnorm(float value, float maxValue)
+    {
+        return static_cast<int32_t>(std::lrint((value > -1.0f ? std::min(value, 1.0f) : -1.0f) * maxValue));
+    }
+
+    float clampUnit(float value)
+    {
+        return value > 0.0f ? std::min(value, 1.0f) : 0.0f;
+    }
+
+    // octahedral encoding of a unit vector into [-1, 1]^2
+    void octEncode(float x, float y, float z, float* encoded)
+    {
+        const float sum = std::max(std::abs(x) + std::abs(y) + std::abs(z), 1e-20f);
+        const float u = x / sum;
+        const float v = y / sum;
+        if(z < 0.0f)
+        {
+            // fold the lower hemisphere onto the corners
+            encoded[0] = (1.0f - std::abs(v)) * std::copysign(1.0f, u);
+            encoded[1] = (1.0f - std::abs(u)) * std::copysign(1.0f, v);
+            return;
+        }
+        encoded[0] = u;
+        encoded[1] = v;
+    }
+
+    // position in [0, 1] within the bounds, handedness as w
+    void encodePosition(const VertexStruct& vertex, const PositionEncode& encode, float* position)
+    {
+        position[0] = clampUnit((vertex.pos.x - encode.offset[0]) * encode.scale[0]);
+        position[1] = clampUnit((vertex.pos.y - encode.offset[1]) * encode.scale[1]);
+        position[2] = clampUnit((vertex.pos.z - encode.offset[2]) * encode.scale[2]);
+        position[3] = vertex.tang.w >= 0.0f ? 1.0f : 0.0f;
+    }
+
+    template <typename Vertex>
+    void packScalar(const VertexStruct* vertices, size_t count, const PositionEncode& encode, Vertex* out);
+
+    template <>
+    void packScalar(const VertexStruct* vertices, size_t count, const PositionEncode& encode, HalfVertex* out)
+    {
+        for(size_t i = 0; i < count; i++)
+        {
+            out[i] = packHalfVertex(vertices[i], encode);
+        }
+    }
+
+    template <>
+    void packScalar(
+        const VertexStruct* vertices, size_t count, const PositionEncode& encode, QuantizedVertex* out)
+    {
+        for(size_t i = 0; i < count; i++)
+        {
+            out[i] = packQuantizedVertex(vertices[i], encode);
+        }
+    }
+
+#if INTERN_HAS_SSE2
+    // one component of 4 consecutive vertices
+    __m128 loadComponent(const VertexStruct* vertices, size_t component)
+    {
+        constexpr size_t stride = sizeof(VertexStruct) / sizeof(float);
+        const float* v = reinterpret_cast<const float*>(vertices) + component;
+        return _mm_setr_ps(v[0], v[stride], v[2 * stride], v[3 * stride]);
+    }
+
+    __m128 select(__m128 mask, __m128 a, __m128 b)
+    {
+        return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+    }
+
+    __m128 clampUnit(__m128 value)
+    {
+        // max returns the second operand for NaNs
+        return _mm_min_ps(_mm_max_ps(value, _mm_setzero_ps()), _mm_set1_ps(1.0f));
+    }
+
+    __m128i toSnorm(__m128 value, float maxValue)
+    {
+        const __m128 clamped = _mm_min_ps(_mm_max_ps(value, _mm_set1_ps(-1.0f)), _mm_set1_ps(1.0f));
+        return _mm_cvtps_epi32(_mm_mul_ps(clamped, _mm_set1_ps(maxValue)));
+    }
+
+    __m128i toHalf(__m128 value)
+    {
+        const __m128i sign =
+            _mm_and_si128(_mm_srli_epi32(_mm_castps_si128(value), 16), _mm_set1_epi32(0x8000));
+        const __m128 magnitude = _mm_min_ps(
+            _mm_max_ps(_mm_andnot_ps(_mm_set1_ps(-0.0f), value), _mm_setzero_ps()), _mm_set1_ps(maxHalf));
+        const __m128i normal = _mm_srli_epi32(
+            _mm_add_epi32(
+                _mm_sub_epi32(_mm_castps_si128(magnitude), _mm_set1_epi32((127 - 15) << 23)),
+                _mm_set1_epi32(1 << 12)),
+            13);
+        const __m128i denormal = _mm_cvtps_epi32(_mm_mul_ps(magnitude, _mm_set1_ps(16777216.0f)));
+        const __m128i isDenormal = _mm_castps_si128(_mm_cmplt_ps(magnitude, _mm_set1_ps(minNormalHalf)));
+        return _mm_or_si128(
+            sign, _mm_or_si128(_mm_and_si128(isDenormal, denormal), _mm_andnot_si128(isDenormal, normal)));
+    }
+
+    void octEncode(__m128 x, __m128 y, __m128 z, __m128* encoded)
+    {
+        const __m128 signMask = _mm_set1_ps(-0.0f);
+        const __m128 one = _mm_set1_ps(1.0f);
+        const __m128 absX = _mm_andnot_ps(signMask, x);
+        const __m128 absY = _mm_andnot_ps(signMask, y);
+        const __m128 absZ = _mm_andnot_ps(signMask, z);
+        const __m128 sum = _mm_max_ps(_mm_add_ps(_mm_add_ps(absX, absY), absZ), _mm_set1_ps(1e-20f));
+        const __m128 u = _mm_div_ps(x, sum);
+        const __m128 v = _mm_div_ps(y, sum);
+        const __m128 foldedU =
+            _mm_mul_ps(_mm_sub_ps(one, _mm_andnot_ps(signMask, v)), _mm_or_ps(_mm_and_ps(signMask, u), one));
+        const __m128 foldedV =
+            _mm_mul_ps(_mm_sub_ps(one, _mm_andnot_ps(signMask, u)), _mm_or_ps(_mm_and_ps(signMask, v), one));
+        const __m128 lower = _mm_cmplt_ps(z, _mm_setzero_ps());
+        encoded[0] = select(lower, foldedU, u);
+        encoded[1] = select(lower, foldedV, v);
+    }
+
+    template <typename Vertex>
+    void packSSE2(const VertexStruct* vertices, size_t count, const PositionEncode& encode, Vertex* out)
+    {
+        constexpr bool half = std::is_same_v<Vertex, HalfVertex>;
+        const size_t vectorCount = count / 4 * 4;
+        alignas(16) int32_t lanes[encodedLaneCount][4];
+        for(size_t i = 0; i < vectorCount; i += 4)
+        {
+            const VertexStruct* v = vertices + i;
+            __m128 position[4];
+            for(size_t c = 0; c < 3; c++)
+            {
+                const __m128 offset = _mm_sub_ps(loadComponent(v, c), _mm_set1_ps(encode.offset[c]));
+                position[c] = clampUnit(_mm_mul_ps(offset, _mm_set1_ps(encode.scale[c])));
+            }
+            position[3] =
+                _mm_and_ps(_mm_cmpge_ps(loadComponent(v, 11), _mm_setzero_ps()), _mm_set1_ps(1.0f));
+            __m128 normal[2];
+            octEncode(loadComponent(v, 3), loadComponent(v, 4), loadComponent(v, 5), normal);
+            __m128 tangent[2];
+            octEncode(loadComponent(v, 8), loadComponent(v, 9), loadComponent(v, 10), tangent);
+
+            for(size_t c = 0; c < 4; c++)
+            {
+                const __m128i p = half ? toHalf(position[c])
+                                       : _mm_cvtps_epi32(_mm_mul_ps(position[c], _mm_set1_ps(maxUnorm16)));
+                _mm_store_si128(reinterpret_cast<__m128i*>(lanes[c]), p);
+            }
+            const float snormMax = half ? maxSnorm16 : maxSnorm8;
+            for(size_t c = 0; c < 2; c++)
+            {
+                _mm_store_si128(reinterpret_cast<__m128i*>(lanes[4 + c]), toSnorm(normal[c], snormMax));
+                _mm_store_si128(reinterpret_cast<__m128i*>(lanes[6 + c]), toSnorm(tangent[c], snormMax));
+                _mm_store_si128(reinterpret_cast<__m128i*>(lanes[8 + c]), toHalf(loadComponent(v, 6 + c)));
+            }
+            writeLanes(lanes, out + i);
+        }
+        packScalar(vertices + vectorCount, count - vectorCount, encode, out + vectorCount);
+    }
+
+    constexpr VertexQuantizationKernels kernelsDefault = {
+        .packHalf = packSSE2<HalfVertex>, .packQuantized = packSSE2<QuantizedVertex>};
+#else
+    constexpr VertexQuantizationKernels kernelsDefault = {
+        .packHalf = packScalar<HalfVertex>, .packQuantized = packScalar<QuantizedVertex>};
+#endif
+
+    const VertexQuantizationKernels& selectKernels()
+    {
+        const CPUFeatures& features = getCPUFeatures();
+        const VertexQuantizationKernels* avx2 = getVertexQuantizationKernelsAVX2();
+        if(avx2 != nullptr && features.avx2 && features.fma)
+        {
+            return *avx2;
+        }
+        return kernelsDefault;
+    }
+
+    template <typename Vertex>
+    void packParallel(
+        void (*pack)(const VertexStruct*, size_t, const PositionEncode&, Vertex*),
+        std::span<const VertexStruct> vertices, const PositionEncode& encode, Vertex* out, ThreadPool* pool)
+    {
+        parallelFor(
+            pool,
+            vertices.size(),
+            64 * 1024,
+            [&](size_t begin, size_t end)
+            { pack(vertices.data() + begin, end - begin, encode, out + begin); });
+    }
+} // namespace
+
+HalfVertex packHalfVertex(const VertexStruct& vertex, const PositionEncode& encode)
+{
+    HalfVertex out;
+    float position[4];
+    encodePosition(vertex, encode, position);
+    float normal[2];
+    octEncode(vertex.nrm.x, vertex.nrm.y, vertex.nrm.z, normal);
+    float tangent[2];
+    octEncode(vertex.tang.x, vertex.tang.y, vertex.tang.z, tangent);
+    for(int c = 0; c < 4; c++)
+    {
+        out.pos[c] = floatToHalf(position[c]);
+    }
+    for(int c = 0; c < 2; c++)
+    {
+        out.nrm[c] = static_cast<int16_t>(toSnorm(normal[c], maxSnorm16));
+        out.tang[c] = static_cast<int16_t>(toSnorm(tangent[c], maxSnorm16));
+    }
+    out.uv[0] = floatToHalf(vertex.uv.x);
+    out.uv[1] = floatToHalf(vertex.uv.y);
+    return out;
+}
+
+QuantizedVertex packQuantizedVertex(const VertexStruct& vertex, const PositionEncode& encode)
+{
+    QuantizedVertex out;
+    float position[4];
+    encodePosition(vertex, encode, position);
+    float normal[2];
+    octEncode(vertex.nrm.x, vertex.nrm.y, vertex.nrm.z, normal);
+    float tangent[2];
+    octEncode(vertex.tang.x, vertex.tang.y, vertex.tang.z, tangent);
+    for(int c = 0; c < 4; c++)
+    {
+        out.pos[c] = static_cast<uint16_t>(std::lrint(position[c] * maxUnorm16));
+    }
+    for(int c = 0; c < 2; c++)
+    {
+        out.nrm[c] = static_cast<int8_t>(toSnorm(normal[c], maxSnorm8));
+        out.tang[c] = static_cast<int8_t>(toSnorm(tangent[c], maxSnorm8));
+    }
+    out.uv[0] = floatToHalf(vertex.uv.x);
+    out.uv[1] = floatToHalf(vertex.uv.y);
+    return out;
+}
+
+size_t vertexFormatSize(VertexFormat format)
+{
+    switch(format)
+    {
+    case VertexFormat::Full:
+        return sizeof(VertexStruct);
+    case VertexFormat::Half:
+        return sizeof(HalfVertex);
+    case VertexFormat::Quantized:
+        return sizeof(QuantizedVertex);
+    }
+    return 0;
+}
+
+std::vector<uint8_t> quantizeVertices(
+    std::span<const VertexStruct> vertices, VertexFormat format, glm::mat4* positionDecode, ThreadPool* pool)
+{
+    std::vector<uint8_t> data(vertices.size() * vertexFormatSize(format));
+    *positionDecode = glm::mat4{1.0f};
+    if(format == VertexFormat::Full)
+    {
+        memcpy(data.data(), vertices.data(), data.size());
+        return data;
+    }
+
+    glm::vec3 minimum{0.0f};
+    glm::vec3 maximum{0.0f};
+    if(!vertices.empty())
+    {
+        minimum = vertices[0].pos;
+        maximum = vertices[0].pos;
+        for(const VertexStruct& vertex : vertices)
+        {
+            minimum = glm::min(minimum, vertex.pos);
+            maximum = glm::max(maximum, vertex.pos);
+        }
+    }
+    const glm::vec3 extent = maximum - minimum;
+    PositionEncode encode{};
+    for(int c = 0; c < 3; c++)
+    {
+        encode.offset[c] = minimum[c];
+        encode.scale[c] = extent[c] > 0.0f ? 1.0f / extent[c] : 0.0f;
+        (*positionDecode)[c][c] = extent[c];
+    }
+    (*positionDecode)[3] = glm::vec4(minimum, 1.0f);
+
+    const VertexQuantizationKernels& kernels = selectKernels();
+    if(format == VertexFormat::Half)
+    {
+        packParallel(kernels.packHalf, vertices, encode, reinterpret_cast<HalfVertex*>(data.data()), pool);
+    }
+    else
+    {
+        packParallel(
+            kernels.packQuantized, vertices, encode, reinterpret_cast<QuantizedVertex*>(data.data()), pool);
+    }
+    return data;
+}
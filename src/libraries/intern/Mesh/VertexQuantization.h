@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "Mesh.h"
+
+class ThreadPool;
+
+/*
+    Compact vertex layouts (see VertexFormat), read by src/shaders/Mesh/shadedQuantized.vert.
+    Positions are stored in [0, 1] within the bounds of the mesh and mapped back by Mesh::getPositionDecode.
+    The w component stores the handedness of the tangent frame: 1 if tang.w >= 0, 0 otherwise.
+    Normals and the tangent directions are octahedral encoded, uvs are stored as half floats.
+*/
+
+struct HalfVertex
+{
+    uint16_t pos[4] = {}; // NOLINT half floats
+    int16_t nrm[2] = {};  // NOLINT snorm16
+    int16_t tang[2] = {}; // NOLINT snorm16
+    uint16_t uv[2] = {};  // NOLINT half floats
+};
+static_assert(sizeof(HalfVertex) == 20);
+
+template <>
+struct VertexLayoutOf<HalfVertex>
+{
+    constexpr static VertexLayout layout = makeVertexLayout<HalfVertex>(
+        {{.location = 0, .size = 4, .type = GL_HALF_FLOAT, .offset = offsetof(HalfVertex, pos)},
+         normalizedAttribute(1, 2, GL_SHORT, offsetof(HalfVertex, nrm)),
+         {.location = 2, .size = 2, .type = GL_HALF_FLOAT, .offset = offsetof(HalfVertex, uv)},
+         normalizedAttribute(3, 2, GL_SHORT, offsetof(HalfVertex, tang))});
+};
+
+struct QuantizedVertex
+{
+    uint16_t pos[4] = {}; // NOLINT unorm16
+    int8_t nrm[2] = {};   // NOLINT snorm8
+    int8_t tang[2] = {};  // NOLINT snorm8
+    uint16_t uv[2] = {};  // NOLINT half floats
+};
+static_assert(sizeof(QuantizedVertex) == 16);
+
+template <>
+struct VertexLayoutOf<QuantizedVertex>
+{
+    constexpr static VertexLayout layout = makeVertexLayout<QuantizedVertex>(
+        {normalizedAttribute(0, 4, GL_UNSIGNED_SHORT, offsetof(QuantizedVertex, pos)),
+         normalizedAttribute(1, 2, GL_BYTE, offsetof(QuantizedVertex, nrm)),
+         {.location = 2, .size = 2, .type = GL_HALF_FLOAT, .offset = offsetof(QuantizedVertex, uv)},
+         normalizedAttribute(3, 2, GL_BYTE, offsetof(QuantizedVertex, tang))});
+};
+
+/* Bytes per vertex of the format */
+size_t vertexFormatSize(VertexFormat format);
+
+/** Converts vertices into the given format.
+ * Normals and tangents are expected to be normalized, uvs beyond +-65504 are clamped.
+ * Runs SSE2 or AVX2 kernels (picked at runtime), split across the pool if one is given.
+ * @param positionDecode Set to the matrix mapping the stored positions back into object space
+ * @return Tightly packed vertices of the format, a plain copy for VertexFormat::Full
+ */
+std::vector<uint8_t> quantizeVertices(
+    std::span<const VertexStruct> vertices, VertexFormat format, glm::mat4* positionDecode,
+    ThreadPool* pool = nullptr);
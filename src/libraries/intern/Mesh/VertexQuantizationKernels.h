@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "VertexQuantization.h"
+
+/*
+    Internal interface between quantizeVertices and its SIMD kernels.
+    Not meant to be included outside of VertexQuantization*.cpp
+*/
+
+/* Positions are mapped into [0, 1] as (pos - offset) * scale */
+struct PositionEncode
+{
+    float offset[3]; // NOLINT
+    float scale[3];  // NOLINT
+};
+
+struct VertexQuantizationKernels
+{
+    void (*packHalf)(
+        const VertexStruct* vertices, size_t count, const PositionEncode& encode, HalfVertex* out);
+    void (*packQuantized)(
+        const VertexStruct* vertices, size_t count, const PositionEncode& encode, QuantizedVertex* out);
+};
+
+/* Scalar reference conversion of a single vertex, used for the tails of the SIMD loops */
+HalfVertex packHalfVertex(const VertexStruct& vertex, const PositionEncode& encode);
+QuantizedVertex packQuantizedVertex(const VertexStruct& vertex, const PositionEncode& encode);
+
+/* returns nullptr if the library was built without AVX2 support */
+const VertexQuantizationKernels* getVertexQuantizationKernelsAVX2();
+
+/* Integer components of N vertices as computed by the SIMD kernels, before they are narrowed and
+ * interleaved: position xyzw, octahedral normal, octahedral tangent, uv */
+constexpr size_t encodedLaneCount = 10;
+
+template <size_t N>
+void writeLanes(const int32_t (&lanes)[encodedLaneCount][N], HalfVertex* out)
+{
+    for(size_t i = 0; i < N; i++)
+    {
+        HalfVertex& vertex = out[i];
+        for(size_t c = 0; c < 4; c++)
+        {
+            vertex.pos[c] = static_cast<uint16_t>(lanes[c][i]);
+        }
+        for(size_t c = 0; c < 2; c++)
+        {
+            vertex.nrm[c] = static_cast<int16_t>(lanes[4 + c][i]);
+            vertex.tang[c] = static_cast<int16_t>(lanes[6 + c][i]);
+            vertex.uv[c] = static_cast<uint16_t>(lanes[8 + c][i]);
+        }
+    }
+}
+
+template <size_t N>
+void writeLanes(const int32_t (&lanes)[encodedLaneCount][N], QuantizedVertex* out)
+{
+    for(size_t i = 0; i < N; i++)
+    {
+        QuantizedVertex& vertex = out[i];
+        for(size_t c = 0; c < 4; c++)
+        {
+            vertex.pos[c] = static_cast<uint16_t>(lanes[c][i]);
+        }
+        for(size_t c = 0; c < 2; c++)
+        {
+            vertex.nrm[c] = static_cast<int8_t>(lanes[4 + c][i]);
+            vertex.tang[c] = static_cast<int8_t>(lanes[6 + c][i]);
+            vertex.uv[c] = static_cast<uint16_t>(lanes[8 + c][i]);
+        }
+    }
+}
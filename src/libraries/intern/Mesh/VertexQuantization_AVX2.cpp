@@ -0,0 +1,155 @@
+#include "VertexQuantizationKernels.h"
+
+#ifdef __AVX2__
+
+    #include <immintrin.h>
+    #include <type_traits>
+
+namespace
+{
+    constexpr float maxHalf = 65504.0f;
+    constexpr float minNormalHalf = 6.103515625e-05f;
+    constexpr float maxSnorm16 = 32767.0f;
+    constexpr float maxSnorm8 = 127.0f;
+    constexpr float maxUnorm16 = 65535.0f;
+
+    __m256 loadComponent(const VertexStruct* vertices, __m256i offsets, int component)
+    {
+        return _mm256_i32gather_ps(reinterpret_cast<const float*>(vertices) + component, offsets, 4);
+    }
+
+    __m256 clampUnit(__m256 value)
+    {
+        // max returns the second operand for NaNs
+        return _mm256_min_ps(_mm256_max_ps(value, _mm256_setzero_ps()), _mm256_set1_ps(1.0f));
+    }
+
+    __m256i toSnorm(__m256 value, float maxValue)
+    {
+        const __m256 clamped =
+            _mm256_min_ps(_mm256_max_ps(value, _mm256_set1_ps(-1.0f)), _mm256_set1_ps(1.0f));
+        return _mm256_cvtps_epi32(_mm256_mul_ps(clamped, _mm256_set1_ps(maxValue)));
+    }
+
+    __m256i toHalf(__m256 value)
+    {
+        const __m256i sign =
+            _mm256_and_si256(_mm256_srli_epi32(_mm256_castps_si256(value), 16), _mm256_set1_epi32(0x8000));
+        const __m256 magnitude = _mm256_min_ps(
+            _mm256_max_ps(_mm256_andnot_ps(_mm256_set1_ps(-0.0f), value), _mm256_setzero_ps()),
+            _mm256_set1_ps(maxHalf));
+        const __m256i normal = _mm256_srli_epi32(
+            _mm256_add_epi32(
+                _mm256_sub_epi32(_mm256_castps_si256(magnitude), _mm256_set1_epi32((127 - 15) << 23)),
+                _mm256_set1_epi32(1 << 12)),
+            13);
+        const __m256i denormal = _mm256_cvtps_epi32(_mm256_mul_ps(magnitude, _mm256_set1_ps(16777216.0f)));
+        const __m256 isDenormal = _mm256_cmp_ps(magnitude, _mm256_set1_ps(minNormalHalf), _CMP_LT_OQ);
+        return _mm256_or_si256(
+            sign,
+            _mm256_castps_si256(
+                _mm256_blendv_ps(_mm256_castsi256_ps(normal), _mm256_castsi256_ps(denormal), isDenormal)));
+    }
+
+    void octEncode(__m256 x, __m256 y, __m256 z, __m256* encoded)
+    {
+        const __m256 signMask = _mm256_set1_ps(-0.0f);
+        const __m256 one = _mm256_set1_ps(1.0f);
+        const __m256 absX = _mm256_andnot_ps(signMask, x);
+        const __m256 absY = _mm256_andnot_ps(signMask, y);
+        const __m256 absZ = _mm256_andnot_ps(signMask, z);
+        const __m256 sum =
+            _mm256_max_ps(_mm256_add_ps(_mm256_add_ps(absX, absY), absZ), _mm256_set1_ps(1e-20f));
+        const __m256 u = _mm256_div_ps(x, sum);
+        const __m256 v = _mm256_div_ps(y, sum);
+        const __m256 foldedU = _mm256_mul_ps(
+            _mm256_sub_ps(one, _mm256_andnot_ps(signMask, v)), _mm256_or_ps(_mm256_and_ps(signMask, u), one));
+        const __m256 foldedV = _mm256_mul_ps(
+            _mm256_sub_ps(one, _mm256_andnot_ps(signMask, u)), _mm256_or_ps(_mm256_and_ps(signMask, v), one));
+        const __m256 lower = _mm256_cmp_ps(z, _mm256_setzero_ps(), _CMP_LT_OQ);
+        encoded[0] = _mm256_blendv_ps(u, foldedU, lower);
+        encoded[1] = _mm256_blendv_ps(v, foldedV, lower);
+    }
+
+    template <typename Vertex>
+    void packAVX2(const VertexStruct* vertices, size_t count, const PositionEncode& encode, Vertex* out)
+    {
+        constexpr bool half = std::is_same_v<Vertex, HalfVertex>;
+        constexpr int stride = sizeof(VertexStruct) / sizeof(float);
+        const __m256i offsets =
+            _mm256_mullo_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7), _mm256_set1_epi32(stride));
+        const size_t vectorCount = count / 8 * 8;
+        alignas(32) int32_t lanes[encodedLaneCount][8];
+        for(size_t i = 0; i < vectorCount; i += 8)
+        {
+            const VertexStruct* v = vertices + i;
+            __m256 position[4];
+            for(int c = 0; c < 3; c++)
+            {
+                position[c] = clampUnit(_mm256_mul_ps(
+                    _mm256_sub_ps(loadComponent(v, offsets, c), _mm256_set1_ps(encode.offset[c])),
+                    _mm256_set1_ps(encode.scale[c])));
+            }
+            position[3] = _mm256_and_ps(
+                _mm256_cmp_ps(loadComponent(v, offsets, 11), _mm256_setzero_ps(), _CMP_GE_OQ),
+                _mm256_set1_ps(1.0f));
+            __m256 normal[2];
+            octEncode(
+                loadComponent(v, offsets, 3),
+                loadComponent(v, offsets, 4),
+                loadComponent(v, offsets, 5),
+                normal);
+            __m256 tangent[2];
+            octEncode(
+                loadComponent(v, offsets, 8),
+                loadComponent(v, offsets, 9),
+                loadComponent(v, offsets, 10),
+                tangent);
+
+            for(int c = 0; c < 4; c++)
+            {
+                const __m256i p =
+                    half ? toHalf(position[c])
+                         : _mm256_cvtps_epi32(_mm256_mul_ps(position[c], _mm256_set1_ps(maxUnorm16)));
+                _mm256_store_si256(reinterpret_cast<__m256i*>(lanes[c]), p);
+            }
+            const float snormMax = half ? maxSnorm16 : maxSnorm8;
+            for(int c = 0; c < 2; c++)
+            {
+                _mm256_store_si256(reinterpret_cast<__m256i*>(lanes[4 + c]), toSnorm(normal[c], snormMax));
+                _mm256_store_si256(reinterpret_cast<__m256i*>(lanes[6 + c]), toSnorm(tangent[c], snormMax));
+                _mm256_store_si256(
+                    reinterpret_cast<__m256i*>(lanes[8 + c]), toHalf(loadComponent(v, offsets, 6 + c)));
+            }
+            writeLanes(lanes, out + i);
+        }
+        for(size_t i = vectorCount; i < count; i++)
+        {
+            if constexpr(half)
+            {
+                out[i] = packHalfVertex(vertices[i], encode);
+            }
+            else
+            {
+                out[i] = packQuantizedVertex(vertices[i], encode);
+            }
+        }
+    }
+
+    constexpr VertexQuantizationKernels kernelsAVX2 = {
+        .packHalf = packAVX2<HalfVertex>, .packQuantized = packAVX2<QuantizedVertex>};
+} // namespace
+
+const VertexQuantizationKernels* getVertexQuantizationKernelsAVX2()
+{
+    return &kernelsAVX2;
+}
+
+#else
+
+const VertexQuantizationKernels* getVertexQuantizationKernelsAVX2()
+{
+    return nullptr;
+}
+
+#endif
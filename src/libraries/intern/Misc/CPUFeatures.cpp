@@ -0,0 +1,41 @@
+#include "CPUFeatures.h"
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+    #include <immintrin.h>
+    #include <intrin.h>
+#endif
+
+namespace
+{
+    CPUFeatures detectFeatures()
+    {
+        CPUFeatures features;
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+        int info[4] = {}; // NOLINT
+        __cpuid(info, 0);
+        if(info[0] < 7)
+        {
+            return features;
+        }
+        __cpuid(info, 1);
+        const bool osxsave = (info[2] & (1 << 27)) != 0;
+        const bool fma = (info[2] & (1 << 12)) != 0;
+        // the os needs to save the ymm registers on context switches
+        const bool osSavesYmm = osxsave && (_xgetbv(0) & 0x6) == 0x6;
+        __cpuidex(info, 7, 0);
+        features.avx2 = osSavesYmm && (info[1] & (1 << 5)) != 0;
+        features.fma = osSavesYmm && fma;
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+        __builtin_cpu_init();
+        features.avx2 = __builtin_cpu_supports("avx2") != 0;
+        features.fma = __builtin_cpu_supports("fma") != 0;
+#endif
+        return features;
+    }
+} // namespace
+
+const CPUFeatures& getCPUFeatures()
+{
+    static const CPUFeatures features = detectFeatures();
+    return features;
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+/* SSE2 is part of every x86-64 cpu, so it can be used without any runtime checks */
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define INTERN_HAS_SSE2 1
+#else
+    #define INTERN_HAS_SSE2 0
+#endif
+
+/** Instruction set extensions that are supported by the cpu *and* the os.
+ * Kernels using them live in *_AVX2.cpp files, which are the only ones compiled with these
+ * extensions enabled, and must only be called after checking the flags here.
+ */
+struct CPUFeatures
+{
+    bool avx2 = false;
+    bool fma = false;
+};
+
+const CPUFeatures& getCPUFeatures();
@@ -0,0 +1,186 @@
+#include "GPUMemoryTracker.h"
+
+#include <algorithm>
+#include <cassert>
+#include <iostream>
+
+#include <intern/Texture/Texture.h>
+
+const char* gpuMemoryCategoryName(GPUMemoryCategory category)
+{
+    switch(category)
+    {
+    case GPUMemoryCategory::Texture:
+        return "Textures";
+    case GPUMemoryCategory::Texture3D:
+        return "3D / array textures";
+    case GPUMemoryCategory::RenderTarget:
+        return "Render targets";
+    case GPUMemoryCategory::Mesh:
+        return "Meshes";
+    case GPUMemoryCategory::Staging:
+        return "Staging / readback";
+    default:
+        return "Unknown";
+    }
+}
+
+GPUMemoryTracker& GPUMemoryTracker::get()
+{
+    static GPUMemoryTracker tracker;
+    return tracker;
+}
+
+uint64_t GPUMemoryTracker::textureKey(GLuint texture)
+{
+    return texture;
+}
+
+uint64_t GPUMemoryTracker::bufferKey(GLuint buffer)
+{
+    return (1ull << 32u) | buffer;
+}
+
+void GPUMemoryTracker::trackTexture(
+    GLuint texture, GPUMemoryCategory category, GLenum internalFormat, int width, int height, int depth,
+    int levels, bool array)
+{
+    Allocation allocation{.category = category, .internalFormat = internalFormat, .bytes = 0};
+    allocation.levelBytes.resize(levels);
+    for(int level = 0; level < levels; level++)
+    {
+        const int levelDepth = array ? depth : std::max(depth >> level, 1);
+        allocation.levelBytes[level] =
+            textureLevelSize(internalFormat, std::max(width >> level, 1), std::max(height >> level, 1)) *
+            levelDepth;
+        allocation.bytes += allocation.levelBytes[level];
+    }
+    add(textureKey(texture), std::move(allocation));
+}
+
+void GPUMemoryTracker::setTextureCategory(GLuint texture, GPUMemoryCategory category)
+{
+    const auto it = allocations.find(textureKey(texture));
+    if(it == allocations.end() || it->second.category == category)
+    {
+        return;
+    }
+    Allocation allocation = it->second;
+    remove(textureKey(texture));
+    allocation.category = category;
+    add(textureKey(texture), std::move(allocation));
+}
+
+void GPUMemoryTracker::untrackTexture(GLuint texture)
+{
+    remove(textureKey(texture));
+}
+
+void GPUMemoryTracker::trackBuffer(GLuint buffer, GPUMemoryCategory category, size_t bytes)
+{
+    add(bufferKey(buffer),
+        {.category = category, .internalFormat = 0, .levelBytes = {bytes}, .bytes = bytes});
+}
+
+void GPUMemoryTracker::untrackBuffer(GLuint buffer)
+{
+    remove(bufferKey(buffer));
+}
+
+void GPUMemoryTracker::setBudget(GPUMemoryCategory category, size_t bytes, BudgetCallback onExceeded)
+{
+    budgets[static_cast<size_t>(category)] = {.bytes = bytes, .onExceeded = std::move(onExceeded)};
+    checkBudget(category);
+}
+
+void GPUMemoryTracker::setTotalBudget(size_t bytes, BudgetCallback onExceeded)
+{
+    totalBudget = {.bytes = bytes, .onExceeded = std::move(onExceeded)};
+    checkBudget(GPUMemoryCategory::Count);
+}
+
+void GPUMemoryTracker::add(uint64_t key, Allocation&& allocation)
+{
+    // GL names are reused after deletion, an existing entry means a delete was not reported
+    assert(!allocations.contains(key) && "GL object tracked twice");
+    remove(key);
+
+    CategoryStats& category = categories[static_cast<size_t>(allocation.category)];
+    category.bytes += allocation.bytes;
+    category.peakBytes = std::max(category.peakBytes, category.bytes);
+    category.objects++;
+    totalBytes += allocation.bytes;
+    peakBytes = std::max(peakBytes, totalBytes);
+    if(allocation.internalFormat != 0)
+    {
+        bytesPerFormat[allocation.internalFormat] += allocation.bytes;
+        bytesPerLevel.resize(std::max(bytesPerLevel.size(), allocation.levelBytes.size()), 0);
+        for(size_t level = 0; level < allocation.levelBytes.size(); level++)
+        {
+            bytesPerLevel[level] += allocation.levelBytes[level];
+        }
+    }
+    const GPUMemoryCategory categoryID = allocation.category;
+    allocations.emplace(key, std::move(allocation));
+    checkBudget(categoryID);
+}
+
+void GPUMemoryTracker::remove(uint64_t key)
+{
+    const auto it = allocations.find(key);
+    if(it == allocations.end())
+    {
+        return;
+    }
+    const Allocation& allocation = it->second;
+    CategoryStats& category = categories[static_cast<size_t>(allocation.category)];
+    category.bytes -= allocation.bytes;
+    category.objects--;
+    totalBytes -= allocation.bytes;
+    if(allocation.internalFormat != 0)
+    {
+        size_t& formatBytes = bytesPerFormat[allocation.internalFormat];
+        formatBytes -= allocation.bytes;
+        if(formatBytes == 0)
+        {
+            bytesPerFormat.erase(allocation.internalFormat);
+        }
+        for(size_t level = 0; level < allocation.levelBytes.size(); level++)
+        {
+            bytesPerLevel[level] -= allocation.levelBytes[level];
+        }
+    }
+
+    Budget& budget = budgets[static_cast<size_t>(allocation.category)];
+    budget.exceeded = budget.exceeded && category.bytes > budget.bytes;
+    totalBudget.exceeded = totalBudget.exceeded && totalBytes > totalBudget.bytes;
+    allocations.erase(it);
+}
+
+void GPUMemoryTracker::checkBudget(GPUMemoryCategory category)
+{
+    // the category itself first, then the total. Callbacks may free memory right away
+    const auto check = [](Budget& budget, GPUMemoryCategory category, size_t used)
+    {
+        if(budget.bytes == 0 || used <= budget.bytes || budget.exceeded)
+        {
+            return;
+        }
+        budget.exceeded = true;
+        if(budget.onExceeded)
+        {
+            budget.onExceeded(category, used, budget.bytes);
+            return;
+        }
+        std::cout << "WARNING: GPU memory budget exceeded ("
+                  << (category == GPUMemoryCategory::Count ? "total" : gpuMemoryCategoryName(category))
+                  << "): " << used / (1024 * 1024) << " MB used of " << budget.bytes / (1024 * 1024) << " MB"
+                  << std::endl;
+    };
+    if(category != GPUMemoryCategory::Count)
+    {
+        const auto index = static_cast<size_t>(category);
+        check(budgets[index], category, categories[index].bytes);
+    }
+    check(totalBudget, GPUMemoryCategory::Count, totalBytes);
+}
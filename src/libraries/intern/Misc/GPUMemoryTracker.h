@@ -0,0 +1,146 @@
+#pragma once
+
+#include <glad/glad/glad.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+enum class GPUMemoryCategory
+{
+    Texture,
+    Texture3D,
+    RenderTarget,
+    Mesh,
+    Staging,
+    Count
+};
+
+const char* gpuMemoryCategoryName(GPUMemoryCategory category);
+
+/** Bookkeeping of the immutable storage allocated for textures and buffers, so it is known how much
+ * VRAM is in use (sizes are computed from the formats, drivers may pad and align on top of that).
+ * Texture, Texture3D, Framebuffer, Mesh and the staging/readback rings register their storage here when
+ * they create it and unregister it when they delete it. Allocations are tracked by their GL object,
+ * so moving or swapping the C++ wrappers does not change anything.
+ *
+ * Budgets can be set per category and in total. When an allocation pushes the usage over a budget its
+ * callback is called (eg. to evict from a cache), or a warning is printed if there is none.
+ * Only use from the GL thread.
+ */
+class GPUMemoryTracker
+{
+  public:
+    // category is GPUMemoryCategory::Count for the total budget
+    using BudgetCallback = std::function<void(GPUMemoryCategory category, size_t used, size_t budget)>;
+
+    struct Budget
+    {
+        // 0 means no budget
+        size_t bytes = 0;
+        BudgetCallback onExceeded;
+        // only warn once per time the budget is exceeded
+        bool exceeded = false;
+    };
+
+    struct CategoryStats
+    {
+        size_t bytes = 0;
+        size_t peakBytes = 0;
+        size_t objects = 0;
+    };
+
+    static GPUMemoryTracker& get();
+
+    GPUMemoryTracker(const GPUMemoryTracker&) = delete;
+    GPUMemoryTracker& operator=(const GPUMemoryTracker&) = delete;
+
+    /** Registers the storage of a texture
+     * @param depth Depth of 3D textures (halved every level) or layer count of array textures (kept)
+     */
+    void trackTexture(
+        GLuint texture, GPUMemoryCategory category, GLenum internalFormat, int width, int height, int depth,
+        int levels, bool array = false);
+    /* Moves a texture to another category, eg. textures used as render targets */
+    void setTextureCategory(GLuint texture, GPUMemoryCategory category);
+    void untrackTexture(GLuint texture);
+
+    void trackBuffer(GLuint buffer, GPUMemoryCategory category, size_t bytes);
+    void untrackBuffer(GLuint buffer);
+
+    /* bytes == 0 removes the budget */
+    void setBudget(GPUMemoryCategory category, size_t bytes, BudgetCallback onExceeded = {});
+    void setTotalBudget(size_t bytes, BudgetCallback onExceeded = {});
+
+    [[nodiscard]] inline const CategoryStats& getCategoryStats(GPUMemoryCategory category) const
+    {
+        return categories[static_cast<size_t>(category)];
+    }
+
+    [[nodiscard]] inline const Budget& getBudget(GPUMemoryCategory category) const
+    {
+        return budgets[static_cast<size_t>(category)];
+    }
+
+    [[nodiscard]] inline const Budget& getTotalBudget() const
+    {
+        return totalBudget;
+    }
+
+    [[nodiscard]] inline size_t getTotalBytes() const
+    {
+        return totalBytes;
+    }
+
+    [[nodiscard]] inline size_t getPeakBytes() const
+    {
+        return peakBytes;
+    }
+
+    /* Texture bytes by internal format */
+    [[nodiscard]] inline const std::map<GLenum, size_t>& getBytesPerFormat() const
+    {
+        return bytesPerFormat;
+    }
+
+    /* Texture bytes by mip level */
+    [[nodiscard]] inline const std::vector<size_t>& getBytesPerLevel() const
+    {
+        return bytesPerLevel;
+    }
+
+  private:
+    struct Allocation
+    {
+        GPUMemoryCategory category;
+        // 0 for buffers
+        GLenum internalFormat;
+        // bytes of every mip level, a single entry for buffers
+        std::vector<size_t> levelBytes;
+        size_t bytes;
+    };
+
+    // texture and buffer names are separate namespaces
+    static uint64_t textureKey(GLuint texture);
+    static uint64_t bufferKey(GLuint buffer);
+
+    GPUMemoryTracker() = default;
+
+    void add(uint64_t key, Allocation&& allocation);
+    void remove(uint64_t key);
+    void checkBudget(GPUMemoryCategory category);
+
+    std::unordered_map<uint64_t, Allocation> allocations;
+    std::array<CategoryStats, static_cast<size_t>(GPUMemoryCategory::Count)> categories;
+    std::array<Budget, static_cast<size_t>(GPUMemoryCategory::Count)> budgets;
+    Budget totalBudget;
+    size_t totalBytes = 0;
+    size_t peakBytes = 0;
+    std::map<GLenum, size_t> bytesPerFormat;
+    std::vector<size_t> bytesPerLevel;
+};
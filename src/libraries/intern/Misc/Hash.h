@@ -0,0 +1,10 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/* Mixes value into hash (as boost::hash_combine does), so hashes of keys with several members can be built */
+inline void hashCombine(size_t& hash, uint64_t value)
+{
+    hash ^= value + 0x9e3779b9 + (hash << 6u) + (hash >> 2u);
+}
@@ -6,10 +6,92 @@
 #include <ImGui/imgui_impl_glfw.h>
 #include <ImGui/imgui_impl_opengl3.h>
 
+#include "GPUMemoryTracker.h"
 #include "ImGuiExtensions.h"
 
+#include <cstdio>
 #include <vector>
 
+#include <intern/Texture/BlockCompression.h>
+
+namespace
+{
+    const char* formatName(GLenum internalFormat)
+    {
+        switch(internalFormat)
+        {
+        case GL_R8:
+            return "R8";
+        case GL_RG8:
+            return "RG8";
+        case GL_RGB8:
+            return "RGB8";
+        case GL_RGBA8:
+            return "RGBA8";
+        case GL_SRGB8_ALPHA8:
+            return "SRGB8_ALPHA8";
+        case GL_RGBA8UI:
+            return "RGBA8UI";
+        case GL_R16F:
+            return "R16F";
+        case GL_RG16F:
+            return "RG16F";
+        case GL_RGBA16F:
+            return "RGBA16F";
+        case GL_R32F:
+            return "R32F";
+        case GL_RG32F:
+            return "RG32F";
+        case GL_RGB32F:
+            return "RGB32F";
+        case GL_RGBA32F:
+            return "RGBA32F";
+        case GL_R32UI:
+            return "R32UI";
+        case GL_RGB9_E5:
+            return "RGB9_E5";
+        case GL_R11F_G11F_B10F:
+            return "R11F_G11F_B10F";
+        case GL_DEPTH_COMPONENT24:
+            return "DEPTH24";
+        case GL_DEPTH_COMPONENT32F:
+            return "DEPTH32F";
+        case GL_DEPTH24_STENCIL8:
+            return "DEPTH24_STENCIL8";
+        case GL_DEPTH32F_STENCIL8:
+            return "DEPTH32F_STENCIL8";
+        case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+        case GL_COMPRESSED_SRGB_S3TC_DXT1_EXT:
+            return "BC1";
+        case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+        case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT:
+            return "BC3";
+        case GL_COMPRESSED_RED_RGTC1:
+        case GL_COMPRESSED_SIGNED_RED_RGTC1:
+            return "BC4";
+        case GL_COMPRESSED_RG_RGTC2:
+        case GL_COMPRESSED_SIGNED_RG_RGTC2:
+            return "BC5";
+        case GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT:
+        case GL_COMPRESSED_RGB_BPTC_SIGNED_FLOAT:
+            return "BC6H";
+        case GL_COMPRESSED_RGBA_BPTC_UNORM:
+        case GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM:
+            return "BC7";
+        default:
+            return nullptr;
+        }
+    }
+
+    void formatBytes(char* buffer, size_t bufferSize, size_t bytes)
+    {
+        if(bytes >= 1024 * 1024)
+            snprintf(buffer, bufferSize, "%.1f MB", bytes / (1024.0 * 1024.0));
+        else
+            snprintf(buffer, bufferSize, "%.1f KB", bytes / 1024.0);
+    }
+} // namespace
+
 void ImGui::Extensions::FrameStart()
 {
     // start imgui frame
@@ -340,4 +422,98 @@ float ImGui::Extensions::GetTextScrollFactor(double time)
     //        glm::smoothstep(freeze, freeze + timeForScroll, glm::mod(time, 2 * freeze + timeForScroll));
     return pixelWidth *
            glm::clamp((glm::mod(time, 2 * freeze + timeForScroll) - freeze) / timeForScroll, 0.0, 1.0);
-}
\ No newline at end of file
+}
+void ImGui::Extensions::GPUMemoryWindow(bool* open)
+{
+    if(!ImGui::Begin("GPU Memory", open))
+    {
+        ImGui::End();
+        return;
+    }
+    const GPUMemoryTracker& tracker = GPUMemoryTracker::get();
+    char used[32];
+    char other[32];
+
+    formatBytes(used, sizeof(used), tracker.getTotalBytes());
+    formatBytes(other, sizeof(other), tracker.getPeakBytes());
+    ImGui::Text("Total: %s (peak %s)", used, other);
+    const GPUMemoryTracker::Budget& totalBudget = tracker.getTotalBudget();
+    if(totalBudget.bytes > 0)
+    {
+        char overlay[80];
+        formatBytes(other, sizeof(other), totalBudget.bytes);
+        snprintf(overlay, sizeof(overlay), "%s / %s", used, other);
+        const float fraction = float(tracker.getTotalBytes()) / float(totalBudget.bytes);
+        HorizontalBar(0.0f, fraction, ImVec2(-1, 0), overlay);
+    }
+
+    if(ImGui::BeginTable("Categories", 3, ImGuiTableFlags_RowBg | ImGuiTableFlags_SizingStretchProp))
+    {
+        ImGui::TableSetupColumn("Category");
+        ImGui::TableSetupColumn("Objects");
+        ImGui::TableSetupColumn("Memory");
+        ImGui::TableHeadersRow();
+        for(size_t i = 0; i < static_cast<size_t>(GPUMemoryCategory::Count); i++)
+        {
+            const auto category = static_cast<GPUMemoryCategory>(i);
+            const GPUMemoryTracker::CategoryStats& stats = tracker.getCategoryStats(category);
+            const GPUMemoryTracker::Budget& budget = tracker.getBudget(category);
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::TextUnformatted(gpuMemoryCategoryName(category));
+            ImGui::TableNextColumn();
+            ImGui::Text("%zu", stats.objects);
+            ImGui::TableNextColumn();
+            formatBytes(used, sizeof(used), stats.bytes);
+            if(budget.bytes == 0)
+            {
+                ImGui::TextUnformatted(used);
+                continue;
+            }
+            char overlay[80];
+            formatBytes(other, sizeof(other), budget.bytes);
+            snprintf(overlay, sizeof(overlay), "%s / %s", used, other);
+            HorizontalBar(0.0f, float(stats.bytes) / float(budget.bytes), ImVec2(-1, 0), overlay);
+        }
+        ImGui::EndTable();
+    }
+
+    if(ImGui::CollapsingHeader("Textures by format") &&
+       ImGui::BeginTable("Formats", 2, ImGuiTableFlags_RowBg | ImGuiTableFlags_SizingStretchProp))
+    {
+        for(const auto& [internalFormat, bytes] : tracker.getBytesPerFormat())
+        {
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            const char* name = formatName(internalFormat);
+            if(name != nullptr)
+                ImGui::TextUnformatted(name);
+            else
+                ImGui::Text("0x%04X", internalFormat);
+            ImGui::TableNextColumn();
+            formatBytes(used, sizeof(used), bytes);
+            ImGui::TextUnformatted(used);
+        }
+        ImGui::EndTable();
+    }
+
+    if(ImGui::CollapsingHeader("Textures by mip level") &&
+       ImGui::BeginTable("Levels", 2, ImGuiTableFlags_RowBg | ImGuiTableFlags_SizingStretchProp))
+    {
+        const std::vector<size_t>& levels = tracker.getBytesPerLevel();
+        for(size_t level = 0; level < levels.size(); level++)
+        {
+            if(levels[level] == 0)
+                continue;
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::Text("Level %zu", level);
+            ImGui::TableNextColumn();
+            formatBytes(used, sizeof(used), levels[level]);
+            ImGui::TextUnformatted(used);
+        }
+        ImGui::EndTable();
+    }
+
+    ImGui::End();
+}
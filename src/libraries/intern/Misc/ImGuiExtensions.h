@@ -25,4 +25,7 @@ namespace ImGui::Extensions
         const char* overlay_text, ImVec2 xRange, ImVec2 yRange, ImVec2 graphSize, ImU32* colors = nullptr);
 
     float GetTextScrollFactor(double time);
+
+    /* Window showing the GPUMemoryTracker statistics */
+    void GPUMemoryWindow(bool* open = nullptr);
 }; // namespace ImGui::Extensions
\ No newline at end of file
@@ -0,0 +1,370 @@
+#include "Json.h"
+
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+
+namespace
+{
+    const JsonValue nullValue{};
+
+    void appendUTF8(std::string& string, uint32_t codePoint)
+    {
+        if(codePoint < 0x80)
+        {
+            string += static_cast<char>(codePoint);
+        }
+        else if(codePoint < 0x800)
+        {
+            string += static_cast<char>(0xC0 | (codePoint >> 6u));
+            string += static_cast<char>(0x80 | (codePoint & 0x3Fu));
+        }
+        else if(codePoint < 0x10000)
+        {
+            string += static_cast<char>(0xE0 | (codePoint >> 12u));
+            string += static_cast<char>(0x80 | ((codePoint >> 6u) & 0x3Fu));
+            string += static_cast<char>(0x80 | (codePoint & 0x3Fu));
+        }
+        else
+        {
+            string += static_cast<char>(0xF0 | (codePoint >> 18u));
+            string += static_cast<char>(0x80 | ((codePoint >> 12u) & 0x3Fu));
+            string += static_cast<char>(0x80 | ((codePoint >> 6u) & 0x3Fu));
+            string += static_cast<char>(0x80 | (codePoint & 0x3Fu));
+        }
+    }
+} // namespace
+
+// recursive descent, fails on the first error
+class JsonParser
+{
+  public:
+    explicit JsonParser(std::string_view text) : current(text.data()), end(text.data() + text.size())
+    {
+    }
+
+    bool parseDocument(JsonValue& document)
+    {
+        if(!parseValue(document, 0))
+        {
+            return false;
+        }
+        skipWhitespace();
+        return current == end;
+    }
+
+  private:
+    // deeper documents are rejected instead of overflowing the stack
+    constexpr static int maxDepth = 256;
+
+    void skipWhitespace()
+    {
+        while(current != end && (*current == ' ' || *current == '\n' || *current == '\r' || *current == '\t'))
+        {
+            current++;
+        }
+    }
+
+    bool consume(std::string_view literal)
+    {
+        if(static_cast<size_t>(end - current) < literal.size() ||
+           std::string_view{current, literal.size()} != literal)
+        {
+            return false;
+        }
+        current += literal.size();
+        return true;
+    }
+
+    bool parseHex4(uint32_t& value)
+    {
+        if(end - current < 4)
+        {
+            return false;
+        }
+        const auto result = std::from_chars(current, current + 4, value, 16);
+        if(result.ptr != current + 4)
+        {
+            return false;
+        }
+        current += 4;
+        return true;
+    }
+
+    bool parseString(std::string& string)
+    {
+        // opening quote was checked by the caller
+        current++;
+        while(current != end)
+        {
+            const char c = *current++;
+            if(c == '"')
+            {
+                return true;
+            }
+            if(c != '\\')
+            {
+                string += c;
+                continue;
+            }
+            if(current == end)
+            {
+                return false;
+            }
+            switch(*current++)
+            {
+            case '"':
+                string += '"';
+                break;
+            case '\\':
+                string += '\\';
+                break;
+            case '/':
+                string += '/';
+                break;
+            case 'b':
+                string += '\b';
+                break;
+            case 'f':
+                string += '\f';
+                break;
+            case 'n':
+                string += '\n';
+                break;
+            case 'r':
+                string += '\r';
+                break;
+            case 't':
+                string += '\t';
+                break;
+            case 'u':
+            {
+                uint32_t codePoint = 0;
+                if(!parseHex4(codePoint))
+                {
+                    return false;
+                }
+                // surrogate pair
+                if(codePoint >= 0xD800 && codePoint < 0xDC00)
+                {
+                    uint32_t low = 0;
+                    if(!consume("\\u") || !parseHex4(low) || low < 0xDC00 || low >= 0xE000)
+                    {
+                        return false;
+                    }
+                    codePoint = 0x10000 + ((codePoint - 0xD800) << 10u) + (low - 0xDC00);
+                }
+                appendUTF8(string, codePoint);
+                break;
+            }
+            default:
+                return false;
+            }
+        }
+        return false;
+    }
+
+    bool parseNumber(double& number)
+    {
+        // from_chars does not accept a leading '+', neither does JSON
+        const auto result = std::from_chars(current, end, number);
+        if(result.ec != std::errc{})
+        {
+            return false;
+        }
+        current = result.ptr;
+        return true;
+    }
+
+    bool parseValue(JsonValue& value, int depth)
+    {
+        if(depth > maxDepth)
+        {
+            return false;
+        }
+        skipWhitespace();
+        if(current == end)
+        {
+            return false;
+        }
+        switch(*current)
+        {
+        case '{':
+        {
+            value.type = JsonValue::Type::Object;
+            current++;
+            skipWhitespace();
+            if(current != end && *current == '}')
+            {
+                current++;
+                return true;
+            }
+            while(true)
+            {
+                skipWhitespace();
+                if(current == end || *current != '"')
+                {
+                    return false;
+                }
+                auto& member = value.object.emplace_back();
+                if(!parseString(member.first))
+                {
+                    return false;
+                }
+                skipWhitespace();
+                if(!consume(":") || !parseValue(member.second, depth + 1))
+                {
+                    return false;
+                }
+                skipWhitespace();
+                if(consume("}"))
+                {
+                    return true;
+                }
+                if(!consume(","))
+                {
+                    return false;
+                }
+            }
+        }
+        case '[':
+        {
+            value.type = JsonValue::Type::Array;
+            current++;
+            skipWhitespace();
+            if(current != end && *current == ']')
+            {
+                current++;
+                return true;
+            }
+            while(true)
+            {
+                if(!parseValue(value.array.emplace_back(), depth + 1))
+                {
+                    return false;
+                }
+                skipWhitespace();
+                if(consume("]"))
+                {
+                    return true;
+                }
+                if(!consume(","))
+                {
+                    return false;
+                }
+            }
+        }
+        case '"':
+            value.type = JsonValue::Type::String;
+            return parseString(value.string);
+        case 't':
+            value.type = JsonValue::Type::Bool;
+            value.boolean = true;
+            return consume("true");
+        case 'f':
+            value.type = JsonValue::Type::Bool;
+            value.boolean = false;
+            return consume("false");
+        case 'n':
+            value.type = JsonValue::Type::Null;
+            return consume("null");
+        default:
+            value.type = JsonValue::Type::Number;
+            return parseNumber(value.number);
+        }
+    }
+
+    const char* current;
+    const char* end;
+};
+
+const JsonValue* JsonValue::find(std::string_view key) const
+{
+    for(const auto& [name, value] : object)
+    {
+        if(name == key)
+        {
+            return &value;
+        }
+    }
+    return nullptr;
+}
+
+const JsonValue& JsonValue::operator[](std::string_view key) const
+{
+    const JsonValue* value = find(key);
+    return value != nullptr ? *value : nullValue;
+}
+
+const JsonValue& JsonValue::operator[](size_t index) const
+{
+    return index < array.size() ? array[index] : nullValue;
+}
+
+size_t JsonValue::size() const
+{
+    if(type == Type::Array)
+    {
+        return array.size();
+    }
+    if(type == Type::Object)
+    {
+        return object.size();
+    }
+    return 0;
+}
+
+double JsonValue::getNumber(double fallback) const
+{
+    return type == Type::Number ? number : fallback;
+}
+
+int JsonValue::getInt(int fallback) const
+{
+    // converting doubles outside of the range of int is undefined
+    if(type != Type::Number || std::trunc(number) != number ||
+       number < static_cast<double>(std::numeric_limits<int>::min()) ||
+       number > static_cast<double>(std::numeric_limits<int>::max()))
+    {
+        return fallback;
+    }
+    return static_cast<int>(number);
+}
+
+std::optional<size_t> JsonValue::getSize(std::optional<size_t> fallback) const
+{
+    if(type == Type::Null)
+    {
+        return fallback;
+    }
+    // doubles represent all integers up to 2^53 exactly
+    constexpr double maxSize = 9007199254740992.0;
+    if(type != Type::Number || std::trunc(number) != number || number < 0.0 || number > maxSize)
+    {
+        return std::nullopt;
+    }
+    return static_cast<size_t>(number);
+}
+
+bool JsonValue::getBool(bool fallback) const
+{
+    return type == Type::Bool ? boolean : fallback;
+}
+
+std::string_view JsonValue::getString(std::string_view fallback) const
+{
+    return type == Type::String ? std::string_view{string} : fallback;
+}
+
+bool parseJson(std::string_view text, JsonValue& document)
+{
+    document = JsonValue{};
+    JsonParser parser{text};
+    if(!parser.parseDocument(document))
+    {
+        document = JsonValue{};
+        return false;
+    }
+    return true;
+}
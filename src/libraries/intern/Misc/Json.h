@@ -0,0 +1,104 @@
+#pragma once
+
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+/** Minimal JSON document, enough to read glTF files.
+ * Numbers are kept as doubles, objects keep the order of their members.
+ */
+class JsonValue
+{
+  public:
+    enum class Type
+    {
+        Null,
+        Bool,
+        Number,
+        String,
+        Array,
+        Object
+    };
+
+    [[nodiscard]] inline Type getType() const
+    {
+        return type;
+    }
+
+    [[nodiscard]] inline bool isNull() const
+    {
+        return type == Type::Null;
+    }
+
+    [[nodiscard]] inline bool isNumber() const
+    {
+        return type == Type::Number;
+    }
+
+    [[nodiscard]] inline bool isString() const
+    {
+        return type == Type::String;
+    }
+
+    [[nodiscard]] inline bool isArray() const
+    {
+        return type == Type::Array;
+    }
+
+    [[nodiscard]] inline bool isObject() const
+    {
+        return type == Type::Object;
+    }
+
+    /* Member of an object, nullptr if there is none (or this is not an object) */
+    [[nodiscard]] const JsonValue* find(std::string_view key) const;
+
+    /* Member of an object, a null value if there is none */
+    [[nodiscard]] const JsonValue& operator[](std::string_view key) const;
+
+    /* Element of an array, a null value if the index is out of range */
+    [[nodiscard]] const JsonValue& operator[](size_t index) const;
+
+    /* Elements of an array / members of an object, 0 for other types */
+    [[nodiscard]] size_t size() const;
+
+    [[nodiscard]] inline const std::vector<JsonValue>& getArray() const
+    {
+        return array;
+    }
+
+    [[nodiscard]] inline const std::vector<std::pair<std::string, JsonValue>>& getObject() const
+    {
+        return object;
+    }
+
+    // return the fallback if the value has a different type
+    [[nodiscard]] double getNumber(double fallback = 0.0) const;
+    // also returns the fallback for numbers that are not integral or out of the range of int
+    [[nodiscard]] int getInt(int fallback = 0) const;
+    /** Sizes, offsets and counts, checked since they come straight from the file
+     * @return The number if it is integral, not negative and exactly representable, the fallback if the
+     *         value is null (eg. a missing member) and nullopt for anything else
+     */
+    [[nodiscard]] std::optional<size_t> getSize(std::optional<size_t> fallback = std::nullopt) const;
+    [[nodiscard]] bool getBool(bool fallback = false) const;
+    [[nodiscard]] std::string_view getString(std::string_view fallback = {}) const;
+
+  private:
+    friend class JsonParser;
+
+    Type type = Type::Null;
+    bool boolean = false;
+    double number = 0.0;
+    std::string string;
+    std::vector<JsonValue> array;
+    std::vector<std::pair<std::string, JsonValue>> object;
+};
+
+/** Parses a JSON document
+ * @return false if the text is not valid JSON, document is left null in that case
+ */
+bool parseJson(std::string_view text, JsonValue& document);
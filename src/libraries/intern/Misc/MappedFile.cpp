@@ -0,0 +1,126 @@
+#include "MappedFile.h"
+
+#include <iostream>
+#include <utility>
+
+#ifdef _WIN32
+    #ifndef WIN32_LEAN_AND_MEAN
+        #define WIN32_LEAN_AND_MEAN
+    #endif
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+MappedFile::MappedFile(const std::string& path, bool sequential)
+{
+#ifdef _WIN32
+    const DWORD flags = sequential ? FILE_FLAG_SEQUENTIAL_SCAN : FILE_ATTRIBUTE_NORMAL;
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, flags, nullptr);
+    if(file == INVALID_HANDLE_VALUE)
+    {
+        std::cout << "Could not open file " << path << std::endl;
+        return;
+    }
+    LARGE_INTEGER size;
+    if(GetFileSizeEx(file, &size) == 0 || size.QuadPart == 0)
+    {
+        CloseHandle(file);
+        return;
+    }
+    HANDLE fileMapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if(fileMapping == nullptr)
+    {
+        CloseHandle(file);
+        return;
+    }
+    mapping = static_cast<const uint8_t*>(MapViewOfFile(fileMapping, FILE_MAP_READ, 0, 0, 0));
+    if(mapping == nullptr)
+    {
+        CloseHandle(fileMapping);
+        CloseHandle(file);
+        return;
+    }
+    fileHandle = file;
+    mappingHandle = fileMapping;
+    fileSize = static_cast<size_t>(size.QuadPart);
+#else
+    const int fd = open(path.c_str(), O_RDONLY);
+    if(fd < 0)
+    {
+        std::cout << "Could not open file " << path << std::endl;
+        return;
+    }
+    struct stat info
+    {
+    };
+    if(fstat(fd, &info) != 0 || info.st_size == 0)
+    {
+        ::close(fd);
+        return;
+    }
+    void* ptr = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    // the mapping stays valid after closing the descriptor
+    ::close(fd);
+    if(ptr == MAP_FAILED)
+    {
+        return;
+    }
+    if(sequential)
+    {
+        // advice values are not flags, so these need two calls
+        madvise(ptr, static_cast<size_t>(info.st_size), MADV_SEQUENTIAL);
+        madvise(ptr, static_cast<size_t>(info.st_size), MADV_WILLNEED);
+    }
+    mapping = static_cast<const uint8_t*>(ptr);
+    fileSize = static_cast<size_t>(info.st_size);
+#endif
+}
+
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+{
+    swap(other);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+{
+    swap(other);
+    return *this;
+}
+
+void MappedFile::swap(MappedFile& other) noexcept
+{
+    std::swap(mapping, other.mapping);
+    std::swap(fileSize, other.fileSize);
+#ifdef _WIN32
+    std::swap(fileHandle, other.fileHandle);
+    std::swap(mappingHandle, other.mappingHandle);
+#endif
+}
+
+void MappedFile::close()
+{
+    if(mapping == nullptr)
+    {
+        return;
+    }
+#ifdef _WIN32
+    UnmapViewOfFile(mapping);
+    CloseHandle(mappingHandle);
+    CloseHandle(fileHandle);
+    fileHandle = nullptr;
+    mappingHandle = nullptr;
+#else
+    munmap(const_cast<uint8_t*>(mapping), fileSize);
+#endif
+    mapping = nullptr;
+    fileSize = 0;
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+
+/** Read only memory mapping of a whole file.
+ * Pages are only read from disk when they are first touched, so nothing is copied into
+ * intermediate buffers when passing the data on to OpenGL.
+ */
+class MappedFile
+{
+  public:
+    MappedFile() = default;
+    /** Maps the file, check isOpen() for failure
+     * @param path Path of the file to map
+     * @param sequential Hint that the file will be read front to back (enables read-ahead)
+     */
+    explicit MappedFile(const std::string& path, bool sequential = true);
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+
+    void swap(MappedFile& other) noexcept;
+
+    [[nodiscard]] inline bool isOpen() const
+    {
+        return mapping != nullptr;
+    }
+
+    [[nodiscard]] inline const uint8_t* data() const
+    {
+        return mapping;
+    }
+
+    [[nodiscard]] inline size_t size() const
+    {
+        return fileSize;
+    }
+
+    [[nodiscard]] inline std::span<const uint8_t> bytes() const
+    {
+        return {mapping, fileSize};
+    }
+
+  private:
+    void close();
+
+    const uint8_t* mapping = nullptr;
+    size_t fileSize = 0;
+#ifdef _WIN32
+    void* fileHandle = nullptr;
+    void* mappingHandle = nullptr;
+#endif
+};
@@ -0,0 +1,111 @@
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+
+ThreadPool::ThreadPool(unsigned int threadCount)
+{
+    if(threadCount == 0)
+    {
+        threadCount = std::max(std::thread::hardware_concurrency(), 2u) - 1;
+    }
+    workers.reserve(threadCount);
+    for(unsigned int i = 0; i < threadCount; i++)
+    {
+        workers.emplace_back(&ThreadPool::workerLoop, this);
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    jobAvailable.notify_all();
+    for(auto& worker : workers)
+    {
+        worker.join();
+    }
+}
+
+void ThreadPool::enqueue(std::function<void()> job)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        jobs.emplace_back(std::move(job));
+    }
+    jobAvailable.notify_one();
+}
+
+void ThreadPool::workerLoop()
+{
+    while(true)
+    {
+        std::function<void()> job;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            jobAvailable.wait(lock, [this]() { return stopping || !jobs.empty(); });
+            if(jobs.empty())
+            {
+                // only reached when stopping, remaining jobs are always drained first
+                return;
+            }
+            job = std::move(jobs.front());
+            jobs.pop_front();
+        }
+        job();
+    }
+}
+
+void ThreadPool::parallelFor(
+    size_t count, size_t grainSize, const std::function<void(size_t, size_t)>& func)
+{
+    grainSize = std::max<size_t>(grainSize, 1);
+    const size_t chunkCount = (count + grainSize - 1) / grainSize;
+    if(chunkCount <= 1 || workers.empty())
+    {
+        if(count > 0)
+        {
+            func(0, count);
+        }
+        return;
+    }
+
+    // shared, since helper jobs may only get scheduled after this call already returned
+    struct State
+    {
+        std::atomic<size_t> nextChunk{0};
+        std::atomic<size_t> finishedChunks{0};
+        std::mutex doneMutex;
+        std::condition_variable done;
+    };
+    auto state = std::make_shared<State>();
+
+    // func is only accessed while there are unclaimed chunks, which is never the case after returning
+    auto work = [state, count, grainSize, chunkCount, &func]()
+    {
+        size_t chunk = 0;
+        while((chunk = state->nextChunk.fetch_add(1)) < chunkCount)
+        {
+            const size_t begin = chunk * grainSize;
+            func(begin, std::min(begin + grainSize, count));
+            if(state->finishedChunks.fetch_add(1) + 1 == chunkCount)
+            {
+                std::lock_guard<std::mutex> lock(state->doneMutex);
+                state->done.notify_all();
+            }
+        }
+    };
+
+    const size_t helperCount = std::min<size_t>(workers.size(), chunkCount - 1);
+    for(size_t i = 0; i < helperCount; i++)
+    {
+        enqueue(work);
+    }
+    work();
+
+    std::unique_lock<std::mutex> lock(state->doneMutex);
+    state->done.wait(lock, [&state, chunkCount]() { return state->finishedChunks.load() == chunkCount; });
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/** Fixed size pool of worker threads that execute jobs in FIFO order.
+ * Jobs must not touch any OpenGL state, there is no context current on the workers.
+ */
+class ThreadPool
+{
+  public:
+    /** @param threadCount Number of workers, 0 picks one less than the hardware concurrency
+     *                     (leaving one core for the render thread)
+     */
+    explicit ThreadPool(unsigned int threadCount = 0);
+    /** Finishes all jobs that are still queued, then joins the workers
+     */
+    ~ThreadPool();
+
+    ThreadPool(ThreadPool&&) = delete;
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(ThreadPool&&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    void enqueue(std::function<void()> job);
+
+    /** Splits [0, count) into chunks of grainSize elements and calls func(begin, end) for each of them.
+     * Blocks until all chunks have been processed. The calling thread works on chunks as well,
+     * so this is safe to call from within a job running on the pool.
+     */
+    void parallelFor(size_t count, size_t grainSize, const std::function<void(size_t, size_t)>& func);
+
+    [[nodiscard]] inline unsigned int getThreadCount() const
+    {
+        return static_cast<unsigned int>(workers.size());
+    }
+
+  private:
+    void workerLoop();
+
+    std::vector<std::thread> workers;
+    std::deque<std::function<void()>> jobs;
+    std::mutex mutex;
+    std::condition_variable jobAvailable;
+    bool stopping = false;
+};
+
+/** Runs func(begin, end) over [0, count) either on the pool or, if there is none, on the calling thread.
+ * Lets CPU kernels take an optional ThreadPool* without duplicating their loops.
+ */
+inline void
+parallelFor(ThreadPool* pool, size_t count, size_t grainSize, const std::function<void(size_t, size_t)>& func)
+{
+    if(pool == nullptr || count <= grainSize)
+    {
+        if(count > 0)
+        {
+            func(0, count);
+        }
+        return;
+    }
+    pool->parallelFor(count, grainSize, func);
+}
@@ -0,0 +1,623 @@
+#include "BlockCompression.h"
+#include "BlockCompressionKernels.h"
+
+#include <intern/Misc/CPUFeatures.h>
+#include <intern/Misc/ThreadPool.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+
+#if INTERN_HAS_SSE2
+    #include <emmintrin.h>
+#endif
+
+namespace
+{
+    // ------------------------------------------------------------ kernels
+
+#if INTERN_HAS_SSE2
+    float horizontalSum(__m128 v)
+    {
+        v = _mm_add_ps(v, _mm_movehl_ps(v, v));
+        v = _mm_add_ss(v, _mm_shuffle_ps(v, v, 1));
+        return _mm_cvtss_f32(v);
+    }
+
+    void statisticsSSE2(const BlockSoA& block, float* mean, float* covariance)
+    {
+        __m128 texels[4][4];
+        for(int c = 0; c < 4; c++)
+        {
+            __m128 sum = _mm_setzero_ps();
+            for(int q = 0; q < 4; q++)
+            {
+                texels[c][q] = _mm_load_ps(&block.channels[c][q * 4]);
+                sum = _mm_add_ps(sum, texels[c][q]);
+            }
+            mean[c] = horizontalSum(sum) * (1.0f / 16.0f);
+        }
+        int index = 0;
+        for(int i = 0; i < 4; i++)
+        {
+            for(int j = i; j < 4; j++)
+            {
+                __m128 sum = _mm_setzero_ps();
+                for(int q = 0; q < 4; q++)
+                {
+                    sum = _mm_add_ps(sum, _mm_mul_ps(texels[i][q], texels[j][q]));
+                }
+                covariance[index++] = horizontalSum(sum) * (1.0f / 16.0f) - mean[i] * mean[j];
+            }
+        }
+    }
+
+    void projectIndicesSSE2(
+        const BlockSoA& block, int firstChannel, int channelCount, const float* e0, const float* e1, int levels,
+        uint8_t* indices)
+    {
+        float lengthSquared = 0.0f;
+        for(int c = firstChannel; c < firstChannel + channelCount; c++)
+        {
+            lengthSquared += (e1[c] - e0[c]) * (e1[c] - e0[c]);
+        }
+        const float scale = lengthSquared > 1e-8f ? static_cast<float>(levels - 1) / lengthSquared : 0.0f;
+        const __m128 maxLevel = _mm_set1_ps(static_cast<float>(levels - 1));
+
+        __m128i rounded[4];
+        for(int q = 0; q < 4; q++)
+        {
+            __m128 t = _mm_setzero_ps();
+            for(int c = firstChannel; c < firstChannel + channelCount; c++)
+            {
+                const __m128 offset = _mm_sub_ps(_mm_load_ps(&block.channels[c][q * 4]), _mm_set1_ps(e0[c]));
+                t = _mm_add_ps(t, _mm_mul_ps(offset, _mm_set1_ps((e1[c] - e0[c]) * scale)));
+            }
+            t = _mm_min_ps(_mm_max_ps(t, _mm_setzero_ps()), maxLevel);
+            rounded[q] = _mm_cvtps_epi32(t);
+        }
+        const __m128i packed16a = _mm_packs_epi32(rounded[0], rounded[1]);
+        const __m128i packed16b = _mm_packs_epi32(rounded[2], rounded[3]);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(indices), _mm_packus_epi16(packed16a, packed16b));
+    }
+
+    constexpr BlockKernels kernelsDefault = {.statistics = statisticsSSE2, .projectIndices = projectIndicesSSE2};
+#else
+    void statisticsScalar(const BlockSoA& block, float* mean, float* covariance)
+    {
+        for(int c = 0; c < 4; c++)
+        {
+            float sum = 0.0f;
+            for(int i = 0; i < 16; i++)
+            {
+                sum += block.channels[c][i];
+            }
+            mean[c] = sum / 16.0f;
+        }
+        int index = 0;
+        for(int i = 0; i < 4; i++)
+        {
+            for(int j = i; j < 4; j++)
+            {
+                float sum = 0.0f;
+                for(int t = 0; t < 16; t++)
+                {
+                    sum += block.channels[i][t] * block.channels[j][t];
+                }
+                covariance[index++] = sum / 16.0f - mean[i] * mean[j];
+            }
+        }
+    }
+
+    void projectIndicesScalar(
+        const BlockSoA& block, int firstChannel, int channelCount, const float* e0, const float* e1, int levels,
+        uint8_t* indices)
+    {
+        float lengthSquared = 0.0f;
+        for(int c = firstChannel; c < firstChannel + channelCount; c++)
+        {
+            lengthSquared += (e1[c] - e0[c]) * (e1[c] - e0[c]);
+        }
+        const float scale = lengthSquared > 1e-8f ? static_cast<float>(levels - 1) / lengthSquared : 0.0f;
+        for(int i = 0; i < 16; i++)
+        {
+            float t = 0.0f;
+            for(int c = firstChannel; c < firstChannel + channelCount; c++)
+            {
+                t += (block.channels[c][i] - e0[c]) * (e1[c] - e0[c]) * scale;
+            }
+            t = std::clamp(t, 0.0f, static_cast<float>(levels - 1));
+            indices[i] = static_cast<uint8_t>(std::lrint(t));
+        }
+    }
+
+    constexpr BlockKernels kernelsDefault = {
+        .statistics = statisticsScalar, .projectIndices = projectIndicesScalar};
+#endif
+
+    const BlockKernels& selectKernels()
+    {
+        const CPUFeatures& features = getCPUFeatures();
+        const BlockKernels* avx2 = getBlockKernelsAVX2();
+        if(avx2 != nullptr && features.avx2 && features.fma)
+        {
+            return *avx2;
+        }
+        return kernelsDefault;
+    }
+
+    // ------------------------------------------------------------ endpoint fitting
+
+    /* Endpoints along the principal axis of the given channels, spanning all texels */
+    void fitPrincipalAxis(
+        const BlockSoA& block, const BlockKernels& kernels, int firstChannel, int channelCount, float* e0,
+        float* e1)
+    {
+        float mean[4];
+        float covariance[10];
+        kernels.statistics(block, mean, covariance);
+        // full symmetric matrix from upper triangle
+        constexpr int triangleIndex[4][4] = {{0, 1, 2, 3}, {1, 4, 5, 6}, {2, 5, 7, 8}, {3, 6, 8, 9}};
+
+        // power iteration, starting from the channel with the largest variance
+        float axis[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+        int largest = firstChannel;
+        for(int c = firstChannel; c < firstChannel + channelCount; c++)
+        {
+            if(covariance[triangleIndex[c][c]] > covariance[triangleIndex[largest][largest]])
+            {
+                largest = c;
+            }
+        }
+        for(int c = firstChannel; c < firstChannel + channelCount; c++)
+        {
+            axis[c] = covariance[triangleIndex[largest][c]];
+        }
+        for(int iteration = 0; iteration < 8; iteration++)
+        {
+            float next[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+            float length = 0.0f;
+            for(int i = firstChannel; i < firstChannel + channelCount; i++)
+            {
+                for(int j = firstChannel; j < firstChannel + channelCount; j++)
+                {
+                    next[i] += covariance[triangleIndex[i][j]] * axis[j];
+                }
+                length = std::max(length, std::abs(next[i]));
+            }
+            if(length < 1e-8f)
+            {
+                break;
+            }
+            for(int c = firstChannel; c < firstChannel + channelCount; c++)
+            {
+                axis[c] = next[c] / length;
+            }
+        }
+        float axisLengthSquared = 0.0f;
+        for(int c = firstChannel; c < firstChannel + channelCount; c++)
+        {
+            axisLengthSquared += axis[c] * axis[c];
+        }
+
+        float minT = 0.0f;
+        float maxT = 0.0f;
+        if(axisLengthSquared > 1e-8f)
+        {
+            minT = INFINITY;
+            maxT = -INFINITY;
+            for(int i = 0; i < 16; i++)
+            {
+                float t = 0.0f;
+                for(int c = firstChannel; c < firstChannel + channelCount; c++)
+                {
+                    t += (block.channels[c][i] - mean[c]) * axis[c];
+                }
+                minT = std::min(minT, t);
+                maxT = std::max(maxT, t);
+            }
+            minT /= axisLengthSquared;
+            maxT /= axisLengthSquared;
+        }
+        for(int c = firstChannel; c < firstChannel + channelCount; c++)
+        {
+            e0[c] = std::clamp(mean[c] + minT * axis[c], 0.0f, 255.0f);
+            e1[c] = std::clamp(mean[c] + maxT * axis[c], 0.0f, 255.0f);
+        }
+    }
+
+    /** Least squares endpoints for fixed indices, weights[index] is the interpolation factor towards e1.
+     * Leaves the endpoints untouched if the system is degenerate (eg. all texels use the same index)
+     */
+    void refineEndpoints(
+        const BlockSoA& block, int firstChannel, int channelCount, const uint8_t* indices, const float* weights,
+        float* e0, float* e1)
+    {
+        float aa = 0.0f;
+        float ab = 0.0f;
+        float bb = 0.0f;
+        float ax[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+        float bx[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+        for(int i = 0; i < 16; i++)
+        {
+            const float b = weights[indices[i]];
+            const float a = 1.0f - b;
+            aa += a * a;
+            ab += a * b;
+            bb += b * b;
+            for(int c = firstChannel; c < firstChannel + channelCount; c++)
+            {
+                ax[c] += a * block.channels[c][i];
+                bx[c] += b * block.channels[c][i];
+            }
+        }
+        const float determinant = aa * bb - ab * ab;
+        if(std::abs(determinant) < 1e-6f)
+        {
+            return;
+        }
+        const float inverse = 1.0f / determinant;
+        for(int c = firstChannel; c < firstChannel + channelCount; c++)
+        {
+            e0[c] = std::clamp((bb * ax[c] - ab * bx[c]) * inverse, 0.0f, 255.0f);
+            e1[c] = std::clamp((aa * bx[c] - ab * ax[c]) * inverse, 0.0f, 255.0f);
+        }
+    }
+
+    // ------------------------------------------------------------ BC1
+
+    uint16_t quantize565(const float* color)
+    {
+        const auto r = static_cast<uint16_t>(std::lrint(color[0] * (31.0f / 255.0f)));
+        const auto g = static_cast<uint16_t>(std::lrint(color[1] * (63.0f / 255.0f)));
+        const auto b = static_cast<uint16_t>(std::lrint(color[2] * (31.0f / 255.0f)));
+        return static_cast<uint16_t>((r << 11u) | (g << 5u) | b);
+    }
+
+    void expand565(uint16_t packed, float* color)
+    {
+        const uint32_t r = (packed >> 11u) & 31u;
+        const uint32_t g = (packed >> 5u) & 63u;
+        const uint32_t b = packed & 31u;
+        color[0] = static_cast<float>((r << 3u) | (r >> 2u));
+        color[1] = static_cast<float>((g << 2u) | (g >> 4u));
+        color[2] = static_cast<float>((b << 3u) | (b >> 2u));
+    }
+
+    void encodeBC1(const BlockSoA& block, const BlockKernels& kernels, uint8_t* out)
+    {
+        constexpr float weights[4] = {0.0f, 1.0f / 3.0f, 2.0f / 3.0f, 1.0f};
+        float e0[4];
+        float e1[4];
+        fitPrincipalAxis(block, kernels, 0, 3, e0, e1);
+
+        uint8_t indices[16];
+        uint16_t c0 = quantize565(e0);
+        uint16_t c1 = quantize565(e1);
+        for(int pass = 0; pass < 2; pass++)
+        {
+            float q0[4];
+            float q1[4];
+            expand565(c0, q0);
+            expand565(c1, q1);
+            kernels.projectIndices(block, 0, 3, q0, q1, 4, indices);
+            if(pass == 0)
+            {
+                refineEndpoints(block, 0, 3, indices, weights, e0, e1);
+                c0 = quantize565(e0);
+                c1 = quantize565(e1);
+            }
+        }
+
+        // 4 color mode requires c0 > c1, the (linear) index order then has to flip
+        if(c0 < c1)
+        {
+            std::swap(c0, c1);
+            for(uint8_t& index : indices)
+            {
+                index = 3 - index;
+            }
+        }
+        else if(c0 == c1)
+        {
+            memset(indices, 0, sizeof(indices));
+        }
+
+        // linear position on the line -> bc1 index (0: c0, 1: c1, 2: 2/3 c0 + 1/3 c1, 3: 1/3 c0 + 2/3 c1)
+        constexpr uint32_t remap[4] = {0, 2, 3, 1};
+        uint32_t packedIndices = 0;
+        for(int i = 0; i < 16; i++)
+        {
+            packedIndices |= remap[indices[i]] << (2u * i);
+        }
+        out[0] = static_cast<uint8_t>(c0 & 0xFFu);
+        out[1] = static_cast<uint8_t>(c0 >> 8u);
+        out[2] = static_cast<uint8_t>(c1 & 0xFFu);
+        out[3] = static_cast<uint8_t>(c1 >> 8u);
+        memcpy(out + 4, &packedIndices, 4);
+    }
+
+    // ------------------------------------------------------------ BC4 (also alpha of BC3, channels of BC5)
+
+    void encodeBC4(const BlockSoA& block, const BlockKernels& kernels, int channel, uint8_t* out)
+    {
+        const float* values = block.channels[channel];
+        const float minValue = *std::min_element(values, values + 16);
+        const float maxValue = *std::max_element(values, values + 16);
+
+        // 8 value mode requires a0 > a1, so a0 is the maximum
+        float e0[4];
+        float e1[4];
+        e0[channel] = std::round(maxValue);
+        e1[channel] = std::round(minValue);
+        uint8_t indices[16] = {};
+        if(e0[channel] > e1[channel])
+        {
+            kernels.projectIndices(block, channel, 1, e0, e1, 8, indices);
+        }
+
+        // linear position -> bc4 index (0: a0, 1: a1, 2-7: interpolated from a0 towards a1)
+        constexpr uint64_t remap[8] = {0, 2, 3, 4, 5, 6, 7, 1};
+        uint64_t packedIndices = 0;
+        for(int i = 0; i < 16; i++)
+        {
+            packedIndices |= remap[indices[i]] << (3u * i);
+        }
+        out[0] = static_cast<uint8_t>(e0[channel]);
+        out[1] = static_cast<uint8_t>(e1[channel]);
+        for(int i = 0; i < 6; i++)
+        {
+            out[2 + i] = static_cast<uint8_t>(packedIndices >> (8u * i));
+        }
+    }
+
+    // ------------------------------------------------------------ BC7
+
+    class BitWriter
+    {
+      public:
+        explicit BitWriter(uint8_t* out) : out(out)
+        {
+            memset(out, 0, 16);
+        }
+        void write(uint32_t value, uint32_t bitCount)
+        {
+            for(uint32_t i = 0; i < bitCount; i++, position++)
+            {
+                out[position / 8] |= static_cast<uint8_t>(((value >> i) & 1u) << (position % 8));
+            }
+        }
+
+      private:
+        uint8_t* out;
+        uint32_t position = 0;
+    };
+
+    /* 7 bit endpoint + shared p-bit, picks the p-bit that reproduces the endpoint best */
+    void quantizeMode6Endpoint(const float* endpoint, uint32_t* quantized, uint32_t* pBit, float* expanded)
+    {
+        float bestError = INFINITY;
+        for(uint32_t p = 0; p < 2; p++)
+        {
+            uint32_t candidate[4];
+            float error = 0.0f;
+            for(int c = 0; c < 4; c++)
+            {
+                candidate[c] = std::clamp<uint32_t>(
+                    static_cast<uint32_t>(std::max(std::lrint((endpoint[c] - static_cast<float>(p)) * 0.5f), 0l)),
+                    0,
+                    127);
+                const float value = static_cast<float>((candidate[c] << 1u) | p);
+                error += (value - endpoint[c]) * (value - endpoint[c]);
+            }
+            if(error < bestError)
+            {
+                bestError = error;
+                *pBit = p;
+                for(int c = 0; c < 4; c++)
+                {
+                    quantized[c] = candidate[c];
+                    expanded[c] = static_cast<float>((candidate[c] << 1u) | p);
+                }
+            }
+        }
+    }
+
+    void encodeBC7Mode6(const BlockSoA& block, const BlockKernels& kernels, uint8_t* out)
+    {
+        constexpr float weights[16] = {
+            0 / 64.0f,
+            4 / 64.0f,
+            9 / 64.0f,
+            13 / 64.0f,
+            17 / 64.0f,
+            21 / 64.0f,
+            26 / 64.0f,
+            30 / 64.0f,
+            34 / 64.0f,
+            38 / 64.0f,
+            43 / 64.0f,
+            47 / 64.0f,
+            51 / 64.0f,
+            55 / 64.0f,
+            60 / 64.0f,
+            64 / 64.0f};
+        float e0[4];
+        float e1[4];
+        fitPrincipalAxis(block, kernels, 0, 4, e0, e1);
+
+        uint8_t indices[16];
+        uint32_t q0[4];
+        uint32_t q1[4];
+        uint32_t p0 = 0;
+        uint32_t p1 = 0;
+        for(int pass = 0; pass < 2; pass++)
+        {
+            float x0[4];
+            float x1[4];
+            quantizeMode6Endpoint(e0, q0, &p0, x0);
+            quantizeMode6Endpoint(e1, q1, &p1, x1);
+            kernels.projectIndices(block, 0, 4, x0, x1, 16, indices);
+            if(pass == 0)
+            {
+                refineEndpoints(block, 0, 4, indices, weights, e0, e1);
+            }
+        }
+
+        // the msb of the first index is implicitly 0, swap endpoints if that does not hold
+        if(indices[0] >= 8)
+        {
+            std::swap(q0, q1);
+            std::swap(p0, p1);
+            for(uint8_t& index : indices)
+            {
+                index = 15 - index;
+            }
+        }
+
+        BitWriter writer(out);
+        writer.write(1u << 6u, 7); // mode 6
+        for(int c = 0; c < 4; c++)
+        {
+            writer.write(q0[c], 7);
+            writer.write(q1[c], 7);
+        }
+        writer.write(p0, 1);
+        writer.write(p1, 1);
+        writer.write(indices[0], 3);
+        for(int i = 1; i < 16; i++)
+        {
+            writer.write(indices[i], 4);
+        }
+    }
+
+    // ------------------------------------------------------------ image -> blocks
+
+    void loadBlock(
+        const uint8_t* pixels, int width, int height, int channels, int blockX, int blockY, BlockSoA& block)
+    {
+        for(int y = 0; y < 4; y++)
+        {
+            // partial blocks repeat the last row/column, which does not disturb the endpoint fit
+            const int sourceY = std::min(blockY * 4 + y, height - 1);
+            for(int x = 0; x < 4; x++)
+            {
+                const int sourceX = std::min(blockX * 4 + x, width - 1);
+                const uint8_t* texel = pixels + (static_cast<size_t>(sourceY) * width + sourceX) * channels;
+                for(int c = 0; c < 4; c++)
+                {
+                    const uint8_t fallback = c == 3 ? 255 : 0;
+                    block.channels[c][y * 4 + x] = c < channels ? texel[c] : fallback;
+                }
+            }
+        }
+    }
+
+    void encodeBlock(BlockFormat format, const BlockSoA& block, const BlockKernels& kernels, uint8_t* out)
+    {
+        switch(format)
+        {
+        case BlockFormat::BC1:
+            encodeBC1(block, kernels, out);
+            break;
+        case BlockFormat::BC3:
+            encodeBC4(block, kernels, 3, out);
+            encodeBC1(block, kernels, out + 8);
+            break;
+        case BlockFormat::BC4:
+            encodeBC4(block, kernels, 0, out);
+            break;
+        case BlockFormat::BC5:
+            encodeBC4(block, kernels, 0, out);
+            encodeBC4(block, kernels, 1, out + 8);
+            break;
+        case BlockFormat::BC7:
+            encodeBC7Mode6(block, kernels, out);
+            break;
+        }
+    }
+} // namespace
+
+size_t blockSize(BlockFormat format)
+{
+    return (format == BlockFormat::BC1 || format == BlockFormat::BC4) ? 8 : 16;
+}
+
+size_t compressedImageSize(BlockFormat format, int width, int height)
+{
+    const size_t blocksX = (std::max(width, 1) + 3) / 4;
+    const size_t blocksY = (std::max(height, 1) + 3) / 4;
+    return blocksX * blocksY * blockSize(format);
+}
+
+GLenum blockFormatToGL(BlockFormat format, bool srgb)
+{
+    switch(format)
+    {
+    case BlockFormat::BC1:
+        return srgb ? GL_COMPRESSED_SRGB_S3TC_DXT1_EXT : GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+    case BlockFormat::BC3:
+        return srgb ? GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT : GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+    case BlockFormat::BC4:
+        return GL_COMPRESSED_RED_RGTC1;
+    case BlockFormat::BC5:
+        return GL_COMPRESSED_RG_RGTC2;
+    case BlockFormat::BC7:
+        return srgb ? GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM : GL_COMPRESSED_RGBA_BPTC_UNORM;
+    }
+    assert(false && "Unknown block format");
+    return 0;
+}
+
+bool isCompressedFormat(GLenum internalFormat)
+{
+    switch(internalFormat)
+    {
+    case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+    case GL_COMPRESSED_SRGB_S3TC_DXT1_EXT:
+    case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+    case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT:
+    case GL_COMPRESSED_RED_RGTC1:
+    case GL_COMPRESSED_SIGNED_RED_RGTC1:
+    case GL_COMPRESSED_RG_RGTC2:
+    case GL_COMPRESSED_SIGNED_RG_RGTC2:
+    case GL_COMPRESSED_RGBA_BPTC_UNORM:
+    case GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM:
+    case GL_COMPRESSED_RGB_BPTC_SIGNED_FLOAT:
+    case GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT:
+        return true;
+    default:
+        return false;
+    }
+}
+
+std::vector<uint8_t> compressImage(
+    BlockFormat format, const uint8_t* pixels, int width, int height, int channels, ThreadPool* pool)
+{
+    const BlockKernels& kernels = selectKernels();
+    const int blocksX = (width + 3) / 4;
+    const int blocksY = (height + 3) / 4;
+    const size_t bytesPerBlock = blockSize(format);
+    std::vector<uint8_t> compressed(compressedImageSize(format, width, height));
+
+    // a few hundred blocks per job keeps the scheduling overhead negligible
+    const size_t rowsPerJob = std::max<size_t>(256 / blocksX, 1);
+    parallelFor(
+        pool,
+        blocksY,
+        rowsPerJob,
+        [&](size_t beginRow, size_t endRow)
+        {
+            BlockSoA block;
+            for(size_t y = beginRow; y < endRow; y++)
+            {
+                for(int x = 0; x < blocksX; x++)
+                {
+                    loadBlock(pixels, width, height, channels, x, static_cast<int>(y), block);
+                    encodeBlock(format, block, kernels, &compressed[(y * blocksX + x) * bytesPerBlock]);
+                }
+            }
+        });
+    return compressed;
+}
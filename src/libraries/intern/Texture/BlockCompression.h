@@ -0,0 +1,55 @@
+#pragma once
+
+#include <glad/glad/glad.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// S3TC is not part of core OpenGL, but supported by every desktop driver
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+    #define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+    #define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+#ifndef GL_COMPRESSED_SRGB_S3TC_DXT1_EXT
+    #define GL_COMPRESSED_SRGB_S3TC_DXT1_EXT 0x8C4C
+#endif
+#ifndef GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT
+    #define GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT 0x8C4F
+#endif
+
+class ThreadPool;
+
+enum struct BlockFormat
+{
+    BC1, // RGB, 8 bytes per block
+    BC3, // RGBA, 16 bytes per block
+    BC4, // R, 8 bytes per block
+    BC5, // RG, 16 bytes per block
+    BC7  // RGBA, 16 bytes per block (encoder only uses mode 6)
+};
+
+/* Size of one compressed 4x4 block in bytes */
+size_t blockSize(BlockFormat format);
+
+/* Size of a compressed image (or mip level) in bytes, partial blocks at the edges are padded */
+size_t compressedImageSize(BlockFormat format, int width, int height);
+
+/* Matching internal format for TextureDesc. BC4 and BC5 have no sRGB variant */
+GLenum blockFormatToGL(BlockFormat format, bool srgb = false);
+
+/* true for the block compressed internal formats that Texture knows how to upload */
+bool isCompressedFormat(GLenum internalFormat);
+
+/** Compresses an 8 bit image into 4x4 blocks.
+ * Missing channels are read as 0, missing alpha as 255. BC4 encodes the first channel, BC5 the first two.
+ * Kernels are vectorized with SSE2 or AVX2 (picked at runtime), blocks are distributed across the pool.
+ * @param format Target block format
+ * @param pixels Tightly packed 8 bit texels, rows in the same order as they are uploaded
+ * @param pool Pool to encode on, nullptr to encode on the calling thread only
+ * @return compressedImageSize() bytes of block data
+ */
+std::vector<uint8_t> compressImage(
+    BlockFormat format, const uint8_t* pixels, int width, int height, int channels, ThreadPool* pool = nullptr);
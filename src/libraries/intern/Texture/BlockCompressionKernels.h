@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstdint>
+
+/*
+    Internal interface between the block compressor and its SIMD kernels.
+    Not meant to be included outside of BlockCompression*.cpp
+*/
+
+/* 4x4 texel block, stored per channel so kernels can load 4/8 texels of one channel at once */
+struct alignas(32) BlockSoA
+{
+    float channels[4][16]; // NOLINT
+};
+
+struct BlockKernels
+{
+    /** Mean and covariance matrix (upper triangle, row major: xx xy xz xw yy yz yw zz zw ww)
+     * of all 16 texels, over the 4 channels
+     */
+    void (*statistics)(const BlockSoA& block, float* mean, float* covariance);
+
+    /** Projects each texel onto the line e0->e1 and rounds to the nearest of levels evenly spaced
+     * positions (0 at e0, levels-1 at e1). Only channels [firstChannel, firstChannel+channelCount) are used.
+     * e0 and e1 are indexed by absolute channel.
+     */
+    void (*projectIndices)(
+        const BlockSoA& block, int firstChannel, int channelCount, const float* e0, const float* e1, int levels,
+        uint8_t* indices);
+};
+
+/* returns nullptr if the library was built without AVX2 support */
+const BlockKernels* getBlockKernelsAVX2();
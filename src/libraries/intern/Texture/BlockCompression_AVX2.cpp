@@ -0,0 +1,84 @@
+#include "BlockCompressionKernels.h"
+
+#ifdef __AVX2__
+
+    #include <immintrin.h>
+
+namespace
+{
+    float horizontalSum(__m256 v)
+    {
+        __m128 sum = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+        sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+        sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 1));
+        return _mm_cvtss_f32(sum);
+    }
+
+    void statisticsAVX2(const BlockSoA& block, float* mean, float* covariance)
+    {
+        __m256 lo[4];
+        __m256 hi[4];
+        for(int c = 0; c < 4; c++)
+        {
+            lo[c] = _mm256_load_ps(&block.channels[c][0]);
+            hi[c] = _mm256_load_ps(&block.channels[c][8]);
+            mean[c] = horizontalSum(_mm256_add_ps(lo[c], hi[c])) * (1.0f / 16.0f);
+        }
+        int index = 0;
+        for(int i = 0; i < 4; i++)
+        {
+            for(int j = i; j < 4; j++)
+            {
+                const __m256 products = _mm256_fmadd_ps(lo[i], lo[j], _mm256_mul_ps(hi[i], hi[j]));
+                covariance[index++] = horizontalSum(products) * (1.0f / 16.0f) - mean[i] * mean[j];
+            }
+        }
+    }
+
+    void projectIndicesAVX2(
+        const BlockSoA& block, int firstChannel, int channelCount, const float* e0, const float* e1, int levels,
+        uint8_t* indices)
+    {
+        float lengthSquared = 0.0f;
+        for(int c = firstChannel; c < firstChannel + channelCount; c++)
+        {
+            lengthSquared += (e1[c] - e0[c]) * (e1[c] - e0[c]);
+        }
+        const float scale = lengthSquared > 1e-8f ? static_cast<float>(levels - 1) / lengthSquared : 0.0f;
+        const __m256 maxLevel = _mm256_set1_ps(static_cast<float>(levels - 1));
+
+        for(int half = 0; half < 2; half++)
+        {
+            __m256 t = _mm256_setzero_ps();
+            for(int c = firstChannel; c < firstChannel + channelCount; c++)
+            {
+                const __m256 texel = _mm256_load_ps(&block.channels[c][half * 8]);
+                const __m256 offset = _mm256_sub_ps(texel, _mm256_set1_ps(e0[c]));
+                t = _mm256_fmadd_ps(offset, _mm256_set1_ps((e1[c] - e0[c]) * scale), t);
+            }
+            t = _mm256_min_ps(_mm256_max_ps(t, _mm256_setzero_ps()), maxLevel);
+            const __m256i rounded = _mm256_cvtps_epi32(t);
+            // 8 x int32 -> 8 x uint8
+            const __m128i packed16 =
+                _mm_packs_epi32(_mm256_castsi256_si128(rounded), _mm256_extracti128_si256(rounded, 1));
+            const __m128i packed8 = _mm_packus_epi16(packed16, packed16);
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(indices + half * 8), packed8);
+        }
+    }
+
+    constexpr BlockKernels kernelsAVX2 = {.statistics = statisticsAVX2, .projectIndices = projectIndicesAVX2};
+} // namespace
+
+const BlockKernels* getBlockKernelsAVX2()
+{
+    return &kernelsAVX2;
+}
+
+#else
+
+const BlockKernels* getBlockKernelsAVX2()
+{
+    return nullptr;
+}
+
+#endif
@@ -0,0 +1,176 @@
+#include "CookedTexture.h"
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <limits>
+
+#include "BlockCompression.h"
+#include "Texture.h"
+
+namespace
+{
+    constexpr uint64_t levelAlignment = 16;
+
+    uint64_t alignUp(uint64_t value)
+    {
+        return (value + levelAlignment - 1) / levelAlignment * levelAlignment;
+    }
+
+    /* Bytes per texel glTextureSubImage2D reads for the pixel format and type, 0 if unknown */
+    size_t uploadTexelSize(GLenum dataFormat, GLenum dataType)
+    {
+        if(dataType == GL_UNSIGNED_INT_5_9_9_9_REV || dataType == GL_UNSIGNED_INT_10F_11F_11F_REV)
+        {
+            return dataFormat == GL_RGB ? 4 : 0;
+        }
+        size_t components = 0;
+        switch(dataFormat)
+        {
+        case GL_RED:
+            components = 1;
+            break;
+        case GL_RG:
+            components = 2;
+            break;
+        case GL_RGB:
+            components = 3;
+            break;
+        case GL_RGBA:
+            components = 4;
+            break;
+        default:
+            return 0;
+        }
+        switch(dataType)
+        {
+        case GL_UNSIGNED_BYTE:
+            return components;
+        case GL_HALF_FLOAT:
+        case GL_UNSIGNED_SHORT:
+            return components * 2;
+        case GL_FLOAT:
+            return components * 4;
+        default:
+            return 0;
+        }
+    }
+} // namespace
+
+CookedTexture::CookedTexture(const std::string& path) : file(path)
+{
+    if(!file.isOpen() || file.size() < sizeof(CookedTextureHeader))
+    {
+        std::cout << "Could not load cooked texture " << path << std::endl;
+        return;
+    }
+    header = reinterpret_cast<const CookedTextureHeader*>(file.data());
+    if(memcmp(header->magic, CookedTextureHeader::magicValue, sizeof(header->magic)) != 0 ||
+       header->version != CookedTextureHeader::currentVersion || header->levelCount == 0)
+    {
+        std::cout << "Invalid cooked texture header in " << path << std::endl;
+        return;
+    }
+    // levels are sized as ints for OpenGL and can not go past the full mip chain
+    constexpr auto maxExtent = static_cast<uint32_t>(std::numeric_limits<int>::max());
+    if(header->width == 0 || header->height == 0 || header->width > maxExtent || header->height > maxExtent ||
+       header->levelCount > static_cast<uint32_t>(std::bit_width(std::max(header->width, header->height))))
+    {
+        std::cout << "Invalid cooked texture size in " << path << std::endl;
+        return;
+    }
+    // compressed levels are uploaded with their size, all others are read as width * height texels of the
+    // data format and type
+    const bool compressed = isCompressedFormat(header->internalFormat);
+    if(compressed != (header->dataFormat == 0) ||
+       (!compressed && uploadTexelSize(header->dataFormat, header->dataType) !=
+                           textureLevelSize(header->internalFormat, 1, 1)))
+    {
+        std::cout << "Invalid cooked texture format in " << path << std::endl;
+        return;
+    }
+    const size_t indexEnd = sizeof(CookedTextureHeader) + header->levelCount * sizeof(CookedTextureLevel);
+    if(indexEnd > file.size())
+    {
+        std::cout << "Truncated cooked texture " << path << std::endl;
+        return;
+    }
+    levels = reinterpret_cast<const CookedTextureLevel*>(file.data() + sizeof(CookedTextureHeader));
+    for(uint32_t i = 0; i < header->levelCount; i++)
+    {
+        // the uploads read the full level, whatever the size in the index says
+        const int level = static_cast<int>(i);
+        const size_t expectedSize =
+            textureLevelSize(header->internalFormat, getLevelWidth(level), getLevelHeight(level));
+        if(levels[i].size != expectedSize)
+        {
+            std::cout << "Invalid size of level " << i << " in cooked texture " << path << std::endl;
+            return;
+        }
+        if(levels[i].size > file.size() || levels[i].offset > file.size() - levels[i].size)
+        {
+            std::cout << "Truncated cooked texture " << path << std::endl;
+            return;
+        }
+    }
+    isValid = true;
+}
+
+int CookedTexture::getLevelWidth(int level) const
+{
+    return std::max(static_cast<int>(header->width) >> level, 1);
+}
+
+int CookedTexture::getLevelHeight(int level) const
+{
+    return std::max(static_cast<int>(header->height) >> level, 1);
+}
+
+std::span<const uint8_t> CookedTexture::getLevelData(int level) const
+{
+    assert(level >= 0 && level < getLevelCount());
+    return file.bytes().subspan(levels[level].offset, levels[level].size);
+}
+
+bool writeCookedTexture(
+    const std::string& file, CookedTextureHeader header, std::span<const std::vector<uint8_t>> levels)
+{
+    memcpy(header.magic, CookedTextureHeader::magicValue, sizeof(header.magic));
+    header.version = CookedTextureHeader::currentVersion;
+    header.levelCount = static_cast<uint32_t>(levels.size());
+
+    std::vector<CookedTextureLevel> index(levels.size());
+    uint64_t offset = alignUp(sizeof(CookedTextureHeader) + levels.size() * sizeof(CookedTextureLevel));
+    for(size_t i = 0; i < levels.size(); i++)
+    {
+        index[i] = {.offset = offset, .size = levels[i].size()};
+        offset = alignUp(offset + levels[i].size());
+    }
+
+    std::ofstream out(file, std::ios::binary | std::ios::trunc);
+    if(!out.is_open())
+    {
+        std::cerr << "ERROR: Unable to open file " << file << std::endl;
+        return false;
+    }
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(index.data()), index.size() * sizeof(CookedTextureLevel));
+    constexpr static char padding[levelAlignment] = {}; // NOLINT
+    for(size_t i = 0; i < levels.size(); i++)
+    {
+        out.write(
+            padding,
+            static_cast<std::streamsize>(index[i].offset) - static_cast<std::streamsize>(out.tellp()));
+        out.write(reinterpret_cast<const char*>(levels[i].data()), levels[i].size());
+    }
+    return out.good();
+}
+
+bool isCookedTexturePath(const std::string& file)
+{
+    const std::string_view extension = CookedTexture::extension;
+    return file.size() >= extension.size() && file.ends_with(extension);
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <glad/glad/glad.h>
+
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+
+#include <intern/Misc/MappedFile.h>
+
+/*
+    Binary runtime texture format (loosely modeled after KTX2):
+
+    CookedTextureHeader
+    CookedTextureLevel[levelCount]     index of the mip levels, level 0 first
+    level data                         each level starts on a 16 byte boundary
+
+    Level data is stored exactly as OpenGL expects it (tightly packed rows, or compressed blocks),
+    so it can be passed to glTextureSubImage2D/glCompressedTextureSubImage2D straight from the mapping.
+*/
+
+struct CookedTextureHeader
+{
+    constexpr static char magicValue[8] = {'O', 'G', 'L', 'F', 'T', 'E', 'X', '\0'}; // NOLINT
+    constexpr static uint32_t currentVersion = 1;
+
+    char magic[8] = {}; // NOLINT
+    uint32_t version = currentVersion;
+    // GLenums, dataFormat and dataType are 0 for compressed formats
+    uint32_t internalFormat = 0;
+    uint32_t dataFormat = 0;
+    uint32_t dataType = 0;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t levelCount = 0;
+    uint32_t flags = 0;
+};
+static_assert(sizeof(CookedTextureHeader) == 40);
+
+struct CookedTextureLevel
+{
+    uint64_t offset = 0;
+    uint64_t size = 0;
+};
+
+/** Memory mapped view of a cooked texture file
+ */
+class CookedTexture
+{
+  public:
+    constexpr static const char* extension = ".ctex";
+
+    explicit CookedTexture(const std::string& file);
+
+    /* true if the file could be mapped and passed validation */
+    [[nodiscard]] inline bool valid() const
+    {
+        return isValid;
+    }
+
+    [[nodiscard]] inline const CookedTextureHeader& getHeader() const
+    {
+        return *header;
+    }
+
+    [[nodiscard]] inline bool isCompressed() const
+    {
+        return header->dataFormat == 0;
+    }
+
+    [[nodiscard]] inline int getLevelCount() const
+    {
+        return static_cast<int>(header->levelCount);
+    }
+
+    [[nodiscard]] int getLevelWidth(int level) const;
+    [[nodiscard]] int getLevelHeight(int level) const;
+    [[nodiscard]] std::span<const uint8_t> getLevelData(int level) const;
+
+  private:
+    MappedFile file;
+    const CookedTextureHeader* header = nullptr;
+    const CookedTextureLevel* levels = nullptr;
+    bool isValid = false;
+};
+
+/** Writes a cooked texture file.
+ * @param file Path of the file to write
+ * @param header Header describing the texture, magic, version and levelCount are filled in
+ * @param levels Data of each mip level, level 0 first
+ * @return false if the file could not be written
+ */
+bool writeCookedTexture(
+    const std::string& file, CookedTextureHeader header, std::span<const std::vector<uint8_t>> levels);
+
+/* true if the path ends in CookedTexture::extension */
+bool isCookedTexturePath(const std::string& file);
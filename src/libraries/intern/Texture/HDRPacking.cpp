@@ -0,0 +1,321 @@
+#include "HDRPacking.h"
+#include "HDRPackingKernels.h"
+#include "Image.h"
+#include "MipGenerator.h"
+
+#include <intern/Misc/CPUFeatures.h>
+#include <intern/Misc/ThreadPool.h>
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+
+#if INTERN_HAS_SSE2
+    #include <emmintrin.h>
+#endif
+
+namespace
+{
+    // largest values representable by the packed formats
+    constexpr float maxRGB9E5 = 65408.0f;
+    constexpr float maxFloat11 = 65024.0f;
+    constexpr float maxFloat10 = 64512.0f;
+    // smallest normal value of the 5 bit exponent formats (2^-14)
+    constexpr float minNormal = 6.103515625e-05f;
+
+    float clampPositive(float value, float maxValue)
+    {
+        // written this way round so NaN ends up as 0
+        return value > 0.0f ? std::min(value, maxValue) : 0.0f;
+    }
+
+    uint32_t packSmallFloat(float value, uint32_t mantissaBits, float maxValue)
+    {
+        value = clampPositive(value, maxValue);
+        if(value < minNormal)
+        {
+            // denormal, rounding up to 1 << mantissaBits correctly produces the smallest normal
+            return static_cast<uint32_t>(std::lrint(std::ldexp(value, static_cast<int>(14 + mantissaBits))));
+        }
+        // rebias the exponent from 127 to 15 and round the mantissa, carries propagate into the exponent
+        const uint32_t shift = 23 - mantissaBits;
+        const uint32_t bits = std::bit_cast<uint32_t>(value) - ((127u - 15u) << 23u);
+        return (bits + (1u << (shift - 1u))) >> shift;
+    }
+
+    void texelToRGB(const float* texel, int channels, float* rgb)
+    {
+        for(int c = 0; c < 3; c++)
+        {
+            rgb[c] = c < channels ? texel[c] : 0.0f;
+        }
+    }
+
+    void packRGB9E5Scalar(const float* texels, size_t texelCount, int channels, uint32_t* out)
+    {
+        for(size_t i = 0; i < texelCount; i++)
+        {
+            float rgb[3];
+            texelToRGB(texels + i * channels, channels, rgb);
+            out[i] = packRGB9E5Texel(rgb);
+        }
+    }
+
+    void packR11G11B10FScalar(const float* texels, size_t texelCount, int channels, uint32_t* out)
+    {
+        for(size_t i = 0; i < texelCount; i++)
+        {
+            float rgb[3];
+            texelToRGB(texels + i * channels, channels, rgb);
+            out[i] = packR11G11B10FTexel(rgb);
+        }
+    }
+
+#if INTERN_HAS_SSE2
+    __m128 loadChannel(const float* texels, int channels, int channel)
+    {
+        const float* t = texels + channel;
+        return _mm_setr_ps(t[0], t[channels], t[2 * channels], t[3 * channels]);
+    }
+
+    __m128 clampPositive(__m128 value, float maxValue)
+    {
+        // max returns the second operand for NaNs
+        return _mm_min_ps(_mm_max_ps(value, _mm_setzero_ps()), _mm_set1_ps(maxValue));
+    }
+
+    void packRGB9E5SSE2(const float* texels, size_t texelCount, int channels, uint32_t* out)
+    {
+        if(channels < 3)
+        {
+            packRGB9E5Scalar(texels, texelCount, channels, out);
+            return;
+        }
+        const size_t vectorCount = texelCount / 4 * 4;
+        for(size_t i = 0; i < vectorCount; i += 4)
+        {
+            const float* t = texels + i * channels;
+            const __m128 r = clampPositive(loadChannel(t, channels, 0), maxRGB9E5);
+            const __m128 g = clampPositive(loadChannel(t, channels, 1), maxRGB9E5);
+            const __m128 b = clampPositive(loadChannel(t, channels, 2), maxRGB9E5);
+            const __m128 maxChannel = _mm_max_ps(_mm_max_ps(r, g), b);
+
+            // shared exponent = max(-16, floor(log2(max))) + 16, taken straight from the float bits
+            __m128i exponent = _mm_sub_epi32(
+                _mm_srli_epi32(_mm_castps_si128(maxChannel), 23), _mm_set1_epi32(127));
+            const __m128i aboveMin = _mm_cmpgt_epi32(exponent, _mm_set1_epi32(-16));
+            exponent = _mm_or_si128(
+                _mm_and_si128(aboveMin, exponent), _mm_andnot_si128(aboveMin, _mm_set1_epi32(-16)));
+            exponent = _mm_add_epi32(exponent, _mm_set1_epi32(16));
+
+            // 2^(24 - exponent), build the float directly
+            __m128i scaleBits = _mm_slli_epi32(_mm_sub_epi32(_mm_set1_epi32(127 + 24), exponent), 23);
+            const __m128 half = _mm_set1_ps(0.5f);
+            const __m128i maxMantissa =
+                _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(maxChannel, _mm_castsi128_ps(scaleBits)), half));
+            // rounding up to 512 needs one more bit of exponent
+            const __m128i overflow = _mm_cmpeq_epi32(maxMantissa, _mm_set1_epi32(512));
+            exponent = _mm_sub_epi32(exponent, overflow);
+            scaleBits = _mm_sub_epi32(scaleBits, _mm_and_si128(overflow, _mm_set1_epi32(1 << 23)));
+            const __m128 scale = _mm_castsi128_ps(scaleBits);
+
+            const __m128i rm = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(r, scale), half));
+            const __m128i gm = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(g, scale), half));
+            const __m128i bm = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(b, scale), half));
+            __m128i packed = _mm_or_si128(rm, _mm_slli_epi32(gm, 9));
+            packed = _mm_or_si128(packed, _mm_slli_epi32(bm, 18));
+            packed = _mm_or_si128(packed, _mm_slli_epi32(exponent, 27));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), packed);
+        }
+        packRGB9E5Scalar(
+            texels + vectorCount * channels, texelCount - vectorCount, channels, out + vectorCount);
+    }
+
+    __m128i packSmallFloatSSE2(__m128 value, int mantissaBits, float maxValue)
+    {
+        value = clampPositive(value, maxValue);
+        const int shift = 23 - mantissaBits;
+        const __m128i normal = _mm_srli_epi32(
+            _mm_add_epi32(
+                _mm_sub_epi32(_mm_castps_si128(value), _mm_set1_epi32((127 - 15) << 23)),
+                _mm_set1_epi32(1 << (shift - 1))),
+            shift);
+        const __m128i denormal =
+            _mm_cvtps_epi32(_mm_mul_ps(value, _mm_set1_ps(std::ldexp(1.0f, 14 + mantissaBits))));
+        const __m128i isDenormal = _mm_castps_si128(_mm_cmplt_ps(value, _mm_set1_ps(minNormal)));
+        return _mm_or_si128(_mm_and_si128(isDenormal, denormal), _mm_andnot_si128(isDenormal, normal));
+    }
+
+    void packR11G11B10FSSE2(const float* texels, size_t texelCount, int channels, uint32_t* out)
+    {
+        if(channels < 3)
+        {
+            packR11G11B10FScalar(texels, texelCount, channels, out);
+            return;
+        }
+        const size_t vectorCount = texelCount / 4 * 4;
+        for(size_t i = 0; i < vectorCount; i += 4)
+        {
+            const float* t = texels + i * channels;
+            const __m128i r = packSmallFloatSSE2(loadChannel(t, channels, 0), 6, maxFloat11);
+            const __m128i g = packSmallFloatSSE2(loadChannel(t, channels, 1), 6, maxFloat11);
+            const __m128i b = packSmallFloatSSE2(loadChannel(t, channels, 2), 5, maxFloat10);
+            const __m128i packed =
+                _mm_or_si128(_mm_or_si128(r, _mm_slli_epi32(g, 11)), _mm_slli_epi32(b, 22));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), packed);
+        }
+        packR11G11B10FScalar(
+            texels + vectorCount * channels, texelCount - vectorCount, channels, out + vectorCount);
+    }
+
+    constexpr HDRPackingKernels kernelsDefault = {
+        .packRGB9E5 = packRGB9E5SSE2, .packR11G11B10F = packR11G11B10FSSE2};
+#else
+    constexpr HDRPackingKernels kernelsDefault = {
+        .packRGB9E5 = packRGB9E5Scalar, .packR11G11B10F = packR11G11B10FScalar};
+#endif
+
+    const HDRPackingKernels& selectKernels()
+    {
+        const CPUFeatures& features = getCPUFeatures();
+        const HDRPackingKernels* avx2 = getHDRPackingKernelsAVX2();
+        if(avx2 != nullptr && features.avx2 && features.fma)
+        {
+            return *avx2;
+        }
+        return kernelsDefault;
+    }
+
+    using PackFunction = void (*)(const float*, size_t, int, uint32_t*);
+    void packParallel(
+        PackFunction pack, const float* texels, size_t texelCount, int channels, uint32_t* out,
+        ThreadPool* pool)
+    {
+        parallelFor(
+            pool,
+            texelCount,
+            64 * 1024,
+            [&](size_t begin, size_t end)
+            { pack(texels + begin * channels, end - begin, channels, out + begin); });
+    }
+} // namespace
+
+uint32_t packRGB9E5Texel(const float* rgb)
+{
+    const float r = clampPositive(rgb[0], maxRGB9E5);
+    const float g = clampPositive(rgb[1], maxRGB9E5);
+    const float b = clampPositive(rgb[2], maxRGB9E5);
+    const float maxChannel = std::max({r, g, b});
+
+    // see EXT_texture_shared_exponent, exponent bias 15, 9 mantissa bits
+    int exponent = std::max(-16, static_cast<int>(std::bit_cast<uint32_t>(maxChannel) >> 23u) - 127) + 16;
+    float scale = std::ldexp(1.0f, 24 - exponent);
+    if(static_cast<uint32_t>(maxChannel * scale + 0.5f) == 512)
+    {
+        exponent++;
+        scale *= 0.5f;
+    }
+    const auto rm = static_cast<uint32_t>(r * scale + 0.5f);
+    const auto gm = static_cast<uint32_t>(g * scale + 0.5f);
+    const auto bm = static_cast<uint32_t>(b * scale + 0.5f);
+    return rm | (gm << 9u) | (bm << 18u) | (static_cast<uint32_t>(exponent) << 27u);
+}
+
+uint32_t packR11G11B10FTexel(const float* rgb)
+{
+    return packSmallFloat(rgb[0], 6, maxFloat11) | (packSmallFloat(rgb[1], 6, maxFloat11) << 11u) |
+           (packSmallFloat(rgb[2], 5, maxFloat10) << 22u);
+}
+
+GLenum hdrInternalFormat(HDRStorage storage, int channels)
+{
+    switch(storage)
+    {
+    case HDRStorage::RGB9E5:
+        return GL_RGB9_E5;
+    case HDRStorage::R11G11B10F:
+        return GL_R11F_G11F_B10F;
+    case HDRStorage::Float32:
+    {
+        constexpr static GLenum formats[4] = {GL_R32F, GL_RG32F, GL_RGB32F, GL_RGBA32F}; // NOLINT
+        return formats[std::clamp(channels, 1, 4) - 1];
+    }
+    }
+    return 0;
+}
+
+GLenum hdrDataFormat(HDRStorage storage, int channels)
+{
+    if(storage != HDRStorage::Float32)
+    {
+        return GL_RGB;
+    }
+    constexpr static GLenum formats[4] = {GL_RED, GL_RG, GL_RGB, GL_RGBA}; // NOLINT
+    return formats[std::clamp(channels, 1, 4) - 1];
+}
+
+GLenum hdrDataType(HDRStorage storage)
+{
+    switch(storage)
+    {
+    case HDRStorage::RGB9E5:
+        return GL_UNSIGNED_INT_5_9_9_9_REV;
+    case HDRStorage::R11G11B10F:
+        return GL_UNSIGNED_INT_10F_11F_11F_REV;
+    case HDRStorage::Float32:
+        return GL_FLOAT;
+    }
+    return 0;
+}
+
+void packRGB9E5(const float* texels, size_t texelCount, int channels, uint32_t* out, ThreadPool* pool)
+{
+    packParallel(selectKernels().packRGB9E5, texels, texelCount, channels, out, pool);
+}
+
+void packR11G11B10F(const float* texels, size_t texelCount, int channels, uint32_t* out, ThreadPool* pool)
+{
+    packParallel(selectKernels().packR11G11B10F, texels, texelCount, channels, out, pool);
+}
+
+std::vector<std::vector<uint8_t>>
+buildHDRLevels(const Image& image, HDRStorage storage, bool mipMap, ThreadPool* pool, MipFilter mipFilter)
+{
+    assert(image.valid() && image.isHdr);
+    const auto* texels = reinterpret_cast<const float*>(image.pixels.get());
+    std::vector<std::vector<float>> mips;
+    if(mipMap)
+    {
+        mips = generateMipChain(texels, image.width, image.height, image.channels, mipFilter, pool);
+    }
+    const int levelCount = mipMap ? static_cast<int>(mips.size()) : 1;
+
+    std::vector<std::vector<uint8_t>> levels(levelCount);
+    for(int level = 0; level < levelCount; level++)
+    {
+        const float* levelTexels = mipMap ? mips[level].data() : texels;
+        const size_t texelCount =
+            static_cast<size_t>(std::max(image.width >> level, 1)) * std::max(image.height >> level, 1);
+
+        std::vector<uint8_t>& data = levels[level];
+        if(storage == HDRStorage::Float32)
+        {
+            const auto* bytes = reinterpret_cast<const uint8_t*>(levelTexels);
+            data.assign(bytes, bytes + texelCount * image.channels * sizeof(float));
+            continue;
+        }
+        data.resize(texelCount * sizeof(uint32_t));
+        auto* packed = reinterpret_cast<uint32_t*>(data.data());
+        if(storage == HDRStorage::RGB9E5)
+        {
+            packRGB9E5(levelTexels, texelCount, image.channels, packed, pool);
+        }
+        else
+        {
+            packR11G11B10F(levelTexels, texelCount, image.channels, packed, pool);
+        }
+    }
+    return levels;
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <glad/glad/glad.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "MipGenerator.h"
+
+class ThreadPool;
+struct Image;
+
+/* How HDR images are stored on the GPU */
+enum struct HDRStorage
+{
+    RGB9E5,     // 4 bytes per texel, shared 5 bit exponent, 9 bit mantissa per channel
+    R11G11B10F, // 4 bytes per texel, unsigned 11/11/10 bit floats
+    Float32     // full precision, 12-16 bytes per texel
+};
+
+/* Internal format, data format and data type of the texel data produced for the storage */
+GLenum hdrInternalFormat(HDRStorage storage, int channels);
+GLenum hdrDataFormat(HDRStorage storage, int channels);
+GLenum hdrDataType(HDRStorage storage);
+
+/** Converts float texels into GL_UNSIGNED_INT_5_9_9_9_REV (GL_RGB9_E5) texels.
+ * Negative values and NaNs become 0, values above the max representable value are clamped.
+ * Only the first 3 of channels are read, missing ones are treated as 0.
+ * Runs SSE2 or AVX2 kernels (picked at runtime), split across the pool if one is given.
+ */
+void packRGB9E5(const float* texels, size_t texelCount, int channels, uint32_t* out, ThreadPool* pool = nullptr);
+
+/** Converts float texels into GL_UNSIGNED_INT_10F_11F_11F_REV (GL_R11F_G11F_B10F) texels.
+ * Same rules as packRGB9E5, rounds to nearest.
+ */
+void packR11G11B10F(
+    const float* texels, size_t texelCount, int channels, uint32_t* out, ThreadPool* pool = nullptr);
+
+/** Builds the texel data of all levels of an HDR image in the given storage, level 0 first.
+ * Mip levels are filtered from the float data before packing (see MipGenerator.h), since RGB9E5
+ * can not be rendered to (and so glGenerateTextureMipmap can not be used with it).
+ * @param image Decoded HDR image (isHdr)
+ * @param mipMap True to build the full mip chain, otherwise only level 0
+ * @param mipFilter Filter used for the mip levels
+ */
+std::vector<std::vector<uint8_t>> buildHDRLevels(
+    const Image& image, HDRStorage storage, bool mipMap, ThreadPool* pool = nullptr,
+    MipFilter mipFilter = MipFilter::Box);
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/*
+    Internal interface between the HDR packing functions and their SIMD kernels.
+    Not meant to be included outside of HDRPacking*.cpp
+*/
+
+struct HDRPackingKernels
+{
+    // both convert texelCount texels with a stride of channels floats, see HDRPacking.h
+    void (*packRGB9E5)(const float* texels, size_t texelCount, int channels, uint32_t* out);
+    void (*packR11G11B10F)(const float* texels, size_t texelCount, int channels, uint32_t* out);
+};
+
+/* Scalar reference conversion of a single texel, used for the tails of the SIMD loops */
+uint32_t packRGB9E5Texel(const float* rgb);
+uint32_t packR11G11B10FTexel(const float* rgb);
+
+/* returns nullptr if the library was built without AVX2 support */
+const HDRPackingKernels* getHDRPackingKernelsAVX2();
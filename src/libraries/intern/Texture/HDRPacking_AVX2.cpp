@@ -0,0 +1,143 @@
+#include "HDRPackingKernels.h"
+
+#ifdef __AVX2__
+
+    #include <cmath>
+    #include <immintrin.h>
+
+namespace
+{
+    constexpr float maxRGB9E5 = 65408.0f;
+    constexpr float maxFloat11 = 65024.0f;
+    constexpr float maxFloat10 = 64512.0f;
+    constexpr float minNormal = 6.103515625e-05f;
+
+    __m256 loadChannel(const float* texels, __m256i offsets, int channel)
+    {
+        return _mm256_i32gather_ps(texels + channel, offsets, 4);
+    }
+
+    __m256 clampPositive(__m256 value, float maxValue)
+    {
+        // max returns the second operand for NaNs
+        return _mm256_min_ps(_mm256_max_ps(value, _mm256_setzero_ps()), _mm256_set1_ps(maxValue));
+    }
+
+    void packTailRGB9E5(const float* texels, size_t texelCount, int channels, uint32_t* out)
+    {
+        for(size_t i = 0; i < texelCount; i++)
+        {
+            float rgb[3] = {0.0f, 0.0f, 0.0f};
+            for(int c = 0; c < channels && c < 3; c++)
+            {
+                rgb[c] = texels[i * channels + c];
+            }
+            out[i] = packRGB9E5Texel(rgb);
+        }
+    }
+
+    void packTailR11G11B10F(const float* texels, size_t texelCount, int channels, uint32_t* out)
+    {
+        for(size_t i = 0; i < texelCount; i++)
+        {
+            float rgb[3] = {0.0f, 0.0f, 0.0f};
+            for(int c = 0; c < channels && c < 3; c++)
+            {
+                rgb[c] = texels[i * channels + c];
+            }
+            out[i] = packR11G11B10FTexel(rgb);
+        }
+    }
+
+    void packRGB9E5AVX2(const float* texels, size_t texelCount, int channels, uint32_t* out)
+    {
+        const size_t vectorCount = channels < 3 ? 0 : texelCount / 8 * 8;
+        const __m256i offsets =
+            _mm256_mullo_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7), _mm256_set1_epi32(channels));
+        const __m256 half = _mm256_set1_ps(0.5f);
+        for(size_t i = 0; i < vectorCount; i += 8)
+        {
+            const float* t = texels + i * channels;
+            const __m256 r = clampPositive(loadChannel(t, offsets, 0), maxRGB9E5);
+            const __m256 g = clampPositive(loadChannel(t, offsets, 1), maxRGB9E5);
+            const __m256 b = clampPositive(loadChannel(t, offsets, 2), maxRGB9E5);
+            const __m256 maxChannel = _mm256_max_ps(_mm256_max_ps(r, g), b);
+
+            __m256i exponent = _mm256_sub_epi32(
+                _mm256_srli_epi32(_mm256_castps_si256(maxChannel), 23), _mm256_set1_epi32(127));
+            exponent =
+                _mm256_add_epi32(_mm256_max_epi32(exponent, _mm256_set1_epi32(-16)), _mm256_set1_epi32(16));
+
+            __m256i scaleBits =
+                _mm256_slli_epi32(_mm256_sub_epi32(_mm256_set1_epi32(127 + 24), exponent), 23);
+            const __m256i maxMantissa =
+                _mm256_cvttps_epi32(_mm256_fmadd_ps(maxChannel, _mm256_castsi256_ps(scaleBits), half));
+            const __m256i overflow = _mm256_cmpeq_epi32(maxMantissa, _mm256_set1_epi32(512));
+            exponent = _mm256_sub_epi32(exponent, overflow);
+            scaleBits = _mm256_sub_epi32(scaleBits, _mm256_and_si256(overflow, _mm256_set1_epi32(1 << 23)));
+            const __m256 scale = _mm256_castsi256_ps(scaleBits);
+
+            const __m256i rm = _mm256_cvttps_epi32(_mm256_fmadd_ps(r, scale, half));
+            const __m256i gm = _mm256_cvttps_epi32(_mm256_fmadd_ps(g, scale, half));
+            const __m256i bm = _mm256_cvttps_epi32(_mm256_fmadd_ps(b, scale, half));
+            __m256i packed = _mm256_or_si256(rm, _mm256_slli_epi32(gm, 9));
+            packed = _mm256_or_si256(packed, _mm256_slli_epi32(bm, 18));
+            packed = _mm256_or_si256(packed, _mm256_slli_epi32(exponent, 27));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), packed);
+        }
+        packTailRGB9E5(
+            texels + vectorCount * channels, texelCount - vectorCount, channels, out + vectorCount);
+    }
+
+    __m256i packSmallFloat(__m256 value, int mantissaBits, float maxValue)
+    {
+        value = clampPositive(value, maxValue);
+        const int shift = 23 - mantissaBits;
+        const __m256i normal = _mm256_srli_epi32(
+            _mm256_add_epi32(
+                _mm256_sub_epi32(_mm256_castps_si256(value), _mm256_set1_epi32((127 - 15) << 23)),
+                _mm256_set1_epi32(1 << (shift - 1))),
+            shift);
+        const __m256i denormal =
+            _mm256_cvtps_epi32(_mm256_mul_ps(value, _mm256_set1_ps(std::ldexp(1.0f, 14 + mantissaBits))));
+        const __m256 isDenormal = _mm256_cmp_ps(value, _mm256_set1_ps(minNormal), _CMP_LT_OQ);
+        return _mm256_castps_si256(
+            _mm256_blendv_ps(_mm256_castsi256_ps(normal), _mm256_castsi256_ps(denormal), isDenormal));
+    }
+
+    void packR11G11B10FAVX2(const float* texels, size_t texelCount, int channels, uint32_t* out)
+    {
+        const size_t vectorCount = channels < 3 ? 0 : texelCount / 8 * 8;
+        const __m256i offsets =
+            _mm256_mullo_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7), _mm256_set1_epi32(channels));
+        for(size_t i = 0; i < vectorCount; i += 8)
+        {
+            const float* t = texels + i * channels;
+            const __m256i r = packSmallFloat(loadChannel(t, offsets, 0), 6, maxFloat11);
+            const __m256i g = packSmallFloat(loadChannel(t, offsets, 1), 6, maxFloat11);
+            const __m256i b = packSmallFloat(loadChannel(t, offsets, 2), 5, maxFloat10);
+            const __m256i packed =
+                _mm256_or_si256(_mm256_or_si256(r, _mm256_slli_epi32(g, 11)), _mm256_slli_epi32(b, 22));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), packed);
+        }
+        packTailR11G11B10F(
+            texels + vectorCount * channels, texelCount - vectorCount, channels, out + vectorCount);
+    }
+
+    constexpr HDRPackingKernels kernelsAVX2 = {
+        .packRGB9E5 = packRGB9E5AVX2, .packR11G11B10F = packR11G11B10FAVX2};
+} // namespace
+
+const HDRPackingKernels* getHDRPackingKernelsAVX2()
+{
+    return &kernelsAVX2;
+}
+
+#else
+
+const HDRPackingKernels* getHDRPackingKernelsAVX2()
+{
+    return nullptr;
+}
+
+#endif
@@ -0,0 +1,64 @@
+#include "Image.h"
+
+#include <stb/stb_image.h>
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <iostream>
+
+void Image::Deleter::operator()(uint8_t* pixels) const
+{
+    stbi_image_free(pixels);
+}
+
+GLenum Image::internalFormat() const
+{
+    constexpr static GLenum ldrFormats[4] = {GL_R8, GL_RG8, GL_RGB8, GL_RGBA8};      // NOLINT
+    constexpr static GLenum hdrFormats[4] = {GL_R32F, GL_RG32F, GL_RGB32F, GL_RGBA32F}; // NOLINT
+    assert(channels >= 1 && channels <= 4);
+    return isHdr ? hdrFormats[channels - 1] : ldrFormats[channels - 1];
+}
+
+GLenum Image::dataFormat() const
+{
+    constexpr static GLenum formats[4] = {GL_RED, GL_RG, GL_RGB, GL_RGBA}; // NOLINT
+    assert(channels >= 1 && channels <= 4);
+    return formats[channels - 1];
+}
+
+GLenum Image::dataType() const
+{
+    return isHdr ? GL_FLOAT : GL_UNSIGNED_BYTE;
+}
+
+Image loadImage(const std::string& file, bool flipVertically)
+{
+    // the non _thread variant sets a process wide flag, which would race with other loading threads
+    stbi_set_flip_vertically_on_load_thread(static_cast<int>(flipVertically));
+
+    Image image;
+    image.isHdr = stbi_is_hdr(file.c_str()) != 0;
+    uint8_t* pixels = nullptr;
+    if(!image.isHdr)
+    {
+        pixels = stbi_load(file.c_str(), &image.width, &image.height, &image.channels, 0);
+    }
+    else
+    {
+        pixels = reinterpret_cast<uint8_t*>(
+            stbi_loadf(file.c_str(), &image.width, &image.height, &image.channels, 0));
+    }
+    image.pixels.reset(pixels);
+
+    if(!image.valid())
+    {
+        std::cout << "Could not load image " << file << ": " << stbi_failure_reason() << std::endl;
+    }
+    return image;
+}
+
+int fullMipChainLevels(int width, int height)
+{
+    return std::bit_width(static_cast<unsigned int>(std::max({width, height, 1})));
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <glad/glad/glad.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+/** Decoded image data in client memory, tightly packed (row alignment of 1).
+ * Can be created on any thread, does not touch OpenGL.
+ */
+struct Image
+{
+    struct Deleter
+    {
+        void operator()(uint8_t* pixels) const;
+    };
+
+    int width = 0;
+    int height = 0;
+    int channels = 0;
+    // true if pixels holds 32bit floats instead of 8bit unorm values
+    bool isHdr = false;
+    std::unique_ptr<uint8_t, Deleter> pixels;
+
+    [[nodiscard]] inline bool valid() const
+    {
+        return pixels != nullptr && width > 0 && height > 0 && channels > 0;
+    }
+
+    [[nodiscard]] inline size_t bytesPerPixel() const
+    {
+        return channels * (isHdr ? sizeof(float) : sizeof(uint8_t));
+    }
+
+    [[nodiscard]] inline size_t rowSize() const
+    {
+        return width * bytesPerPixel();
+    }
+
+    [[nodiscard]] inline size_t byteSize() const
+    {
+        return rowSize() * height;
+    }
+
+    /* Format enums matching the channel count and type, for use in TextureDesc */
+    [[nodiscard]] GLenum internalFormat() const;
+    [[nodiscard]] GLenum dataFormat() const;
+    [[nodiscard]] GLenum dataType() const;
+};
+
+/** Loads an image file through stb_image.
+ * Thread safe: the vertical flip is set per thread instead of through the global stb flag.
+ * @param file Path to the image file
+ * @param flipVertically Flip rows so the first row is the bottom one, as OpenGL expects
+ * @return The decoded image, check valid() for failure
+ */
+Image loadImage(const std::string& file, bool flipVertically = true);
+
+/** Number of mip levels of a full chain for the given size
+ */
+int fullMipChainLevels(int width, int height);
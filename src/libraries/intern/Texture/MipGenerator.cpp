@@ -0,0 +1,582 @@
+#include "MipGenerator.h"
+#include "Image.h"
+#include "MipGeneratorKernels.h"
+
+#include <intern/Misc/CPUFeatures.h>
+#include <intern/Misc/ThreadPool.h>
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <numbers>
+
+#if INTERN_HAS_SSE2
+    #include <emmintrin.h>
+#endif
+
+namespace
+{
+    // ------------------------------------------------------------ filter kernels
+
+    // kernel radius in destination texels
+    constexpr double windowedRadius = 3.0;
+    constexpr double kaiserAlpha = 4.0;
+
+    double sinc(double x)
+    {
+        if(std::abs(x) < 1e-6)
+        {
+            return 1.0;
+        }
+        x *= std::numbers::pi;
+        return std::sin(x) / x;
+    }
+
+    // modified bessel function of the first kind, std::cyl_bessel_i is not available everywhere
+    double besselI0(double x)
+    {
+        double sum = 1.0;
+        double term = 1.0;
+        for(int k = 1; k < 32; k++)
+        {
+            term *= (x / (2.0 * k)) * (x / (2.0 * k));
+            sum += term;
+        }
+        return sum;
+    }
+
+    // x in destination texels
+    double evaluateKernel(MipFilter filter, double x)
+    {
+        if(std::abs(x) >= windowedRadius)
+        {
+            return 0.0;
+        }
+        if(filter == MipFilter::Lanczos)
+        {
+            return sinc(x) * sinc(x / windowedRadius);
+        }
+        const double t = x / windowedRadius;
+        return sinc(x) * besselI0(kaiserAlpha * std::sqrt(1.0 - t * t)) / besselI0(kaiserAlpha);
+    }
+
+    /* Filter taps of one axis, every destination texel has the same amount of taps
+     * (shorter ones are padded with zero weights) so the kernels dont need per texel loop counts.
+     * Indices are already clamped to the source size.
+     */
+    struct AxisTaps
+    {
+        int taps = 0;
+        std::vector<int> indices;
+        std::vector<float> weights;
+    };
+
+    AxisTaps computeAxisTaps(int srcSize, int dstSize, MipFilter filter)
+    {
+        const double ratio = static_cast<double>(srcSize) / dstSize;
+        const double radius = filter == MipFilter::Box ? 0.5 * ratio : windowedRadius * ratio;
+
+        struct Tap
+        {
+            int index;
+            double weight;
+        };
+        std::vector<std::vector<Tap>> texelTaps(dstSize);
+        int maxTaps = 1;
+        for(int x = 0; x < dstSize; x++)
+        {
+            const double center = (x + 0.5) * ratio;
+            const int first = static_cast<int>(std::floor(center - radius));
+            const int last = static_cast<int>(std::ceil(center + radius));
+            double sum = 0.0;
+            std::vector<Tap>& taps = texelTaps[x];
+            for(int i = first; i <= last; i++)
+            {
+                double weight = 0.0;
+                if(filter == MipFilter::Box)
+                {
+                    // exact overlap of the source texel with the footprint of the destination texel
+                    const double overlap =
+                        std::min(center + radius, i + 1.0) - std::max(center - radius, 1.0 * i);
+                    weight = std::max(overlap, 0.0);
+                }
+                else
+                {
+                    weight = evaluateKernel(filter, (i + 0.5 - center) / ratio);
+                }
+                if(weight == 0.0 && taps.empty())
+                {
+                    continue;
+                }
+                taps.push_back({std::clamp(i, 0, srcSize - 1), weight});
+                sum += weight;
+            }
+            while(!taps.empty() && taps.back().weight == 0.0)
+            {
+                taps.pop_back();
+            }
+            for(Tap& tap : taps)
+            {
+                tap.weight /= sum;
+            }
+            maxTaps = std::max(maxTaps, static_cast<int>(taps.size()));
+        }
+
+        AxisTaps result;
+        result.taps = maxTaps;
+        result.indices.resize(static_cast<size_t>(dstSize) * maxTaps);
+        result.weights.resize(static_cast<size_t>(dstSize) * maxTaps, 0.0f);
+        for(int x = 0; x < dstSize; x++)
+        {
+            const std::vector<Tap>& taps = texelTaps[x];
+            for(int t = 0; t < maxTaps; t++)
+            {
+                const bool valid = t < static_cast<int>(taps.size());
+                result.indices[x * maxTaps + t] = valid ? taps[t].index : taps.back().index;
+                result.weights[x * maxTaps + t] = valid ? static_cast<float>(taps[t].weight) : 0.0f;
+            }
+        }
+        return result;
+    }
+
+    // ------------------------------------------------------------ sRGB conversion
+
+    double srgbToLinear(double value)
+    {
+        return value <= 0.04045 ? value / 12.92 : std::pow((value + 0.055) / 1.055, 2.4);
+    }
+
+    double linearToSrgb(double value)
+    {
+        return value <= 0.0031308 ? value * 12.92 : 1.055 * std::pow(value, 1.0 / 2.4) - 0.055;
+    }
+
+    struct DecodeTables
+    {
+        std::array<float, 256> linear;
+        std::array<float, 256> srgb;
+    };
+
+    const DecodeTables& getDecodeTables()
+    {
+        static const DecodeTables tables = []()
+        {
+            DecodeTables result{};
+            for(int i = 0; i < 256; i++)
+            {
+                result.linear[i] = static_cast<float>(i / 255.0);
+                result.srgb[i] = static_cast<float>(srgbToLinear(i / 255.0));
+            }
+            return result;
+        }();
+        return tables;
+    }
+
+    /* Linear float -> 8 bit sRGB without calling pow for every value:
+     * Values in [2^-13, 1) are split into buckets by their exponent and top 4 mantissa bits,
+     * within each bucket the curve is interpolated linearly (error well below half a step).
+     * Everything below 2^-13 rounds to 0 anyway.
+     */
+    struct SrgbEncodeTable
+    {
+        constexpr static uint32_t minBits = (127u - 13u) << 23u; // 2^-13
+        constexpr static uint32_t maxBits = 0x3F7FFFFFu;         // largest float below 1
+        constexpr static uint32_t bucketShift = 23u - 4u;
+        constexpr static int bucketCount = 13 * 16;
+        std::array<float, bucketCount> start;
+        std::array<float, bucketCount> slope;
+    };
+
+    const SrgbEncodeTable& getSrgbEncodeTable()
+    {
+        static const SrgbEncodeTable table = []()
+        {
+            SrgbEncodeTable result{};
+            for(int i = 0; i < SrgbEncodeTable::bucketCount; i++)
+            {
+                const uint32_t bucketBits = SrgbEncodeTable::minBits + (static_cast<uint32_t>(i) << 19u);
+                const double begin = std::bit_cast<float>(bucketBits);
+                const double end = std::bit_cast<float>(bucketBits + (1u << 19u));
+                const double srgbBegin = 255.0 * linearToSrgb(begin);
+                const double srgbEnd = 255.0 * linearToSrgb(end);
+                // +0.5 so the conversion to int rounds
+                result.start[i] = static_cast<float>(srgbBegin + 0.5);
+                result.slope[i] = static_cast<float>((srgbEnd - srgbBegin) / (1u << 19u));
+            }
+            return result;
+        }();
+        return table;
+    }
+
+    uint8_t encodeSrgb8(const SrgbEncodeTable& table, float value)
+    {
+        // written this way round so NaN ends up as 0
+        if(!(value > std::bit_cast<float>(SrgbEncodeTable::minBits)))
+        {
+            return 0;
+        }
+        const uint32_t bits = std::min(std::bit_cast<uint32_t>(value), SrgbEncodeTable::maxBits);
+        const uint32_t offset = bits - SrgbEncodeTable::minBits;
+        const uint32_t bucket = offset >> SrgbEncodeTable::bucketShift;
+        const auto fraction = static_cast<float>(offset & ((1u << SrgbEncodeTable::bucketShift) - 1u));
+        return static_cast<uint8_t>(table.start[bucket] + table.slope[bucket] * fraction);
+    }
+
+    // color channels are the first 3, a 4th one is alpha
+    int srgbChannels(int channels)
+    {
+        return std::min(channels, 3);
+    }
+
+    void decodeRows(const uint8_t* in, size_t texelCount, int channels, bool srgb, float* out)
+    {
+        const DecodeTables& tables = getDecodeTables();
+        if(!srgb)
+        {
+            for(size_t i = 0; i < texelCount * channels; i++)
+            {
+                out[i] = tables.linear[in[i]];
+            }
+            return;
+        }
+        const int colorChannels = srgbChannels(channels);
+        for(size_t i = 0; i < texelCount; i++)
+        {
+            for(int c = 0; c < channels; c++)
+            {
+                const uint8_t value = in[i * channels + c];
+                out[i * channels + c] = c < colorChannels ? tables.srgb[value] : tables.linear[value];
+            }
+        }
+    }
+
+    uint8_t toUnorm8(float value)
+    {
+        // written this way round so NaN ends up as 0
+        value = value > 0.0f ? std::min(value, 1.0f) : 0.0f;
+        return static_cast<uint8_t>(value * 255.0f + 0.5f);
+    }
+
+    void encodeRows(
+        const MipKernels& kernels, const float* in, size_t texelCount, int channels, bool srgb, uint8_t* out)
+    {
+        if(!srgb)
+        {
+            kernels.encodeUnorm8(in, texelCount * channels, out);
+            return;
+        }
+        const SrgbEncodeTable& table = getSrgbEncodeTable();
+        const int colorChannels = srgbChannels(channels);
+        for(size_t i = 0; i < texelCount; i++)
+        {
+            for(int c = 0; c < channels; c++)
+            {
+                const float value = in[i * channels + c];
+                out[i * channels + c] = c < colorChannels ? encodeSrgb8(table, value) : toUnorm8(value);
+            }
+        }
+    }
+
+    // ------------------------------------------------------------ kernels
+
+#if INTERN_HAS_SSE2
+    void weightedRowSumSSE2(
+        const float* const* rows, const float* weights, int taps, size_t count, float* out)
+    {
+        size_t i = 0;
+        for(; i + 4 <= count; i += 4)
+        {
+            __m128 sum = _mm_mul_ps(_mm_set1_ps(weights[0]), _mm_loadu_ps(rows[0] + i));
+            for(int t = 1; t < taps; t++)
+            {
+                sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(weights[t]), _mm_loadu_ps(rows[t] + i)));
+            }
+            _mm_storeu_ps(out + i, sum);
+        }
+        for(; i < count; i++)
+        {
+            float sum = 0.0f;
+            for(int t = 0; t < taps; t++)
+            {
+                sum += weights[t] * rows[t][i];
+            }
+            out[i] = sum;
+        }
+    }
+
+    void filterRowSSE2(
+        const float* row, int channels, const int* indices, const float* weights, int taps, int dstWidth,
+        float* out)
+    {
+        if(channels != 4)
+        {
+            filterRowScalar(row, channels, indices, weights, taps, dstWidth, out);
+            return;
+        }
+        // one rgba texel per register
+        for(int x = 0; x < dstWidth; x++)
+        {
+            const int* texelIndices = indices + static_cast<ptrdiff_t>(x) * taps;
+            const float* texelWeights = weights + static_cast<ptrdiff_t>(x) * taps;
+            __m128 sum = _mm_setzero_ps();
+            for(int t = 0; t < taps; t++)
+            {
+                sum = _mm_add_ps(
+                    sum, _mm_mul_ps(_mm_set1_ps(texelWeights[t]), _mm_loadu_ps(row + texelIndices[t] * 4)));
+            }
+            _mm_storeu_ps(out + x * 4, sum);
+        }
+    }
+
+    void encodeUnorm8SSE2(const float* in, size_t count, uint8_t* out)
+    {
+        const __m128 scale = _mm_set1_ps(255.0f);
+        const __m128 half = _mm_set1_ps(0.5f);
+        size_t i = 0;
+        for(; i + 16 <= count; i += 16)
+        {
+            __m128i values[4];
+            for(int v = 0; v < 4; v++)
+            {
+                // max returns the second operand for NaNs
+                const __m128 clamped =
+                    _mm_min_ps(_mm_max_ps(_mm_loadu_ps(in + i + v * 4), _mm_setzero_ps()), _mm_set1_ps(1.0f));
+                values[v] = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(clamped, scale), half));
+            }
+            const __m128i packed = _mm_packus_epi16(
+                _mm_packs_epi32(values[0], values[1]), _mm_packs_epi32(values[2], values[3]));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), packed);
+        }
+        for(; i < count; i++)
+        {
+            out[i] = toUnorm8(in[i]);
+        }
+    }
+
+    constexpr MipKernels kernelsDefault = {
+        .weightedRowSum = weightedRowSumSSE2, .filterRow = filterRowSSE2, .encodeUnorm8 = encodeUnorm8SSE2};
+#else
+    void weightedRowSumScalar(
+        const float* const* rows, const float* weights, int taps, size_t count, float* out)
+    {
+        for(size_t i = 0; i < count; i++)
+        {
+            float sum = 0.0f;
+            for(int t = 0; t < taps; t++)
+            {
+                sum += weights[t] * rows[t][i];
+            }
+            out[i] = sum;
+        }
+    }
+
+    void encodeUnorm8Scalar(const float* in, size_t count, uint8_t* out)
+    {
+        for(size_t i = 0; i < count; i++)
+        {
+            out[i] = toUnorm8(in[i]);
+        }
+    }
+
+    constexpr MipKernels kernelsDefault = {
+        .weightedRowSum = weightedRowSumScalar,
+        .filterRow = filterRowScalar,
+        .encodeUnorm8 = encodeUnorm8Scalar};
+#endif
+
+    const MipKernels& selectKernels()
+    {
+        const CPUFeatures& features = getCPUFeatures();
+        const MipKernels* avx2 = getMipKernelsAVX2();
+        if(avx2 != nullptr && features.avx2 && features.fma)
+        {
+            return *avx2;
+        }
+        return kernelsDefault;
+    }
+
+    // ------------------------------------------------------------ level filtering
+
+    struct LevelFilter
+    {
+        int srcWidth;
+        int srcHeight;
+        int dstWidth;
+        int dstHeight;
+        int channels;
+        AxisTaps x;
+        AxisTaps y;
+
+        LevelFilter(int srcWidth, int srcHeight, int channels, MipFilter filter)
+            : srcWidth(srcWidth), srcHeight(srcHeight), dstWidth(std::max(srcWidth / 2, 1)),
+              dstHeight(std::max(srcHeight / 2, 1)), channels(channels),
+              x(computeAxisTaps(srcWidth, dstWidth, filter)), y(computeAxisTaps(srcHeight, dstHeight, filter))
+        {
+        }
+
+        [[nodiscard]] size_t srcRowFloats() const
+        {
+            return static_cast<size_t>(srcWidth) * channels;
+        }
+
+        [[nodiscard]] size_t dstRowFloats() const
+        {
+            return static_cast<size_t>(dstWidth) * channels;
+        }
+
+        // source rows read by the destination rows [begin, end)
+        [[nodiscard]] std::pair<int, int> sourceRows(size_t begin, size_t end) const
+        {
+            const auto first = y.indices.begin() + static_cast<ptrdiff_t>(begin * y.taps);
+            const auto last = y.indices.begin() + static_cast<ptrdiff_t>(end * y.taps);
+            const auto [minRow, maxRow] = std::minmax_element(first, last);
+            return {*minRow, *maxRow + 1};
+        }
+
+        /** Filters the destination rows [begin, end): vertical pass first into rowBuffer
+         * (contiguous rows, cheap to vectorize), then the horizontal pass of that single row
+         * @param source Source rows, starting at row sourceFirstRow
+         */
+        void filterRows(
+            const MipKernels& kernels, const float* source, int sourceFirstRow, size_t begin, size_t end,
+            float* dst, float* rowBuffer) const
+        {
+            std::vector<const float*> rows(y.taps);
+            for(size_t row = begin; row < end; row++)
+            {
+                for(int t = 0; t < y.taps; t++)
+                {
+                    rows[t] = source + (y.indices[row * y.taps + t] - sourceFirstRow) * srcRowFloats();
+                }
+                kernels.weightedRowSum(
+                    rows.data(), &y.weights[row * y.taps], y.taps, srcRowFloats(), rowBuffer);
+                kernels.filterRow(
+                    rowBuffer, channels, x.indices.data(), x.weights.data(), x.taps, dstWidth,
+                    dst + (row - begin) * dstRowFloats());
+            }
+        }
+    };
+
+    // a few ten thousand texels per tile keeps the scheduling overhead negligible
+    size_t rowsPerTile(int width)
+    {
+        return std::max<size_t>(64 * 1024 / width, 4);
+    }
+} // namespace
+
+void filterRowScalar(
+    const float* row, int channels, const int* indices, const float* weights, int taps, int dstWidth,
+    float* out)
+{
+    for(int x = 0; x < dstWidth; x++)
+    {
+        const int* texelIndices = indices + static_cast<ptrdiff_t>(x) * taps;
+        const float* texelWeights = weights + static_cast<ptrdiff_t>(x) * taps;
+        for(int c = 0; c < channels; c++)
+        {
+            float sum = 0.0f;
+            for(int t = 0; t < taps; t++)
+            {
+                sum += texelWeights[t] * row[texelIndices[t] * channels + c];
+            }
+            out[x * channels + c] = sum;
+        }
+    }
+}
+
+std::vector<std::vector<uint8_t>> generateMipChain(
+    const uint8_t* pixels, int width, int height, int channels, const MipSettings& settings, ThreadPool* pool)
+{
+    assert(pixels != nullptr && width > 0 && height > 0 && channels > 0 && channels <= 4);
+    const MipKernels& kernels = selectKernels();
+    const int levelCount = fullMipChainLevels(width, height);
+
+    std::vector<std::vector<uint8_t>> levels(levelCount);
+    levels[0].assign(pixels, pixels + static_cast<size_t>(width) * height * channels);
+
+    // linear float data of the previous level, level 0 is decoded per tile instead of all at once
+    std::vector<float> previous;
+    for(int level = 1; level < levelCount; level++)
+    {
+        const LevelFilter filter{
+            std::max(width >> (level - 1), 1), std::max(height >> (level - 1), 1), channels, settings.filter};
+        std::vector<float> current(filter.dstRowFloats() * filter.dstHeight);
+        levels[level].resize(current.size());
+
+        parallelFor(
+            pool,
+            filter.dstHeight,
+            rowsPerTile(filter.dstWidth),
+            [&](size_t begin, size_t end)
+            {
+                std::vector<float> rowBuffer(filter.srcRowFloats());
+                std::vector<float> decoded;
+                const float* source = previous.data();
+                int sourceFirstRow = 0;
+                if(level == 1)
+                {
+                    const auto [firstRow, endRow] = filter.sourceRows(begin, end);
+                    decoded.resize((endRow - firstRow) * filter.srcRowFloats());
+                    decodeRows(
+                        pixels + firstRow * filter.srcRowFloats(),
+                        static_cast<size_t>(endRow - firstRow) * filter.srcWidth,
+                        channels,
+                        settings.srgb,
+                        decoded.data());
+                    source = decoded.data();
+                    sourceFirstRow = firstRow;
+                }
+                float* dst = current.data() + begin * filter.dstRowFloats();
+                filter.filterRows(kernels, source, sourceFirstRow, begin, end, dst, rowBuffer.data());
+                encodeRows(
+                    kernels,
+                    dst,
+                    (end - begin) * filter.dstWidth,
+                    channels,
+                    settings.srgb,
+                    levels[level].data() + begin * filter.dstRowFloats());
+            });
+        previous = std::move(current);
+    }
+    return levels;
+}
+
+std::vector<std::vector<float>> generateMipChain(
+    const float* texels, int width, int height, int channels, MipFilter filter, ThreadPool* pool)
+{
+    assert(texels != nullptr && width > 0 && height > 0 && channels > 0 && channels <= 4);
+    const MipKernels& kernels = selectKernels();
+    const int levelCount = fullMipChainLevels(width, height);
+
+    std::vector<std::vector<float>> levels(levelCount);
+    levels[0].assign(texels, texels + static_cast<size_t>(width) * height * channels);
+    for(int level = 1; level < levelCount; level++)
+    {
+        const LevelFilter levelFilter{
+            std::max(width >> (level - 1), 1), std::max(height >> (level - 1), 1), channels, filter};
+        const std::vector<float>& source = levels[level - 1];
+        std::vector<float>& current = levels[level];
+        current.resize(levelFilter.dstRowFloats() * levelFilter.dstHeight);
+
+        parallelFor(
+            pool,
+            levelFilter.dstHeight,
+            rowsPerTile(levelFilter.dstWidth),
+            [&](size_t begin, size_t end)
+            {
+                std::vector<float> rowBuffer(levelFilter.srcRowFloats());
+                levelFilter.filterRows(
+                    kernels,
+                    source.data(),
+                    0,
+                    begin,
+                    end,
+                    current.data() + begin * levelFilter.dstRowFloats(),
+                    rowBuffer.data());
+            });
+    }
+    return levels;
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class ThreadPool;
+
+enum struct MipFilter
+{
+    Box,    // area average, 2x2 texels for power of two sizes
+    Kaiser, // Kaiser windowed sinc (width 3, alpha 4), sharper than box with little ringing
+    Lanczos // Lanczos 3, sharpest, can ring around hard edges
+};
+
+struct MipSettings
+{
+    MipFilter filter = MipFilter::Box;
+    // treat the color channels as sRGB encoded and filter them in linear space, alpha is always linear
+    bool srgb = false;
+};
+
+/** Generates the full mip chain of an 8 bit image on the CPU, as a replacement for glGenerateTextureMipmap
+ * with filtering that does not depend on the driver.
+ * Every level is filtered from the previous one, which is kept in linear float precision.
+ * Levels are rounded down (like OpenGL does) and filtered with the exact ratio between
+ * the sizes, so odd sizes do not shift the image. Edges are clamped.
+ * Each level is split into row tiles that are filtered on the pool, if one is given.
+ * @param pixels Tightly packed texels with channels 8 bit values each
+ * @return All levels tightly packed, level 0 first (a copy of pixels).
+ *         Can be passed to TextureDesc::levelData as is
+ */
+std::vector<std::vector<uint8_t>> generateMipChain(
+    const uint8_t* pixels, int width, int height, int channels, const MipSettings& settings = {},
+    ThreadPool* pool = nullptr);
+
+/** Same as above for 32 bit float images (eg. HDR images), which are always filtered as is
+ */
+std::vector<std::vector<float>> generateMipChain(
+    const float* texels, int width, int height, int channels, MipFilter filter = MipFilter::Box,
+    ThreadPool* pool = nullptr);
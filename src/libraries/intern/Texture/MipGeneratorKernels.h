@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/*
+    Internal interface between the mip generator and its SIMD kernels.
+    Not meant to be included outside of MipGenerator*.cpp
+*/
+
+struct MipKernels
+{
+    // out[i] = sum of weights[t] * rows[t][i] over all taps, for i < count
+    void (*weightedRowSum)(
+        const float* const* rows, const float* weights, int taps, size_t count, float* out);
+
+    /** Horizontal filter of one row with texels of channels floats.
+     * Texel x of out is the sum of weights[x * taps + t] * row texel indices[x * taps + t] over all taps
+     */
+    void (*filterRow)(
+        const float* row, int channels, const int* indices, const float* weights, int taps, int dstWidth,
+        float* out);
+
+    // clamps to [0,1] and rounds to 8 bit unorm
+    void (*encodeUnorm8)(const float* in, size_t count, uint8_t* out);
+};
+
+/* Scalar version of filterRow, used by the SIMD kernels for channel counts they do not handle */
+void filterRowScalar(
+    const float* row, int channels, const int* indices, const float* weights, int taps, int dstWidth,
+    float* out);
+
+/* returns nullptr if the library was built without AVX2 support */
+const MipKernels* getMipKernelsAVX2();
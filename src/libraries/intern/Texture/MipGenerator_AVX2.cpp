@@ -0,0 +1,122 @@
+#include "MipGeneratorKernels.h"
+
+#ifdef __AVX2__
+
+    #include <immintrin.h>
+
+namespace
+{
+    void weightedRowSumAVX2(
+        const float* const* rows, const float* weights, int taps, size_t count, float* out)
+    {
+        size_t i = 0;
+        for(; i + 8 <= count; i += 8)
+        {
+            __m256 sum = _mm256_mul_ps(_mm256_set1_ps(weights[0]), _mm256_loadu_ps(rows[0] + i));
+            for(int t = 1; t < taps; t++)
+            {
+                sum = _mm256_fmadd_ps(_mm256_set1_ps(weights[t]), _mm256_loadu_ps(rows[t] + i), sum);
+            }
+            _mm256_storeu_ps(out + i, sum);
+        }
+        for(; i < count; i++)
+        {
+            float sum = 0.0f;
+            for(int t = 0; t < taps; t++)
+            {
+                sum += weights[t] * rows[t][i];
+            }
+            out[i] = sum;
+        }
+    }
+
+    void filterRowAVX2(
+        const float* row, int channels, const int* indices, const float* weights, int taps, int dstWidth,
+        float* out)
+    {
+        if(channels != 4)
+        {
+            filterRowScalar(row, channels, indices, weights, taps, dstWidth, out);
+            return;
+        }
+        // two rgba texels per register
+        int x = 0;
+        for(; x + 2 <= dstWidth; x += 2)
+        {
+            const int* indices0 = indices + static_cast<ptrdiff_t>(x) * taps;
+            const int* indices1 = indices0 + taps;
+            const float* weights0 = weights + static_cast<ptrdiff_t>(x) * taps;
+            const float* weights1 = weights0 + taps;
+            __m256 sum = _mm256_setzero_ps();
+            for(int t = 0; t < taps; t++)
+            {
+                const __m256 texels = _mm256_insertf128_ps(
+                    _mm256_castps128_ps256(_mm_loadu_ps(row + indices0[t] * 4)),
+                    _mm_loadu_ps(row + indices1[t] * 4),
+                    1);
+                const __m256 weight = _mm256_insertf128_ps(
+                    _mm256_castps128_ps256(_mm_set1_ps(weights0[t])), _mm_set1_ps(weights1[t]), 1);
+                sum = _mm256_fmadd_ps(weight, texels, sum);
+            }
+            _mm256_storeu_ps(out + x * 4, sum);
+        }
+        if(x < dstWidth)
+        {
+            filterRowScalar(
+                row,
+                channels,
+                indices + static_cast<ptrdiff_t>(x) * taps,
+                weights + static_cast<ptrdiff_t>(x) * taps,
+                taps,
+                dstWidth - x,
+                out + x * 4);
+        }
+    }
+
+    void encodeUnorm8AVX2(const float* in, size_t count, uint8_t* out)
+    {
+        const __m256 scale = _mm256_set1_ps(255.0f);
+        const __m256 half = _mm256_set1_ps(0.5f);
+        size_t i = 0;
+        for(; i + 16 <= count; i += 16)
+        {
+            __m256i values[2];
+            for(int v = 0; v < 2; v++)
+            {
+                // max returns the second operand for NaNs
+                const __m256 value = _mm256_loadu_ps(in + i + v * 8);
+                const __m256 clamped =
+                    _mm256_min_ps(_mm256_max_ps(value, _mm256_setzero_ps()), _mm256_set1_ps(1.0f));
+                values[v] = _mm256_cvttps_epi32(_mm256_fmadd_ps(clamped, scale, half));
+            }
+            // packs work per 128 bit lane, the groups of 4 bytes end up in the order 0 2 1 3
+            const __m256i packed16 = _mm256_packs_epi32(values[0], values[1]);
+            const __m128i packed8 =
+                _mm_packus_epi16(_mm256_castsi256_si128(packed16), _mm256_extracti128_si256(packed16, 1));
+            _mm_storeu_si128(
+                reinterpret_cast<__m128i*>(out + i), _mm_shuffle_epi32(packed8, _MM_SHUFFLE(3, 1, 2, 0)));
+        }
+        for(; i < count; i++)
+        {
+            const float value = in[i] > 0.0f ? (in[i] < 1.0f ? in[i] : 1.0f) : 0.0f;
+            out[i] = static_cast<uint8_t>(value * 255.0f + 0.5f);
+        }
+    }
+
+    constexpr MipKernels kernelsAVX2 = {
+        .weightedRowSum = weightedRowSumAVX2, .filterRow = filterRowAVX2, .encodeUnorm8 = encodeUnorm8AVX2};
+} // namespace
+
+const MipKernels* getMipKernelsAVX2()
+{
+    return &kernelsAVX2;
+}
+
+#else
+
+const MipKernels* getMipKernelsAVX2()
+{
+    return nullptr;
+}
+
+#endif
@@ -0,0 +1,116 @@
+#include "SamplerCache.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+
+#include <intern/Misc/Hash.h>
+
+namespace
+{
+    // core in 4.6 (and available as extension almost everywhere), but glad is generated for 4.5
+    constexpr GLenum textureMaxAnisotropy = 0x84FE;
+    constexpr GLenum maxTextureMaxAnisotropy = 0x84FF;
+
+    bool anisotropySupported()
+    {
+        GLint extensionCount = 0;
+        glGetIntegerv(GL_NUM_EXTENSIONS, &extensionCount);
+        for(GLint i = 0; i < extensionCount; i++)
+        {
+            const auto* name = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i));
+            if(name != nullptr && (strcmp(name, "GL_ARB_texture_filter_anisotropic") == 0 ||
+                                   strcmp(name, "GL_EXT_texture_filter_anisotropic") == 0))
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+} // namespace
+
+size_t SamplerCache::DescHash::operator()(const SamplerDesc& desc) const
+{
+    size_t hash = 0;
+    // + 0.0f turns -0 into 0, they compare equal so they have to hash the same
+    for(const uint32_t value :
+        {static_cast<uint32_t>(desc.minFilter),
+         static_cast<uint32_t>(desc.magFilter),
+         static_cast<uint32_t>(desc.wrapS),
+         static_cast<uint32_t>(desc.wrapT),
+         static_cast<uint32_t>(desc.wrapR),
+         std::bit_cast<uint32_t>(desc.maxAnisotropy + 0.0f),
+         std::bit_cast<uint32_t>(desc.lodBias + 0.0f),
+         static_cast<uint32_t>(desc.compareFunc)})
+    {
+        hashCombine(hash, value);
+    }
+    return hash;
+}
+
+SamplerCache::SamplerCache()
+{
+    if(anisotropySupported())
+    {
+        glGetFloatv(maxTextureMaxAnisotropy, &maxSupportedAnisotropy);
+    }
+}
+
+SamplerCache::~SamplerCache()
+{
+    for(const auto& [desc, sampler] : samplers)
+    {
+        glDeleteSamplers(1, &sampler);
+    }
+}
+
+GLuint SamplerCache::get(const SamplerDesc& desc)
+{
+    const auto it = samplers.find(desc);
+    if(it != samplers.end())
+    {
+        return it->second;
+    }
+
+    GLuint sampler = 0;
+    glCreateSamplers(1, &sampler);
+    glSamplerParameteri(sampler, GL_TEXTURE_MIN_FILTER, desc.minFilter);
+    glSamplerParameteri(sampler, GL_TEXTURE_MAG_FILTER, desc.magFilter);
+    glSamplerParameteri(sampler, GL_TEXTURE_WRAP_S, desc.wrapS);
+    glSamplerParameteri(sampler, GL_TEXTURE_WRAP_T, desc.wrapT);
+    glSamplerParameteri(sampler, GL_TEXTURE_WRAP_R, desc.wrapR);
+    glSamplerParameterf(sampler, GL_TEXTURE_LOD_BIAS, desc.lodBias);
+    if(maxSupportedAnisotropy > 1.0f)
+    {
+        glSamplerParameterf(
+            sampler, textureMaxAnisotropy, std::clamp(desc.maxAnisotropy, 1.0f, maxSupportedAnisotropy));
+    }
+    if(desc.compareFunc != GL_NONE)
+    {
+        glSamplerParameteri(sampler, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+        glSamplerParameteri(sampler, GL_TEXTURE_COMPARE_FUNC, static_cast<GLint>(desc.compareFunc));
+    }
+    samplers.emplace(desc, sampler);
+    return sampler;
+}
+
+void SamplerCache::bind(GLuint unit, const SamplerDesc& desc)
+{
+    glBindSampler(unit, get(desc));
+}
+
+void SamplerCache::bind(GLuint firstUnit, std::span<const SamplerDesc> descs)
+{
+    bindScratch.clear();
+    for(const SamplerDesc& desc : descs)
+    {
+        bindScratch.push_back(get(desc));
+    }
+    glBindSamplers(firstUnit, static_cast<GLsizei>(bindScratch.size()), bindScratch.data());
+}
+
+void SamplerCache::unbind(GLuint firstUnit, GLsizei count)
+{
+    glBindSamplers(firstUnit, count, nullptr);
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <glad/glad/glad.h>
+
+#include <cstddef>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+struct SamplerDesc
+{
+    GLint minFilter = GL_LINEAR_MIPMAP_LINEAR;
+    GLint magFilter = GL_LINEAR;
+    GLint wrapS = GL_REPEAT;
+    GLint wrapT = GL_REPEAT;
+    GLint wrapR = GL_REPEAT;
+    // 1 disables anisotropic filtering, clamped to what the driver supports
+    float maxAnisotropy = 1.0f;
+    float lodBias = 0.0f;
+    // GL_NONE or a compare function (eg. GL_LEQUAL) for shadow map lookups
+    GLenum compareFunc = GL_NONE;
+
+    bool operator==(const SamplerDesc& other) const = default;
+};
+
+/** Deduplicated sampler objects. Sampling state bound through a sampler overrides the parameters of the
+ * texture on the same unit, so one texture can be sampled in different ways without duplicating it
+ * and a draw can bind the samplers of all its units in one call.
+ * Textures keep the parameters of their TextureDesc as the state used when no sampler is bound
+ * (eg. by ImGui). Unbind samplers again (unbind()) before passes that rely on that.
+ */
+class SamplerCache
+{
+  public:
+    SamplerCache();
+    ~SamplerCache();
+
+    SamplerCache(const SamplerCache&) = delete;
+    SamplerCache& operator=(const SamplerCache&) = delete;
+
+    /* Sampler object with the given state, created on first use */
+    GLuint get(const SamplerDesc& desc);
+
+    void bind(GLuint unit, const SamplerDesc& desc);
+
+    /* Binds samplers to the units firstUnit to firstUnit + descs.size() - 1 with a single call */
+    void bind(GLuint firstUnit, std::span<const SamplerDesc> descs);
+
+    /* Restores the parameters of the textures themselves on the given units */
+    static void unbind(GLuint firstUnit, GLsizei count = 1);
+
+    [[nodiscard]] inline size_t getSamplerCount() const
+    {
+        return samplers.size();
+    }
+
+    /* 1 if anisotropic filtering is not supported */
+    [[nodiscard]] inline float getMaxSupportedAnisotropy() const
+    {
+        return maxSupportedAnisotropy;
+    }
+
+  private:
+    struct DescHash
+    {
+        size_t operator()(const SamplerDesc& desc) const;
+    };
+
+    float maxSupportedAnisotropy = 1.0f;
+    std::unordered_map<SamplerDesc, GLuint, DescHash> samplers;
+    // reused by bind() to avoid allocating every draw
+    std::vector<GLuint> bindScratch;
+};
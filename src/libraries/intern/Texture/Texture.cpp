@@ -2,76 +2,164 @@
 
 #include <glad/glad/glad.h>
 
+#include <algorithm>
 #include <cassert>
+#include <cstring>
+#include <vector>
 
-#include <stb/stb_image.h>
+#include <intern/Misc/GPUMemoryTracker.h>
 
-Texture::Texture(const std::string& file, bool mipMap)
-{
-    // todo: load image data first, then use descriptor based constructor
-
-    //  load texture data from file
-    int bytesPerPixel = 0;
-    stbi_set_flip_vertically_on_load(true);
-
-    std::string texName = file;
-    size_t pos = texName.find_last_of('/') + 1;
-    texName = texName.substr(pos, texName.find_last_of('.') - pos);
-
-    bool isHdr = stbi_is_hdr(file.c_str()) != 0;
+#include "BlockCompression.h"
+#include "CookedTexture.h"
+#include "HDRPacking.h"
+#include "Image.h"
+#include "MipGenerator.h"
 
-    unsigned char* image = nullptr;
-    if(!isHdr)
+namespace
+{
+    std::string nameFromFile(const std::string& file)
     {
-        image = stbi_load(file.c_str(), &width, &height, &bytesPerPixel, 0);
+        size_t pos = file.find_last_of('/') + 1;
+        return file.substr(pos, file.find_last_of('.') - pos);
     }
-    else
+
+    std::vector<std::span<const uint8_t>> cookedLevels(const CookedTexture& cooked)
     {
-        assert(false && "todo: hdr image load");
-        image = (unsigned char*)stbi_loadf(file.c_str(), &width, &height, &bytesPerPixel, 0);
+        std::vector<std::span<const uint8_t>> levels;
+        for(int level = 0; cooked.valid() && level < cooked.getLevelCount(); level++)
+        {
+            levels.push_back(cooked.getLevelData(level));
+        }
+        return levels;
     }
+} // namespace
 
-    if(bytesPerPixel == 0 || width == 0 || height == 0)
+size_t textureLevelSize(GLenum internalFormat, int width, int height)
+{
+    const size_t texels = static_cast<size_t>(width) * height;
+    if(isCompressedFormat(internalFormat))
     {
-        std::cout << "Could not load texture " << file << std::endl;
+        const size_t blocks = static_cast<size_t>((width + 3) / 4) * ((height + 3) / 4);
+        switch(internalFormat)
+        {
+        case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+        case GL_COMPRESSED_SRGB_S3TC_DXT1_EXT:
+        case GL_COMPRESSED_RED_RGTC1:
+        case GL_COMPRESSED_SIGNED_RED_RGTC1:
+            return blocks * 8;
+        default:
+            return blocks * 16;
+        }
     }
-
-    int levels = static_cast<int>(log2(std::max(width, height))) + 1;
-
-    // create openGL texture object
-    glCreateTextures(GL_TEXTURE_2D, 1, &textureID);
-    glObjectLabel(GL_TEXTURE, textureID, static_cast<GLsizei>(texName.size()), texName.data());
-    glTextureParameterf(textureID, GL_TEXTURE_WRAP_S, GL_REPEAT);
-    glTextureParameterf(textureID, GL_TEXTURE_WRAP_T, GL_REPEAT);
-    glTextureParameterf(textureID, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTextureParameterf(textureID, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-    // todo: calculate if changing alignment is needed (or worst case set alignment to 1 by default)
-    if(bytesPerPixel == 3)
+    switch(internalFormat)
     {
-        glTextureStorage2D(textureID, levels, GL_RGB8, width, height);
-        glTextureSubImage2D(textureID, 0, 0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE, image);
+    case GL_R8:
+    case GL_R8UI:
+    case GL_STENCIL_INDEX8:
+        return texels;
+    case GL_RG8:
+    case GL_R16:
+    case GL_R16F:
+    case GL_R16UI:
+    case GL_DEPTH_COMPONENT16:
+        return texels * 2;
+    case GL_RGB8:
+    case GL_SRGB8:
+    case GL_DEPTH_COMPONENT24:
+        return texels * 3;
+    case GL_RGB16F:
+        return texels * 6;
+    case GL_RGBA16:
+    case GL_RGBA16F:
+    case GL_RG32F:
+    case GL_RG32UI:
+    case GL_DEPTH32F_STENCIL8:
+        return texels * 8;
+    case GL_RGB32F:
+        return texels * 12;
+    case GL_RGBA32F:
+    case GL_RGBA32UI:
+        return texels * 16;
+    default:
+        // RGBA8, RG16F, R32F, R32UI, R11G11B10F, RGB9E5, DEPTH24_STENCIL8, ...
+        return texels * 4;
     }
-    else if(bytesPerPixel == 4)
+}
+
+Texture::Texture(const std::string& file, bool mipMap, HDRStorage hdrStorage)
+{
+    const std::string texName = nameFromFile(file);
+    if(isCookedTexturePath(file))
     {
-        glTextureStorage2D(textureID, levels, GL_RGBA8, width, height);
-        glTextureSubImage2D(textureID, 0, 0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, image);
+        Texture loaded{CookedTexture{file}, texName.c_str()};
+        swap(loaded);
     }
     else
     {
-        assert(false && "Unknown / unsupported image format");
+        Texture loaded{loadImage(file), mipMap, texName.c_str(), hdrStorage};
+        swap(loaded);
     }
-    if(mipMap)
+}
+
+Texture::Texture(const Image& image, bool mipMap, const char* name, HDRStorage hdrStorage)
+{
+    assert(image.valid() && "Could not load image");
+    if(image.valid() && image.isHdr)
     {
-        glTextureParameterf(textureID, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-        glGenerateTextureMipmap(textureID);
+        // packed formats like RGB9E5 are not color renderable, so the mips are built on the cpu
+        const std::vector<std::vector<uint8_t>> levels = buildHDRLevels(image, hdrStorage, mipMap);
+        const std::vector<std::span<const uint8_t>> levelSpans(levels.begin(), levels.end());
+        Texture loaded{TextureDesc{
+            .name = name,
+            .levels = static_cast<GLsizei>(levels.size()),
+            .width = image.width,
+            .height = image.height,
+            .internalFormat = hdrInternalFormat(hdrStorage, image.channels),
+            .minFilter = mipMap ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR,
+            .dataFormat = hdrDataFormat(hdrStorage, image.channels),
+            .dataType = hdrDataType(hdrStorage),
+            .levelData = levelSpans}};
+        swap(loaded);
+        return;
+    }
+    // mips are generated on the cpu, so the filtering does not depend on the driver
+    std::vector<std::vector<uint8_t>> levels;
+    if(image.valid() && mipMap)
+    {
+        levels = generateMipChain(image.pixels.get(), image.width, image.height, image.channels);
     }
+    const std::vector<std::span<const uint8_t>> levelSpans(levels.begin(), levels.end());
+    Texture loaded{TextureDesc{
+        .name = name,
+        .levels = mipMap ? fullMipChainLevels(image.width, image.height) : 1,
+        .width = image.valid() ? image.width : 1,
+        .height = image.valid() ? image.height : 1,
+        .internalFormat = image.valid() ? image.internalFormat() : GL_RGBA8,
+        .minFilter = mipMap ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR,
+        .data = image.pixels.get(),
+        .dataFormat = image.valid() ? image.dataFormat() : GL_RGBA,
+        .dataType = image.dataType(),
+        .levelData = levelSpans}};
+    swap(loaded);
 
     // GLfloat maxAniso = 0;
     // glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY, &maxAniso);
     // glTextureParameterf(textureID, GL_TEXTURE_MAX_ANISOTROPY, maxAniso);
+}
 
-    initialized = true;
-    stbi_image_free(image);
+Texture::Texture(const CookedTexture& cooked, const char* name)
+    : Texture(TextureDesc{
+          .name = name,
+          .levels = cooked.valid() ? cooked.getLevelCount() : 1,
+          .width = cooked.valid() ? cooked.getLevelWidth(0) : 1,
+          .height = cooked.valid() ? cooked.getLevelHeight(0) : 1,
+          .internalFormat = cooked.valid() ? cooked.getHeader().internalFormat : GL_RGBA8,
+          .minFilter = cooked.valid() && cooked.getLevelCount() > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR,
+          .dataFormat = cooked.valid() ? cooked.getHeader().dataFormat : 0,
+          .dataType = cooked.valid() ? cooked.getHeader().dataType : 0,
+          .levelData = cookedLevels(cooked)})
+{
+    assert(cooked.valid() && "Could not load cooked texture");
 }
 
 Texture::Texture(const TextureDesc descriptor) : width(descriptor.width), height(descriptor.height)
@@ -80,6 +168,14 @@ Texture::Texture(const TextureDesc descriptor) : width(descriptor.width), height
     glCreateTextures(GL_TEXTURE_2D, 1, &textureID);
     glTextureStorage2D(
         textureID, descriptor.levels, descriptor.internalFormat, descriptor.width, descriptor.height);
+    GPUMemoryTracker::get().trackTexture(
+        textureID,
+        GPUMemoryCategory::Texture,
+        descriptor.internalFormat,
+        descriptor.width,
+        descriptor.height,
+        1,
+        descriptor.levels);
     glTextureParameteri(textureID, GL_TEXTURE_MIN_FILTER, descriptor.minFilter);
     glTextureParameteri(textureID, GL_TEXTURE_MAG_FILTER, descriptor.magFilter);
     glTextureParameteri(textureID, GL_TEXTURE_WRAP_S, descriptor.wrapS);
@@ -91,10 +187,51 @@ Texture::Texture(const TextureDesc descriptor) : width(descriptor.width), height
     {
         glObjectLabel(GL_TEXTURE, textureID, -1, descriptor.name);
     }
-    if(descriptor.data != nullptr)
+    if(!descriptor.levelData.empty())
+    {
+        const bool compressed = isCompressedFormat(descriptor.internalFormat);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        for(int level = 0; level < static_cast<int>(descriptor.levelData.size()); level++)
+        {
+            const std::span<const uint8_t> data = descriptor.levelData[level];
+            const int levelWidth = std::max(width >> level, 1);
+            const int levelHeight = std::max(height >> level, 1);
+            if(compressed)
+            {
+                glCompressedTextureSubImage2D(
+                    textureID,
+                    level,
+                    0,
+                    0,
+                    levelWidth,
+                    levelHeight,
+                    descriptor.internalFormat,
+                    static_cast<GLsizei>(data.size()),
+                    data.data());
+            }
+            else
+            {
+                glTextureSubImage2D(
+                    textureID,
+                    level,
+                    0,
+                    0,
+                    levelWidth,
+                    levelHeight,
+                    descriptor.dataFormat,
+                    descriptor.dataType,
+                    data.data());
+            }
+        }
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    }
+    else if(descriptor.data != nullptr)
     {
+        // descriptor data is expected to be tightly packed
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
         glTextureSubImage2D(
             textureID, 0, 0, 0, width, height, descriptor.dataFormat, descriptor.dataType, descriptor.data);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
     }
     if(descriptor.generateMips)
     {
@@ -126,6 +263,7 @@ Texture::~Texture()
 {
     if(initialized)
     {
+        GPUMemoryTracker::get().untrackTexture(textureID);
         glDeleteTextures(1, &textureID);
     }
 }
@@ -4,10 +4,16 @@
 
 #include <stb/stb_image.h>
 
+#include <cstddef>
 #include <iostream>
+#include <span>
 #include <string>
 
 #include "GLTexture.h"
+#include "HDRPacking.h"
+
+struct Image;
+class CookedTexture;
 
 struct TextureDesc
 {
@@ -26,8 +32,16 @@ struct TextureDesc
     GLenum dataFormat = 0xFFFFFFFF;
     GLenum dataType = 0xFFFFFFFF;
     bool generateMips = false;
+    // Data for every mip level (level 0 first), used instead of data when not empty.
+    // Compressed internal formats (see BlockCompression.h) are uploaded with glCompressedTextureSubImage2D
+    std::span<const std::span<const uint8_t>> levelData = {};
 };
 
+/** Bytes one level of a texture with the given internal format occupies, without any driver padding.
+ * Block compressed formats are rounded up to whole blocks, unknown formats count as 4 bytes per texel
+ */
+size_t textureLevelSize(GLenum internalFormat, int width, int height);
+
 class Texture : public GLTexture
 {
   public:
@@ -40,10 +54,29 @@ class Texture : public GLTexture
     Texture& operator=(const Texture&) = delete; // copy assign
 
     /** Sets up and loads a texture from a file.
+     * Files ending in CookedTexture::extension are memory mapped and uploaded without decoding,
+     * using the mip levels stored in the file instead of generating them.
      * @param file Name of the image file within the resource folder
+     * @param mipMap True if texture is supposed to generate mipmapping (ignored for cooked files)
+     * @param hdrStorage How HDR images (.hdr) are stored on the GPU, ignored for LDR images
+     */
+    Texture(const std::string& file, bool mipMap, HDRStorage hdrStorage = HDRStorage::RGB9E5);
+
+    /** Creates a texture from an already decoded image (see loadImage() in Image.h).
+     * HDR images are packed into hdrStorage on the cpu, including their mip levels.
+     * @param image Decoded image data
      * @param mipMap True if texture is supposed to generate mipmapping
+     * @param name Debug label of the texture
+     * @param hdrStorage How HDR images are stored on the GPU, ignored for LDR images
+     */
+    Texture(
+        const Image& image, bool mipMap, const char* name = "", HDRStorage hdrStorage = HDRStorage::RGB9E5);
+
+    /** Creates a texture from a cooked texture file, uploading every stored level as is.
+     * @param cooked Mapped cooked texture, see CookedTexture.h
+     * @param name Debug label of the texture
      */
-    Texture(const std::string& file, bool mipMap);
+    explicit Texture(const CookedTexture& cooked, const char* name = "");
 
     /** Creates an immutable Texture object based on a given descriptor.
      * @param descriptor Descriptor to use for configuring the texture
@@ -66,12 +99,12 @@ class Texture : public GLTexture
 
     void swap(Texture& other);
 
-    inline int getWidth()
+    inline int getWidth() const
     {
         return width;
     };
 
-    inline int getHeight()
+    inline int getHeight() const
     {
         return height;
     };
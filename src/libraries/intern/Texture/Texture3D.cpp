@@ -1,13 +1,20 @@
 #include <glad/glad/glad.h>
 
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+#include <intern/Misc/GPUMemoryTracker.h>
+
 #include "Texture.h"
 #include "Texture3D.h"
 
-Texture3D::Texture3D(const TextureDesc descriptor)
+Texture3D::Texture3D(const TextureDesc descriptor, GLenum target)
     : width(descriptor.width), height(descriptor.height), depth(descriptor.depth)
 {
+    assert(target == GL_TEXTURE_3D || target == GL_TEXTURE_2D_ARRAY);
 
-    glCreateTextures(GL_TEXTURE_3D, 1, &textureID);
+    glCreateTextures(target, 1, &textureID);
     glTextureStorage3D(
         textureID,
         descriptor.levels,
@@ -15,6 +22,15 @@ Texture3D::Texture3D(const TextureDesc descriptor)
         descriptor.width,
         descriptor.height,
         descriptor.depth);
+    GPUMemoryTracker::get().trackTexture(
+        textureID,
+        GPUMemoryCategory::Texture3D,
+        descriptor.internalFormat,
+        descriptor.width,
+        descriptor.height,
+        descriptor.depth,
+        descriptor.levels,
+        target == GL_TEXTURE_2D_ARRAY);
     glTextureParameteri(textureID, GL_TEXTURE_MIN_FILTER, descriptor.minFilter);
     glTextureParameteri(textureID, GL_TEXTURE_MAG_FILTER, descriptor.magFilter);
     glTextureParameteri(textureID, GL_TEXTURE_WRAP_S, descriptor.wrapS);
@@ -24,7 +40,29 @@ Texture3D::Texture3D(const TextureDesc descriptor)
     {
         glObjectLabel(GL_TEXTURE, textureID, -1, descriptor.name);
     }
-    if(descriptor.data != nullptr)
+    if(!descriptor.levelData.empty())
+    {
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        for(int level = 0; level < static_cast<int>(descriptor.levelData.size()); level++)
+        {
+            // array layers are not mipmapped, only the slices of a 3D texture are
+            const int levelDepth = target == GL_TEXTURE_2D_ARRAY ? depth : std::max(depth >> level, 1);
+            glTextureSubImage3D(
+                textureID,
+                level,
+                0,
+                0,
+                0,
+                std::max(width >> level, 1),
+                std::max(height >> level, 1),
+                levelDepth,
+                descriptor.dataFormat,
+                descriptor.dataType,
+                descriptor.levelData[level].data());
+        }
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    }
+    else if(descriptor.data != nullptr)
     {
         glTextureSubImage3D(
             textureID,
@@ -71,6 +109,7 @@ Texture3D::~Texture3D()
 {
     if(initialized)
     {
+        GPUMemoryTracker::get().untrackTexture(textureID);
         glDeleteTextures(1, &textureID);
     }
 }
@@ -7,7 +7,7 @@
 // forward declared, part of Texture.h
 struct TextureDesc;
 
-/** Texture class encapsulating and managing an OpenGL 3D texture object.
+/** Texture class encapsulating and managing an OpenGL 3D texture or 2D array texture object.
  */
 class Texture3D : public GLTexture
 {
@@ -22,8 +22,10 @@ class Texture3D : public GLTexture
 
     /** Creates an immutable Texture object based on a given descriptor.
      * @param descriptor Descriptor to use for configuring the texture
+     * @param target GL_TEXTURE_3D or GL_TEXTURE_2D_ARRAY (descriptor.depth is the layer count then).
+     *               levelData of an array holds all layers of the level, one after another
      */
-    explicit Texture3D(TextureDesc descriptor);
+    explicit Texture3D(TextureDesc descriptor, GLenum target = GL_TEXTURE_3D);
 
     /*
         Move constructor
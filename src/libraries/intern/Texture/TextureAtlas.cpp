@@ -0,0 +1,390 @@
+#include "TextureAtlas.h"
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+
+// ImGui only compiles the packer into imgui_draw.cpp (as static functions), so it is compiled here as well
+#define STBRP_STATIC
+#define STB_RECT_PACK_IMPLEMENTATION
+#include <ImGui/imstb_rectpack.h>
+
+#include <intern/Misc/ThreadPool.h>
+
+#include "Image.h"
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    double millisecondsSince(Clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+
+    int alignUp(int value, int alignment)
+    {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+
+    int nextPowerOfTwo(int value)
+    {
+        int result = 1;
+        while(result < value)
+        {
+            result *= 2;
+        }
+        return result;
+    }
+
+    // packs every rect, returns false if not all of them fit
+    bool packRects(std::vector<stbrp_rect>& rects, int width, int height)
+    {
+        stbrp_context context;
+        // one node per column, so the widths are not quantized
+        std::vector<stbrp_node> nodes(width);
+        stbrp_init_target(&context, width, height, nodes.data(), width);
+        stbrp_setup_heuristic(&context, STBRP_HEURISTIC_Skyline_BF_sortHeight);
+        return stbrp_pack_rects(&context, rects.data(), static_cast<int>(rects.size())) == 1;
+    }
+
+    /* Tries every power of two width with the full height, crops the height to the used rows (aligned)
+     * and keeps the smallest (then squarest) result
+     */
+    bool packSingle(
+        std::vector<stbrp_rect>& rects, int minWidth, int minHeight, int maxSize, int alignment, int& width,
+        int& height)
+    {
+        std::vector<stbrp_rect> best;
+        size_t bestArea = SIZE_MAX;
+        for(int w = nextPowerOfTwo(minWidth); w <= maxSize; w *= 2)
+        {
+            std::vector<stbrp_rect> attempt = rects;
+            if(!packRects(attempt, w, maxSize))
+            {
+                continue;
+            }
+            int h = minHeight;
+            for(const stbrp_rect& rect : attempt)
+            {
+                h = std::max(h, rect.y + rect.h);
+            }
+            h = alignUp(h, alignment);
+            const size_t area = static_cast<size_t>(w) * h;
+            if(area < bestArea || (area == bestArea && std::abs(w - h) < std::abs(width - height)))
+            {
+                best = std::move(attempt);
+                bestArea = area;
+                width = w;
+                height = h;
+            }
+        }
+        if(best.empty())
+        {
+            return false;
+        }
+        rects = std::move(best);
+        return true;
+    }
+
+    // fills layer after layer with the rects that did not fit into the previous ones, stores the layer in id
+    bool packLayers(std::vector<stbrp_rect>& rects, int size, int maxLayers, int& layers)
+    {
+        std::vector<stbrp_rect> remaining = rects;
+        std::vector<int> layerOf(rects.size());
+        layers = 0;
+        while(!remaining.empty())
+        {
+            if(layers == maxLayers)
+            {
+                return false;
+            }
+            packRects(remaining, size, size);
+            std::vector<stbrp_rect> next;
+            for(const stbrp_rect& rect : remaining)
+            {
+                if(rect.was_packed != 0)
+                {
+                    rects[rect.id] = rect;
+                    layerOf[rect.id] = layers;
+                }
+                else
+                {
+                    next.push_back(rect);
+                }
+            }
+            // cannot happen as long as every rect fits into an empty layer
+            assert(next.size() < remaining.size());
+            remaining = std::move(next);
+            layers++;
+        }
+        for(size_t i = 0; i < rects.size(); i++)
+        {
+            rects[i].id = layerOf[i];
+        }
+        return true;
+    }
+
+    std::vector<uint8_t> toRGBA(const Image& image)
+    {
+        const size_t texels = static_cast<size_t>(image.width) * image.height;
+        std::vector<uint8_t> rgba(texels * 4, 255);
+        const uint8_t* pixels = image.pixels.get();
+        for(size_t i = 0; i < texels; i++)
+        {
+            for(int c = 0; c < std::min(image.channels, 4); c++)
+            {
+                rgba[i * 4 + c] = pixels[i * image.channels + c];
+            }
+            if(image.channels < 3)
+            {
+                // grey (and alpha) images are expanded to grey rgb
+                rgba[i * 4 + 3] = image.channels == 2 ? pixels[i * 2 + 1] : 255;
+                rgba[i * 4 + 1] = pixels[i * image.channels];
+                rgba[i * 4 + 2] = pixels[i * image.channels];
+            }
+        }
+        return rgba;
+    }
+
+    /* Copies one level of an image into its cell and repeats the edge texels up to the cell border.
+     * cellX/Y/Width/Height are in texels of the level, gutter is the offset of the image inside the cell
+     */
+    void copyIntoCell(
+        const uint8_t* source, int sourceWidth, int sourceHeight, uint8_t* destination, int destinationWidth,
+        int cellX, int cellY, int cellWidth, int cellHeight, int gutter)
+    {
+        constexpr size_t texelSize = 4;
+        const int right = std::min(cellWidth - gutter, sourceWidth + gutter);
+        for(int row = 0; row < cellHeight; row++)
+        {
+            const int sourceRow = std::clamp(row - gutter, 0, sourceHeight - 1);
+            const uint8_t* sourceLine = source + static_cast<size_t>(sourceRow) * sourceWidth * texelSize;
+            uint8_t* line =
+                destination + (static_cast<size_t>(cellY + row) * destinationWidth + cellX) * texelSize;
+            for(int x = 0; x < gutter; x++)
+            {
+                memcpy(line + x * texelSize, sourceLine, texelSize);
+            }
+            memcpy(line + gutter * texelSize, sourceLine, (right - gutter) * texelSize);
+            for(int x = right; x < cellWidth; x++)
+            {
+                memcpy(line + x * texelSize, sourceLine + (sourceWidth - 1) * texelSize, texelSize);
+            }
+        }
+    }
+} // namespace
+
+PackedAtlas packAtlas(std::span<const Image> images, const AtlasSettings& settings, ThreadPool* pool)
+{
+    assert(settings.maxSize > 0 && settings.maxSize <= 0xFFFF);
+    PackedAtlas atlas;
+    atlas.stats.images = images.size();
+    if(images.empty())
+    {
+        return atlas;
+    }
+
+    const int levelCount =
+        std::clamp(settings.mipLevels, 1, fullMipChainLevels(settings.maxSize, settings.maxSize));
+    // every cell starts and ends on a multiple of alignment, so it maps to whole texels on every level
+    const int alignment = 1 << (levelCount - 1);
+    const int gutter = alignUp(std::max(settings.gutter, 0), alignment);
+
+    auto start = Clock::now();
+    std::vector<stbrp_rect> rects(images.size());
+    int maxCellWidth = alignment;
+    int maxCellHeight = alignment;
+    for(size_t i = 0; i < images.size(); i++)
+    {
+        const Image& image = images[i];
+        assert(image.valid() && !image.isHdr && "Atlas images need to be 8 bit images");
+        const int cellWidth = alignUp(image.width, alignment) + 2 * gutter;
+        const int cellHeight = alignUp(image.height, alignment) + 2 * gutter;
+        if(cellWidth > settings.maxSize || cellHeight > settings.maxSize)
+        {
+            std::cout << "Atlas image " << i << " (" << image.width << "x" << image.height
+                      << ") does not fit into the maximum atlas size of " << settings.maxSize << std::endl;
+            return atlas;
+        }
+        rects[i] = {
+            .id = static_cast<int>(i),
+            .w = static_cast<stbrp_coord>(cellWidth),
+            .h = static_cast<stbrp_coord>(cellHeight)};
+        maxCellWidth = std::max(maxCellWidth, cellWidth);
+        maxCellHeight = std::max(maxCellHeight, cellHeight);
+    }
+
+    bool packed = false;
+    std::vector<int> layerOf(images.size(), 0);
+    if(settings.array)
+    {
+        size_t area = 0;
+        for(const stbrp_rect& rect : rects)
+        {
+            area += static_cast<size_t>(rect.w) * rect.h;
+        }
+        // layers are square, large enough for everything if possible
+        const int size = std::min(
+            nextPowerOfTwo(
+                std::max({maxCellWidth, maxCellHeight, static_cast<int>(std::ceil(std::sqrt(area)))})),
+            settings.maxSize);
+        atlas.width = size;
+        atlas.height = size;
+        packed = packLayers(rects, size, settings.maxLayers, atlas.layers);
+        for(size_t i = 0; i < rects.size(); i++)
+        {
+            layerOf[i] = rects[i].id;
+        }
+    }
+    else
+    {
+        atlas.layers = 1;
+        packed = packSingle(
+            rects, maxCellWidth, maxCellHeight, settings.maxSize, alignment, atlas.width, atlas.height);
+    }
+    atlas.stats.packMs = millisecondsSince(start);
+    if(!packed)
+    {
+        std::cout << "Could not pack " << images.size() << " images into the atlas (maximum size "
+                  << settings.maxSize << ")" << std::endl;
+        return atlas;
+    }
+
+    start = Clock::now();
+    const int width = atlas.width;
+    const int height = atlas.height;
+    atlas.levels.resize(levelCount);
+    for(int level = 0; level < levelCount; level++)
+    {
+        atlas.levels[level].resize(
+            static_cast<size_t>(width >> level) * (height >> level) * 4 * atlas.layers);
+    }
+    atlas.regions.resize(images.size());
+    size_t imageTexels = 0;
+    for(size_t i = 0; i < images.size(); i++)
+    {
+        const Image& image = images[i];
+        AtlasRegion& region = atlas.regions[i];
+        region.layer = layerOf[i];
+        region.x = rects[i].x + gutter;
+        region.y = rects[i].y + gutter;
+        region.width = image.width;
+        region.height = image.height;
+        region.uvScale = {
+            static_cast<float>(image.width) / static_cast<float>(width),
+            static_cast<float>(image.height) / static_cast<float>(height)};
+        region.uvOffset = {
+            static_cast<float>(region.x) / static_cast<float>(width),
+            static_cast<float>(region.y) / static_cast<float>(height)};
+        imageTexels += static_cast<size_t>(image.width) * image.height;
+    }
+
+    // images cover disjoint cells, so they can be processed in parallel
+    parallelFor(
+        pool,
+        images.size(),
+        1,
+        [&](size_t begin, size_t end)
+        {
+            for(size_t i = begin; i < end; i++)
+            {
+                const Image& image = images[i];
+                const std::vector<uint8_t> rgba = toRGBA(image);
+                const std::vector<std::vector<uint8_t>> mips =
+                    levelCount > 1
+                        ? generateMipChain(rgba.data(), image.width, image.height, 4, settings.mipSettings)
+                        : std::vector<std::vector<uint8_t>>{rgba};
+                for(int level = 0; level < levelCount; level++)
+                {
+                    // the chain of small images ends early, the last (1x1) level is repeated then
+                    const int mip = std::min(level, static_cast<int>(mips.size()) - 1);
+                    const int levelWidth = width >> level;
+                    const size_t layerSize = static_cast<size_t>(levelWidth) * (height >> level) * 4;
+                    copyIntoCell(
+                        mips[mip].data(),
+                        std::max(image.width >> mip, 1),
+                        std::max(image.height >> mip, 1),
+                        atlas.levels[level].data() + layerSize * layerOf[i],
+                        levelWidth,
+                        rects[i].x >> level,
+                        rects[i].y >> level,
+                        rects[i].w >> level,
+                        rects[i].h >> level,
+                        gutter >> level);
+                }
+            }
+        });
+    atlas.stats.buildMs = millisecondsSince(start);
+
+    atlas.stats.width = width;
+    atlas.stats.height = height;
+    atlas.stats.layers = atlas.layers;
+    atlas.stats.efficiency = static_cast<float>(
+        static_cast<double>(imageTexels) / (static_cast<double>(width) * height * atlas.layers));
+    return atlas;
+}
+
+TextureAtlas::TextureAtlas(
+    std::span<const Image> images, const AtlasSettings& settings, ThreadPool* pool, const char* name)
+{
+    const PackedAtlas atlas = packAtlas(images, settings, pool);
+    assert(atlas.valid() && "Could not pack the atlas");
+    regions = atlas.regions;
+    stats = atlas.stats;
+
+    const auto start = Clock::now();
+    const std::vector<std::span<const uint8_t>> levelSpans(atlas.levels.begin(), atlas.levels.end());
+    const TextureDesc desc{
+        .name = name,
+        .levels = atlas.valid() ? static_cast<GLsizei>(atlas.levels.size()) : 1,
+        .width = atlas.valid() ? atlas.width : 1,
+        .height = atlas.valid() ? atlas.height : 1,
+        .depth = atlas.valid() ? atlas.layers : 1,
+        .internalFormat = static_cast<GLenum>(settings.mipSettings.srgb ? GL_SRGB8_ALPHA8 : GL_RGBA8),
+        .minFilter = atlas.levels.size() > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR,
+        // the gutters handle the edges of every image, wrapping the atlas itself is never wanted
+        .wrapS = GL_CLAMP_TO_EDGE,
+        .wrapT = GL_CLAMP_TO_EDGE,
+        .wrapR = GL_CLAMP_TO_EDGE,
+        .dataFormat = GL_RGBA,
+        .dataType = GL_UNSIGNED_BYTE,
+        .levelData = levelSpans};
+    if(settings.array)
+    {
+        textureArray.emplace(desc, GL_TEXTURE_2D_ARRAY);
+    }
+    else
+    {
+        texture.emplace(desc);
+    }
+    // only measures submitting the upload, the driver might still be copying afterwards
+    stats.uploadMs = millisecondsSince(start);
+}
+
+const GLTexture& TextureAtlas::getTexture() const
+{
+    if(textureArray.has_value())
+    {
+        return *textureArray;
+    }
+    return *texture;
+}
+
+std::vector<AtlasRemapEntry> TextureAtlas::getRemapTable() const
+{
+    std::vector<AtlasRemapEntry> table;
+    table.reserve(regions.size());
+    for(const AtlasRegion& region : regions)
+    {
+        table.push_back(AtlasRemapEntry{
+            .scaleOffset = {region.uvScale.x, region.uvScale.y, region.uvOffset.x, region.uvOffset.y},
+            .layer = region.layer,
+            .padding = {0, 0, 0}});
+    }
+    return table;
+}
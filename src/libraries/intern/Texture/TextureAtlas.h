@@ -0,0 +1,152 @@
+#pragma once
+
+#include <glad/glad/glad.h>
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include "MipGenerator.h"
+#include "Texture.h"
+#include "Texture3D.h"
+
+class ThreadPool;
+struct Image;
+
+struct AtlasSettings
+{
+    // pack into layers of a GL_TEXTURE_2D_ARRAY instead of growing a single texture
+    bool array = false;
+    // maximum width and height of the atlas (or of every array layer)
+    int maxSize = 4096;
+    int maxLayers = 256;
+    // mip levels of the atlas. Images are aligned to 2^(mipLevels - 1) texels, so every level can be
+    // built from the mips of the images themselves and no level mixes texels of neighbouring images
+    int mipLevels = 4;
+    // texels around every image that repeat its edge (clamp), so filtering does not bleed in neighbours.
+    // Rounded up to the alignment above, which keeps at least one texel of gutter on every level
+    int gutter = 4;
+    MipSettings mipSettings = {};
+};
+
+/** Where an image ended up in the atlas. Texture coordinates of the image map to the atlas with
+ * uv * uvScale + uvOffset (see remap()), sampled from layer if the atlas is an array.
+ */
+struct AtlasRegion
+{
+    glm::vec2 uvScale{1.0f};
+    glm::vec2 uvOffset{0.0f};
+    int layer = 0;
+    // texel rectangle of the image on level 0, without the gutter
+    int x = 0;
+    int y = 0;
+    int width = 0;
+    int height = 0;
+
+    [[nodiscard]] inline glm::vec2 remap(glm::vec2 uv) const
+    {
+        return uv * uvScale + uvOffset;
+    }
+};
+
+/** One AtlasRegion as stored in the remap table of a shader storage buffer (std430),
+ * see General/atlasTexture.frag (array atlases)
+ */
+struct AtlasRemapEntry
+{
+    glm::vec4 scaleOffset;
+    int32_t layer;
+    int32_t padding[3];
+};
+
+struct AtlasStats
+{
+    size_t images = 0;
+    int width = 0;
+    int height = 0;
+    int layers = 0;
+    // texels of the images / texels of the atlas, the rest is gutter, alignment and free space
+    float efficiency = 0.0f;
+    double packMs = 0.0;
+    // mip generation and copying into the atlas levels
+    double buildMs = 0.0;
+    double uploadMs = 0.0;
+};
+
+/** Atlas in client memory, does not touch OpenGL
+ */
+struct PackedAtlas
+{
+    int width = 0;
+    int height = 0;
+    int layers = 0;
+    // rgba8 texels of every level, level 0 first, all layers of a level one after another
+    std::vector<std::vector<uint8_t>> levels;
+    // one per input image, in input order
+    std::vector<AtlasRegion> regions;
+    AtlasStats stats;
+
+    [[nodiscard]] inline bool valid() const
+    {
+        return !levels.empty();
+    }
+};
+
+/** Packs 8 bit images into an atlas with the skyline packer of imstb_rectpack.h.
+ * Without settings.array the atlas gets the power of two width that leads to the smallest area, with the
+ * height cropped to what is used. With it every layer has the same power of two size and new layers are
+ * started when one is full.
+ * Every image is converted to rgba8. The mips of every image are generated (see MipGenerator.h) and copied
+ * into the matching level of the atlas, gutters are rebuilt on every level.
+ * Images are processed in parallel on the pool, if one is given.
+ * @return The packed atlas, invalid if the images do not fit into maxSize (and maxLayers)
+ */
+PackedAtlas
+packAtlas(std::span<const Image> images, const AtlasSettings& settings = {}, ThreadPool* pool = nullptr);
+
+/** Many small textures packed into a single Texture (or a 2D array texture), so meshes using different
+ * images can be drawn without rebinding textures in between.
+ * The uv remap table (one entry per image) is either applied to the texture coordinates directly
+ * (AtlasRegion::remap()) or uploaded and indexed in the shader (getRemapTable()).
+ */
+class TextureAtlas
+{
+  public:
+    TextureAtlas(
+        std::span<const Image> images, const AtlasSettings& settings = {}, ThreadPool* pool = nullptr,
+        const char* name = "");
+
+    TextureAtlas(const TextureAtlas&) = delete;
+    TextureAtlas& operator=(const TextureAtlas&) = delete;
+
+    /* Either the Texture or the array texture, depending on AtlasSettings::array */
+    [[nodiscard]] const GLTexture& getTexture() const;
+
+    [[nodiscard]] inline bool isArray() const
+    {
+        return textureArray.has_value();
+    }
+
+    [[nodiscard]] inline const std::vector<AtlasRegion>& getRegions() const
+    {
+        return regions;
+    }
+
+    [[nodiscard]] inline const AtlasStats& getStats() const
+    {
+        return stats;
+    }
+
+    /* The regions in a layout that can be uploaded into a shader storage buffer as is */
+    [[nodiscard]] std::vector<AtlasRemapEntry> getRemapTable() const;
+
+  private:
+    std::optional<Texture> texture;
+    std::optional<Texture3D> textureArray;
+    std::vector<AtlasRegion> regions;
+    AtlasStats stats;
+};
@@ -0,0 +1,91 @@
+#include "TextureCache.h"
+
+#include <filesystem>
+#include <functional>
+#include <system_error>
+
+#include <intern/Misc/Hash.h>
+
+size_t TextureCache::KeyHash::operator()(const Key& key) const
+{
+    size_t hash = std::hash<std::string>{}(key.path);
+    for(const uint64_t value :
+        {static_cast<uint64_t>(key.modificationTime),
+         static_cast<uint64_t>(key.mipMap),
+         static_cast<uint64_t>(key.hdrStorage)})
+    {
+        hashCombine(hash, value);
+    }
+    return hash;
+}
+
+TextureCache::TextureCache(TextureLoader& loader, uint32_t framesUntilEvict, size_t evictionsPerUpdate)
+    : loader(loader), framesUntilEvict(framesUntilEvict), evictionsPerUpdate(evictionsPerUpdate)
+{
+}
+
+std::shared_ptr<AsyncTexture> TextureCache::load(const std::string& file, bool mipMap, HDRStorage hdrStorage)
+{
+    // files that do not exist keep their path as is, the loader reports them as failed
+    std::error_code error;
+    std::filesystem::path path = std::filesystem::canonical(file, error);
+    if(error)
+    {
+        path = file;
+    }
+    const auto modified = std::filesystem::last_write_time(path, error);
+    const Key key{
+        .path = path.string(),
+        .modificationTime = error ? 0 : static_cast<int64_t>(modified.time_since_epoch().count()),
+        .mipMap = mipMap,
+        .hdrStorage = hdrStorage};
+
+    const auto it = entries.find(key);
+    if(it != entries.end())
+    {
+        stats.hits++;
+        it->second.lastUsed = frame;
+        return it->second.texture;
+    }
+    stats.misses++;
+    std::shared_ptr<AsyncTexture> texture = loader.load(key.path, mipMap, hdrStorage);
+    entries.emplace(key, Entry{.texture = texture, .lastUsed = frame});
+    stats.entries = entries.size();
+    return texture;
+}
+
+void TextureCache::update()
+{
+    frame++;
+    size_t evicted = 0;
+    stats.unused = 0;
+    for(auto it = entries.begin(); it != entries.end();)
+    {
+        // only touched on the GL thread, so the count is exact
+        if(it->second.texture.use_count() > 1)
+        {
+            it->second.lastUsed = frame;
+            ++it;
+            continue;
+        }
+        if(frame - it->second.lastUsed >= framesUntilEvict && evicted < evictionsPerUpdate)
+        {
+            it = entries.erase(it);
+            evicted++;
+            continue;
+        }
+        stats.unused++;
+        ++it;
+    }
+    stats.evictions += evicted;
+    stats.entries = entries.size();
+}
+
+void TextureCache::purge()
+{
+    const size_t before = entries.size();
+    std::erase_if(entries, [](const auto& entry) { return entry.second.texture.use_count() == 1; });
+    stats.evictions += before - entries.size();
+    stats.entries = entries.size();
+    stats.unused = 0;
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#include "HDRPacking.h"
+#include "TextureLoader.h"
+
+/** Deduplicates texture loads: every file is decoded and uploaded once, all loads of it share the same
+ * AsyncTexture (and with that the same GL texture) through reference counted handles.
+ * Files are identified by their canonical path and modification time, so changed files are loaded again.
+ *
+ * Entries that are no longer referenced outside of the cache are kept for framesUntilEvict calls of
+ * update() (so dropping and reloading a texture, eg. when switching scenes, is free) and then deleted,
+ * at most evictionsPerUpdate per update() so that freeing a whole scene does not cause a hitch.
+ */
+class TextureCache
+{
+  public:
+    struct Stats
+    {
+        // loads served from the cache / by starting a new load, since construction
+        size_t hits = 0;
+        size_t misses = 0;
+        size_t evictions = 0;
+        // entries in the cache and how many of them are only referenced by the cache
+        size_t entries = 0;
+        size_t unused = 0;
+    };
+
+    /** @param loader Loader for textures that are not cached yet, needs to outlive the cache
+     */
+    explicit TextureCache(
+        TextureLoader& loader, uint32_t framesUntilEvict = 120, size_t evictionsPerUpdate = 4);
+
+    TextureCache(const TextureCache&) = delete;
+    TextureCache& operator=(const TextureCache&) = delete;
+
+    /** Returns the texture of the file, loading it through the TextureLoader if it is not cached.
+     * Needs to be called from the GL thread. Parameters as in TextureLoader::load()
+     */
+    std::shared_ptr<AsyncTexture>
+    load(const std::string& file, bool mipMap, HDRStorage hdrStorage = HDRStorage::RGB9E5);
+
+    /** Evicts entries that were unused for too long. Call once per frame on the GL thread.
+     */
+    void update();
+
+    /** Evicts all entries that are not referenced outside of the cache right away
+     */
+    void purge();
+
+    [[nodiscard]] inline const Stats& getStats() const
+    {
+        return stats;
+    }
+
+  private:
+    struct Key
+    {
+        std::string path;
+        int64_t modificationTime;
+        bool mipMap;
+        HDRStorage hdrStorage;
+
+        bool operator==(const Key& other) const = default;
+    };
+
+    struct KeyHash
+    {
+        size_t operator()(const Key& key) const;
+    };
+
+    struct Entry
+    {
+        std::shared_ptr<AsyncTexture> texture;
+        uint64_t lastUsed;
+    };
+
+    TextureLoader& loader;
+    uint32_t framesUntilEvict;
+    size_t evictionsPerUpdate;
+    uint64_t frame = 0;
+    std::unordered_map<Key, Entry, KeyHash> entries;
+    Stats stats;
+};
@@ -0,0 +1,274 @@
+#include "TextureLoader.h"
+
+#include <intern/Misc/ThreadPool.h>
+
+#include "MipGenerator.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <thread>
+
+namespace
+{
+    // 2x2 magenta/black checker, so textures that are still loading are easy to spot
+    constexpr uint8_t placeholderTexels[] = {
+        255, 0, 255, 255, 0, 0, 0, 255, 0, 0, 0, 255, 255, 0, 255, 255};
+
+    std::string nameFromPath(const std::string& file)
+    {
+        const size_t pos = file.find_last_of('/') + 1;
+        return file.substr(pos, file.find_last_of('.') - pos);
+    }
+} // namespace
+
+TextureLoader::TextureLoader(ThreadPool& pool, size_t stagingSize, size_t uploadBudget)
+    : pool(pool), inbox(std::make_shared<Inbox>()), stagingRing(stagingSize, "TextureLoader Staging"),
+      placeholder(std::make_shared<const Texture>(TextureDesc{
+          .name = "TextureLoader Placeholder",
+          .width = 2,
+          .height = 2,
+          .internalFormat = GL_RGBA8,
+          .minFilter = GL_NEAREST,
+          .magFilter = GL_NEAREST,
+          .data = placeholderTexels,
+          .dataFormat = GL_RGBA,
+          .dataType = GL_UNSIGNED_BYTE})),
+      uploadBudget(uploadBudget)
+{
+}
+
+std::shared_ptr<AsyncTexture>
+TextureLoader::load(const std::string& file, bool mipMap, HDRStorage hdrStorage)
+{
+    std::shared_ptr<AsyncTexture> handle{new AsyncTexture(placeholder)};
+
+    inbox->pending++;
+    pool.enqueue(
+        [inbox = inbox, target = std::weak_ptr<AsyncTexture>(handle), file, mipMap, hdrStorage]()
+        {
+            // nobody is interested in the result anymore, dont bother decoding
+            Decoded decoded{
+                .target = target,
+                .name = nameFromPath(file),
+                .image = target.expired() ? Image{} : loadImage(file),
+                .hdrStorage = hdrStorage,
+                .mipMap = mipMap};
+            const Image& image = decoded.image;
+            if(image.valid() && image.isHdr)
+            {
+                decoded.levels = buildHDRLevels(image, hdrStorage, mipMap);
+            }
+            else if(image.valid() && mipMap)
+            {
+                decoded.levels =
+                    generateMipChain(image.pixels.get(), image.width, image.height, image.channels);
+            }
+            if(!decoded.levels.empty())
+            {
+                decoded.image.pixels.reset();
+            }
+            std::lock_guard<std::mutex> lock(inbox->mutex);
+            inbox->decoded.push_back(std::move(decoded));
+            inbox->pending--;
+        });
+
+    return handle;
+}
+
+void TextureLoader::update()
+{
+    stagingRing.retire();
+
+    std::vector<Decoded> decoded;
+    {
+        std::lock_guard<std::mutex> lock(inbox->mutex);
+        decoded.swap(inbox->decoded);
+    }
+    for(auto& entry : decoded)
+    {
+        startUpload(std::move(entry));
+    }
+
+    size_t uploaded = 0;
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, stagingRing.getBufferID());
+    while(!uploads.empty() && uploaded < uploadBudget)
+    {
+        Upload& upload = uploads.front();
+        if(upload.source.target.expired())
+        {
+            uploads.pop_front();
+            continue;
+        }
+        const size_t bytes = uploadRows(upload, uploadBudget - uploaded);
+        if(bytes == 0)
+        {
+            // staging ring is full, try again once the GPU consumed some of it
+            break;
+        }
+        uploaded += bytes;
+        if(upload.uploadedRows == std::max(upload.source.image.height >> upload.level, 1))
+        {
+            upload.level++;
+            upload.uploadedRows = 0;
+        }
+        if(upload.level == upload.levelCount)
+        {
+            completeUpload(upload);
+            uploads.pop_front();
+        }
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    stagingRing.fence();
+
+    stats.bytesUploadedLastUpdate = uploaded;
+    stats.totalBytesUploaded += uploaded;
+}
+
+void TextureLoader::finish()
+{
+    const size_t oldBudget = uploadBudget;
+    uploadBudget = SIZE_MAX;
+    while(true)
+    {
+        update();
+        if(uploads.empty() && inbox->pending == 0)
+        {
+            std::lock_guard<std::mutex> lock(inbox->mutex);
+            if(inbox->decoded.empty())
+            {
+                break;
+            }
+        }
+        if(!uploads.empty() && stagingRing.hasPendingFences())
+        {
+            stagingRing.retire(true);
+        }
+        else
+        {
+            std::this_thread::yield();
+        }
+    }
+    uploadBudget = oldBudget;
+}
+
+void TextureLoader::setUploadBudget(size_t bytesPerUpdate)
+{
+    uploadBudget = bytesPerUpdate;
+}
+
+TextureLoader::Stats TextureLoader::getStats() const
+{
+    Stats current = stats;
+    current.pendingDecodes = inbox->pending;
+    current.pendingUploads = uploads.size();
+    return current;
+}
+
+void TextureLoader::startUpload(Decoded&& decoded)
+{
+    auto target = decoded.target.lock();
+    if(target == nullptr)
+    {
+        return;
+    }
+    if(decoded.image.width <= 0 || (decoded.levels.empty() && !decoded.image.valid()))
+    {
+        target->failed = true;
+        return;
+    }
+    target->width = decoded.image.width;
+    target->height = decoded.image.height;
+
+    Upload& upload = uploads.emplace_back(Upload{.source = std::move(decoded)});
+    const Image& image = upload.source.image;
+    const bool mipMap = upload.source.mipMap;
+    GLenum internalFormat = 0;
+    if(!image.isHdr)
+    {
+        internalFormat = image.internalFormat();
+        upload.dataFormat = image.dataFormat();
+        upload.dataType = image.dataType();
+        upload.bytesPerTexel = image.bytesPerPixel();
+    }
+    else
+    {
+        const HDRStorage storage = upload.source.hdrStorage;
+        internalFormat = hdrInternalFormat(storage, image.channels);
+        upload.dataFormat = hdrDataFormat(storage, image.channels);
+        upload.dataType = hdrDataType(storage);
+        upload.bytesPerTexel = storage == HDRStorage::Float32 ? image.bytesPerPixel() : sizeof(uint32_t);
+    }
+    upload.levelCount = std::max(static_cast<int>(upload.source.levels.size()), 1);
+    upload.texture.emplace(TextureDesc{
+        .name = upload.source.name.c_str(),
+        .levels = mipMap ? fullMipChainLevels(image.width, image.height) : 1,
+        .width = image.width,
+        .height = image.height,
+        .internalFormat = internalFormat,
+        .minFilter = mipMap ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR});
+}
+
+size_t TextureLoader::uploadRows(Upload& upload, size_t budget)
+{
+    const Decoded& source = upload.source;
+    const int level = upload.level;
+    const int width = std::max(source.image.width >> level, 1);
+    const int height = std::max(source.image.height >> level, 1);
+    const uint8_t* texels =
+        source.levels.empty() ? source.image.pixels.get() : source.levels[level].data();
+    const size_t rowSize = width * upload.bytesPerTexel;
+    const int remainingRows = height - upload.uploadedRows;
+    const GLuint textureID = upload.texture->getTextureID();
+
+    // keep chunks well below the ring size so a chunk always fits once the ring drained
+    const size_t maxChunk = stagingRing.getSize() / 4;
+    if(rowSize > maxChunk)
+    {
+        // single row does not even fit, fall back to uploading straight from client memory
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        glTextureSubImage2D(
+            textureID, level, 0, 0, width, height, upload.dataFormat, upload.dataType, texels);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, stagingRing.getBufferID());
+        upload.uploadedRows = height;
+        return rowSize * height;
+    }
+
+    // always upload at least one row, otherwise rows larger than the budget would never make progress
+    const size_t rowsInBudget = std::max<size_t>(std::min(budget, maxChunk) / rowSize, 1);
+    const int rows = static_cast<int>(std::min<size_t>(rowsInBudget, remainingRows));
+    const size_t bytes = rows * rowSize;
+
+    StagingRing::Allocation staging = stagingRing.allocate(bytes);
+    if(staging.ptr == nullptr)
+    {
+        return 0;
+    }
+    memcpy(staging.ptr, texels + upload.uploadedRows * rowSize, bytes);
+    glTextureSubImage2D(
+        textureID,
+        level,
+        0,
+        upload.uploadedRows,
+        width,
+        rows,
+        upload.dataFormat,
+        upload.dataType,
+        reinterpret_cast<const void*>(staging.offset)); // NOLINT(performance-no-int-to-ptr)
+    upload.uploadedRows += rows;
+    return bytes;
+}
+
+void TextureLoader::completeUpload(Upload& upload)
+{
+    auto target = upload.source.target.lock();
+    if(target == nullptr)
+    {
+        return;
+    }
+    target->texture = std::move(upload.texture);
+    target->textureID = target->texture->getTextureID();
+    stats.completed++;
+}
@@ -0,0 +1,179 @@
+#pragma once
+
+#include <glad/glad/glad.h>
+
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <intern/Buffer/StagingRing.h>
+
+#include "GLTexture.h"
+#include "HDRPacking.h"
+#include "Image.h"
+#include "Texture.h"
+
+class ThreadPool;
+
+/** Handle to a texture that is loaded in the background by a TextureLoader.
+ * Can be bound right away, until the upload has finished the loaders placeholder texture is used.
+ * The handle shares ownership of that placeholder, so it stays valid even if the loader is destroyed first.
+ */
+class AsyncTexture : public GLTexture
+{
+  public:
+    AsyncTexture(const AsyncTexture&) = delete;
+    AsyncTexture& operator=(const AsyncTexture&) = delete;
+    AsyncTexture(AsyncTexture&&) = delete;
+    AsyncTexture& operator=(AsyncTexture&&) = delete;
+    ~AsyncTexture() = default;
+
+    /* true once all texel data has been uploaded and getTextureID() returns the actual texture */
+    [[nodiscard]] inline bool isReady() const
+    {
+        return texture.has_value();
+    }
+
+    /* true if the image could not be loaded, the placeholder then stays bound forever */
+    [[nodiscard]] inline bool hasFailed() const
+    {
+        return failed;
+    }
+
+    /* -1 until the image has been decoded */
+    [[nodiscard]] inline int getWidth() const
+    {
+        return width;
+    }
+
+    [[nodiscard]] inline int getHeight() const
+    {
+        return height;
+    }
+
+  private:
+    friend class TextureLoader;
+    explicit AsyncTexture(std::shared_ptr<const Texture> placeholderTexture)
+        : placeholder(std::move(placeholderTexture))
+    {
+        textureID = placeholder->getTextureID();
+    }
+
+    std::shared_ptr<const Texture> placeholder;
+    std::optional<Texture> texture;
+    int width = -1;
+    int height = -1;
+    bool failed = false;
+};
+
+/** Loads textures without stalling the render thread:
+ * Images are decoded on a ThreadPool, the decoded texels are copied into a persistently mapped
+ * staging ring on the GL thread and uploaded from there, at most uploadBudget bytes per update().
+ * Large images are split into row ranges across multiple frames.
+ * Mip chains are generated on the pool as well (see MipGenerator.h), HDR images are packed there
+ * (see HDRPacking.h).
+ */
+class TextureLoader
+{
+  public:
+    struct Stats
+    {
+        size_t bytesUploadedLastUpdate = 0;
+        size_t totalBytesUploaded = 0;
+        size_t pendingDecodes = 0;
+        size_t pendingUploads = 0;
+        size_t completed = 0;
+    };
+
+    /**
+     * @param pool Pool used for decoding, needs to outlive the loader
+     * @param stagingSize Size of the persistently mapped staging ring in bytes
+     * @param uploadBudget Max amount of bytes uploaded during one update()
+     */
+    explicit TextureLoader(
+        ThreadPool& pool, size_t stagingSize = 64ull << 20u, size_t uploadBudget = 16ull << 20u);
+    ~TextureLoader() = default;
+
+    TextureLoader(TextureLoader&&) = delete;
+    TextureLoader(const TextureLoader&) = delete;
+    TextureLoader& operator=(TextureLoader&&) = delete;
+    TextureLoader& operator=(const TextureLoader&) = delete;
+
+    /** Queues an image file for loading. Needs to be called from the GL thread.
+     * @param file Path of the image file
+     * @param mipMap True if the mip chain should be generated (on the pool) and uploaded as well
+     * @param hdrStorage How HDR images are stored on the GPU, ignored for LDR images
+     */
+    std::shared_ptr<AsyncTexture>
+    load(const std::string& file, bool mipMap, HDRStorage hdrStorage = HDRStorage::RGB9E5);
+
+    /** Uploads decoded images within the budget. Call once per frame on the GL thread.
+     */
+    void update();
+
+    /** Blocks until all queued textures are ready (eg. for loading screens)
+     */
+    void finish();
+
+    void setUploadBudget(size_t bytesPerUpdate);
+
+    [[nodiscard]] Stats getStats() const;
+
+    [[nodiscard]] inline const Texture& getPlaceholder() const
+    {
+        return *placeholder;
+    }
+
+  private:
+    struct Decoded
+    {
+        std::weak_ptr<AsyncTexture> target;
+        std::string name;
+        Image image;
+        // texels of every level, level 0 first, the image pixels are released once these are built.
+        // Empty for LDR images without mips, those upload image.pixels directly
+        std::vector<std::vector<uint8_t>> levels;
+        HDRStorage hdrStorage = HDRStorage::RGB9E5;
+        bool mipMap = false;
+    };
+
+    // shared with the decode jobs, so that jobs finishing after the loader was destroyed are harmless
+    struct Inbox
+    {
+        std::mutex mutex;
+        std::vector<Decoded> decoded;
+        std::atomic<size_t> pending{0};
+    };
+
+    struct Upload
+    {
+        Decoded source;
+        std::optional<Texture> texture;
+        int levelCount = 1;
+        GLenum dataFormat = 0;
+        GLenum dataType = 0;
+        size_t bytesPerTexel = 0;
+        // level and rows of that level that are already uploaded
+        int level = 0;
+        int uploadedRows = 0;
+    };
+
+    void startUpload(Decoded&& decoded);
+    // returns the amount of bytes uploaded, 0 if no staging memory was available
+    size_t uploadRows(Upload& upload, size_t budget);
+    void completeUpload(Upload& upload);
+
+    ThreadPool& pool;
+    std::shared_ptr<Inbox> inbox;
+    StagingRing stagingRing;
+    // shared with every handle, which may outlive the loader
+    std::shared_ptr<const Texture> placeholder;
+    std::deque<Upload> uploads;
+    size_t uploadBudget;
+    Stats stats;
+};
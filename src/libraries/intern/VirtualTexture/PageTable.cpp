@@ -0,0 +1,155 @@
+#include "PageTable.h"
+
+#include <algorithm>
+#include <cassert>
+
+namespace
+{
+    constexpr uint32_t unmapped = 0;
+
+    uint32_t makeEntry(int tileX, int tileY, int level)
+    {
+        return static_cast<uint32_t>(tileX) | static_cast<uint32_t>(tileY) << 8u |
+               static_cast<uint32_t>(level) << 16u | 0xFFu << 24u;
+    }
+
+    int entryLevel(uint32_t entry)
+    {
+        return static_cast<int>((entry >> 16u) & 0xFFu);
+    }
+} // namespace
+
+PageTable::PageTable(int pagesX, int pagesY, int levelCount, const char* name)
+    : texture(TextureDesc{
+          .name = name,
+          .levels = levelCount,
+          .width = pagesX,
+          .height = pagesY,
+          .internalFormat = GL_RGBA8UI,
+          .minFilter = GL_NEAREST_MIPMAP_NEAREST,
+          .magFilter = GL_NEAREST,
+          .wrapS = GL_CLAMP_TO_EDGE,
+          .wrapT = GL_CLAMP_TO_EDGE})
+{
+    levels.resize(levelCount);
+    for(int level = 0; level < levelCount; level++)
+    {
+        Level& entry = levels[level];
+        entry.width = std::max(pagesX >> level, 1);
+        entry.height = std::max(pagesY >> level, 1);
+        entry.entries.assign(static_cast<size_t>(entry.width) * entry.height, unmapped);
+        // upload the cleared level once
+        entry.minX = 0;
+        entry.minY = 0;
+        entry.maxX = entry.width;
+        entry.maxY = entry.height;
+    }
+}
+
+template <typename Func>
+void PageTable::forEachCovered(PageID page, int level, Func&& func)
+{
+    Level& target = levels[level];
+    const int scale = 1 << (page.level - level);
+    const int x0 = page.x * scale;
+    const int y0 = page.y * scale;
+    const int x1 = std::min(x0 + scale, target.width);
+    const int y1 = std::min(y0 + scale, target.height);
+    bool changed = false;
+    for(int y = y0; y < y1; y++)
+    {
+        for(int x = x0; x < x1; x++)
+        {
+            changed |= func(target.entries[static_cast<size_t>(y) * target.width + x]);
+        }
+    }
+    if(changed)
+    {
+        const bool empty = target.minX >= target.maxX;
+        target.minX = empty ? x0 : std::min(target.minX, x0);
+        target.minY = empty ? y0 : std::min(target.minY, y0);
+        target.maxX = empty ? x1 : std::max(target.maxX, x1);
+        target.maxY = empty ? y1 : std::max(target.maxY, y1);
+    }
+}
+
+void PageTable::map(PageID page, int tileX, int tileY)
+{
+    assert(page.level < getLevelCount());
+    const uint32_t entry = makeEntry(tileX, tileY, page.level);
+    for(int level = page.level; level >= 0; level--)
+    {
+        forEachCovered(
+            page,
+            level,
+            [&](uint32_t& current)
+            {
+                // finer texels keep pointing to finer pages that are already resident
+                if(current != unmapped && entryLevel(current) < page.level)
+                {
+                    return false;
+                }
+                current = entry;
+                return true;
+            });
+    }
+}
+
+void PageTable::unmap(PageID page)
+{
+    assert(page.level < getLevelCount());
+    const PageID parent = page.parent();
+    uint32_t fallback = unmapped;
+    if(parent.level < getLevelCount())
+    {
+        const Level& parentLevel = levels[parent.level];
+        fallback = parentLevel.entries[static_cast<size_t>(parent.y) * parentLevel.width + parent.x];
+    }
+    for(int level = page.level; level >= 0; level--)
+    {
+        forEachCovered(
+            page,
+            level,
+            [&](uint32_t& current)
+            {
+                // the only page of that level covering these texels is the evicted one
+                if(current == unmapped || entryLevel(current) != page.level)
+                {
+                    return false;
+                }
+                current = fallback;
+                return true;
+            });
+    }
+}
+
+size_t PageTable::upload()
+{
+    size_t bytes = 0;
+    for(int level = 0; level < getLevelCount(); level++)
+    {
+        Level& entry = levels[level];
+        if(entry.minX >= entry.maxX)
+        {
+            continue;
+        }
+        const int width = entry.maxX - entry.minX;
+        const int height = entry.maxY - entry.minY;
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, entry.width);
+        glTextureSubImage2D(
+            texture.getTextureID(),
+            level,
+            entry.minX,
+            entry.minY,
+            width,
+            height,
+            GL_RGBA_INTEGER,
+            GL_UNSIGNED_BYTE,
+            &entry.entries[static_cast<size_t>(entry.minY) * entry.width + entry.minX]);
+        bytes += static_cast<size_t>(width) * height * sizeof(uint32_t);
+        entry.maxX = 0;
+        entry.minX = 0;
+    }
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+    return bytes;
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <glad/glad/glad.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <intern/Texture/Texture.h>
+
+/* Page of a virtual texture, packed into 32 bits as level << 28 | y << 14 | x
+ * (the same packing is written by the feedback shader)
+ */
+struct PageID
+{
+    int level = 0;
+    int x = 0;
+    int y = 0;
+
+    constexpr static uint32_t invalid = 0xFFFFFFFF;
+
+    [[nodiscard]] inline uint32_t pack() const
+    {
+        return static_cast<uint32_t>(level) << 28u | static_cast<uint32_t>(y) << 14u |
+               static_cast<uint32_t>(x);
+    }
+
+    [[nodiscard]] inline static PageID unpack(uint32_t packed)
+    {
+        return {
+            .level = static_cast<int>(packed >> 28u),
+            .x = static_cast<int>(packed & 0x3FFFu),
+            .y = static_cast<int>((packed >> 14u) & 0x3FFFu)};
+    }
+
+    [[nodiscard]] inline PageID parent() const
+    {
+        return {.level = level + 1, .x = x / 2, .y = y / 2};
+    }
+};
+
+/** Indirection texture of a virtual texture, one texel per page and a mip level per virtual level.
+ * Every texel holds the tile (in the physical tile cache) of the finest resident page covering it,
+ * as rgba8ui: x, y, level of that page, 255 (0 if nothing is resident yet).
+ * Kept on the CPU as well, only the changed rectangles are uploaded.
+ */
+class PageTable
+{
+  public:
+    PageTable(int pagesX, int pagesY, int levelCount, const char* name = "");
+
+    PageTable(PageTable&&) = delete;
+    PageTable(const PageTable&) = delete;
+    PageTable& operator=(PageTable&&) = delete;
+    PageTable& operator=(const PageTable&) = delete;
+
+    /* Page got resident in the given tile, updates its texel and all finer ones that used a coarser page */
+    void map(PageID page, int tileX, int tileY);
+
+    /* Page got evicted, texels that pointed to it fall back to the entry of its parent */
+    void unmap(PageID page);
+
+    /* Uploads the changed rectangle of every level, returns the uploaded bytes.
+     * Expects no buffer to be bound to GL_PIXEL_UNPACK_BUFFER
+     */
+    size_t upload();
+
+    [[nodiscard]] inline const Texture& getTexture() const
+    {
+        return texture;
+    }
+
+    [[nodiscard]] inline int getLevelCount() const
+    {
+        return static_cast<int>(levels.size());
+    }
+
+  private:
+    struct Level
+    {
+        int width;
+        int height;
+        std::vector<uint32_t> entries;
+        // changed rectangle, [minX, maxX) x [minY, maxY), empty if minX >= maxX
+        int minX = 0;
+        int minY = 0;
+        int maxX = 0;
+        int maxY = 0;
+    };
+
+    /* calls func(entry) for all texels of level that are covered by page */
+    template <typename Func>
+    void forEachCovered(PageID page, int level, Func&& func);
+
+    Texture texture;
+    std::vector<Level> levels;
+};
@@ -0,0 +1,92 @@
+#include "TileCache.h"
+#include "PageTable.h"
+
+#include <cassert>
+
+TileCache::TileCache(int tilesX, int tilesY) : tilesX(tilesX)
+{
+    tiles.resize(static_cast<size_t>(tilesX) * tilesY);
+    for(int tile = 0; tile < getTileCount(); tile++)
+    {
+        tiles[tile].page = PageID::invalid;
+        tiles[tile].position = lru.insert(lru.end(), tile);
+    }
+}
+
+int TileCache::find(uint32_t page) const
+{
+    const auto it = lookup.find(page);
+    return it == lookup.end() ? noTile : it->second;
+}
+
+void TileCache::touch(int tile, uint64_t frame)
+{
+    Tile& entry = tiles[tile];
+    entry.lastUsedFrame = frame;
+    lru.splice(lru.begin(), lru, entry.position);
+}
+
+bool TileCache::canAllocate(uint64_t frame) const
+{
+    return findVictim(frame) != noTile;
+}
+
+int TileCache::allocate(uint32_t page, uint64_t frame, uint32_t& evictedPage)
+{
+    assert(find(page) == noTile);
+    evictedPage = PageID::invalid;
+
+    const int tile = findVictim(frame);
+    if(tile == noTile)
+    {
+        return noTile;
+    }
+
+    Tile& entry = tiles[tile];
+    if(entry.page != PageID::invalid)
+    {
+        evictedPage = entry.page;
+        lookup.erase(entry.page);
+    }
+    entry.page = page;
+    lookup[page] = tile;
+    touch(tile, frame);
+    return tile;
+}
+
+int TileCache::findVictim(uint64_t frame) const
+{
+    // the least recently used tiles are at the back, pinned ones are skipped
+    // (there are only a few of them and they are touched every frame anyways)
+    for(auto it = lru.rbegin(); it != lru.rend(); ++it)
+    {
+        const Tile& candidate = tiles[*it];
+        if(candidate.pinned)
+        {
+            continue;
+        }
+        if(candidate.page != PageID::invalid && candidate.lastUsedFrame >= frame)
+        {
+            // everything in front of it was used this frame as well
+            return noTile;
+        }
+        return *it;
+    }
+    return noTile;
+}
+
+void TileCache::release(int tile)
+{
+    Tile& entry = tiles[tile];
+    assert(entry.page != PageID::invalid && !entry.pinned);
+    lookup.erase(entry.page);
+    entry.page = PageID::invalid;
+    entry.lastUsedFrame = 0;
+    // free tiles are kept at the back
+    lru.splice(lru.end(), lru, entry.position);
+}
+
+void TileCache::pin(int tile)
+{
+    tiles[tile].pinned = true;
+}
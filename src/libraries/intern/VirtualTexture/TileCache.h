@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstdint>
+#include <list>
+#include <unordered_map>
+#include <vector>
+
+/** Bookkeeping of the tiles of a physical tile cache texture with least recently used eviction.
+ * Does not touch OpenGL, tiles are identified by their index (x + y * tilesX).
+ */
+class TileCache
+{
+  public:
+    constexpr static int noTile = -1;
+
+    TileCache(int tilesX, int tilesY);
+
+    /* tile holding the page, noTile if it is not resident */
+    [[nodiscard]] int find(uint32_t page) const;
+
+    /* Marks the tile as used in the given frame (moves it to the front of the LRU order) */
+    void touch(int tile, uint64_t frame);
+
+    /** Assigns a tile to a page that is not resident yet. Free tiles are used first, otherwise the least
+     * recently used one, unless it was already used in the given frame or is pinned.
+     * @param evictedPage Set to the page that was evicted or to PageID::invalid
+     * @return The tile or noTile if all of them are in use
+     */
+    int allocate(uint32_t page, uint64_t frame, uint32_t& evictedPage);
+
+    /* true if allocate() would succeed, without evicting anything */
+    [[nodiscard]] bool canAllocate(uint64_t frame) const;
+
+    /* Frees the tile again, eg. if the page could not be uploaded after all */
+    void release(int tile);
+
+    /* pinned tiles are never evicted */
+    void pin(int tile);
+
+    [[nodiscard]] inline int getTilesX() const
+    {
+        return tilesX;
+    }
+
+    [[nodiscard]] inline int getTileCount() const
+    {
+        return static_cast<int>(tiles.size());
+    }
+
+    [[nodiscard]] inline int getResidentCount() const
+    {
+        return static_cast<int>(lookup.size());
+    }
+
+  private:
+    /* tile allocate() would hand out, noTile if all of them are in use */
+    [[nodiscard]] int findVictim(uint64_t frame) const;
+
+    struct Tile
+    {
+        uint32_t page;
+        uint64_t lastUsedFrame = 0;
+        bool pinned = false;
+        // position in lru
+        std::list<int>::iterator position;
+    };
+
+    int tilesX;
+    std::vector<Tile> tiles;
+    // most recently used first, contains every tile (free ones have an invalid page and are kept at the back)
+    std::list<int> lru;
+    std::unordered_map<uint32_t, int> lookup;
+};
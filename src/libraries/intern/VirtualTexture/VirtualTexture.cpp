@@ -0,0 +1,396 @@
+#include "VirtualTexture.h"
+
+#include <intern/Misc/GPUMemoryTracker.h>
+#include <intern/Misc/ThreadPool.h>
+#include <intern/Texture/Image.h>
+#include <intern/Texture/MipGenerator.h>
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+namespace
+{
+    int levelCountFor(int pagesX, int pagesY)
+    {
+        // coarsest level still has at least one page in both directions
+        return std::bit_width(static_cast<unsigned int>(std::min(pagesX, pagesY)));
+    }
+} // namespace
+
+VirtualTexture::VirtualTexture(const VirtualTextureDesc& desc, PageProvider provider, ThreadPool& pool)
+    : desc(desc), pagesX(desc.width / desc.pageSize), pagesY(desc.height / desc.pageSize), pool(pool),
+      inbox(std::make_shared<Inbox>()),
+      physicalTexture(TextureDesc{
+          .name = desc.name,
+          .width = desc.cacheTilesX * (desc.pageSize + 2 * desc.border),
+          .height = desc.cacheTilesY * (desc.pageSize + 2 * desc.border),
+          .internalFormat = desc.internalFormat,
+          .wrapS = GL_CLAMP_TO_EDGE,
+          .wrapT = GL_CLAMP_TO_EDGE}),
+      pageTable(pagesX, pagesY, levelCountFor(pagesX, pagesY), "VirtualTexture PageTable"),
+      tileCache(desc.cacheTilesX, desc.cacheTilesY),
+      // enough for a frame of uploads with some slack for the GPU to catch up
+      stagingRing(tileBytes() * desc.maxUploadsPerFrame * 3, "VirtualTexture Staging"),
+      feedbackFramebuffer(
+          std::max(desc.viewportWidth / desc.feedbackDivisor, 1),
+          std::max(desc.viewportHeight / desc.feedbackDivisor, 1),
+          {GL_R32UI},
+          true),
+      feedbackWidth(std::max(desc.viewportWidth / desc.feedbackDivisor, 1)),
+      feedbackHeight(std::max(desc.viewportHeight / desc.feedbackDivisor, 1))
+{
+    assert(std::has_single_bit(static_cast<unsigned int>(pagesX)) && pagesX * desc.pageSize == desc.width);
+    assert(std::has_single_bit(static_cast<unsigned int>(pagesY)) && pagesY * desc.pageSize == desc.height);
+    assert(pagesX <= 0x3FFF && pagesY <= 0x3FFF && "PageID packing only has 14 bits per axis");
+    assert(desc.cacheTilesX <= 256 && desc.cacheTilesY <= 256 && "PageTable entries have 8 bits per axis");
+    assert((desc.internalFormat == GL_RGBA8 || desc.internalFormat == GL_SRGB8_ALPHA8) &&
+           "Pages are uploaded as GL_RGBA / GL_UNSIGNED_BYTE");
+    inbox->provider = std::move(provider);
+
+    const size_t feedbackBytes = static_cast<size_t>(feedbackWidth) * feedbackHeight * sizeof(uint32_t);
+    for(Readback& readback : readbacks)
+    {
+        constexpr GLbitfield flags = GL_MAP_READ_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glCreateBuffers(1, &readback.buffer);
+        glNamedBufferStorage(
+            readback.buffer, static_cast<GLsizeiptr>(feedbackBytes), nullptr, flags | GL_CLIENT_STORAGE_BIT);
+        GPUMemoryTracker::get().trackBuffer(readback.buffer, GPUMemoryCategory::Staging, feedbackBytes);
+        readback.mapped = static_cast<const uint32_t*>(
+            glMapNamedBufferRange(readback.buffer, 0, static_cast<GLsizeiptr>(feedbackBytes), flags));
+    }
+
+    // coarsest level is loaded right away and stays resident, so every texel has a fallback
+    const int coarsestLevel = pageTable.getLevelCount() - 1;
+    const int coarsePagesX = pagesX >> coarsestLevel;
+    const int coarsePagesY = pagesY >> coarsestLevel;
+    if(coarsePagesX * coarsePagesY > tileCache.getTileCount())
+    {
+        std::cout << "VirtualTexture: tile cache is too small to even hold the coarsest level" << std::endl;
+        assert(false && "VirtualTexture tile cache too small");
+        return;
+    }
+    for(int y = 0; y < coarsePagesY; y++)
+    {
+        for(int x = 0; x < coarsePagesX; x++)
+        {
+            const PageID page{.level = coarsestLevel, .x = x, .y = y};
+            LoadedPage loaded{.page = page.pack(), .texels = std::vector<uint8_t>(tileBytes())};
+            inbox->provider(page, loaded.texels.data());
+            readyPages.push_back(std::move(loaded));
+        }
+    }
+    while(!readyPages.empty())
+    {
+        const uint32_t page = readyPages.front().page;
+        if(!uploadPage(readyPages.front()))
+        {
+            // ring is sized for multiple frames of uploads, only happens with a tiny maxUploadsPerFrame
+            stagingRing.fence();
+            stagingRing.retire(true);
+            continue;
+        }
+        tileCache.pin(tileCache.find(page));
+        readyPages.pop_front();
+    }
+    stagingRing.fence();
+    pageTable.upload();
+}
+
+VirtualTexture::~VirtualTexture()
+{
+    for(Readback& readback : readbacks)
+    {
+        if(readback.fence != nullptr)
+        {
+            glDeleteSync(readback.fence);
+        }
+        glUnmapNamedBuffer(readback.buffer);
+        GPUMemoryTracker::get().untrackBuffer(readback.buffer);
+        glDeleteBuffers(1, &readback.buffer);
+    }
+}
+
+void VirtualTexture::beginFeedback()
+{
+    feedbackFramebuffer.bind();
+    constexpr GLuint noPage = PageID::invalid;
+    glClearBufferuiv(GL_COLOR, 0, &noPage);
+    glClear(GL_DEPTH_BUFFER_BIT);
+}
+
+void VirtualTexture::endFeedback()
+{
+    Readback& readback = readbacks[nextReadback % readbacks.size()];
+    if(readback.fence != nullptr)
+    {
+        // all readbacks are still in flight, skip this frames feedback instead of stalling
+        return;
+    }
+    const size_t bytes = static_cast<size_t>(feedbackWidth) * feedbackHeight * sizeof(uint32_t);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.buffer);
+    glGetTextureImage(
+        feedbackFramebuffer.getColorTextures()[0].getTextureID(),
+        0,
+        GL_RED_INTEGER,
+        GL_UNSIGNED_INT,
+        static_cast<GLsizei>(bytes),
+        nullptr);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    readback.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    nextReadback++;
+}
+
+void VirtualTexture::update()
+{
+    frame++;
+    stats.uploadedPages = 0;
+    stats.uploadedBytes = 0;
+    stats.evictions = 0;
+    stagingRing.retire();
+
+    // newest finished readback wins, older ones are outdated anyways
+    const uint32_t* feedback = nullptr;
+    while(oldestReadback != nextReadback)
+    {
+        Readback& readback = readbacks[oldestReadback % readbacks.size()];
+        const GLenum status = glClientWaitSync(readback.fence, 0, 0);
+        if(status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+        {
+            break;
+        }
+        glDeleteSync(readback.fence);
+        readback.fence = nullptr;
+        feedback = readback.mapped;
+        oldestReadback++;
+    }
+    if(feedback != nullptr)
+    {
+        analyseFeedback(feedback);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(inbox->mutex);
+        for(LoadedPage& loaded : inbox->loaded)
+        {
+            readyPages.push_back(std::move(loaded));
+        }
+        inbox->loaded.clear();
+    }
+    while(!readyPages.empty() && static_cast<int>(stats.uploadedPages) < desc.maxUploadsPerFrame)
+    {
+        if(!uploadPage(readyPages.front()))
+        {
+            break;
+        }
+        pendingLoads.erase(readyPages.front().page);
+        readyPages.pop_front();
+    }
+    stagingRing.fence();
+    stats.uploadedBytes += pageTable.upload();
+
+    stats.residentPages = tileCache.getResidentCount();
+    stats.pendingLoads = pendingLoads.size();
+}
+
+void VirtualTexture::bind(GLuint physicalUnit, GLuint pageTableUnit) const
+{
+    glBindTextureUnit(physicalUnit, physicalTexture.getTextureID());
+    glBindTextureUnit(pageTableUnit, pageTable.getTexture().getTextureID());
+}
+
+void VirtualTexture::setUniforms(GLint location) const
+{
+    const int tileSize = desc.pageSize + 2 * desc.border;
+    glUniform4ui(location, pagesX, pagesY, pageTable.getLevelCount(), 0);
+    glUniform4f(
+        location + 1,
+        static_cast<float>(desc.pageSize),
+        static_cast<float>(desc.border),
+        1.0f / static_cast<float>(desc.cacheTilesX * tileSize),
+        1.0f / static_cast<float>(desc.cacheTilesY * tileSize));
+}
+
+void VirtualTexture::setFeedbackUniforms(GLint location) const
+{
+    setUniforms(location);
+    // derivatives in the feedback pass are feedbackDivisor times larger than in the actual pass
+    glUniform1f(location + 2, -std::log2(static_cast<float>(desc.feedbackDivisor)));
+}
+
+void VirtualTexture::analyseFeedback(const uint32_t* feedback)
+{
+    // neighbouring pixels mostly request the same page, sorting a copy is cheaper than hashing every pixel
+    std::vector<uint32_t> pages(feedback, feedback + static_cast<size_t>(feedbackWidth) * feedbackHeight);
+    std::sort(pages.begin(), pages.end());
+    pages.erase(std::unique(pages.begin(), pages.end()), pages.end());
+    if(!pages.empty() && pages.back() == PageID::invalid)
+    {
+        pages.pop_back();
+    }
+
+    stats.requestedPages = pages.size();
+    stats.hits = 0;
+    std::vector<uint32_t> missing;
+    std::unordered_set<uint32_t> visited;
+    for(const uint32_t packed : pages)
+    {
+        PageID page = PageID::unpack(packed);
+        if(page.level >= pageTable.getLevelCount() || (page.x >= (pagesX >> page.level)) ||
+           (page.y >= (pagesY >> page.level)))
+        {
+            continue;
+        }
+        const int tile = tileCache.find(packed);
+        stats.hits += tile != TileCache::noTile ? 1 : 0;
+
+        // parents are needed as well, they are what gets sampled until the page itself is resident
+        for(; page.level < pageTable.getLevelCount(); page = page.parent())
+        {
+            const uint32_t key = page.pack();
+            if(!visited.insert(key).second)
+            {
+                break;
+            }
+            const int residentTile = tileCache.find(key);
+            if(residentTile != TileCache::noTile)
+            {
+                tileCache.touch(residentTile, frame);
+            }
+            else
+            {
+                missing.push_back(key);
+            }
+        }
+    }
+    stats.hitRate = stats.requestedPages > 0
+                        ? static_cast<float>(stats.hits) / static_cast<float>(stats.requestedPages)
+                        : 1.0f;
+
+    // coarse pages first, they cover the most screen space and are the fallback of the finer ones
+    std::stable_sort(
+        missing.begin(), missing.end(), [](uint32_t a, uint32_t b) { return (a >> 28u) > (b >> 28u); });
+    for(const uint32_t page : missing)
+    {
+        if(static_cast<int>(pendingLoads.size()) >= desc.maxPendingLoads)
+        {
+            break;
+        }
+        requestPage(page);
+    }
+}
+
+void VirtualTexture::requestPage(uint32_t page)
+{
+    if(!pendingLoads.insert(page).second)
+    {
+        return;
+    }
+    pool.enqueue(
+        [inbox = inbox, page, bytes = tileBytes()]()
+        {
+            LoadedPage loaded{.page = page, .texels = std::vector<uint8_t>(bytes)};
+            inbox->provider(PageID::unpack(page), loaded.texels.data());
+            std::lock_guard<std::mutex> lock(inbox->mutex);
+            inbox->loaded.push_back(std::move(loaded));
+        });
+}
+
+bool VirtualTexture::uploadPage(const LoadedPage& page)
+{
+    if(tileCache.find(page.page) != TileCache::noTile)
+    {
+        return true;
+    }
+    // the tile first, so no staging space is wasted on pages that are dropped
+    uint32_t evicted = PageID::invalid;
+    const int tile = tileCache.allocate(page.page, frame, evicted);
+    if(tile == TileCache::noTile)
+    {
+        // everything resident is in use, drop the page, it is requested again if it is still visible
+        // once the view changed
+        return true;
+    }
+    if(evicted != PageID::invalid)
+    {
+        pageTable.unmap(PageID::unpack(evicted));
+        stats.evictions++;
+    }
+    StagingRing::Allocation staging = stagingRing.allocate(tileBytes());
+    if(staging.ptr == nullptr)
+    {
+        // the page would count as resident without its texels otherwise, it is retried later
+        tileCache.release(tile);
+        return false;
+    }
+
+    const int tileSize = desc.pageSize + 2 * desc.border;
+    const int tileX = tile % tileCache.getTilesX();
+    const int tileY = tile / tileCache.getTilesX();
+    memcpy(staging.ptr, page.texels.data(), tileBytes());
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, stagingRing.getBufferID());
+    glTextureSubImage2D(
+        physicalTexture.getTextureID(),
+        0,
+        tileX * tileSize,
+        tileY * tileSize,
+        tileSize,
+        tileSize,
+        GL_RGBA,
+        GL_UNSIGNED_BYTE,
+        reinterpret_cast<const void*>(staging.offset)); // NOLINT(performance-no-int-to-ptr)
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    pageTable.map(PageID::unpack(page.page), tileX, tileY);
+
+    stats.uploadedPages++;
+    stats.uploadedBytes += tileBytes();
+    return true;
+}
+
+size_t VirtualTexture::tileBytes() const
+{
+    // RGBA8, see the assert in the constructor
+    const size_t tileSize = desc.pageSize + 2 * desc.border;
+    return tileSize * tileSize * 4;
+}
+
+VirtualTexture::PageProvider imagePageProvider(const Image& image, int pageSize, int border, ThreadPool* pool)
+{
+    assert(image.valid() && !image.isHdr);
+
+    // expand to rgba once, then let the mip generator build the levels
+    std::vector<uint8_t> rgba(static_cast<size_t>(image.width) * image.height * 4, 255);
+    for(size_t i = 0; i < rgba.size() / 4; i++)
+    {
+        for(int c = 0; c < std::min(image.channels, 4); c++)
+        {
+            rgba[i * 4 + c] = image.pixels.get()[i * image.channels + c];
+        }
+    }
+    auto levels = std::make_shared<const std::vector<std::vector<uint8_t>>>(
+        generateMipChain(rgba.data(), image.width, image.height, 4, {}, pool));
+
+    return [levels, width = image.width, height = image.height, pageSize, border](
+               PageID page, uint8_t* texels)
+    {
+        const int levelWidth = std::max(width >> page.level, 1);
+        const int levelHeight = std::max(height >> page.level, 1);
+        const std::vector<uint8_t>& level = (*levels)[page.level];
+        const int tileSize = pageSize + 2 * border;
+        for(int y = 0; y < tileSize; y++)
+        {
+            const int sourceY = ((page.y * pageSize + y - border) % levelHeight + levelHeight) % levelHeight;
+            for(int x = 0; x < tileSize; x++)
+            {
+                const int sourceX = ((page.x * pageSize + x - border) % levelWidth + levelWidth) % levelWidth;
+                memcpy(
+                    texels + (static_cast<size_t>(y) * tileSize + x) * 4,
+                    &level[(static_cast<size_t>(sourceY) * levelWidth + sourceX) * 4],
+                    4);
+            }
+        }
+    };
+}
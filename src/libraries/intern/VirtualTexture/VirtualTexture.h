@@ -0,0 +1,181 @@
+#pragma once
+
+#include <glad/glad/glad.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <unordered_set>
+#include <vector>
+
+#include <intern/Buffer/StagingRing.h>
+#include <intern/Framebuffer/Framebuffer.h>
+#include <intern/Texture/Texture.h>
+
+#include "PageTable.h"
+#include "TileCache.h"
+
+class ThreadPool;
+struct Image;
+
+struct VirtualTextureDesc
+{
+    const char* name = "";
+    // virtual size in texels, both have to be power of two multiples of pageSize
+    int width = -1;
+    int height = -1;
+    // texels per page side, without the border
+    int pageSize = 128;
+    // texels around each page that are copied from its neighbours, so bilinear filtering does not bleed
+    int border = 4;
+    // size of the physical tile cache texture in tiles (at most 256 each)
+    int cacheTilesX = 16;
+    int cacheTilesY = 16;
+    // GL_RGBA8 or GL_SRGB8_ALPHA8, the PageProvider writes RGBA8 texels either way
+    GLenum internalFormat = GL_RGBA8;
+    // size of the viewport that is rendered with the virtual texture, the feedback pass renders at
+    // viewport size / feedbackDivisor
+    int viewportWidth = -1;
+    int viewportHeight = -1;
+    int feedbackDivisor = 8;
+    // budgets
+    int maxUploadsPerFrame = 16;
+    int maxPendingLoads = 64;
+};
+
+/** Software virtual texturing, no ARB_sparse_texture needed:
+ * Only the pages (fixed size tiles of every mip level) that are actually visible are kept resident
+ * in a physical tile cache texture, an indirection texture (see PageTable) maps virtual pages to tiles.
+ *
+ * Per frame:
+ *  - beginFeedback(), render the scene with VirtualTexture/feedback.frag, endFeedback():
+ *    writes the page every pixel needs into a small R32UI framebuffer, which is read back asynchronously
+ *  - update(): analyses finished feedback readbacks, loads missing pages on the ThreadPool (through the
+ *    PageProvider), uploads finished ones and evicts the least recently used pages if the cache is full
+ *  - bind() and setUniforms(), render the scene with VirtualTexture/virtualTexture.frag
+ *
+ * The coarsest level is loaded on construction and never evicted, so there is always something to sample.
+ */
+class VirtualTexture
+{
+  public:
+    /** Fills the texels of a page including its border ((pageSize + 2 * border)^2 rgba8 texels).
+     * Called on ThreadPool threads, needs to be thread safe.
+     */
+    using PageProvider = std::function<void(PageID page, uint8_t* texels)>;
+
+    struct Stats
+    {
+        // pages requested by the last analysed feedback, and how many of them were resident
+        size_t requestedPages = 0;
+        size_t hits = 0;
+        float hitRate = 1.0f;
+        size_t residentPages = 0;
+        size_t pendingLoads = 0;
+        size_t evictions = 0;
+        size_t uploadedPages = 0;
+        // tiles and indirection texels uploaded in the last update()
+        size_t uploadedBytes = 0;
+    };
+
+    VirtualTexture(const VirtualTextureDesc& desc, PageProvider provider, ThreadPool& pool);
+    ~VirtualTexture();
+
+    VirtualTexture(VirtualTexture&&) = delete;
+    VirtualTexture(const VirtualTexture&) = delete;
+    VirtualTexture& operator=(VirtualTexture&&) = delete;
+    VirtualTexture& operator=(const VirtualTexture&) = delete;
+
+    /* Binds and clears the feedback framebuffer (including the viewport) */
+    void beginFeedback();
+    /* Queues the asynchronous readback of the feedback framebuffer */
+    void endFeedback();
+
+    /* Call once per frame on the GL thread */
+    void update();
+
+    /* Binds the physical tile cache and the page table, see virtualTexture.frag */
+    void bind(GLuint physicalUnit = 0, GLuint pageTableUnit = 1) const;
+    /* Sets the uniforms at location and location + 1, see virtualTexture.frag */
+    void setUniforms(GLint location = 3) const;
+    /* Sets the uniforms at location to location + 2, see feedback.frag */
+    void setFeedbackUniforms(GLint location = 3) const;
+
+    [[nodiscard]] inline const Stats& getStats() const
+    {
+        return stats;
+    }
+
+    [[nodiscard]] inline const Texture& getPhysicalTexture() const
+    {
+        return physicalTexture;
+    }
+
+    [[nodiscard]] inline const Texture& getPageTableTexture() const
+    {
+        return pageTable.getTexture();
+    }
+
+  private:
+    struct LoadedPage
+    {
+        uint32_t page;
+        std::vector<uint8_t> texels;
+    };
+
+    // shared with the load jobs, so that jobs finishing after the virtual texture was destroyed are harmless
+    struct Inbox
+    {
+        PageProvider provider;
+        std::mutex mutex;
+        std::vector<LoadedPage> loaded;
+    };
+
+    struct Readback
+    {
+        GLuint buffer = 0xFFFFFFFF;
+        const uint32_t* mapped = nullptr;
+        GLsync fence = nullptr;
+    };
+
+    void analyseFeedback(const uint32_t* feedback);
+    void requestPage(uint32_t page);
+    // returns false if the page could not be uploaded this frame
+    bool uploadPage(const LoadedPage& page);
+
+    [[nodiscard]] size_t tileBytes() const;
+
+    VirtualTextureDesc desc;
+    int pagesX;
+    int pagesY;
+    ThreadPool& pool;
+    std::shared_ptr<Inbox> inbox;
+
+    Texture physicalTexture;
+    PageTable pageTable;
+    TileCache tileCache;
+    StagingRing stagingRing;
+
+    Framebuffer feedbackFramebuffer;
+    int feedbackWidth;
+    int feedbackHeight;
+    std::array<Readback, 3> readbacks;
+    size_t nextReadback = 0;
+    size_t oldestReadback = 0;
+
+    std::unordered_set<uint32_t> pendingLoads;
+    std::deque<LoadedPage> readyPages;
+    uint64_t frame = 1;
+    Stats stats;
+};
+
+/** Serves the pages of a virtual texture from an image in client memory, eg. for testing or for
+ * textures that fit into RAM but not into VRAM. The image size needs to match the virtual size.
+ * Borders wrap around, matching the repeat addressing of virtualTexture.frag.
+ */
+VirtualTexture::PageProvider
+imagePageProvider(const Image& image, int pageSize, int border, ThreadPool* pool = nullptr);
@@ -0,0 +1,273 @@
+#include "BrickedVolume.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <vector>
+
+#include <intern/Misc/ThreadPool.h>
+
+namespace
+{
+    constexpr uint64_t brickAlignment = 4096;
+
+    uint64_t alignUp(uint64_t value)
+    {
+        return (value + brickAlignment - 1) / brickAlignment * brickAlignment;
+    }
+
+    int channelCount(GLenum dataFormat)
+    {
+        switch(dataFormat)
+        {
+        case GL_RED:
+            return 1;
+        case GL_RG:
+            return 2;
+        case GL_RGB:
+            return 3;
+        case GL_RGBA:
+            return 4;
+        default:
+            return 0;
+        }
+    }
+
+    int typeSize(GLenum dataType)
+    {
+        switch(dataType)
+        {
+        case GL_UNSIGNED_BYTE:
+            return 1;
+        case GL_UNSIGNED_SHORT:
+            return 2;
+        case GL_FLOAT:
+            return 4;
+        default:
+            return 0;
+        }
+    }
+
+    // first channel of a voxel, as the shader samples it
+    float voxelValue(const uint8_t* voxel, GLenum dataType)
+    {
+        switch(dataType)
+        {
+        case GL_UNSIGNED_BYTE:
+            return static_cast<float>(*voxel) / 255.0f;
+        case GL_UNSIGNED_SHORT:
+        {
+            uint16_t value = 0;
+            memcpy(&value, voxel, sizeof(value));
+            return static_cast<float>(value) / 65535.0f;
+        }
+        default:
+        {
+            float value = 0.0f;
+            memcpy(&value, voxel, sizeof(value));
+            return value;
+        }
+        }
+    }
+
+    using SliceMap = std::map<int, std::vector<uint8_t>>;
+
+    // copies the voxels of a brick including its border, clamped at the edges of the volume
+    void extractBrick(
+        const SliceMap& slices, const BrickedVolumeDesc& desc, size_t bytesPerVoxel, int originX, int originY,
+        int originZ, uint8_t* brick)
+    {
+        const int tile = desc.brickSize + 2 * desc.border;
+        const size_t rowBytes = tile * bytesPerVoxel;
+        // rows that do not touch the edges of the volume are copied in one go
+        const bool rowInside = originX >= 0 && originX + tile <= desc.width;
+        for(int z = 0; z < tile; z++)
+        {
+            const uint8_t* slice = slices.at(std::clamp(originZ + z, 0, desc.depth - 1)).data();
+            for(int y = 0; y < tile; y++)
+            {
+                const int sourceY = std::clamp(originY + y, 0, desc.height - 1);
+                const uint8_t* sourceRow = slice + static_cast<size_t>(sourceY) * desc.width * bytesPerVoxel;
+                uint8_t* row = brick + (static_cast<size_t>(z) * tile + y) * rowBytes;
+                if(rowInside)
+                {
+                    memcpy(row, sourceRow + originX * bytesPerVoxel, rowBytes);
+                    continue;
+                }
+                for(int x = 0; x < tile; x++)
+                {
+                    const int sourceX = std::clamp(originX + x, 0, desc.width - 1);
+                    memcpy(row + x * bytesPerVoxel, sourceRow + sourceX * bytesPerVoxel, bytesPerVoxel);
+                }
+            }
+        }
+    }
+
+    void storeValueRange(
+        const uint8_t* brick, size_t brickBytes, size_t bytesPerVoxel, GLenum dataType,
+        BrickedVolumeBrick& entry)
+    {
+        entry.minValue = std::numeric_limits<float>::max();
+        entry.maxValue = std::numeric_limits<float>::lowest();
+        for(size_t voxel = 0; voxel < brickBytes; voxel += bytesPerVoxel)
+        {
+            const float value = voxelValue(brick + voxel, dataType);
+            entry.minValue = std::min(entry.minValue, value);
+            entry.maxValue = std::max(entry.maxValue, value);
+        }
+    }
+} // namespace
+
+BrickedVolume::BrickedVolume(const std::string& path) : file(path, false)
+{
+    if(!file.isOpen() || file.size() < sizeof(BrickedVolumeHeader))
+    {
+        std::cout << "Could not load bricked volume " << path << std::endl;
+        return;
+    }
+    header = reinterpret_cast<const BrickedVolumeHeader*>(file.data());
+    if(memcmp(header->magic, BrickedVolumeHeader::magicValue, sizeof(header->magic)) != 0 ||
+       header->version != BrickedVolumeHeader::currentVersion || header->brickSize == 0 ||
+       getBrickCount() == 0)
+    {
+        std::cout << "Invalid bricked volume header in " << path << std::endl;
+        return;
+    }
+    const size_t indexEnd = sizeof(BrickedVolumeHeader) + getBrickCount() * sizeof(BrickedVolumeBrick);
+    if(indexEnd > file.size())
+    {
+        std::cout << "Truncated bricked volume " << path << std::endl;
+        return;
+    }
+    bricks = reinterpret_cast<const BrickedVolumeBrick*>(file.data() + sizeof(BrickedVolumeHeader));
+    for(uint32_t i = 0; i < getBrickCount(); i++)
+    {
+        if(bricks[i].offset + getBrickBytes() > file.size())
+        {
+            std::cout << "Truncated bricked volume " << path << std::endl;
+            return;
+        }
+    }
+    isValid = true;
+}
+
+size_t BrickedVolume::getBrickBytes() const
+{
+    const size_t voxels = getBrickVoxels();
+    return voxels * voxels * voxels * header->bytesPerVoxel;
+}
+
+std::span<const uint8_t> BrickedVolume::getBrickData(uint32_t index) const
+{
+    assert(index < getBrickCount());
+    return file.bytes().subspan(bricks[index].offset, getBrickBytes());
+}
+
+bool writeBrickedVolume(
+    const std::string& file, const BrickedVolumeDesc& desc, const VolumeSliceSource& source, ThreadPool* pool)
+{
+    const int channels = channelCount(desc.dataFormat);
+    const int bytesPerChannel = typeSize(desc.dataType);
+    assert(channels > 0 && bytesPerChannel > 0 && "Unsupported bricked volume data format or type");
+    assert(desc.width > 0 && desc.height > 0 && desc.depth > 0 && desc.brickSize > 0 && desc.border >= 0);
+    if(channels == 0 || bytesPerChannel == 0)
+    {
+        return false;
+    }
+
+    BrickedVolumeHeader header{
+        .internalFormat = desc.internalFormat,
+        .dataFormat = desc.dataFormat,
+        .dataType = desc.dataType,
+        .bytesPerVoxel = static_cast<uint32_t>(channels * bytesPerChannel),
+        .width = static_cast<uint32_t>(desc.width),
+        .height = static_cast<uint32_t>(desc.height),
+        .depth = static_cast<uint32_t>(desc.depth),
+        .brickSize = static_cast<uint32_t>(desc.brickSize),
+        .border = static_cast<uint32_t>(desc.border),
+        .bricksX = static_cast<uint32_t>((desc.width + desc.brickSize - 1) / desc.brickSize),
+        .bricksY = static_cast<uint32_t>((desc.height + desc.brickSize - 1) / desc.brickSize),
+        .bricksZ = static_cast<uint32_t>((desc.depth + desc.brickSize - 1) / desc.brickSize)};
+    memcpy(header.magic, BrickedVolumeHeader::magicValue, sizeof(header.magic));
+
+    const size_t bytesPerVoxel = header.bytesPerVoxel;
+    const int tile = desc.brickSize + 2 * desc.border;
+    const size_t brickBytes = static_cast<size_t>(tile) * tile * tile * bytesPerVoxel;
+    const uint64_t brickStride = alignUp(brickBytes);
+    const size_t brickCount = static_cast<size_t>(header.bricksX) * header.bricksY * header.bricksZ;
+    const uint64_t dataStart = alignUp(sizeof(BrickedVolumeHeader) + brickCount * sizeof(BrickedVolumeBrick));
+    std::vector<BrickedVolumeBrick> index(brickCount);
+    for(size_t i = 0; i < brickCount; i++)
+    {
+        index[i].offset = dataStart + i * brickStride;
+    }
+
+    std::ofstream out(file, std::ios::binary | std::ios::trunc);
+    if(!out.is_open())
+    {
+        std::cerr << "ERROR: Unable to open file " << file << std::endl;
+        return false;
+    }
+    // the index is written again once the value ranges are known
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(index.data()), index.size() * sizeof(BrickedVolumeBrick));
+    const std::vector<char> padding(brickStride, 0);
+    out.write(
+        padding.data(), static_cast<std::streamsize>(dataStart) - static_cast<std::streamsize>(out.tellp()));
+
+    const size_t sliceBytes = static_cast<size_t>(desc.width) * desc.height * bytesPerVoxel;
+    // slices of the current layer of bricks (including the borders), by z
+    SliceMap slices;
+    std::vector<uint8_t> brickRow(header.bricksX * brickBytes);
+    for(int bz = 0; bz < static_cast<int>(header.bricksZ); bz++)
+    {
+        const int firstZ = std::max(bz * desc.brickSize - desc.border, 0);
+        const int lastZ = std::min(bz * desc.brickSize + desc.brickSize + desc.border, desc.depth) - 1;
+        slices.erase(slices.begin(), slices.lower_bound(firstZ));
+        for(int z = slices.empty() ? firstZ : slices.rbegin()->first + 1; z <= lastZ; z++)
+        {
+            std::vector<uint8_t>& slice = slices[z];
+            slice.resize(sliceBytes);
+            source(z, slice.data());
+        }
+
+        for(int by = 0; by < static_cast<int>(header.bricksY); by++)
+        {
+            parallelFor(
+                pool,
+                header.bricksX,
+                1,
+                [&](size_t begin, size_t end)
+                {
+                    for(size_t bx = begin; bx < end; bx++)
+                    {
+                        uint8_t* brick = brickRow.data() + bx * brickBytes;
+                        extractBrick(
+                            slices,
+                            desc,
+                            bytesPerVoxel,
+                            static_cast<int>(bx) * desc.brickSize - desc.border,
+                            by * desc.brickSize - desc.border,
+                            bz * desc.brickSize - desc.border,
+                            brick);
+                        const size_t brickIndex =
+                            bx + header.bricksX * (by + header.bricksY * static_cast<size_t>(bz));
+                        storeValueRange(brick, brickBytes, bytesPerVoxel, desc.dataType, index[brickIndex]);
+                    }
+                });
+            for(uint32_t bx = 0; bx < header.bricksX; bx++)
+            {
+                out.write(reinterpret_cast<const char*>(brickRow.data() + bx * brickBytes), brickBytes);
+                out.write(padding.data(), static_cast<std::streamsize>(brickStride - brickBytes));
+            }
+        }
+    }
+
+    out.seekp(sizeof(BrickedVolumeHeader));
+    out.write(reinterpret_cast<const char*>(index.data()), index.size() * sizeof(BrickedVolumeBrick));
+    return out.good();
+}
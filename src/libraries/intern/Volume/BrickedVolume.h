@@ -0,0 +1,147 @@
+#pragma once
+
+#include <glad/glad/glad.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <span>
+#include <string>
+
+#include <intern/Misc/MappedFile.h>
+
+class ThreadPool;
+
+/*
+    Bricked volume format, for volumes that are too large to be loaded (or uploaded) as a whole:
+
+    BrickedVolumeHeader
+    BrickedVolumeBrick[bricksX * bricksY * bricksZ]    x fastest, then y, then z
+    brick data                                         each brick starts on a 4096 byte boundary
+
+    Every brick stores (brickSize + 2 * border)^3 voxels, tightly packed in the layout OpenGL expects:
+    its own voxels plus a border copied from its neighbours (clamped at the edges of the volume),
+    so every brick can be filtered on its own once it is in the brick atlas (see VolumeBrickCache.h).
+    Bricks are page aligned, so reading one from the mapping never faults in parts of another.
+*/
+
+struct BrickedVolumeHeader
+{
+    constexpr static char magicValue[8] = {'O', 'G', 'L', 'F', 'V', 'O', 'L', '\0'}; // NOLINT
+    constexpr static uint32_t currentVersion = 1;
+
+    char magic[8] = {}; // NOLINT
+    uint32_t version = currentVersion;
+    // GLenums of the voxel data
+    uint32_t internalFormat = 0;
+    uint32_t dataFormat = 0;
+    uint32_t dataType = 0;
+    uint32_t bytesPerVoxel = 0;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t depth = 0;
+    // voxels per brick side, without the border
+    uint32_t brickSize = 0;
+    uint32_t border = 0;
+    uint32_t bricksX = 0;
+    uint32_t bricksY = 0;
+    uint32_t bricksZ = 0;
+    uint32_t flags = 0;
+};
+static_assert(sizeof(BrickedVolumeHeader) == 64);
+
+struct BrickedVolumeBrick
+{
+    uint64_t offset = 0;
+    // range of the first channel within the brick (including its border), as the shader samples it
+    // (normalized for integer types). Lets empty bricks be skipped without reading their data
+    float minValue = 0.0f;
+    float maxValue = 0.0f;
+};
+static_assert(sizeof(BrickedVolumeBrick) == 16);
+
+/** Memory mapped view of a bricked volume file
+ */
+class BrickedVolume
+{
+  public:
+    constexpr static const char* extension = ".bvol";
+
+    explicit BrickedVolume(const std::string& file);
+
+    BrickedVolume(const BrickedVolume&) = delete;
+    BrickedVolume& operator=(const BrickedVolume&) = delete;
+
+    /* true if the file could be mapped and passed validation */
+    [[nodiscard]] inline bool valid() const
+    {
+        return isValid;
+    }
+
+    [[nodiscard]] inline const BrickedVolumeHeader& getHeader() const
+    {
+        return *header;
+    }
+
+    [[nodiscard]] inline uint32_t getBrickCount() const
+    {
+        return header->bricksX * header->bricksY * header->bricksZ;
+    }
+
+    [[nodiscard]] inline uint32_t brickIndex(uint32_t x, uint32_t y, uint32_t z) const
+    {
+        return x + header->bricksX * (y + header->bricksY * z);
+    }
+
+    /* voxels per brick side including the border */
+    [[nodiscard]] inline uint32_t getBrickVoxels() const
+    {
+        return header->brickSize + 2 * header->border;
+    }
+
+    [[nodiscard]] size_t getBrickBytes() const;
+
+    [[nodiscard]] inline const BrickedVolumeBrick& getBrick(uint32_t index) const
+    {
+        return bricks[index];
+    }
+
+    /* Voxels of the brick, straight from the mapping (first access reads them from disk) */
+    [[nodiscard]] std::span<const uint8_t> getBrickData(uint32_t index) const;
+
+  private:
+    MappedFile file;
+    const BrickedVolumeHeader* header = nullptr;
+    const BrickedVolumeBrick* bricks = nullptr;
+    bool isValid = false;
+};
+
+struct BrickedVolumeDesc
+{
+    int width = -1;
+    int height = -1;
+    int depth = -1;
+    GLenum internalFormat = GL_R8;
+    // GL_RED, GL_RG, GL_RGB or GL_RGBA
+    GLenum dataFormat = GL_RED;
+    // GL_UNSIGNED_BYTE, GL_UNSIGNED_SHORT or GL_FLOAT
+    GLenum dataType = GL_UNSIGNED_BYTE;
+    int brickSize = 32;
+    // 1 is enough for trilinear filtering
+    int border = 1;
+};
+
+/* Fills one z slice of the volume (width * height voxels, tightly packed) */
+using VolumeSliceSource = std::function<void(int z, uint8_t* voxels)>;
+
+/** Writes a bricked volume file, reading the source slice by slice.
+ * Only the slices of one layer of bricks are kept in memory at a time, so volumes of any size can be
+ * converted. Each row of bricks is extracted on the pool, if one is given.
+ * @param file Path of the file to write
+ * @param desc Size and format of the volume
+ * @param source Called once for every slice, in ascending order
+ * @return false if the file could not be written
+ */
+bool writeBrickedVolume(
+    const std::string& file, const BrickedVolumeDesc& desc, const VolumeSliceSource& source,
+    ThreadPool* pool = nullptr);
@@ -0,0 +1,350 @@
+#include "VolumeBrickCache.h"
+
+#include <intern/Misc/ThreadPool.h>
+#include <intern/VirtualTexture/PageTable.h>
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <utility>
+
+namespace
+{
+    constexpr size_t pageSize = 4096;
+
+    // planes (pointing inwards) of the frustum of a view projection matrix (Gribb & Hartmann)
+    std::array<glm::vec4, 6> frustumPlanes(const glm::mat4& m)
+    {
+        const glm::vec4 row0{m[0][0], m[1][0], m[2][0], m[3][0]};
+        const glm::vec4 row1{m[0][1], m[1][1], m[2][1], m[3][1]};
+        const glm::vec4 row2{m[0][2], m[1][2], m[2][2], m[3][2]};
+        const glm::vec4 row3{m[0][3], m[1][3], m[2][3], m[3][3]};
+        return {row3 + row0, row3 - row0, row3 + row1, row3 - row1, row3 + row2, row3 - row2};
+    }
+
+    bool boxInFrustum(const std::array<glm::vec4, 6>& planes, glm::vec3 center, glm::vec3 extent)
+    {
+        for(const glm::vec4& plane : planes)
+        {
+            const float distance = plane.x * center.x + plane.y * center.y + plane.z * center.z + plane.w;
+            const float radius = std::abs(plane.x) * extent.x + std::abs(plane.y) * extent.y +
+                                 std::abs(plane.z) * extent.z;
+            if(distance + radius < 0.0f)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+} // namespace
+
+VolumeBrickCache::VolumeBrickCache(
+    const BrickedVolume& volume, ThreadPool& pool, const VolumeBrickCacheDesc& desc)
+    : volume(volume), desc(desc), pool(pool), inbox(std::make_shared<Inbox>()),
+      atlasTexture(TextureDesc{
+          .name = desc.name,
+          .width = desc.cacheBricksX * static_cast<int>(volume.getBrickVoxels()),
+          .height = desc.cacheBricksY * static_cast<int>(volume.getBrickVoxels()),
+          .depth = desc.cacheBricksZ * static_cast<int>(volume.getBrickVoxels()),
+          .internalFormat = volume.getHeader().internalFormat,
+          .wrapS = GL_CLAMP_TO_EDGE,
+          .wrapT = GL_CLAMP_TO_EDGE,
+          .wrapR = GL_CLAMP_TO_EDGE}),
+      indirectionTexture(TextureDesc{
+          .name = "VolumeBrickCache Indirection",
+          .width = static_cast<GLsizei>(volume.getHeader().bricksX),
+          .height = static_cast<GLsizei>(volume.getHeader().bricksY),
+          .depth = static_cast<GLsizei>(volume.getHeader().bricksZ),
+          .internalFormat = GL_RGBA8UI,
+          .minFilter = GL_NEAREST,
+          .magFilter = GL_NEAREST,
+          .wrapS = GL_CLAMP_TO_EDGE,
+          .wrapT = GL_CLAMP_TO_EDGE,
+          .wrapR = GL_CLAMP_TO_EDGE}),
+      // TileCache only knows rows of tiles, the layers of the atlas are stacked on top of each other
+      brickCache(desc.cacheBricksX, desc.cacheBricksY * desc.cacheBricksZ),
+      // enough for a frame of uploads with some slack for the GPU to catch up
+      stagingRing(volume.getBrickBytes() * desc.maxUploadsPerFrame * 3, "VolumeBrickCache Staging"),
+      indirection(volume.getBrickCount(), 0), dirtyMin(0),
+      dirtyMax(
+          static_cast<int>(volume.getHeader().bricksX) - 1,
+          static_cast<int>(volume.getHeader().bricksY) - 1,
+          static_cast<int>(volume.getHeader().bricksZ) - 1)
+{
+    assert(volume.valid());
+    assert(desc.cacheBricksX <= 255 && desc.cacheBricksY <= 255 && desc.cacheBricksZ <= 255 &&
+           "Indirection entries have 8 bits per axis");
+    // nothing is resident yet, clears the whole indirection volume
+    uploadIndirection();
+}
+
+VolumeBrickCache::~VolumeBrickCache()
+{
+    std::unique_lock<std::mutex> lock(inbox->mutex);
+    inbox->jobDone.wait(lock, [this]() { return inbox->runningJobs == 0; });
+}
+
+void VolumeBrickCache::update(
+    const glm::mat4& volumeToClip, glm::vec3 viewerPosition, float minValue, float maxValue)
+{
+    const BrickedVolumeHeader& header = volume.getHeader();
+    const std::array<glm::vec4, 6> planes = frustumPlanes(volumeToClip);
+    const glm::vec3 volumeSize{
+        static_cast<float>(header.width),
+        static_cast<float>(header.height),
+        static_cast<float>(header.depth)};
+    const float brickSize = static_cast<float>(header.brickSize);
+
+    size_t culled = 0;
+    std::vector<std::pair<float, uint32_t>> visible;
+    for(uint32_t z = 0; z < header.bricksZ; z++)
+    {
+        for(uint32_t y = 0; y < header.bricksY; y++)
+        {
+            for(uint32_t x = 0; x < header.bricksX; x++)
+            {
+                const glm::vec3 brickMin = glm::vec3(x, y, z) * brickSize / volumeSize;
+                const glm::vec3 brickMax =
+                    glm::min(glm::vec3(x + 1, y + 1, z + 1) * brickSize / volumeSize, glm::vec3(1.0f));
+                const glm::vec3 center = (brickMin + brickMax) * 0.5f;
+                if(!boxInFrustum(planes, center, (brickMax - brickMin) * 0.5f))
+                {
+                    continue;
+                }
+                const uint32_t brick = volume.brickIndex(x, y, z);
+                const BrickedVolumeBrick& entry = volume.getBrick(brick);
+                if(entry.maxValue < minValue || entry.minValue > maxValue)
+                {
+                    culled++;
+                    continue;
+                }
+                const glm::vec3 toViewer = center - viewerPosition;
+                visible.emplace_back(glm::dot(toViewer, toViewer), brick);
+            }
+        }
+    }
+    std::sort(visible.begin(), visible.end());
+
+    std::vector<uint32_t> bricks(visible.size());
+    std::transform(
+        visible.begin(),
+        visible.end(),
+        bricks.begin(),
+        [](const std::pair<float, uint32_t>& entry) { return entry.second; });
+    update(bricks);
+    stats.culledBricks = culled;
+}
+
+void VolumeBrickCache::update(std::span<const uint32_t> visibleBricks)
+{
+    frame++;
+    stats.culledBricks = 0;
+    stats.uploadedBricks = 0;
+    stats.uploadedBytes = 0;
+    stats.evictions = 0;
+    stagingRing.retire();
+
+    stats.visibleBricks = visibleBricks.size();
+    stats.hits = 0;
+    std::vector<uint32_t> missing;
+    for(const uint32_t brick : visibleBricks)
+    {
+        assert(brick < volume.getBrickCount());
+        const int tile = brickCache.find(brick);
+        if(tile != TileCache::noTile)
+        {
+            brickCache.touch(tile, frame);
+            stats.hits++;
+        }
+        else
+        {
+            missing.push_back(brick);
+        }
+    }
+    stats.hitRate = stats.visibleBricks > 0
+                        ? static_cast<float>(stats.hits) / static_cast<float>(stats.visibleBricks)
+                        : 1.0f;
+    // already in priority order
+    for(const uint32_t brick : missing)
+    {
+        if(static_cast<int>(pendingLoads.size()) >= desc.maxPendingLoads)
+        {
+            break;
+        }
+        requestBrick(brick);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(inbox->mutex);
+        readyBricks.insert(readyBricks.end(), inbox->loaded.begin(), inbox->loaded.end());
+        inbox->loaded.clear();
+    }
+    while(!readyBricks.empty() && static_cast<int>(stats.uploadedBricks) < desc.maxUploadsPerFrame)
+    {
+        if(!uploadBrick(readyBricks.front()))
+        {
+            break;
+        }
+        pendingLoads.erase(readyBricks.front());
+        readyBricks.pop_front();
+    }
+    stagingRing.fence();
+    stats.uploadedBytes += uploadIndirection();
+
+    stats.residentBricks = brickCache.getResidentCount();
+    stats.pendingLoads = pendingLoads.size();
+}
+
+void VolumeBrickCache::bind(GLuint atlasUnit, GLuint indirectionUnit) const
+{
+    glBindTextureUnit(atlasUnit, atlasTexture.getTextureID());
+    glBindTextureUnit(indirectionUnit, indirectionTexture.getTextureID());
+}
+
+void VolumeBrickCache::setUniforms(GLint location) const
+{
+    const BrickedVolumeHeader& header = volume.getHeader();
+    const float tileSize = static_cast<float>(volume.getBrickVoxels());
+    glUniform4ui(location, header.bricksX, header.bricksY, header.bricksZ, header.brickSize);
+    glUniform4f(
+        location + 1,
+        static_cast<float>(header.border),
+        1.0f / (static_cast<float>(desc.cacheBricksX) * tileSize),
+        1.0f / (static_cast<float>(desc.cacheBricksY) * tileSize),
+        1.0f / (static_cast<float>(desc.cacheBricksZ) * tileSize));
+    glUniform3f(
+        location + 2,
+        static_cast<float>(header.width),
+        static_cast<float>(header.height),
+        static_cast<float>(header.depth));
+}
+
+void VolumeBrickCache::requestBrick(uint32_t brick)
+{
+    if(!pendingLoads.insert(brick).second)
+    {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(inbox->mutex);
+        inbox->runningJobs++;
+    }
+    pool.enqueue(
+        [inbox = inbox, brick, data = volume.getBrickData(brick)]()
+        {
+            // touch every page once, so the disk reads happen here and not during the memcpy on the GL thread
+            uint8_t sum = 0;
+            for(size_t offset = 0; offset < data.size(); offset += pageSize)
+            {
+                sum += *static_cast<const volatile uint8_t*>(&data[offset]);
+            }
+            (void)sum;
+            std::lock_guard<std::mutex> lock(inbox->mutex);
+            inbox->loaded.push_back(brick);
+            inbox->runningJobs--;
+            inbox->jobDone.notify_all();
+        });
+}
+
+bool VolumeBrickCache::uploadBrick(uint32_t brick)
+{
+    if(brickCache.find(brick) != TileCache::noTile)
+    {
+        return true;
+    }
+    if(!brickCache.canAllocate(frame))
+    {
+        // everything resident is visible, drop the brick, it is requested again if it is still visible
+        // once the view changed
+        return true;
+    }
+    // staging before the slot, so no resident brick is evicted for an upload that has to be retried later
+    const size_t brickBytes = volume.getBrickBytes();
+    StagingRing::Allocation staging = stagingRing.allocate(brickBytes);
+    if(staging.ptr == nullptr)
+    {
+        return false;
+    }
+    uint32_t evicted = PageID::invalid;
+    const int tile = brickCache.allocate(brick, frame, evicted);
+    assert(tile != TileCache::noTile);
+    if(evicted != PageID::invalid)
+    {
+        setIndirection(evicted, 0);
+        stats.evictions++;
+    }
+
+    const BrickedVolumeHeader& header = volume.getHeader();
+    const int tileSize = static_cast<int>(volume.getBrickVoxels());
+    const int slotX = tile % desc.cacheBricksX;
+    const int slotY = (tile / desc.cacheBricksX) % desc.cacheBricksY;
+    const int slotZ = tile / (desc.cacheBricksX * desc.cacheBricksY);
+    memcpy(staging.ptr, volume.getBrickData(brick).data(), brickBytes);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, stagingRing.getBufferID());
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTextureSubImage3D(
+        atlasTexture.getTextureID(),
+        0,
+        slotX * tileSize,
+        slotY * tileSize,
+        slotZ * tileSize,
+        tileSize,
+        tileSize,
+        tileSize,
+        header.dataFormat,
+        header.dataType,
+        reinterpret_cast<const void*>(staging.offset)); // NOLINT(performance-no-int-to-ptr)
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    // alpha marks the brick as resident
+    setIndirection(brick, slotX | slotY << 8u | slotZ << 16u | 0xFFu << 24u);
+
+    stats.uploadedBricks++;
+    stats.uploadedBytes += brickBytes;
+    return true;
+}
+
+void VolumeBrickCache::setIndirection(uint32_t brick, uint32_t entry)
+{
+    indirection[brick] = entry;
+    const BrickedVolumeHeader& header = volume.getHeader();
+    const glm::ivec3 position{
+        static_cast<int>(brick % header.bricksX),
+        static_cast<int>((brick / header.bricksX) % header.bricksY),
+        static_cast<int>(brick / (header.bricksX * header.bricksY))};
+    dirtyMin = glm::min(dirtyMin, position);
+    dirtyMax = glm::max(dirtyMax, position);
+}
+
+size_t VolumeBrickCache::uploadIndirection()
+{
+    if(dirtyMin.x > dirtyMax.x)
+    {
+        return 0;
+    }
+    const BrickedVolumeHeader& header = volume.getHeader();
+    const glm::ivec3 size = dirtyMax - dirtyMin + 1;
+    const size_t first = volume.brickIndex(dirtyMin.x, dirtyMin.y, dirtyMin.z);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, static_cast<GLint>(header.bricksX));
+    glPixelStorei(GL_UNPACK_IMAGE_HEIGHT, static_cast<GLint>(header.bricksY));
+    glTextureSubImage3D(
+        indirectionTexture.getTextureID(),
+        0,
+        dirtyMin.x,
+        dirtyMin.y,
+        dirtyMin.z,
+        size.x,
+        size.y,
+        size.z,
+        GL_RGBA_INTEGER,
+        GL_UNSIGNED_BYTE,
+        &indirection[first]);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+    glPixelStorei(GL_UNPACK_IMAGE_HEIGHT, 0);
+
+    dirtyMin = glm::ivec3(header.bricksX, header.bricksY, header.bricksZ);
+    dirtyMax = glm::ivec3(-1);
+    return static_cast<size_t>(size.x) * size.y * size.z * sizeof(uint32_t);
+}
@@ -0,0 +1,145 @@
+#pragma once
+
+#include <glad/glad/glad.h>
+
+#include <glm/glm.hpp>
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <unordered_set>
+#include <vector>
+
+#include <intern/Buffer/StagingRing.h>
+#include <intern/Texture/Texture3D.h>
+#include <intern/VirtualTexture/TileCache.h>
+
+#include "BrickedVolume.h"
+
+class ThreadPool;
+
+struct VolumeBrickCacheDesc
+{
+    const char* name = "";
+    // size of the brick atlas in bricks (at most 255 each)
+    int cacheBricksX = 8;
+    int cacheBricksY = 8;
+    int cacheBricksZ = 8;
+    // budgets
+    int maxUploadsPerFrame = 32;
+    int maxPendingLoads = 128;
+};
+
+/** GPU side of a BrickedVolume that does not fit into VRAM (or RAM):
+ * Visible bricks are streamed into a fixed size atlas Texture3D, an indirection volume with one texel per
+ * brick tells the shader where a brick is (see Volume/brickedVolume.frag). When the atlas is full, the least
+ * recently used bricks are evicted.
+ *
+ * Per frame call update(), either with the view (bricks outside the frustum or the visible value range are
+ * skipped, using the per brick min/max of the file) or with a list of bricks determined elsewhere.
+ * Bricks are read from the mapping on the ThreadPool (so page faults never block the GL thread) and then
+ * uploaded through a StagingRing.
+ * Bricks that are not resident read as 0 in the shader.
+ */
+class VolumeBrickCache
+{
+  public:
+    struct Stats
+    {
+        // bricks requested by the last update, and how many of them were resident
+        size_t visibleBricks = 0;
+        size_t hits = 0;
+        float hitRate = 1.0f;
+        // bricks inside the frustum that were skipped because of their value range
+        size_t culledBricks = 0;
+        size_t residentBricks = 0;
+        size_t pendingLoads = 0;
+        size_t evictions = 0;
+        // bricks and indirection texels uploaded in the last update
+        size_t uploadedBricks = 0;
+        size_t uploadedBytes = 0;
+    };
+
+    /** @param volume Needs to be valid() and outlive the cache
+     */
+    VolumeBrickCache(const BrickedVolume& volume, ThreadPool& pool, const VolumeBrickCacheDesc& desc = {});
+    ~VolumeBrickCache();
+
+    VolumeBrickCache(VolumeBrickCache&&) = delete;
+    VolumeBrickCache(const VolumeBrickCache&) = delete;
+    VolumeBrickCache& operator=(VolumeBrickCache&&) = delete;
+    VolumeBrickCache& operator=(const VolumeBrickCache&) = delete;
+
+    /** Streams in the bricks that are visible, nearest first. Call once per frame on the GL thread.
+     * @param volumeToClip Transforms volume coordinates ([0,1]^3 covering the whole volume) to clip space
+     * @param viewerPosition Camera position in volume coordinates
+     * @param minValue, maxValue Bricks whose values lie completely outside of this range are skipped
+     *                           (eg. fully transparent in the transfer function)
+     */
+    void update(const glm::mat4& volumeToClip, glm::vec3 viewerPosition, float minValue, float maxValue);
+
+    /** Streams in the given bricks (indices as in BrickedVolume::brickIndex()), in order of priority
+     */
+    void update(std::span<const uint32_t> visibleBricks);
+
+    /* Binds the brick atlas and the indirection volume, see brickedVolume.frag */
+    void bind(GLuint atlasUnit = 0, GLuint indirectionUnit = 1) const;
+    /* Sets the uniforms at location to location + 2, see brickedVolume.frag */
+    void setUniforms(GLint location = 4) const;
+
+    [[nodiscard]] inline const Stats& getStats() const
+    {
+        return stats;
+    }
+
+    [[nodiscard]] inline const Texture3D& getAtlasTexture() const
+    {
+        return atlasTexture;
+    }
+
+    [[nodiscard]] inline const Texture3D& getIndirectionTexture() const
+    {
+        return indirectionTexture;
+    }
+
+  private:
+    // shared with the load jobs. They read from the mapping of the volume, so the destructor waits for
+    // the ones that are still running
+    struct Inbox
+    {
+        std::mutex mutex;
+        std::condition_variable jobDone;
+        size_t runningJobs = 0;
+        std::vector<uint32_t> loaded;
+    };
+
+    void requestBrick(uint32_t brick);
+    // returns false if the brick could not be uploaded this frame
+    bool uploadBrick(uint32_t brick);
+    void setIndirection(uint32_t brick, uint32_t entry);
+    size_t uploadIndirection();
+
+    const BrickedVolume& volume;
+    VolumeBrickCacheDesc desc;
+    ThreadPool& pool;
+    std::shared_ptr<Inbox> inbox;
+
+    Texture3D atlasTexture;
+    Texture3D indirectionTexture;
+    TileCache brickCache;
+    StagingRing stagingRing;
+
+    // cpu copy of the indirection volume and the part of it that changed since the last upload
+    std::vector<uint32_t> indirection;
+    glm::ivec3 dirtyMin;
+    glm::ivec3 dirtyMax;
+
+    std::unordered_set<uint32_t> pendingLoads;
+    std::deque<uint32_t> readyBricks;
+    uint64_t frame = 1;
+    Stats stats;
+};
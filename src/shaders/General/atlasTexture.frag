@@ -0,0 +1,31 @@
+#version 430
+
+// Samples one image of an array TextureAtlas through its remap table (see TextureAtlas.h),
+// so meshes with different images can be drawn without rebinding the texture
+
+in vec2 passTexCoord;
+
+uniform layout (binding = 0) sampler2DArray atlas;
+
+struct AtlasRemapEntry
+{
+    vec4 scaleOffset;
+    int layer;
+};
+
+layout (std430, binding = 0) readonly buffer AtlasRemapTable
+{
+    AtlasRemapEntry remapTable[];
+};
+
+layout (location = 3) uniform uint atlasImage;
+
+out vec4 fragmentColor;
+
+void main()
+{
+    AtlasRemapEntry entry = remapTable[atlasImage];
+    // images are clamped, the gutters take care of filtering across the edges
+    vec2 uv = clamp(passTexCoord, 0.0, 1.0) * entry.scaleOffset.xy + entry.scaleOffset.zw;
+    fragmentColor = texture(atlas, vec3(uv, float(entry.layer)));
+}
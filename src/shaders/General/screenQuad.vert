@@ -1,11 +1,11 @@
 #version 430
 
+// FullscreenTri only has positions, the texture coordinates follow from them
 layout (location = 0) in vec4 position;
-layout (location = 2) in vec2 textureCoord;
 
 out vec2 passTextureCoord;
 
 void main(){
-    passTextureCoord = textureCoord;
+    passTextureCoord = position.xy * 0.5 + 0.5;
     gl_Position = position;
 }
\ No newline at end of file
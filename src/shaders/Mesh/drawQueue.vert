@@ -0,0 +1,42 @@
+#version 430
+
+// Draws of a RenderQueue (see RenderQueue.h), use with shaded.frag
+// The model matrix of every draw comes from the draw data buffer instead of a uniform
+
+layout (location = 0) in vec4 position;
+layout (location = 1) in vec3 normal;
+layout (location = 2) in vec2 textureCoord;
+layout (location = 3) in vec4 tangent;
+// baseInstance of the draw, RenderQueue::drawIndexLocation
+layout (location = 8) in uint drawIndex;
+
+struct DrawData
+{
+    mat4 model;
+};
+
+// RenderQueue::drawDataBinding
+layout (std430, binding = 0) readonly buffer DrawDataBuffer
+{
+    DrawData draws[];
+};
+
+layout (location = 1) uniform mat4 viewMatrix;
+layout (location = 2) uniform mat4 projectionMatrix;
+
+out vec3 passNormal;
+out vec2 passTexCoord;
+// xyz is the tangent, w the handedness
+out vec4 passTangent;
+out vec4 passColor;
+
+void main()
+{
+    const mat4 modelMatrix = draws[drawIndex].model;
+    // model matrix only scales uniformly and translates
+    passNormal = mat3(modelMatrix) * normal;
+    passTexCoord = textureCoord;
+    passTangent = vec4(mat3(modelMatrix) * tangent.xyz, tangent.w);
+    passColor = vec4(0.9, 0.7, 0.4, 1.0);
+    gl_Position = projectionMatrix * viewMatrix * modelMatrix * position;
+}
@@ -0,0 +1,42 @@
+#version 430
+
+// Instances of an InstanceBuffer (see InstanceBuffer.h), use with shaded.frag
+// The model matrix and color of every instance come from the instance buffer instead of uniforms
+
+layout (location = 0) in vec4 position;
+layout (location = 1) in vec3 normal;
+layout (location = 2) in vec2 textureCoord;
+layout (location = 3) in vec4 tangent;
+
+struct InstanceData
+{
+    mat4 model;
+    vec4 color;
+    uint materialID;
+};
+
+// InstanceBuffer::binding
+layout (std430, binding = 1) readonly buffer InstanceDataBuffer
+{
+    InstanceData instances[];
+};
+
+layout (location = 1) uniform mat4 viewMatrix;
+layout (location = 2) uniform mat4 projectionMatrix;
+
+out vec3 passNormal;
+out vec2 passTexCoord;
+// xyz is the tangent, w the handedness
+out vec4 passTangent;
+out vec4 passColor;
+
+void main()
+{
+    const InstanceData instance = instances[gl_InstanceID];
+    // model matrix only scales uniformly and translates
+    passNormal = mat3(instance.model) * normal;
+    passTexCoord = textureCoord;
+    passTangent = vec4(mat3(instance.model) * tangent.xyz, tangent.w);
+    passColor = instance.color;
+    gl_Position = projectionMatrix * viewMatrix * instance.model * position;
+}
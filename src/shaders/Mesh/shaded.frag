@@ -0,0 +1,35 @@
+#version 430
+
+in vec3 passNormal;
+in vec2 passTexCoord;
+in vec4 passTangent;
+in vec4 passColor;
+
+// 0: shaded, 1: normals, 2: uvs, 3: tangents (blue where the handedness is negative)
+layout (location = 3) uniform int mode = 0;
+
+out vec4 fragmentColor;
+
+void main()
+{
+    const vec3 normal = normalize(passNormal) * (gl_FrontFacing ? 1.0 : -1.0);
+    if(mode == 1)
+    {
+        fragmentColor = vec4(normal * 0.5 + 0.5, 1.0);
+        return;
+    }
+    if(mode == 2)
+    {
+        fragmentColor = vec4(fract(passTexCoord), 0.0, 1.0);
+        return;
+    }
+    if(mode == 3)
+    {
+        const vec3 tangent = normalize(passTangent.xyz) * 0.5 + 0.5;
+        fragmentColor = vec4(passTangent.w < 0.0 ? tangent.zyx : tangent, 1.0);
+        return;
+    }
+    const vec3 lightDirection = normalize(vec3(0.5, 1.0, 0.3));
+    const float diffuse = max(dot(normal, lightDirection), 0.0);
+    fragmentColor = vec4(passColor.rgb * (0.15 + 0.85 * diffuse), passColor.a);
+}
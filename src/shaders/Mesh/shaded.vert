@@ -0,0 +1,26 @@
+#version 430
+
+layout (location = 0) in vec4 position;
+layout (location = 1) in vec3 normal;
+layout (location = 2) in vec2 textureCoord;
+layout (location = 3) in vec4 tangent;
+
+layout (location = 0) uniform mat4 modelMatrix;
+layout (location = 1) uniform mat4 viewMatrix;
+layout (location = 2) uniform mat4 projectionMatrix;
+
+out vec3 passNormal;
+out vec2 passTexCoord;
+// xyz is the tangent, w the handedness
+out vec4 passTangent;
+out vec4 passColor;
+
+void main()
+{
+    // model matrix only scales uniformly and translates
+    passNormal = mat3(modelMatrix) * normal;
+    passTexCoord = textureCoord;
+    passTangent = vec4(mat3(modelMatrix) * tangent.xyz, tangent.w);
+    passColor = vec4(0.9, 0.7, 0.4, 1.0);
+    gl_Position = projectionMatrix * viewMatrix * modelMatrix * position;
+}
@@ -0,0 +1,40 @@
+#version 430
+
+// Half and Quantized vertex formats, see VertexQuantization.h
+// xyz in [0, 1] within the bounds of the mesh, w is the handedness of the tangent frame
+layout (location = 0) in vec4 position;
+layout (location = 1) in vec2 octNormal;
+layout (location = 2) in vec2 textureCoord;
+layout (location = 3) in vec2 octTangent;
+
+layout (location = 0) uniform mat4 modelMatrix;
+layout (location = 1) uniform mat4 viewMatrix;
+layout (location = 2) uniform mat4 projectionMatrix;
+// Mesh::getPositionDecode
+layout (location = 4) uniform mat4 positionDecode;
+
+out vec3 passNormal;
+out vec2 passTexCoord;
+// xyz is the tangent, w the handedness
+out vec4 passTangent;
+out vec4 passColor;
+
+vec3 octDecode(vec2 encoded)
+{
+    vec3 v = vec3(encoded, 1.0 - abs(encoded.x) - abs(encoded.y));
+    if(v.z < 0.0)
+    {
+        v.xy = (1.0 - abs(v.yx)) * vec2(v.x >= 0.0 ? 1.0 : -1.0, v.y >= 0.0 ? 1.0 : -1.0);
+    }
+    return normalize(v);
+}
+
+void main()
+{
+    // model matrix only scales uniformly and translates
+    passNormal = mat3(modelMatrix) * octDecode(octNormal);
+    passTexCoord = textureCoord;
+    passTangent = vec4(mat3(modelMatrix) * octDecode(octTangent), position.w > 0.5 ? 1.0 : -1.0);
+    passColor = vec4(0.9, 0.7, 0.4, 1.0);
+    gl_Position = projectionMatrix * viewMatrix * modelMatrix * positionDecode * vec4(position.xyz, 1.0);
+}
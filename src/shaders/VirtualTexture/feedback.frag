@@ -0,0 +1,28 @@
+#version 430
+
+// Writes the virtual texture page every fragment needs, see VirtualTexture.h
+
+in vec2 passTexCoord;
+
+// x,y: pages of level 0, z: level count
+layout (location = 3) uniform uvec4 vtPages;
+// x: page size, y: border, zw: 1 / physical texture size
+layout (location = 4) uniform vec4 vtPage;
+// feedback is rendered at a lower resolution, this corrects the mip level
+layout (location = 5) uniform float vtFeedbackBias;
+
+out uint feedback;
+
+void main()
+{
+    vec2 uv = fract(passTexCoord);
+    vec2 texel = passTexCoord * vec2(vtPages.xy) * vtPage.x;
+    vec2 dx = dFdx(texel);
+    vec2 dy = dFdy(texel);
+    float lod = 0.5 * log2(max(dot(dx, dx), dot(dy, dy))) + vtFeedbackBias;
+    uint level = uint(clamp(floor(lod), 0.0, float(vtPages.z - 1)));
+
+    uvec2 levelPages = max(vtPages.xy >> level, uvec2(1));
+    uvec2 page = min(uvec2(uv * vec2(vtPages.xy)) >> level, levelPages - 1);
+    feedback = (level << 28) | (page.y << 14) | page.x;
+}
@@ -0,0 +1,35 @@
+#version 430
+
+// Samples a virtual texture through its page table, see VirtualTexture.h
+
+in vec2 passTexCoord;
+
+uniform layout (binding = 0) sampler2D physicalTexture;
+uniform layout (binding = 1) usampler2D pageTable;
+
+// x,y: pages of level 0, z: level count
+layout (location = 3) uniform uvec4 vtPages;
+// x: page size, y: border, zw: 1 / physical texture size
+layout (location = 4) uniform vec4 vtPage;
+
+out vec4 fragmentColor;
+
+void main()
+{
+    vec2 uv = fract(passTexCoord);
+    vec2 texel = passTexCoord * vec2(vtPages.xy) * vtPage.x;
+    vec2 dx = dFdx(texel);
+    vec2 dy = dFdy(texel);
+    float lod = 0.5 * log2(max(dot(dx, dx), dot(dy, dy)));
+    uint level = uint(clamp(floor(lod), 0.0, float(vtPages.z - 1)));
+
+    // unmapped pages point to their closest resident ancestor, so the entry can be of a coarser level
+    uvec2 levelPages = max(vtPages.xy >> level, uvec2(1));
+    uvec2 page = min(uvec2(uv * vec2(vtPages.xy)) >> level, levelPages - 1);
+    uvec4 entry = texelFetch(pageTable, ivec2(page), int(level));
+    uint mappedLevel = entry.z;
+
+    vec2 inPage = fract(uv * vec2(max(vtPages.xy >> mappedLevel, uvec2(1))));
+    vec2 physical = vec2(entry.xy) * (vtPage.x + 2.0 * vtPage.y) + vtPage.y + inPage * vtPage.x;
+    fragmentColor = textureLod(physicalTexture, physical * vtPage.zw, 0.0);
+}
@@ -0,0 +1,67 @@
+#version 430
+
+// Raymarches a bricked volume through the brick cache, see VolumeBrickCache.h
+// Drawn with front face culling, so that the volume is also visible with the camera inside of it
+
+in vec3 passVolumePosition;
+
+uniform layout (binding = 0) sampler3D brickAtlas;
+uniform layout (binding = 1) usampler3D brickIndirection;
+
+// camera position in volume coordinates
+layout (location = 3) uniform vec3 cameraPosition;
+// xyz: bricks per axis, w: brick size
+layout (location = 4) uniform uvec4 volumeBricks;
+// x: border, yzw: 1 / atlas size
+layout (location = 5) uniform vec4 volumeAtlas;
+// volume size in voxels
+layout (location = 6) uniform vec3 volumeSize;
+// values outside of this range are fully transparent
+layout (location = 7) uniform vec2 valueRange;
+layout (location = 8) uniform float density;
+
+out vec4 fragmentColor;
+
+float sampleVolume(vec3 position)
+{
+    vec3 voxel = position * volumeSize;
+    uvec3 brick = min(uvec3(voxel / float(volumeBricks.w)), volumeBricks.xyz - 1);
+    uvec4 entry = texelFetch(brickIndirection, ivec3(brick), 0);
+    // not resident (yet)
+    if(entry.w == 0)
+    {
+        return 0.0;
+    }
+    vec3 inBrick = voxel - vec3(brick) * float(volumeBricks.w);
+    float tileSize = float(volumeBricks.w) + 2.0 * volumeAtlas.x;
+    vec3 atlasVoxel = vec3(entry.xyz) * tileSize + volumeAtlas.x + inBrick;
+    return textureLod(brickAtlas, atlasVoxel * volumeAtlas.yzw, 0.0).r;
+}
+
+void main()
+{
+    // ray from the camera (or where it enters the volume) to the back face
+    vec3 direction = normalize(passVolumePosition - cameraPosition);
+    vec3 tMin = (vec3(0.0) - cameraPosition) / direction;
+    vec3 tMax = (vec3(1.0) - cameraPosition) / direction;
+    float tEnter = max(max(max(min(tMin.x, tMax.x), min(tMin.y, tMax.y)), min(tMin.z, tMax.z)), 0.0);
+    float tExit = length(passVolumePosition - cameraPosition);
+
+    // about two samples per voxel
+    float stepSize = 0.5 / max(volumeSize.x, max(volumeSize.y, volumeSize.z));
+    vec3 color = vec3(0.0);
+    float transmittance = 1.0;
+    for(float t = tEnter; t < tExit && transmittance > 0.01; t += stepSize)
+    {
+        float value = sampleVolume(cameraPosition + t * direction);
+        if(value < valueRange.x || value > valueRange.y)
+        {
+            continue;
+        }
+        float visible = (value - valueRange.x) / max(valueRange.y - valueRange.x, 1e-5);
+        float alpha = 1.0 - exp(-visible * density * stepSize);
+        color += transmittance * alpha * mix(vec3(0.2, 0.4, 1.0), vec3(1.0, 0.9, 0.7), visible);
+        transmittance *= 1.0 - alpha;
+    }
+    fragmentColor = vec4(color, 1.0 - transmittance);
+}
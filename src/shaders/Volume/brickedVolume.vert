@@ -0,0 +1,17 @@
+#version 430
+
+// Volume raymarching on a unit cube (Cube{1.0f}), passes on the volume coordinates ([0,1]^3) of the fragment
+
+layout (location = 0) in vec4 position;
+
+layout (location = 0) uniform mat4 modelMatrix;
+layout (location = 1) uniform mat4 viewMatrix;
+layout (location = 2) uniform mat4 projectionMatrix;
+
+out vec3 passVolumePosition;
+
+void main()
+{
+    passVolumePosition = position.xyz + 0.5;
+    gl_Position = projectionMatrix * viewMatrix * modelMatrix * position;
+}